@@ -0,0 +1,208 @@
+#include "BenchmarkHistory.h"
+#include <QFile>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QHash>
+#include <cmath>
+
+namespace {
+// Continued fraction for the regularized incomplete beta function (modified Lentz)
+double betaContinuedFraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+
+    for (int m = 1; m <= 200; ++m) {
+        const int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        const double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < 1e-12) {
+            break;
+        }
+    }
+    return h;
+}
+
+double regularizedBeta(double a, double b, double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    if (x >= 1.0) {
+        return 1.0;
+    }
+    const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                                  + a * std::log(x) + b * std::log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * betaContinuedFraction(a, b, x) / a;
+    }
+    return 1.0 - front * betaContinuedFraction(b, a, 1.0 - x) / b;
+}
+}
+
+BenchmarkHistory::BenchmarkHistory(const QString &projectPath)
+    : m_projectPath(projectPath)
+{
+}
+
+QString BenchmarkHistory::historyFile(const QString &projectPath)
+{
+    return QDir(projectPath).filePath(".qtcide_benchmarks.json");
+}
+
+bool BenchmarkHistory::load(QString *error)
+{
+    m_runs.clear();
+    QFile file(historyFile(m_projectPath));
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (doc.isNull()) {
+        if (error) {
+            *error = parseError.errorString();
+        }
+        return false;
+    }
+
+    for (const QJsonValue &run : doc.object()["runs"].toArray()) {
+        m_runs << BenchmarkRun::fromJson(run.toObject());
+    }
+    return true;
+}
+
+bool BenchmarkHistory::save(QString *error) const
+{
+    QJsonArray runArray;
+    for (const BenchmarkRun &run : m_runs) {
+        runArray.append(run.toJson());
+    }
+    QJsonObject root;
+    root["version"] = 1;
+    root["runs"] = runArray;
+
+    QFile file(historyFile(m_projectPath));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+void BenchmarkHistory::addRun(const BenchmarkRun &run)
+{
+    m_runs << run;
+}
+
+int BenchmarkHistory::findCommit(const QString &commit) const
+{
+    if (commit.isEmpty()) {
+        return -1;
+    }
+    for (int i = m_runs.size() - 1; i >= 0; --i) {
+        if (m_runs.at(i).commit.startsWith(commit)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+double BenchmarkHistory::welchPValue(const BenchmarkResult &a, const BenchmarkResult &b)
+{
+    if (a.repetitions < 2 || b.repetitions < 2) {
+        return 1.0;
+    }
+
+    const double varianceA = a.stddev * a.stddev / a.repetitions;
+    const double varianceB = b.stddev * b.stddev / b.repetitions;
+    const double standardError = varianceA + varianceB;
+    if (standardError <= 0.0) {
+        return a.mean == b.mean ? 1.0 : 0.0;
+    }
+
+    const double t = (a.mean - b.mean) / std::sqrt(standardError);
+    const double degrees = standardError * standardError
+                           / (varianceA * varianceA / (a.repetitions - 1) + varianceB * varianceB / (b.repetitions - 1));
+    return regularizedBeta(degrees / 2.0, 0.5, degrees / (degrees + t * t));
+}
+
+QVector<BenchmarkComparison> BenchmarkHistory::compare(const BenchmarkRun &baseline, const BenchmarkRun &current)
+{
+    QHash<QString, BenchmarkResult> baselineResults;
+    for (const BenchmarkResult &result : baseline.results) {
+        baselineResults.insert(result.name, result);
+    }
+
+    QVector<BenchmarkComparison> comparisons;
+    for (const BenchmarkResult &result : current.results) {
+        BenchmarkComparison comparison;
+        comparison.name = result.name;
+        comparison.current = result;
+
+        auto it = baselineResults.constFind(result.name);
+        if (it != baselineResults.constEnd() && it->median > 0) {
+            comparison.baseline = *it;
+            comparison.changePercent = (result.median - it->median) / it->median * 100.0;
+            comparison.pValue = welchPValue(*it, result);
+            comparison.verdict = BenchmarkComparison::Unchanged;
+            if (comparison.pValue < kSignificanceLevel && std::fabs(comparison.changePercent) >= kMinimumChangePercent) {
+                comparison.verdict = comparison.changePercent > 0 ? BenchmarkComparison::Regressed
+                                                                  : BenchmarkComparison::Improved;
+            }
+        }
+        comparisons << comparison;
+    }
+    return comparisons;
+}
+
+QString BenchmarkHistory::formatDuration(double nanoseconds)
+{
+    const char *units[] = {"ns", "us", "ms", "s"};
+    int unit = 0;
+    while (nanoseconds >= 1000 && unit < 3) {
+        nanoseconds /= 1000;
+        ++unit;
+    }
+    return QString("%1 %2").arg(nanoseconds, 0, 'f', unit == 0 ? 1 : 2).arg(units[unit]);
+}
+
+QString BenchmarkHistory::verdictText(BenchmarkComparison::Verdict verdict)
+{
+    switch (verdict) {
+    case BenchmarkComparison::Improved:
+        return "improved";
+    case BenchmarkComparison::Regressed:
+        return "REGRESSED";
+    case BenchmarkComparison::Added:
+        return "new";
+    default:
+        return "unchanged";
+    }
+}
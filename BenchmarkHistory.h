@@ -0,0 +1,56 @@
+#ifndef BENCHMARKHISTORY_H
+#define BENCHMARKHISTORY_H
+
+#include <QString>
+#include <QVector>
+#include "BenchmarkRunner.h"
+
+struct BenchmarkComparison
+{
+    enum Verdict {
+        Unchanged,
+        Improved,
+        Regressed,
+        Added
+    };
+
+    QString name;
+    BenchmarkResult baseline;
+    BenchmarkResult current;
+    double changePercent = 0;   // of the median, positive means slower
+    double pValue = 1;
+    Verdict verdict = Added;
+};
+
+// Benchmark runs for one project, persisted next to it in .qtcide_benchmarks.json
+class BenchmarkHistory
+{
+public:
+    static constexpr double kSignificanceLevel = 0.05;
+    // Changes smaller than this are reported as noise even when significant
+    static constexpr double kMinimumChangePercent = 2.0;
+
+    explicit BenchmarkHistory(const QString &projectPath = QString());
+
+    static QString historyFile(const QString &projectPath);
+
+    bool load(QString *error = nullptr);
+    bool save(QString *error = nullptr) const;
+
+    void addRun(const BenchmarkRun &run);
+    const QVector<BenchmarkRun> &runs() const { return m_runs; }
+    // Latest run recorded for a commit (prefix match), or -1
+    int findCommit(const QString &commit) const;
+
+    static QVector<BenchmarkComparison> compare(const BenchmarkRun &baseline, const BenchmarkRun &current);
+    // Two-sided p-value of Welch's t-test on the two results
+    static double welchPValue(const BenchmarkResult &a, const BenchmarkResult &b);
+    static QString formatDuration(double nanoseconds);
+    static QString verdictText(BenchmarkComparison::Verdict verdict);
+
+private:
+    QString m_projectPath;
+    QVector<BenchmarkRun> m_runs;
+};
+
+#endif // BENCHMARKHISTORY_H
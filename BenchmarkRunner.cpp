@@ -0,0 +1,312 @@
+#include "BenchmarkRunner.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QXmlStreamReader>
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+double toNanoseconds(double value, const QString &unit)
+{
+    if (unit == "us") {
+        return value * 1e3;
+    }
+    if (unit == "ms") {
+        return value * 1e6;
+    }
+    if (unit == "s") {
+        return value * 1e9;
+    }
+    return value;
+}
+}
+
+QJsonObject BenchmarkResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["repetitions"] = repetitions;
+    object["mean"] = mean;
+    object["median"] = median;
+    object["stddev"] = stddev;
+    QJsonArray sampleArray;
+    for (double sample : samples) {
+        sampleArray.append(sample);
+    }
+    object["samples"] = sampleArray;
+    return object;
+}
+
+BenchmarkResult BenchmarkResult::fromJson(const QJsonObject &object)
+{
+    BenchmarkResult result;
+    result.name = object["name"].toString();
+    result.repetitions = object["repetitions"].toInt();
+    result.mean = object["mean"].toDouble();
+    result.median = object["median"].toDouble();
+    result.stddev = object["stddev"].toDouble();
+    for (const QJsonValue &sample : object["samples"].toArray()) {
+        result.samples << sample.toDouble();
+    }
+    return result;
+}
+
+BenchmarkResult BenchmarkResult::fromSamples(const QString &name, const QVector<double> &samples)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.samples = samples;
+    result.repetitions = samples.size();
+    if (samples.isEmpty()) {
+        return result;
+    }
+
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.mean = sum / samples.size();
+
+    QVector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    const int middle = sorted.size() / 2;
+    result.median = sorted.size() % 2 ? sorted.at(middle) : (sorted.at(middle - 1) + sorted.at(middle)) / 2;
+
+    if (samples.size() > 1) {
+        double squares = 0;
+        for (double sample : samples) {
+            squares += (sample - result.mean) * (sample - result.mean);
+        }
+        result.stddev = std::sqrt(squares / (samples.size() - 1));
+    }
+    return result;
+}
+
+QString BenchmarkRun::label() const
+{
+    QString commitLabel = commit.isEmpty() ? QString("no commit") : commit.left(10);
+    if (dirty) {
+        commitLabel += "+";
+    }
+    return QString("%1 (%2)").arg(commitLabel, timestamp.toString("yyyy-MM-dd hh:mm"));
+}
+
+QJsonObject BenchmarkRun::toJson() const
+{
+    QJsonObject object;
+    object["commit"] = commit;
+    object["dirty"] = dirty;
+    object["timestamp"] = timestamp.toString(Qt::ISODate);
+    object["executable"] = executable;
+    QJsonArray resultArray;
+    for (const BenchmarkResult &result : results) {
+        resultArray.append(result.toJson());
+    }
+    object["results"] = resultArray;
+    return object;
+}
+
+BenchmarkRun BenchmarkRun::fromJson(const QJsonObject &object)
+{
+    BenchmarkRun run;
+    run.commit = object["commit"].toString();
+    run.dirty = object["dirty"].toBool();
+    run.timestamp = QDateTime::fromString(object["timestamp"].toString(), Qt::ISODate);
+    run.executable = object["executable"].toString();
+    for (const QJsonValue &result : object["results"].toArray()) {
+        run.results << BenchmarkResult::fromJson(result.toObject());
+    }
+    return run;
+}
+
+BenchmarkRunner::BenchmarkRunner(QObject *parent)
+    : QObject(parent)
+    , m_process(new QProcess(this))
+    , m_framework(Unknown)
+{
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &BenchmarkRunner::onFinished);
+    // Structured results arrive on stdout; progress and diagnostics on stderr
+    connect(m_process, &QProcess::readyReadStandardOutput, this, [this]() {
+        m_stdout += m_process->readAllStandardOutput();
+    });
+    connect(m_process, &QProcess::readyReadStandardError, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_process->readAllStandardError()));
+    });
+}
+
+BenchmarkRunner::Framework BenchmarkRunner::detectFramework(const QString &executable)
+{
+    // Both frameworks embed their command line flag names in the binary
+    QFile file(executable);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Unknown;
+    }
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        return Unknown;
+    }
+
+    const QByteArray contents = QByteArray::fromRawData(reinterpret_cast<const char *>(data), file.size());
+    Framework framework = Unknown;
+    if (contents.contains("benchmark_repetitions")) {
+        framework = GoogleBenchmark;
+    } else if (contents.contains("benchmark-samples")) {
+        framework = Catch2;
+    }
+    file.unmap(data);
+    return framework;
+}
+
+QVector<BenchmarkResult> BenchmarkRunner::parseGoogleBenchmarkJson(const QByteArray &json, QString *error)
+{
+    // Console output may precede the JSON document when the program prints on its own
+    QByteArray document = json.mid(qMax<qsizetype>(0, json.indexOf('{')));
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(document, &parseError);
+    if (doc.isNull()) {
+        if (error) {
+            *error = parseError.errorString();
+        }
+        return {};
+    }
+
+    // Each repetition is its own entry; aggregates are recomputed from the raw samples
+    QMap<QString, QVector<double>> samplesByName;
+    QStringList order;
+    for (const QJsonValue &value : doc.object()["benchmarks"].toArray()) {
+        QJsonObject entry = value.toObject();
+        if (entry["run_type"].toString() == "aggregate" || entry["error_occurred"].toBool()) {
+            continue;
+        }
+        QString name = entry.contains("run_name") ? entry["run_name"].toString() : entry["name"].toString();
+        if (!samplesByName.contains(name)) {
+            order << name;
+        }
+        samplesByName[name] << toNanoseconds(entry["real_time"].toDouble(), entry["time_unit"].toString());
+    }
+
+    QVector<BenchmarkResult> results;
+    for (const QString &name : order) {
+        results << BenchmarkResult::fromSamples(name, samplesByName.value(name));
+    }
+    return results;
+}
+
+QVector<BenchmarkResult> BenchmarkRunner::parseCatch2Xml(const QByteArray &xml, QString *error)
+{
+    // Catch2 reports per-benchmark estimates rather than raw samples, already in nanoseconds
+    QVector<BenchmarkResult> results;
+    QXmlStreamReader reader(xml);
+    BenchmarkResult *current = nullptr;
+
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            if (reader.name() == QLatin1String("BenchmarkResults")) {
+                BenchmarkResult result;
+                result.name = attributes.value("name").toString();
+                result.repetitions = attributes.value("samples").toInt();
+                results << result;
+                current = &results.last();
+            } else if (current && reader.name() == QLatin1String("mean")) {
+                current->mean = attributes.value("value").toDouble();
+                current->median = current->mean;
+            } else if (current && reader.name() == QLatin1String("standardDeviation")) {
+                current->stddev = attributes.value("value").toDouble();
+            }
+        } else if (reader.isEndElement() && reader.name() == QLatin1String("BenchmarkResults")) {
+            current = nullptr;
+        }
+    }
+
+    if (reader.hasError() && error) {
+        *error = reader.errorString();
+    }
+    return results;
+}
+
+void BenchmarkRunner::currentCommit(const QString &projectPath, QString *commit, bool *dirty)
+{
+    QProcess git;
+    git.setWorkingDirectory(projectPath);
+    git.start("git", {"rev-parse", "HEAD"});
+    *commit = git.waitForFinished(5000) && git.exitCode() == 0
+                  ? QString::fromUtf8(git.readAllStandardOutput()).trimmed() : QString();
+
+    *dirty = false;
+    if (!commit->isEmpty()) {
+        git.start("git", {"status", "--porcelain", "--untracked-files=no"});
+        *dirty = git.waitForFinished(5000) && !git.readAllStandardOutput().trimmed().isEmpty();
+    }
+}
+
+bool BenchmarkRunner::start(const QString &executable, const QStringList &arguments, const QString &workingDirectory,
+                            const QProcessEnvironment &environment, const QString &projectPath, int repetitions)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    m_framework = detectFramework(executable);
+    if (m_framework == Unknown) {
+        emit errorOccurred(QFileInfo(executable).fileName() + " is not a Google Benchmark or Catch2 executable");
+        return false;
+    }
+
+    m_run = BenchmarkRun();
+    m_run.executable = executable;
+    m_run.timestamp = QDateTime::currentDateTime();
+    currentCommit(projectPath, &m_run.commit, &m_run.dirty);
+    m_stdout.clear();
+
+    QStringList args = arguments;
+    if (m_framework == GoogleBenchmark) {
+        args << "--benchmark_format=json"
+             << QString("--benchmark_repetitions=%1").arg(repetitions);
+    } else {
+        args << "--reporter" << "xml"
+             << "--benchmark-samples" << QString::number(repetitions);
+    }
+
+    m_process->setWorkingDirectory(workingDirectory);
+    m_process->setProcessEnvironment(environment);
+    m_process->start(executable, args);
+    return true;
+}
+
+void BenchmarkRunner::stop()
+{
+    if (m_process->state() != QProcess::NotRunning) {
+        m_process->kill();
+    }
+}
+
+bool BenchmarkRunner::isRunning() const
+{
+    return m_process->state() != QProcess::NotRunning;
+}
+
+void BenchmarkRunner::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_stdout += m_process->readAllStandardOutput();
+    if (exitStatus == QProcess::CrashExit) {
+        emit errorOccurred("Benchmark executable crashed");
+        return;
+    }
+
+    QString error;
+    m_run.results = m_framework == GoogleBenchmark ? parseGoogleBenchmarkJson(m_stdout, &error)
+                                                   : parseCatch2Xml(m_stdout, &error);
+    if (m_run.results.isEmpty()) {
+        emit errorOccurred(error.isEmpty() ? QString("No benchmark results (exit code %1)").arg(exitCode)
+                                           : "Could not parse benchmark output: " + error);
+        return;
+    }
+
+    emit runFinished(m_run);
+}
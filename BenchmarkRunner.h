@@ -0,0 +1,78 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QVector>
+#include <QDateTime>
+#include <QJsonObject>
+
+struct BenchmarkResult
+{
+    QString name;
+    int repetitions = 0;
+    // Times per iteration in nanoseconds; samples are empty when only aggregates are known
+    double mean = 0;
+    double median = 0;
+    double stddev = 0;
+    QVector<double> samples;
+
+    QJsonObject toJson() const;
+    static BenchmarkResult fromJson(const QJsonObject &object);
+    static BenchmarkResult fromSamples(const QString &name, const QVector<double> &samples);
+};
+
+struct BenchmarkRun
+{
+    QString commit;       // git HEAD of the project, empty outside a repository
+    bool dirty = false;   // uncommitted changes were present
+    QDateTime timestamp;
+    QString executable;
+    QVector<BenchmarkResult> results;
+
+    QString label() const;
+    QJsonObject toJson() const;
+    static BenchmarkRun fromJson(const QJsonObject &object);
+};
+
+// Runs a Google Benchmark or Catch2 executable with machine-readable output and
+// turns it into a BenchmarkRun tagged with the project's current commit.
+class BenchmarkRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Framework {
+        Unknown,
+        GoogleBenchmark,
+        Catch2
+    };
+
+    explicit BenchmarkRunner(QObject *parent = nullptr);
+
+    static Framework detectFramework(const QString &executable);
+    static QVector<BenchmarkResult> parseGoogleBenchmarkJson(const QByteArray &json, QString *error = nullptr);
+    static QVector<BenchmarkResult> parseCatch2Xml(const QByteArray &xml, QString *error = nullptr);
+    static void currentCommit(const QString &projectPath, QString *commit, bool *dirty);
+
+    bool start(const QString &executable, const QStringList &arguments, const QString &workingDirectory,
+               const QProcessEnvironment &environment, const QString &projectPath, int repetitions);
+    void stop();
+    bool isRunning() const;
+
+signals:
+    void output(const QString &text);
+    void runFinished(const BenchmarkRun &run);
+    void errorOccurred(const QString &message);
+
+private slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    QProcess *m_process;
+    Framework m_framework;
+    QByteArray m_stdout;
+    BenchmarkRun m_run;
+};
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,117 @@
+#include "BenchmarkView.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFileInfo>
+
+BenchmarkView::BenchmarkView(QWidget *parent)
+    : QWidget(parent)
+    , m_history(nullptr)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    auto *header = new QHBoxLayout;
+    m_summaryLabel = new QLabel("No benchmark runs");
+    m_summaryLabel->setStyleSheet("color: white;");
+    header->addWidget(m_summaryLabel, 1);
+    auto *baselineLabel = new QLabel("Baseline:");
+    baselineLabel->setStyleSheet("color: white;");
+    header->addWidget(baselineLabel);
+    m_baselineCombo = new QComboBox;
+    m_baselineCombo->setMinimumWidth(220);
+    header->addWidget(m_baselineCombo);
+    layout->addLayout(header);
+
+    m_results = new QTableWidget(0, 6);
+    m_results->setHorizontalHeaderLabels({"Benchmark", "Baseline", "Current", "Change", "p-value", "Verdict"});
+    m_results->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_results->verticalHeader()->hide();
+    m_results->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_results->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(m_results, 1);
+
+    connect(m_baselineCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &BenchmarkView::showComparison);
+}
+
+void BenchmarkView::setHistory(const BenchmarkHistory *history)
+{
+    m_history = history;
+    refresh();
+}
+
+void BenchmarkView::refresh()
+{
+    // Keep the chosen baseline across new runs; default to the run before the latest
+    const int previous = m_baselineCombo->currentData().isValid() ? m_baselineCombo->currentData().toInt() : -1;
+
+    m_baselineCombo->blockSignals(true);
+    m_baselineCombo->clear();
+    const int runCount = m_history ? m_history->runs().size() : 0;
+    for (int i = runCount - 2; i >= 0; --i) {
+        m_baselineCombo->addItem(m_history->runs().at(i).label(), i);
+    }
+    int index = m_baselineCombo->findData(previous);
+    m_baselineCombo->setCurrentIndex(index >= 0 ? index : 0);
+    m_baselineCombo->blockSignals(false);
+
+    showComparison();
+}
+
+void BenchmarkView::showComparison()
+{
+    m_results->setRowCount(0);
+    if (!m_history || m_history->runs().isEmpty()) {
+        m_summaryLabel->setText("No benchmark runs");
+        return;
+    }
+
+    const BenchmarkRun &current = m_history->runs().last();
+    const QVariant baselineIndex = m_baselineCombo->currentData();
+    const BenchmarkRun baseline = baselineIndex.isValid() ? m_history->runs().at(baselineIndex.toInt()) : BenchmarkRun();
+    const QVector<BenchmarkComparison> comparisons = BenchmarkHistory::compare(baseline, current);
+
+    int regressions = 0;
+    m_results->setRowCount(comparisons.size());
+    for (int row = 0; row < comparisons.size(); ++row) {
+        const BenchmarkComparison &comparison = comparisons.at(row);
+        const bool hasBaseline = comparison.verdict != BenchmarkComparison::Added;
+
+        auto *name = new QTableWidgetItem(comparison.name);
+        auto *baselineItem = new QTableWidgetItem(hasBaseline ? BenchmarkHistory::formatDuration(comparison.baseline.median) : QString());
+        baselineItem->setToolTip(QString("stddev %1, %2 repetitions")
+                                     .arg(BenchmarkHistory::formatDuration(comparison.baseline.stddev))
+                                     .arg(comparison.baseline.repetitions));
+        auto *currentItem = new QTableWidgetItem(BenchmarkHistory::formatDuration(comparison.current.median));
+        currentItem->setToolTip(QString("stddev %1, %2 repetitions")
+                                    .arg(BenchmarkHistory::formatDuration(comparison.current.stddev))
+                                    .arg(comparison.current.repetitions));
+        auto *change = new QTableWidgetItem(hasBaseline ? QString("%1%2%").arg(comparison.changePercent > 0 ? "+" : "")
+                                                              .arg(comparison.changePercent, 0, 'f', 1)
+                                                        : QString());
+        auto *pValue = new QTableWidgetItem(hasBaseline ? QString::number(comparison.pValue, 'g', 3) : QString());
+        auto *verdict = new QTableWidgetItem(BenchmarkHistory::verdictText(comparison.verdict));
+
+        if (comparison.verdict == BenchmarkComparison::Regressed) {
+            verdict->setForeground(QColor(255, 100, 100));
+            change->setForeground(QColor(255, 100, 100));
+            ++regressions;
+        } else if (comparison.verdict == BenchmarkComparison::Improved) {
+            verdict->setForeground(QColor(100, 220, 100));
+            change->setForeground(QColor(100, 220, 100));
+        }
+
+        m_results->setItem(row, 0, name);
+        m_results->setItem(row, 1, baselineItem);
+        m_results->setItem(row, 2, currentItem);
+        m_results->setItem(row, 3, change);
+        m_results->setItem(row, 4, pValue);
+        m_results->setItem(row, 5, verdict);
+    }
+
+    m_summaryLabel->setText(QString("%1 %2: %3 benchmarks, %4 regressions")
+                                .arg(QFileInfo(current.executable).fileName(), current.label())
+                                .arg(comparisons.size())
+                                .arg(regressions));
+}
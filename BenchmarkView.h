@@ -0,0 +1,31 @@
+#ifndef BENCHMARKVIEW_H
+#define BENCHMARKVIEW_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QComboBox>
+#include <QLabel>
+#include "BenchmarkHistory.h"
+
+// Compares the latest benchmark run against a baseline picked from the history
+class BenchmarkView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BenchmarkView(QWidget *parent = nullptr);
+
+    void setHistory(const BenchmarkHistory *history);
+    void refresh();
+
+private slots:
+    void showComparison();
+
+private:
+    const BenchmarkHistory *m_history;
+    QLabel *m_summaryLabel;
+    QComboBox *m_baselineCombo;
+    QTableWidget *m_results;
+};
+
+#endif // BENCHMARKVIEW_H
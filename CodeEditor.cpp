@@ -1,4 +1,7 @@
 #include "CodeEditor.h"
+#include "Instrumentation.h"
+#include "Minimap.h"
+#include "CodeStructure.h"
 #include <QPainter>
 #include <QTextBlock>
 #include <QScrollBar>
@@ -6,6 +9,128 @@
 #include <QStringListModel>
 #include <QKeyEvent>
 #include <QAbstractItemView>
+#include <QAbstractTextDocumentLayout>
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QTextLayout>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+
+// Rainbow colors for the brackets by nesting depth
+const QColor kBracketColors[] = {QColor(255, 215, 0), QColor(218, 112, 214), QColor(23, 159, 255)};
+// A minified line can hold far more brackets than fit on screen
+constexpr int kMaxColoredBrackets = 4000;
+
+bool isOpeningBracket(QChar c)
+{
+    return c == u'(' || c == u'[' || c == u'{';
+}
+
+bool bracketsPair(QChar open, QChar close)
+{
+    return (open == u'(' && close == u')') || (open == u'[' && close == u']')
+           || (open == u'{' && close == u'}');
+}
+
+QTextEdit::ExtraSelection characterSelection(QTextDocument *document, int position,
+                                             const QTextCharFormat &format)
+{
+    QTextEdit::ExtraSelection selection;
+    selection.format = format;
+    selection.cursor = QTextCursor(document);
+    selection.cursor.setPosition(position);
+    selection.cursor.setPosition(position + 1, QTextCursor::KeepAnchor);
+    return selection;
+}
+
+// Brackets outside comments, strings and character literals, and the conditional a
+// preprocessor line opens or closes. inComment is the /* */ state the line starts in.
+void lexNesting(const QString &text, bool inComment, QVector<CodeBlockData::Bracket> *brackets,
+                BlockNesting *nesting)
+{
+    const int size = text.size();
+    int i = 0;
+    while (i < size && text.at(i).isSpace()) {
+        ++i;
+    }
+    if (!inComment && i < size && text.at(i) == u'#') {
+        // Brackets in directives, a #define body for one, do not nest with the code around them
+        ++i;
+        while (i < size && text.at(i).isSpace()) {
+            ++i;
+        }
+        int end = i;
+        while (end < size && text.at(end).isLetter()) {
+            ++end;
+        }
+        const QStringView directive = QStringView(text).mid(i, end - i);
+        if (directive == u"if" || directive == u"ifdef" || directive == u"ifndef") {
+            nesting->conditionals.open = 1;
+        } else if (directive == u"elif" || directive == u"else" || directive == u"elifdef"
+                   || directive == u"elifndef") {
+            nesting->conditionals = {1, 1};
+        } else if (directive == u"endif") {
+            nesting->conditionals.close = 1;
+        }
+        return;
+    }
+
+    NestingBalance &balance = nesting->brackets;
+    while (i < size) {
+        const QChar c = text.at(i);
+        if (inComment) {
+            if (c == u'*' && i + 1 < size && text.at(i + 1) == u'/') {
+                inComment = false;
+                ++i;
+            }
+            ++i;
+            continue;
+        }
+        switch (c.unicode()) {
+        case u'/':
+            if (i + 1 < size && text.at(i + 1) == u'/') {
+                return;
+            }
+            if (i + 1 < size && text.at(i + 1) == u'*') {
+                inComment = true;
+                ++i;
+            }
+            break;
+        case u'"':
+        case u'\'': {
+            ++i;
+            while (i < size && text.at(i) != c) {
+                i += text.at(i) == u'\\' ? 2 : 1;
+            }
+            break;
+        }
+        case u'(':
+        case u'[':
+        case u'{':
+            brackets->append({i, c});
+            ++balance.open;
+            break;
+        case u')':
+        case u']':
+        case u'}':
+            brackets->append({i, c});
+            if (balance.open > 0) {
+                --balance.open;
+            } else {
+                ++balance.close;
+            }
+            break;
+        default:
+            break;
+        }
+        ++i;
+    }
+}
+
+} // namespace
 
 CppHighlighter::CppHighlighter(QTextDocument *parent)
     : QSyntaxHighlighter(parent)
@@ -82,6 +207,7 @@ CppHighlighter::CppHighlighter(QTextDocument *parent)
 
 void CppHighlighter::highlightBlock(const QString &text)
 {
+    InstrumentationScope scope("CppHighlighter::highlightBlock");
     foreach (const HighlightingRule &rule, highlightingRules) {
         QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
         while (matchIterator.hasNext()) {
@@ -112,18 +238,53 @@ void CppHighlighter::highlightBlock(const QString &text)
         setFormat(startIndex, commentLength, xmlCommentFormat);
         startIndex = text.indexOf(startExpression, startIndex + commentLength);
     }
+
+    // Brackets and conditionals for folding; only blocks that have some carry the data
+    QVector<CodeBlockData::Bracket> brackets;
+    BlockNesting nesting;
+    lexNesting(text, previousBlockState() == 1, &brackets, &nesting);
+    auto *data = static_cast<CodeBlockData *>(currentBlockUserData());
+    const BlockNesting previous = data ? data->nesting : BlockNesting();
+    if (!data && (!brackets.isEmpty() || nesting != BlockNesting())) {
+        data = new CodeBlockData;
+        setCurrentBlockUserData(data);
+    }
+    if (data) {
+        data->brackets = std::move(brackets);
+        data->nesting = nesting;
+    }
+    if (nesting != previous) {
+        emit nestingChanged(currentBlock().blockNumber());
+    }
+    emit blockHighlighted(currentBlock().blockNumber());
 }
 
-CodeEditor::CodeEditor(QWidget *parent) : QPlainTextEdit(parent)
+CodeEditor::CodeEditor(QWidget *parent)
+    : QPlainTextEdit(parent)
+    , executionLine(0)
+    , bracketColorsFirst(-1)
+    , bracketColorsHeight(-1)
+    , bracketColorsStale(true)
+    , applyingCursors(false)
+    , columnSelecting(false)
+    , columnBlock(0)
+    , columnX(0)
 {
     lineNumberArea = new LineNumberArea(this);
+    structure = new CodeStructure(document());
     highlighter = new CppHighlighter(document());
+    minimap = new Minimap(this);
+    connect(highlighter, &CppHighlighter::nestingChanged, structure, &CodeStructure::blockChanged);
+    connect(highlighter, &CppHighlighter::blockHighlighted, minimap, &Minimap::blockChanged);
+    // After the highlighter, so the edited blocks are lexed again by the time this runs
+    connect(document(), &QTextDocument::contentsChange, this, &CodeEditor::onContentsChange);
 
     // Setup auto-completion
     setupCompleter();
 
     connect(this, &CodeEditor::blockCountChanged, this, &CodeEditor::updateLineNumberAreaWidth);
     connect(this, &CodeEditor::updateRequest, this, &CodeEditor::updateLineNumberArea);
+    connect(this, &CodeEditor::cursorPositionChanged, this, &CodeEditor::revealCursorBlock);
     connect(this, &CodeEditor::cursorPositionChanged, this, &CodeEditor::highlightCurrentLine);
 
     updateLineNumberAreaWidth(0);
@@ -175,6 +336,7 @@ void CodeEditor::setupCompleter()
 
 void CodeEditor::keyPressEvent(QKeyEvent *e)
 {
+    InstrumentationScope scope("CodeEditor::keyPressEvent");
     if (completer && completer->popup()->isVisible()) {
         switch (e->key()) {
         case Qt::Key_Enter:
@@ -189,6 +351,10 @@ void CodeEditor::keyPressEvent(QKeyEvent *e)
         }
     }
 
+    if (multiCursorKeyPress(e)) {
+        return;
+    }
+
     // Auto-indentation
     if (e->key() == Qt::Key_Return || e->key() == Qt::Key_Enter) {
         QTextCursor cursor = textCursor();
@@ -290,13 +456,257 @@ int CodeEditor::lineNumberAreaWidth()
         ++digits;
     }
 
-    int space = 3 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
-    return space;
+    return GutterRenderer::width(fontMetrics(), digits);
+}
+
+void CodeEditor::goToLine(int line)
+{
+    QTextBlock block = document()->findBlockByNumber(qMax(0, line - 1));
+    if (!block.isValid()) {
+        return;
+    }
+    
+    QTextCursor cursor(block);
+    setTextCursor(cursor);
+    centerCursor();
+    setFocus();
+}
+
+void CodeEditor::setBreakpoints(const QSet<int> &lines)
+{
+    breakpointLines = lines;
+    updateGutterRows();
+}
+
+void CodeEditor::toggleBreakpoint(int line)
+{
+    bool enabled = !breakpointLines.contains(line);
+    if (enabled) {
+        breakpointLines.insert(line);
+    } else {
+        breakpointLines.remove(line);
+    }
+    updateGutterRows();
+    emit breakpointToggled(line, enabled);
+}
+
+void CodeEditor::setExecutionLine(int line)
+{
+    executionLine = line;
+    updateGutterRows();
+    highlightCurrentLine();
+}
+
+void CodeEditor::setLineMarks(quint16 kinds, const QHash<int, quint16> &marks)
+{
+    for (auto it = lineMarks.begin(); it != lineMarks.end();) {
+        it.value() &= ~kinds;
+        it = it.value() ? std::next(it) : lineMarks.erase(it);
+    }
+    for (auto it = marks.cbegin(); it != marks.cend(); ++it) {
+        if (it.value() & kinds) {
+            lineMarks[it.key()] |= it.value() & kinds;
+        }
+    }
+    updateGutterRows();
+    minimap->setMarks(lineMarks);
+}
+
+void CodeEditor::lineNumberAreaMousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        return;
+    }
+
+    const QPoint pos = event->position().toPoint();
+    QTextBlock block = cursorForPosition(QPoint(0, pos.y())).block();
+    if (!block.isValid()) {
+        return;
+    }
+    const int foldLeft = GutterRenderer::foldLaneLeft(fontMetrics(), lineNumberArea->width());
+    if (pos.x() >= foldLeft && pos.x() < foldLeft + GutterRenderer::foldLaneWidth(fontMetrics())) {
+        const int blockNumber = block.blockNumber();
+        if (isFolded(blockNumber) || isFoldable(blockNumber)) {
+            setFolded(blockNumber, !isFolded(blockNumber));
+        }
+        return;
+    }
+    toggleBreakpoint(block.blockNumber() + 1);
+}
+
+bool CodeEditor::isFoldable(int blockNumber)
+{
+    return structure->regionEnd(blockNumber) - blockNumber >= 2;
+}
+
+bool CodeEditor::isFolded(int blockNumber) const
+{
+    const CodeBlockData *data = CodeBlockData::of(document()->findBlockByNumber(blockNumber));
+    return data && data->folded;
+}
+
+void CodeEditor::setFolded(int blockNumber, bool folded)
+{
+    InstrumentationScope scope("CodeEditor::setFolded");
+    QTextBlock start = document()->findBlockByNumber(blockNumber);
+    const int end = structure->regionEnd(blockNumber);
+    auto *data = static_cast<CodeBlockData *>(start.userData());
+    if (!data || data->folded == folded || (folded && end - blockNumber < 2)) {
+        return;
+    }
+
+    const int cursorBlock = textCursor().blockNumber();
+    if (folded && cursorBlock > blockNumber && cursorBlock < end) {
+        QTextCursor cursor(start);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        setTextCursor(cursor);
+    }
+
+    // Regions folded inside this one stay folded when it opens
+    data->folded = folded;
+    QTextBlock block = start.next();
+    int number = blockNumber + 1;
+    while (block.isValid() && number < end) {
+        block.setVisible(!folded);
+        const CodeBlockData *inner = CodeBlockData::of(block);
+        const int innerEnd = !folded && inner && inner->folded ? structure->regionEnd(number) : -1;
+        if (innerEnd > number) {
+            block = document()->findBlockByNumber(innerEnd);
+            number = innerEnd;
+        } else {
+            block = block.next();
+            ++number;
+        }
+    }
+
+    // Only the region is laid out again, and hidden blocks are not laid out at all
+    const int last = block.isValid() ? block.position() : document()->characterCount();
+    document()->markContentsDirty(start.position(), last - start.position());
+    bracketColorsStale = true;
+    updateGutterRows();
+}
+
+void CodeEditor::foldAtCursor(bool folded)
+{
+    const int cursorBlock = textCursor().blockNumber();
+    if (!folded) {
+        setFolded(cursorBlock, false);
+        return;
+    }
+    int start = cursorBlock;
+    while (start >= 0 && (isFolded(start) || !isFoldable(start))) {
+        start = structure->enclosingRegionStart(start);
+    }
+    if (start >= 0) {
+        setFolded(start, true);
+    }
+}
+
+void CodeEditor::unfoldAll()
+{
+    int first = -1;
+    int last = -1;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        if (auto *data = static_cast<CodeBlockData *>(block.userData())) {
+            data->folded = false;
+        }
+        if (!block.isVisible()) {
+            block.setVisible(true);
+            if (first < 0) {
+                first = block.position();
+            }
+            last = block.position() + block.length();
+        }
+    }
+    if (first >= 0) {
+        document()->markContentsDirty(first, last - first);
+    }
+    bracketColorsStale = true;
+    updateGutterRows();
+}
+
+void CodeEditor::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    bracketColorsStale = true;
+
+    // Loading a file or clearing the editor replaces the whole text; cursors in it mean nothing
+    // afterwards
+    if (!applyingCursors && position == 0 && charsAdded >= document()->characterCount() - 1) {
+        extraCursors.clear();
+    }
+
+    // Edits made through the primary cursor alone, undo and reloads move the other cursors the
+    // way the document moves a QTextCursor
+    if (!applyingCursors && !extraCursors.isEmpty()) {
+        auto map = [&](int p) {
+            return p < position ? p : (p >= position + charsRemoved ? p + charsAdded - charsRemoved : position);
+        };
+        for (CursorRange &range : extraCursors) {
+            range = {map(range.anchor), map(range.position)};
+        }
+        int none = -1;
+        mergeCursorRanges(&extraCursors, &none);
+    }
+
+    // An edit can take away the bracket a folded region started with; its lines are shown
+    // again rather than staying hidden with nothing to unfold them
+    QTextBlock block = document()->findBlock(position);
+    const QTextBlock last = document()->findBlock(position + charsAdded);
+    for (; block.isValid(); block = block.next()) {
+        auto *data = static_cast<CodeBlockData *>(block.userData());
+        if (data && data->folded && !isFoldable(block.blockNumber())) {
+            data->folded = false;
+            showHiddenRun(block.next());
+        }
+        if (block == last) {
+            break;
+        }
+    }
+}
+
+void CodeEditor::revealCursorBlock()
+{
+    revealBlock(textCursor().block());
+}
+
+void CodeEditor::revealBlock(const QTextBlock &block)
+{
+    // Hidden blocks always follow the folded block that hides them
+    while (block.isValid() && !block.isVisible()) {
+        QTextBlock start = block.previous();
+        while (start.isValid() && !start.isVisible()) {
+            start = start.previous();
+        }
+        const CodeBlockData *data = CodeBlockData::of(start);
+        if (data && data->folded && isFoldable(start.blockNumber())) {
+            setFolded(start.blockNumber(), false);
+        } else {
+            showHiddenRun(start.isValid() ? start.next() : document()->begin());
+        }
+    }
+}
+
+void CodeEditor::showHiddenRun(QTextBlock block)
+{
+    const int first = block.position();
+    int last = first;
+    for (; block.isValid() && !block.isVisible(); block = block.next()) {
+        block.setVisible(true);
+        if (auto *data = static_cast<CodeBlockData *>(block.userData())) {
+            data->folded = false;
+        }
+        last = block.position() + block.length();
+    }
+    if (last > first) {
+        document()->markContentsDirty(first, last - first);
+        bracketColorsStale = true;
+        updateGutterRows();
+    }
 }
 
 void CodeEditor::updateLineNumberAreaWidth(int /* newBlockCount */)
 {
-    setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+    setViewportMargins(lineNumberAreaWidth(), 0, Minimap::kWidth, 0);
 }
 
 void CodeEditor::updateLineNumberArea(const QRect &rect, int dy)
@@ -304,7 +714,9 @@ void CodeEditor::updateLineNumberArea(const QRect &rect, int dy)
     if (dy)
         lineNumberArea->scroll(0, dy);
     else
-        lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
+        updateGutterRows();
+    if (updateBracketColors())
+        highlightCurrentLine();
 
     if (rect.contains(viewport()->rect()))
         updateLineNumberAreaWidth(0);
@@ -316,6 +728,7 @@ void CodeEditor::resizeEvent(QResizeEvent *e)
 
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    minimap->setGeometry(QRect(viewport()->geometry().right() + 1, cr.top(), Minimap::kWidth, cr.height()));
 }
 
 void CodeEditor::highlightCurrentLine()
@@ -334,30 +747,690 @@ void CodeEditor::highlightCurrentLine()
         extraSelections.append(selection);
     }
 
+    if (executionLine > 0) {
+        QTextBlock block = document()->findBlockByNumber(executionLine - 1);
+        if (block.isValid()) {
+            QTextEdit::ExtraSelection selection;
+            selection.format.setBackground(QColor(255, 220, 0, 50));
+            selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+            selection.cursor = QTextCursor(block);
+            extraSelections.append(selection);
+        }
+    }
+
+    // The bracket next to the cursor and its match; a bracket without one is shown as an error
+    bool before = false;
+    const QTextCursor cursor = textCursor();
+    const int index = cursor.hasSelection() ? -1 : bracketAtCursor(cursor, &before);
+    if (index >= 0) {
+        const QTextBlock block = cursor.block();
+        const CodeBlockData::Bracket bracket = CodeBlockData::of(block)->brackets.at(index);
+        const int match = matchingBracket(block, index);
+        const QChar other = match >= 0 ? document()->characterAt(match) : QChar();
+        const bool matched = isOpeningBracket(bracket.character) ? bracketsPair(bracket.character, other)
+                                                                 : bracketsPair(other, bracket.character);
+        QTextCharFormat format;
+        format.setBackground(matched ? QColor(255, 140, 0, 90) : QColor(240, 70, 70, 120));
+        extraSelections.append(characterSelection(document(), block.position() + bracket.position, format));
+        if (match >= 0) {
+            extraSelections.append(characterSelection(document(), match, format));
+        }
+    }
+
+    updateBracketColors();
+    extraSelections += bracketColors;
     setExtraSelections(extraSelections);
 }
 
-void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
+int CodeEditor::bracketAtCursor(const QTextCursor &cursor, bool *before) const
 {
-    QPainter painter(lineNumberArea);
-    painter.fillRect(event->rect(), QColor(40, 40, 40, 180));
+    // The bracket just before the cursor wins over the one just after it
+    const CodeBlockData *data = CodeBlockData::of(cursor.block());
+    if (!data) {
+        return -1;
+    }
+    const QVector<CodeBlockData::Bracket> &brackets = data->brackets;
+    const int column = cursor.positionInBlock();
+    const auto it = std::lower_bound(brackets.cbegin(), brackets.cend(), column - 1,
+                                     [](const CodeBlockData::Bracket &bracket, int position) {
+                                         return bracket.position < position;
+                                     });
+    const int index = int(it - brackets.cbegin());
+    if (index < brackets.size() && brackets.at(index).position == column - 1) {
+        *before = true;
+        return index;
+    }
+    if (index < brackets.size() && brackets.at(index).position == column) {
+        *before = false;
+        return index;
+    }
+    return -1;
+}
+
+int CodeEditor::matchingBracket(const QTextBlock &block, int index)
+{
+    // Within the block first; otherwise the structure finds the block holding the match in
+    // O(log n), and only that block's brackets are read
+    InstrumentationScope scope("CodeEditor::matchingBracket");
+    const QVector<CodeBlockData::Bracket> &brackets = CodeBlockData::of(block)->brackets;
+    int depth = 0;
+    if (isOpeningBracket(brackets.at(index).character)) {
+        for (int i = index + 1; i < brackets.size(); ++i) {
+            if (isOpeningBracket(brackets.at(i).character)) {
+                ++depth;
+            } else if (depth-- == 0) {
+                return block.position() + brackets.at(i).position;
+            }
+        }
+        // Brackets opened after this one are closed first
+        int need = depth + 1;
+        const QTextBlock target = document()->findBlockByNumber(structure->closingBlock(block.blockNumber(), &need));
+        const CodeBlockData *data = CodeBlockData::of(target);
+        if (!data) {
+            return -1;
+        }
+        int inner = 0;
+        for (const CodeBlockData::Bracket &bracket : data->brackets) {
+            if (isOpeningBracket(bracket.character)) {
+                ++inner;
+            } else if (inner > 0) {
+                --inner;
+            } else if (--need == 0) {
+                return target.position() + bracket.position;
+            }
+        }
+        return -1;
+    }
+
+    for (int i = index - 1; i >= 0; --i) {
+        if (!isOpeningBracket(brackets.at(i).character)) {
+            ++depth;
+        } else if (depth-- == 0) {
+            return block.position() + brackets.at(i).position;
+        }
+    }
+    int need = depth + 1;
+    const QTextBlock target = document()->findBlockByNumber(structure->openingBlock(block.blockNumber(), &need));
+    const CodeBlockData *data = CodeBlockData::of(target);
+    if (!data) {
+        return -1;
+    }
+    int inner = 0;
+    for (int i = data->brackets.size() - 1; i >= 0; --i) {
+        const CodeBlockData::Bracket &bracket = data->brackets.at(i);
+        if (!isOpeningBracket(bracket.character)) {
+            ++inner;
+        } else if (inner > 0) {
+            --inner;
+        } else if (--need == 0) {
+            return target.position() + bracket.position;
+        }
+    }
+    return -1;
+}
+
+void CodeEditor::jumpToMatchingBracket()
+{
+    QTextCursor cursor = textCursor();
+    bool before = false;
+    const int index = bracketAtCursor(cursor, &before);
+    const int match = index >= 0 ? matchingBracket(cursor.block(), index) : -1;
+    if (match < 0) {
+        return;
+    }
+    // From after a bracket to after its match, so jumping again comes back
+    cursor.setPosition(before ? match + 1 : match);
+    setTextCursor(cursor);
+}
+
+bool CodeEditor::updateBracketColors()
+{
+    // The depth in front of the first line on screen comes from the structure, so only the
+    // brackets on screen are read; nothing is done until the view scrolls or the text changes
+    QTextBlock block = firstVisibleBlock();
+    const int bottom = viewport()->height();
+    if (!bracketColorsStale && block.blockNumber() == bracketColorsFirst && bottom == bracketColorsHeight) {
+        return false;
+    }
+    InstrumentationScope scope("CodeEditor::updateBracketColors");
+    bracketColorsStale = false;
+    bracketColorsFirst = block.blockNumber();
+    bracketColorsHeight = bottom;
+    bracketColors.clear();
+
+    QTextCharFormat format;
+    int depth = structure->depthAt(block.blockNumber());
+    qreal top = blockBoundingGeometry(block).translated(contentOffset()).top();
+    while (block.isValid() && top <= bottom && bracketColors.size() < kMaxColoredBrackets) {
+        const CodeBlockData *data = CodeBlockData::of(block);
+        if (data) {
+            for (const CodeBlockData::Bracket &bracket : data->brackets) {
+                const bool opening = isOpeningBracket(bracket.character);
+                if (!opening && depth > 0) {
+                    --depth;
+                }
+                format.setForeground(kBracketColors[depth % int(std::size(kBracketColors))]);
+                bracketColors.append(characterSelection(document(), block.position() + bracket.position, format));
+                if (opening) {
+                    ++depth;
+                }
+            }
+        }
+        top += blockBoundingRect(block).height();
+
+        const int end = data && data->folded && block.isVisible() ? structure->regionEnd(block.blockNumber()) : -1;
+        if (end > block.blockNumber()) {
+            block = document()->findBlockByNumber(end);
+            depth = structure->depthAt(end);
+        } else {
+            block = block.next();
+        }
+    }
+    return true;
+}
+
+quint16 CodeEditor::gutterMarks(const QTextBlock &block, int line)
+{
+    quint16 marks = lineMarks.isEmpty() ? 0 : lineMarks.value(line);
+    if (breakpointLines.contains(line)) {
+        marks |= GutterRenderer::Breakpoint;
+    }
+    if (executionLine == line) {
+        marks |= GutterRenderer::ExecutionLine;
+    }
+    if (const CodeBlockData *data = CodeBlockData::of(block)) {
+        if (data->folded) {
+            marks |= GutterRenderer::Folded;
+        } else if (data->nesting.opensRegion() && isFoldable(line - 1)) {
+            marks |= GutterRenderer::FoldStart;
+        }
+    }
+    return marks;
+}
 
+void CodeEditor::layoutGutterRows(QVector<GutterRenderer::Row> *rows)
+{
+    rows->clear();
     QTextBlock block = firstVisibleBlock();
-    int blockNumber = block.blockNumber();
+    int line = block.blockNumber() + 1;
     int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
-    int bottom = top + qRound(blockBoundingRect(block).height());
+    const int bottom = lineNumberArea->height();
+
+    while (block.isValid() && top <= bottom) {
+        const int height = qRound(blockBoundingRect(block).height());
+        if (block.isVisible()) {
+            rows->append({line, top, height, gutterMarks(block, line)});
+        }
+        top += height;
+
+        // A folded region is stepped over at once rather than block by block
+        const CodeBlockData *data = CodeBlockData::of(block);
+        const int end = data && data->folded && block.isVisible() ? structure->regionEnd(line - 1) : -1;
+        if (end > line) {
+            block = document()->findBlockByNumber(end);
+            line = end + 1;
+        } else {
+            block = block.next();
+            ++line;
+        }
+    }
+}
+
+void CodeEditor::updateGutterRows()
+{
+    // Cursor blinks, rehighlighting and edits within a line leave every row as it was painted;
+    // only rows whose number, position or marks changed are repainted
+    layoutGutterRows(&gutterLayout);
+    const int width = lineNumberArea->width();
+    QRect dirty;
+    for (int i = 0; i < qMax(gutterLayout.size(), gutterRows.size()); ++i) {
+        const bool inLayout = i < gutterLayout.size();
+        const bool painted = i < gutterRows.size();
+        if (inLayout && painted && gutterLayout.at(i) == gutterRows.at(i)) {
+            continue;
+        }
+        if (inLayout) {
+            dirty |= QRect(0, gutterLayout.at(i).top, width, gutterLayout.at(i).height);
+        }
+        if (painted) {
+            dirty |= QRect(0, gutterRows.at(i).top, width, gutterRows.at(i).height);
+        }
+    }
+    if (!dirty.isEmpty()) {
+        lineNumberArea->update(dirty);
+    }
+}
+
+void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
+{
+    InstrumentationScope scope("CodeEditor::lineNumberAreaPaintEvent");
+    layoutGutterRows(&gutterRows);
+    QPainter painter(lineNumberArea);
+    gutter.paint(&painter, event->rect(), gutterRows, font(), lineNumberArea->devicePixelRatioF(),
+                 lineNumberArea->width());
+}
+
+bool CodeEditor::multiCursorKeyPress(QKeyEvent *e)
+{
+    Qt::KeyboardModifiers modifiers = e->modifiers();
+    modifiers.setFlag(Qt::KeypadModifier, false);
+    if (modifiers == (Qt::ControlModifier | Qt::AltModifier) && (e->key() == Qt::Key_Up || e->key() == Qt::Key_Down)) {
+        addCursorOnAdjacentLine(e->key() == Qt::Key_Up);
+        return true;
+    }
+    if (extraCursors.isEmpty()) {
+        return false;
+    }
+
+    if (e->key() == Qt::Key_Escape) {
+        clearExtraCursors();
+        return true;
+    }
+    if (e->matches(QKeySequence::Copy) || e->matches(QKeySequence::Cut)) {
+        // One line per cursor, in document order
+        int primary;
+        QStringList texts;
+        QTextCursor cursor(document());
+        for (const CursorRange &range : cursorRanges(&primary)) {
+            cursor.setPosition(range.anchor);
+            cursor.setPosition(range.position, QTextCursor::KeepAnchor);
+            texts << cursor.selectedText().replace(QChar::ParagraphSeparator, u'\n');
+        }
+        QGuiApplication::clipboard()->setText(texts.join(u'\n'));
+        if (e->matches(QKeySequence::Cut)) {
+            editAtCursors([](int, const CursorRange &range) { return Replacement{range.start(), range.end(), QString()}; });
+        }
+        return true;
+    }
+    if (e->matches(QKeySequence::Paste)) {
+        // A clipboard with a line for each cursor is spread over them, as copied above
+        QString text = QGuiApplication::clipboard()->text();
+        text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+        QStringList lines = text.split(u'\n');
+        if (lines.size() == cursorCount() + 1 && lines.last().isEmpty()) {
+            lines.removeLast();
+        }
+        const bool spread = lines.size() == cursorCount();
+        editAtCursors([&](int index, const CursorRange &range) {
+            return Replacement{range.start(), range.end(), spread ? lines.at(index) : text};
+        });
+        return true;
+    }
+
+    const bool shift = modifiers & Qt::ShiftModifier;
+    const bool control = modifiers & Qt::ControlModifier;
+    const QTextCursor::MoveMode mode = shift ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor;
+    if (modifiers & ~(Qt::ShiftModifier | Qt::ControlModifier)) {
+        return false;
+    }
+    switch (e->key()) {
+    case Qt::Key_Left:
+        moveCursors(control ? QTextCursor::WordLeft : QTextCursor::Left, mode);
+        return true;
+    case Qt::Key_Right:
+        moveCursors(control ? QTextCursor::WordRight : QTextCursor::Right, mode);
+        return true;
+    case Qt::Key_Up:
+        moveCursors(QTextCursor::Up, mode);
+        return true;
+    case Qt::Key_Down:
+        moveCursors(QTextCursor::Down, mode);
+        return true;
+    case Qt::Key_Home:
+        moveCursors(QTextCursor::StartOfLine, mode);
+        return true;
+    case Qt::Key_End:
+        moveCursors(QTextCursor::EndOfLine, mode);
+        return true;
+    case Qt::Key_Backspace:
+        editAtCursors([](int, const CursorRange &range) {
+            const int from = range.anchor != range.position ? range.start() : qMax(0, range.position - 1);
+            return Replacement{from, range.end(), QString()};
+        });
+        return true;
+    case Qt::Key_Delete: {
+        const int last = document()->characterCount() - 1;
+        editAtCursors([last](int, const CursorRange &range) {
+            const int to = range.anchor != range.position ? range.end() : qMin(last, range.position + 1);
+            return Replacement{range.start(), to, QString()};
+        });
+        return true;
+    }
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        // Each new line keeps the indentation of the one it was split from
+        editAtCursors([this](int, const CursorRange &range) {
+            const QString line = document()->findBlock(range.start()).text();
+            int indent = 0;
+            while (indent < line.size() && (line.at(indent) == u' ' || line.at(indent) == u'\t')) {
+                ++indent;
+            }
+            return Replacement{range.start(), range.end(), u'\n' + line.left(indent)};
+        });
+        return true;
+    case Qt::Key_Tab:
+        editAtCursors([](int, const CursorRange &range) { return Replacement{range.start(), range.end(), QStringLiteral("\t")}; });
+        return true;
+    default:
+        break;
+    }
+
+    const QString text = e->text();
+    if (control || text.isEmpty() || !text.at(0).isPrint()) {
+        return false;
+    }
+    editAtCursors([&text](int, const CursorRange &range) { return Replacement{range.start(), range.end(), text}; });
+    return true;
+}
+
+QVector<CodeEditor::CursorRange> CodeEditor::cursorRanges(int *primary) const
+{
+    // The primary cursor slotted in among the others
+    const QTextCursor cursor = textCursor();
+    const CursorRange main{cursor.anchor(), cursor.position()};
+    const auto it = std::lower_bound(extraCursors.cbegin(), extraCursors.cend(), main.start(),
+                                     [](const CursorRange &range, int position) { return range.start() < position; });
+    *primary = int(it - extraCursors.cbegin());
+    QVector<CursorRange> ranges;
+    ranges.reserve(extraCursors.size() + 1);
+    std::copy(extraCursors.cbegin(), it, std::back_inserter(ranges));
+    ranges.append(main);
+    std::copy(it, extraCursors.cend(), std::back_inserter(ranges));
+    // Edits the others were not part of can move them onto the primary cursor
+    mergeCursorRanges(&ranges, primary);
+    return ranges;
+}
+
+void CodeEditor::mergeCursorRanges(QVector<CursorRange> *ranges, int *primary)
+{
+    // Sorted by start; cursors that overlap, or carets in the same place, become one
+    QVector<int> order(ranges->size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [ranges](int a, int b) { return ranges->at(a).start() < ranges->at(b).start(); });
+    QVector<CursorRange> merged;
+    merged.reserve(ranges->size());
+    int mergedPrimary = -1;
+    for (int i : order) {
+        const CursorRange &range = ranges->at(i);
+        if (!merged.isEmpty() && (range.start() < merged.last().end() || range.start() == merged.last().start())) {
+            CursorRange &last = merged.last();
+            const int end = qMax(last.end(), range.end());
+            last = last.anchor <= last.position ? CursorRange{last.start(), end} : CursorRange{end, last.start()};
+        } else {
+            merged.append(range);
+        }
+        if (i == *primary) {
+            mergedPrimary = merged.size() - 1;
+        }
+    }
+    *ranges = std::move(merged);
+    *primary = mergedPrimary;
+}
+
+void CodeEditor::setCursorRanges(QVector<CursorRange> ranges, int primary)
+{
+    const int last = document()->characterCount() - 1;
+    for (CursorRange &range : ranges) {
+        range = {qBound(0, range.anchor, last), qBound(0, range.position, last)};
+    }
+    mergeCursorRanges(&ranges, &primary);
+    if (primary < 0) {
+        return;
+    }
+
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(ranges.at(primary).anchor);
+    cursor.setPosition(ranges.at(primary).position, QTextCursor::KeepAnchor);
+    ranges.remove(primary);
+    extraCursors = std::move(ranges);
+    setTextCursor(cursor);
+    viewport()->update();
+}
+
+void CodeEditor::editAtCursors(const std::function<Replacement(int index, const CursorRange &range)> &edit)
+{
+    InstrumentationScope scope("CodeEditor::editAtCursors");
+    int primary;
+    QVector<CursorRange> ranges = cursorRanges(&primary);
+    QVector<Replacement> replacements;
+    replacements.reserve(ranges.size());
+    int previousEnd = 0;
+    for (int i = 0; i < ranges.size(); ++i) {
+        Replacement replacement = edit(i, ranges.at(i));
+        replacement.from = qMax(replacement.from, previousEnd);
+        replacement.to = qMax(replacement.to, replacement.from);
+        previousEnd = replacement.to;
+        replacements.append(std::move(replacement));
+    }
+
+    // Every QTextCursor on the document is adjusted on every insert, so the cursors are kept as
+    // positions instead and the bracket colors are dropped until the edit is done. Replacing
+    // from the last cursor to the first leaves the positions still to be replaced valid, and
+    // the single edit block makes the document report one change for all of them.
+    bracketColors.clear();
+    bracketColorsStale = true;
+    setExtraSelections({});
+    applyingCursors = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    for (int i = replacements.size() - 1; i >= 0; --i) {
+        const Replacement &replacement = replacements.at(i);
+        if (replacement.from == replacement.to && replacement.text.isEmpty()) {
+            continue;
+        }
+        cursor.setPosition(replacement.from);
+        cursor.setPosition(replacement.to, QTextCursor::KeepAnchor);
+        cursor.insertText(replacement.text);
+    }
+    cursor.endEditBlock();
+    applyingCursors = false;
+
+    // Each cursor ends after its replacement, moved by what the replacements before it changed
+    int shift = 0;
+    for (int i = 0; i < replacements.size(); ++i) {
+        const Replacement &replacement = replacements.at(i);
+        const int caret = replacement.from + shift + replacement.text.size();
+        ranges[i] = {caret, caret};
+        shift += replacement.text.size() - (replacement.to - replacement.from);
+    }
+    setCursorRanges(std::move(ranges), primary);
+    highlightCurrentLine();
+}
+
+void CodeEditor::moveCursors(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode)
+{
+    int primary;
+    QVector<CursorRange> ranges = cursorRanges(&primary);
+    QTextCursor cursor(document());
+    for (CursorRange &range : ranges) {
+        cursor.setPosition(range.anchor);
+        cursor.setPosition(range.position, QTextCursor::KeepAnchor);
+        cursor.movePosition(operation, mode);
+        range = {cursor.anchor(), cursor.position()};
+    }
+    setCursorRanges(std::move(ranges), primary);
+}
+
+void CodeEditor::addCursor(int position)
+{
+    int primary;
+    QVector<CursorRange> ranges = cursorRanges(&primary);
+    ranges.append({position, position});
+    // The new cursor becomes the primary one
+    const int added = ranges.size() - 1;
+    setCursorRanges(std::move(ranges), added);
+}
+
+void CodeEditor::addCursorOnAdjacentLine(bool above)
+{
+    int primary;
+    QVector<CursorRange> ranges = cursorRanges(&primary);
+    const CursorRange &edge = above ? ranges.first() : ranges.last();
+    const QTextBlock block = document()->findBlock(edge.position);
+    QTextBlock target = above ? block.previous() : block.next();
+    while (target.isValid() && !target.isVisible()) {
+        target = above ? target.previous() : target.next();
+    }
+    if (!target.isValid()) {
+        return;
+    }
+    const int position = target.position() + qMin(edge.position - block.position(), target.length() - 1);
+    ranges.append({position, position});
+    setCursorRanges(std::move(ranges), primary);
+}
 
-    while (block.isValid() && top <= event->rect().bottom()) {
-        if (block.isVisible() && bottom >= event->rect().top()) {
-            QString number = QString::number(blockNumber + 1);
-            painter.setPen(QColor(255, 140, 0));
-            painter.drawText(0, top, lineNumberArea->width(), fontMetrics().height(),
-                           Qt::AlignRight, number);
+void CodeEditor::selectColumns(int firstBlock, int lastBlock, qreal anchorX, qreal positionX)
+{
+    // Each line maps the x positions to its own characters; lines too short for them get a
+    // cursor at their end
+    QVector<CursorRange> ranges;
+    ranges.reserve(qAbs(lastBlock - firstBlock) + 1);
+    QTextBlock block = document()->findBlockByNumber(qMin(firstBlock, lastBlock));
+    for (int number = qMin(firstBlock, lastBlock); block.isValid() && number <= qMax(firstBlock, lastBlock);
+         block = block.next(), ++number) {
+        if (block.layout()->lineCount() == 0) {
+            document()->documentLayout()->blockBoundingRect(block);
+        }
+        const QTextLine line = block.layout()->lineAt(0);
+        const int anchor = line.isValid() ? line.xToCursor(anchorX) : 0;
+        const int position = line.isValid() ? line.xToCursor(positionX) : 0;
+        ranges.append({block.position() + anchor, block.position() + position});
+    }
+    if (!ranges.isEmpty()) {
+        const int primary = lastBlock >= firstBlock ? ranges.size() - 1 : 0;
+        setCursorRanges(std::move(ranges), primary);
+    }
+}
+
+void CodeEditor::clearExtraCursors()
+{
+    if (!extraCursors.isEmpty()) {
+        extraCursors.clear();
+        viewport()->update();
+    }
+}
+
+void CodeEditor::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || !(event->modifiers() & Qt::AltModifier)) {
+        columnSelecting = false;
+        if (event->button() == Qt::LeftButton) {
+            clearExtraCursors();
+        }
+        QPlainTextEdit::mousePressEvent(event);
+        return;
+    }
+
+    // Alt+click adds a cursor, or removes the one clicked on; Alt+drag selects columns
+    const QTextCursor clicked = cursorForPosition(event->position().toPoint());
+    columnSelecting = true;
+    columnBlock = clicked.blockNumber();
+    columnX = layoutX(clicked.block(), event->position().toPoint());
+
+    int primary;
+    QVector<CursorRange> ranges = cursorRanges(&primary);
+    const int position = clicked.position();
+    const int index = int(std::find_if(ranges.cbegin(), ranges.cend(),
+                                       [position](const CursorRange &range) {
+                                           return range.anchor == position && range.position == position;
+                                       })
+                          - ranges.cbegin());
+    if (index < ranges.size() && ranges.size() > 1) {
+        ranges.remove(index);
+        setCursorRanges(std::move(ranges), qMax(0, primary >= index ? primary - 1 : primary));
+    } else {
+        addCursor(position);
+    }
+}
+
+void CodeEditor::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!columnSelecting || !(event->buttons() & Qt::LeftButton)) {
+        QPlainTextEdit::mouseMoveEvent(event);
+        return;
+    }
+    const QTextCursor cursor = cursorForPosition(event->position().toPoint());
+    const qreal x = layoutX(cursor.block(), event->position().toPoint());
+    const QTextLine line = document()->findBlockByNumber(columnBlock).layout()->lineAt(0);
+    if (cursor.blockNumber() != columnBlock || !line.isValid() || line.xToCursor(x) != line.xToCursor(columnX)) {
+        selectColumns(columnBlock, cursor.blockNumber(), columnX, x);
+    }
+}
+
+qreal CodeEditor::layoutX(const QTextBlock &block, const QPoint &pos)
+{
+    return pos.x() - blockBoundingGeometry(block).translated(contentOffset()).left();
+}
+
+void CodeEditor::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (columnSelecting) {
+        columnSelecting = false;
+        return;
+    }
+    QPlainTextEdit::mouseReleaseEvent(event);
+}
+
+void CodeEditor::paintEvent(QPaintEvent *event)
+{
+    QPlainTextEdit::paintEvent(event);
+    if (!extraCursors.isEmpty()) {
+        paintExtraCursors();
+    }
+}
+
+void CodeEditor::paintExtraCursors()
+{
+    // The cursors are sorted, so those on screen are found by binary search and only they are
+    // painted, however many there are
+    InstrumentationScope scope("CodeEditor::paintExtraCursors");
+    QPainter painter(viewport());
+    const QColor selectionColor(255, 140, 0, 100);
+    const QColor caretColor = palette().text().color();
+    const int bottom = viewport()->height();
+    auto firstEndingAfter = [this](int position) {
+        return std::lower_bound(extraCursors.cbegin(), extraCursors.cend(), position,
+                                [](const CursorRange &range, int value) { return range.end() < value; });
+    };
+
+    QTextBlock block = firstVisibleBlock();
+    auto range = firstEndingAfter(block.position());
+    while (block.isValid() && range != extraCursors.cend()) {
+        const QRectF bounds = blockBoundingGeometry(block).translated(contentOffset());
+        if (bounds.top() > bottom) {
+            break;
+        }
+        const int blockStart = block.position();
+        const int blockEnd = blockStart + block.length() - 1;   // before the separator
+        const QTextLayout *layout = block.layout();
+        for (auto it = range; block.isVisible() && it != extraCursors.cend() && it->start() <= blockEnd; ++it) {
+            const int from = qMax(it->start(), blockStart) - blockStart;
+            const int to = qMin(it->end(), blockEnd) - blockStart;
+            for (int i = 0; from < to && i < layout->lineCount(); ++i) {
+                const QTextLine line = layout->lineAt(i);
+                const int left = qMax(from, line.textStart());
+                const int right = qMin(to, line.textStart() + line.textLength());
+                if (left < right) {
+                    const qreal x = line.cursorToX(left);
+                    painter.fillRect(QRectF(bounds.left() + x, bounds.top() + line.y(),
+                                            line.cursorToX(right) - x, line.height()), selectionColor);
+                }
+            }
+            if (it->position >= blockStart && it->position <= blockEnd) {
+                const int column = it->position - blockStart;
+                const QTextLine line = layout->lineForTextPosition(column);
+                if (line.isValid()) {
+                    painter.fillRect(QRectF(bounds.left() + line.cursorToX(column), bounds.top() + line.y(),
+                                            cursorWidth(), line.height()), caretColor);
+                }
+            }
         }
 
-        block = block.next();
-        top = bottom;
-        bottom = top + qRound(blockBoundingRect(block).height());
-        ++blockNumber;
+        // A folded region is stepped over at once
+        const CodeBlockData *data = CodeBlockData::of(block);
+        const int end = data && data->folded && block.isVisible() ? structure->regionEnd(block.blockNumber()) : -1;
+        block = end > block.blockNumber() ? document()->findBlockByNumber(end) : block.next();
+        range = firstEndingAfter(block.position());
     }
 }
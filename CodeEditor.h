@@ -5,12 +5,19 @@
 #include <QObject>
 #include <QSyntaxHighlighter>
 #include <QTextDocument>
+#include <QTextBlock>
 #include <QTextCharFormat>
 #include <QRegularExpression>
 #include <QCompleter>
 #include <QKeyEvent>
+#include <QSet>
+#include <QHash>
+#include <functional>
+#include "GutterRenderer.h"
 
 class LineNumberArea;
+class Minimap;
+class CodeStructure;
 
 class CppHighlighter : public QSyntaxHighlighter
 {
@@ -19,6 +26,12 @@ class CppHighlighter : public QSyntaxHighlighter
 public:
     explicit CppHighlighter(QTextDocument *parent = nullptr);
 
+signals:
+    // The brackets or preprocessor conditionals a block leaves open or closes changed
+    void nestingChanged(int blockNumber);
+    // A block's formats were set again, including blocks a changed comment state cascaded to
+    void blockHighlighted(int blockNumber);
+
 protected:
     void highlightBlock(const QString &text) override;
 
@@ -43,25 +56,115 @@ public:
     CodeEditor(QWidget *parent = nullptr);
 
     void lineNumberAreaPaintEvent(QPaintEvent *event);
+    void lineNumberAreaMousePressEvent(QMouseEvent *event);
     int lineNumberAreaWidth();
+    void goToLine(int line);
+
+    // Breakpoints and the debugger's current line, as 1-based line numbers
+    QSet<int> breakpoints() const { return breakpointLines; }
+    void setBreakpoints(const QSet<int> &lines);
+    void toggleBreakpoint(int line);
+    void setExecutionLine(int line);
+
+    // Diagnostics, version control changes and search hits as GutterRenderer::Mark bits per
+    // 1-based line; replaces only the marks of the given kinds
+    void setLineMarks(quint16 kinds, const QHash<int, quint16> &marks);
+
+    // Folding of multi-line bracket pairs and #if/#else/#endif branches, by 0-based block
+    // number; a folded region keeps its first and last lines visible
+    bool isFoldable(int blockNumber);
+    bool isFolded(int blockNumber) const;
+    void setFolded(int blockNumber, bool folded);
+    void foldAtCursor(bool folded);
+    void unfoldAll();
+
+    // Moves the cursor to the bracket matching the one next to it, keeping its side
+    void jumpToMatchingBracket();
+
+    // Cursors edited together with textCursor(): each keystroke is applied to all of them in
+    // one edit block, so it is one undo step, one rehighlight and one relayout
+    int cursorCount() const { return extraCursors.size() + 1; }
+    void addCursor(int position);
+    // One cursor per block from firstBlock to lastBlock, selecting between two x positions in
+    // the blocks' layout, so tabs and mixed indentation still give a straight column
+    void selectColumns(int firstBlock, int lastBlock, qreal anchorX, qreal positionX);
+    void clearExtraCursors();
+
+signals:
+    void breakpointToggled(int line, bool enabled);
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *e) override;
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
 
 private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
     void highlightCurrentLine();
     void updateLineNumberArea(const QRect &rect, int dy);
     void insertCompletion(const QString &completion);
+    void revealCursorBlock();
 
 private:
+    struct CursorRange
+    {
+        int anchor;
+        int position;
+
+        int start() const { return qMin(anchor, position); }
+        int end() const { return qMax(anchor, position); }
+    };
+    struct Replacement
+    {
+        int from;
+        int to;
+        QString text;
+    };
+
     void setupCompleter();
     QString textUnderCursor() const;
+    quint16 gutterMarks(const QTextBlock &block, int line);
+    void layoutGutterRows(QVector<GutterRenderer::Row> *rows);
+    void updateGutterRows();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void revealBlock(const QTextBlock &block);
+    void showHiddenRun(QTextBlock block);
+    int bracketAtCursor(const QTextCursor &cursor, bool *before) const;
+    int matchingBracket(const QTextBlock &block, int index);
+    bool updateBracketColors();
+    bool multiCursorKeyPress(QKeyEvent *e);
+    QVector<CursorRange> cursorRanges(int *primary) const;
+    void setCursorRanges(QVector<CursorRange> ranges, int primary);
+    static void mergeCursorRanges(QVector<CursorRange> *ranges, int *primary);
+    void editAtCursors(const std::function<Replacement(int index, const CursorRange &range)> &edit);
+    void moveCursors(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode);
+    void addCursorOnAdjacentLine(bool above);
+    void paintExtraCursors();
+    qreal layoutX(const QTextBlock &block, const QPoint &pos);
 
     QWidget *lineNumberArea;
+    Minimap *minimap;
+    CodeStructure *structure;
     CppHighlighter *highlighter;
     QCompleter *completer;
+    QSet<int> breakpointLines;
+    int executionLine;
+    QHash<int, quint16> lineMarks;
+    GutterRenderer gutter;
+    QVector<GutterRenderer::Row> gutterRows;      // as last painted
+    QVector<GutterRenderer::Row> gutterLayout;    // scratch for updateGutterRows
+    QList<QTextEdit::ExtraSelection> bracketColors;   // brackets on screen, colored by depth
+    int bracketColorsFirst;
+    int bracketColorsHeight;
+    bool bracketColorsStale;
+    QVector<CursorRange> extraCursors;   // sorted, without textCursor()
+    bool applyingCursors;
+    bool columnSelecting;
+    int columnBlock;    // where an Alt+drag started
+    qreal columnX;
 };
 
 class LineNumberArea : public QWidget
@@ -81,6 +184,11 @@ protected:
         codeEditor->lineNumberAreaPaintEvent(event);
     }
 
+    void mousePressEvent(QMouseEvent *event) override
+    {
+        codeEditor->lineNumberAreaMousePressEvent(event);
+    }
+
 private:
     CodeEditor *codeEditor;
 };
@@ -0,0 +1,338 @@
+#include "CodeStructure.h"
+#include <climits>
+
+CodeStructure::CodeStructure(QTextDocument *document)
+    : QObject(document)
+    , m_document(document)
+    , m_blockCount(document->blockCount())
+    , m_root(-1)
+    , m_seed(0x9e3779b9u)
+    , m_dirtyFirst(INT_MAX)
+    , m_dirtyLast(-1)
+{
+    m_root = build(document->begin(), m_blockCount);
+    connect(document, &QTextDocument::contentsChange, this, &CodeStructure::onContentsChange);
+}
+
+void CodeStructure::blockChanged(int blockNumber)
+{
+    markDirty(blockNumber, blockNumber);
+}
+
+void CodeStructure::markDirty(int first, int last)
+{
+    m_dirtyFirst = qMin(m_dirtyFirst, first);
+    m_dirtyLast = qMax(m_dirtyLast, last);
+}
+
+void CodeStructure::onContentsChange(int position, int /* charsRemoved */, int charsAdded)
+{
+    const int blockCount = m_document->blockCount();
+    const int first = qMax(0, m_document->findBlock(position).blockNumber());
+    const QTextBlock lastBlock = m_document->findBlock(position + charsAdded);
+    const int newSpan = (lastBlock.isValid() ? lastBlock.blockNumber() : blockCount - 1) - first + 1;
+
+    // Blocks the edit replaced or split can lose their data without the highlighter noticing
+    // a change, so the span is always read again
+    if (blockCount != m_blockCount) {
+        const int delta = blockCount - m_blockCount;
+        const int oldSpan = qBound(0, newSpan - delta, m_blockCount - first);
+        m_blockCount = blockCount;
+
+        // Reports still pending were numbered before the edit
+        if (m_dirtyFirst <= m_dirtyLast) {
+            auto renumber = [&](int block) {
+                return block < first ? block : (block >= first + oldSpan ? block + delta : first);
+            };
+            m_dirtyFirst = renumber(m_dirtyFirst);
+            m_dirtyLast = renumber(m_dirtyLast);
+        }
+
+        int left, middle, right;
+        split(m_root, first, &left, &middle);
+        split(middle, oldSpan, &middle, &right);
+        release(middle);
+        m_root = merge(merge(left, build(QTextBlock(), newSpan)), right);
+    }
+    markDirty(first, first + newSpan - 1);
+}
+
+void CodeStructure::flush()
+{
+    if (m_dirtyFirst > m_dirtyLast) {
+        return;
+    }
+    const int first = qMax(0, m_dirtyFirst);
+    const int last = qMin(m_dirtyLast, m_blockCount - 1);
+    m_dirtyFirst = INT_MAX;
+    m_dirtyLast = -1;
+    if (first > last) {
+        return;
+    }
+
+    int left, middle, right;
+    split(m_root, first, &left, &middle);
+    split(middle, last - first + 1, &middle, &right);
+    release(middle);
+    m_root = merge(merge(left, build(m_document->findBlockByNumber(first), last - first + 1)), right);
+}
+
+BlockNesting CodeStructure::nesting(int blockNumber)
+{
+    flush();
+    int node = m_root;
+    int offset = 0;
+    while (node >= 0) {
+        const Node &n = m_nodes.at(node);
+        const int index = offset + size(n.left);
+        if (blockNumber < index) {
+            node = n.left;
+        } else if (blockNumber == index) {
+            return n.self;
+        } else {
+            offset = index + 1;
+            node = n.right;
+        }
+    }
+    return BlockNesting();
+}
+
+int CodeStructure::regionEnd(int blockNumber)
+{
+    const BlockNesting self = nesting(blockNumber);
+    NestingBalance BlockNesting::*kind = &BlockNesting::brackets;
+    if (self.brackets.open == 0) {
+        if (self.conditionals.open == 0) {
+            return -1;
+        }
+        kind = &BlockNesting::conditionals;
+    }
+    // All brackets the block leaves open, so the region is that of the first one
+    int need = (self.*kind).open;
+    return findClose(m_root, 0, blockNumber + 1, &need, kind);
+}
+
+int CodeStructure::enclosingRegionStart(int blockNumber)
+{
+    int need = 1;
+    return openingBlock(blockNumber, &need);
+}
+
+int CodeStructure::closingBlock(int blockNumber, int *need)
+{
+    flush();
+    return findClose(m_root, 0, blockNumber + 1, need, &BlockNesting::brackets);
+}
+
+int CodeStructure::openingBlock(int blockNumber, int *need)
+{
+    flush();
+    return findOpen(m_root, 0, blockNumber, need, &BlockNesting::brackets);
+}
+
+int CodeStructure::depthAt(int blockNumber)
+{
+    flush();
+    // Balances of everything to the left of the path down to the block
+    NestingBalance before;
+    int node = m_root;
+    int offset = 0;
+    while (node >= 0) {
+        const Node &n = m_nodes.at(node);
+        const int index = offset + size(n.left);
+        if (blockNumber <= index) {
+            node = n.left;
+        } else {
+            before = before + total(n.left).brackets + n.self.brackets;
+            offset = index + 1;
+            node = n.right;
+        }
+    }
+    return before.open;
+}
+
+int CodeStructure::findClose(int node, int offset, int from, int *need, NestingBalance BlockNesting::*kind) const
+{
+    if (node < 0) {
+        return -1;
+    }
+    const Node &n = m_nodes.at(node);
+    if (offset + n.size <= from) {
+        return -1;
+    }
+    if (offset >= from) {
+        // A subtree that closes too few only passes its opens on to the right
+        const NestingBalance &balance = n.total.*kind;
+        if (balance.close < *need) {
+            *need += balance.open - balance.close;
+            return -1;
+        }
+    }
+
+    const int found = findClose(n.left, offset, from, need, kind);
+    if (found >= 0) {
+        return found;
+    }
+    const int index = offset + size(n.left);
+    if (index >= from) {
+        const NestingBalance &balance = n.self.*kind;
+        if (balance.close >= *need) {
+            return index;
+        }
+        *need += balance.open - balance.close;
+    }
+    return findClose(n.right, index + 1, from, need, kind);
+}
+
+int CodeStructure::findOpen(int node, int offset, int before, int *need, NestingBalance BlockNesting::*kind) const
+{
+    if (node < 0 || offset >= before) {
+        return -1;
+    }
+    const Node &n = m_nodes.at(node);
+    if (offset + n.size <= before) {
+        // Mirror of findClose, walking to the left
+        const NestingBalance &balance = n.total.*kind;
+        if (balance.open < *need) {
+            *need += balance.close - balance.open;
+            return -1;
+        }
+    }
+
+    const int index = offset + size(n.left);
+    const int found = findOpen(n.right, index + 1, before, need, kind);
+    if (found >= 0) {
+        return found;
+    }
+    if (index < before) {
+        const NestingBalance &balance = n.self.*kind;
+        if (balance.open >= *need) {
+            return index;
+        }
+        *need += balance.close - balance.open;
+    }
+    return findOpen(n.left, offset, before, need, kind);
+}
+
+void CodeStructure::pull(int node)
+{
+    Node &n = m_nodes[node];
+    n.size = 1 + size(n.left) + size(n.right);
+    n.total = total(n.left) + n.self + total(n.right);
+}
+
+void CodeStructure::split(int node, int count, int *left, int *right)
+{
+    if (node < 0) {
+        *left = *right = -1;
+        return;
+    }
+    const int leftSize = size(m_nodes.at(node).left);
+    if (leftSize < count) {
+        int rest;
+        split(m_nodes.at(node).right, count - leftSize - 1, &rest, right);
+        m_nodes[node].right = rest;
+        pull(node);
+        *left = node;
+    } else {
+        int rest;
+        split(m_nodes.at(node).left, count, left, &rest);
+        m_nodes[node].left = rest;
+        pull(node);
+        *right = node;
+    }
+}
+
+int CodeStructure::merge(int left, int right)
+{
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+    if (m_nodes.at(left).priority > m_nodes.at(right).priority) {
+        const int merged = merge(m_nodes.at(left).right, right);
+        m_nodes[left].right = merged;
+        pull(left);
+        return left;
+    }
+    const int merged = merge(left, m_nodes.at(right).left);
+    m_nodes[right].left = merged;
+    pull(right);
+    return right;
+}
+
+int CodeStructure::build(const QTextBlock &first, int count)
+{
+    // Blocks arrive in order, so the treap is built in linear time on a stack holding its right
+    // spine; a node leaves the spine only once its subtree is complete
+    QVector<int> spine;
+    QTextBlock block = first;
+    for (int i = 0; i < count; ++i) {
+        Node fresh{-1, -1, 1, nextPriority(), BlockNesting(), BlockNesting()};
+        if (block.isValid()) {
+            if (const CodeBlockData *data = CodeBlockData::of(block)) {
+                fresh.self = data->nesting;
+            }
+            block = block.next();
+        }
+        fresh.total = fresh.self;
+
+        int node;
+        if (!m_free.isEmpty()) {
+            node = m_free.takeLast();
+            m_nodes[node] = fresh;
+        } else {
+            node = m_nodes.size();
+            m_nodes.append(fresh);
+        }
+
+        int child = -1;
+        while (!spine.isEmpty() && m_nodes.at(spine.last()).priority < fresh.priority) {
+            child = spine.takeLast();
+            pull(child);
+        }
+        m_nodes[node].left = child;
+        if (!spine.isEmpty()) {
+            m_nodes[spine.last()].right = node;
+        }
+        spine.append(node);
+    }
+    while (spine.size() > 1) {
+        pull(spine.takeLast());
+    }
+    if (spine.isEmpty()) {
+        return -1;
+    }
+    pull(spine.first());
+    return spine.first();
+}
+
+void CodeStructure::release(int node)
+{
+    if (node < 0) {
+        return;
+    }
+    QVector<int> pending{node};
+    while (!pending.isEmpty()) {
+        const int current = pending.takeLast();
+        const Node &n = m_nodes.at(current);
+        if (n.left >= 0) {
+            pending.append(n.left);
+        }
+        if (n.right >= 0) {
+            pending.append(n.right);
+        }
+        m_free.append(current);
+    }
+}
+
+quint32 CodeStructure::nextPriority()
+{
+    // xorshift32; the treap only needs priorities that are independent of the text
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
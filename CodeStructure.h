@@ -0,0 +1,134 @@
+#ifndef CODESTRUCTURE_H
+#define CODESTRUCTURE_H
+
+#include <QObject>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QVector>
+
+// Unmatched closing brackets at the start of a range and unmatched opening brackets at its end
+struct NestingBalance
+{
+    int close = 0;
+    int open = 0;
+
+    bool operator==(const NestingBalance &other) const { return close == other.close && open == other.open; }
+    bool operator!=(const NestingBalance &other) const { return !(*this == other); }
+};
+
+// A range followed by another one: opens of the first are closed by the second
+inline NestingBalance operator+(const NestingBalance &a, const NestingBalance &b)
+{
+    const int matched = qMin(a.open, b.close);
+    return {a.close + b.close - matched, a.open + b.open - matched};
+}
+
+struct BlockNesting
+{
+    NestingBalance brackets;       // (), [] and {} outside strings and comments
+    NestingBalance conditionals;   // #if/#ifdef/#ifndef, #elif/#else, #endif
+
+    bool operator==(const BlockNesting &other) const
+    {
+        return brackets == other.brackets && conditionals == other.conditionals;
+    }
+    bool operator!=(const BlockNesting &other) const { return !(*this == other); }
+    bool opensRegion() const { return brackets.open > 0 || conditionals.open > 0; }
+};
+
+inline BlockNesting operator+(const BlockNesting &a, const BlockNesting &b)
+{
+    return {a.brackets + b.brackets, a.conditionals + b.conditionals};
+}
+
+// What the highlighter's lexer found in a block, attached to blocks that have brackets, a
+// preprocessor conditional or a fold
+class CodeBlockData : public QTextBlockUserData
+{
+public:
+    struct Bracket
+    {
+        int position;   // in the block
+        QChar character;
+    };
+
+    QVector<Bracket> brackets;
+    BlockNesting nesting;
+    bool folded = false;   // the region this block starts is collapsed
+
+    static CodeBlockData *of(const QTextBlock &block)
+    {
+        return static_cast<CodeBlockData *>(block.userData());
+    }
+};
+
+// The nesting of every block in document order, as an implicit treap: a balanced tree keyed by
+// position whose nodes also hold the combined balance of their subtree. An edit replaces only
+// the blocks it spans and the highlighter reports blocks whose brackets changed; both are
+// applied on the next query by splitting out the affected range and rebuilding it, so updates
+// cost O(changed blocks + log n). The end of the region a block opens and the nesting in
+// front of a block are found by descending the tree in O(log n).
+class CodeStructure : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Must be created before the highlighter, so edits reach it before the blocks are lexed
+    explicit CodeStructure(QTextDocument *document);
+
+    // The highlighter lexed a block and its nesting changed
+    void blockChanged(int blockNumber);
+
+    BlockNesting nesting(int blockNumber);
+    // Block holding the bracket or #else/#endif that closes the region blockNumber opens, or -1
+    int regionEnd(int blockNumber);
+    // Innermost block before blockNumber with a bracket still open at its start, or -1
+    int enclosingRegionStart(int blockNumber);
+
+    // Block after blockNumber that closes the need-th bracket still open at its end, or -1;
+    // need is left at the unmatched closing brackets of that block up to the one that does
+    int closingBlock(int blockNumber, int *need);
+    // Mirror of closingBlock: block before blockNumber that opens the need-th bracket still
+    // unmatched at its start, counting openings of that block from its end
+    int openingBlock(int blockNumber, int *need);
+    // Brackets open at the start of the block
+    int depthAt(int blockNumber);
+
+private:
+    struct Node
+    {
+        int left;
+        int right;
+        int size;
+        quint32 priority;
+        BlockNesting self;
+        BlockNesting total;
+    };
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void flush();
+    void markDirty(int first, int last);
+
+    int size(int node) const { return node < 0 ? 0 : m_nodes.at(node).size; }
+    BlockNesting total(int node) const { return node < 0 ? BlockNesting() : m_nodes.at(node).total; }
+    void pull(int node);
+    void split(int node, int count, int *left, int *right);
+    int merge(int left, int right);
+    int build(const QTextBlock &first, int count);
+    void release(int node);
+    quint32 nextPriority();
+
+    int findClose(int node, int offset, int from, int *need, NestingBalance BlockNesting::*kind) const;
+    int findOpen(int node, int offset, int before, int *need, NestingBalance BlockNesting::*kind) const;
+
+    QTextDocument *m_document;
+    int m_blockCount;
+    QVector<Node> m_nodes;   // pool; released entries are listed in m_free
+    QVector<int> m_free;
+    int m_root;
+    quint32 m_seed;
+    int m_dirtyFirst;   // blocks to read again from their CodeBlockData
+    int m_dirtyLast;
+};
+
+#endif // CODESTRUCTURE_H
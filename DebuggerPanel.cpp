@@ -0,0 +1,246 @@
+#include "DebuggerPanel.h"
+#include <QVBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileInfo>
+
+namespace {
+// Item data roles shared by the call stack and variables trees
+const int KeyRole = Qt::UserRole;
+const int VarobjRole = Qt::UserRole + 1;
+const int ExpressionRole = Qt::UserRole + 2;
+const int RequestedRole = Qt::UserRole + 3;
+const int MoreFromRole = Qt::UserRole + 4;
+const int FileRole = Qt::UserRole + 5;
+const int LineRole = Qt::UserRole + 6;
+}
+
+DebuggerPanel::DebuggerPanel(DebuggerSession *session, QWidget *parent)
+    : QWidget(parent)
+    , m_session(session)
+    , m_frameLevel(0)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    auto *toolbar = new QToolBar;
+    m_stoppedActions << toolbar->addAction("Continue", m_session, &DebuggerSession::continueExecution);
+    m_stoppedActions << toolbar->addAction("Step Over", m_session, &DebuggerSession::stepOver);
+    m_stoppedActions << toolbar->addAction("Step Into", m_session, &DebuggerSession::stepInto);
+    m_stoppedActions << toolbar->addAction("Step Out", m_session, &DebuggerSession::stepOut);
+    m_interruptAction = toolbar->addAction("Pause", m_session, &DebuggerSession::interrupt);
+    toolbar->addAction("Stop", m_session, &DebuggerSession::stop);
+    layout->addWidget(toolbar);
+
+    m_statusLabel = new QLabel("Not debugging");
+    m_statusLabel->setStyleSheet("color: white;");
+    layout->addWidget(m_statusLabel);
+
+    auto *splitter = new QSplitter(Qt::Horizontal);
+
+    m_frames = new QTreeWidget;
+    m_frames->setHeaderLabels({"Function", "Location"});
+    m_frames->setRootIsDecorated(false);
+    m_frames->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    splitter->addWidget(m_frames);
+
+    m_variables = new QTreeWidget;
+    m_variables->setHeaderLabels({"Name", "Value", "Type"});
+    m_variables->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+    splitter->addWidget(m_variables);
+
+    layout->addWidget(splitter, 1);
+
+    connect(m_session, &DebuggerSession::running, this, &DebuggerPanel::onRunning);
+    connect(m_session, &DebuggerSession::stopped, this, &DebuggerPanel::onStopped);
+    connect(m_session, &DebuggerSession::exited, this, &DebuggerPanel::onExited);
+    connect(m_session, &DebuggerSession::framesReceived, this, &DebuggerPanel::onFramesReceived);
+    connect(m_session, &DebuggerSession::variablesReceived, this, &DebuggerPanel::onVariablesReceived);
+    connect(m_session, &DebuggerSession::childrenReceived, this, &DebuggerPanel::onChildrenReceived);
+    connect(m_frames, &QTreeWidget::itemActivated, this, &DebuggerPanel::onFrameActivated);
+    connect(m_variables, &QTreeWidget::itemExpanded, this, &DebuggerPanel::onVariableExpanded);
+    connect(m_variables, &QTreeWidget::itemActivated, this, &DebuggerPanel::onVariableActivated);
+
+    setControlsEnabled(false);
+    m_interruptAction->setEnabled(false);
+}
+
+void DebuggerPanel::setControlsEnabled(bool stopped)
+{
+    for (QAction *action : std::as_const(m_stoppedActions)) {
+        action->setEnabled(stopped);
+    }
+    m_interruptAction->setEnabled(!stopped && m_session->isActive());
+}
+
+void DebuggerPanel::onRunning()
+{
+    m_statusLabel->setText("Running...");
+    setControlsEnabled(false);
+}
+
+void DebuggerPanel::onStopped(const QString &file, int line, const QString &reason)
+{
+    m_statusLabel->setText(QString("Stopped (%1) at %2:%3").arg(reason, QFileInfo(file).fileName()).arg(line));
+    setControlsEnabled(true);
+
+    m_frameLevel = 0;
+    m_frames->clear();
+    m_variables->clear();
+    m_variableItems.clear();
+}
+
+void DebuggerPanel::onExited(int exitCode)
+{
+    m_statusLabel->setText(QString("Program exited with code %1").arg(exitCode));
+    setControlsEnabled(false);
+    m_interruptAction->setEnabled(false);
+    m_frames->clear();
+    m_variables->clear();
+    m_variableItems.clear();
+}
+
+void DebuggerPanel::onFramesReceived(int from, const QVector<DebugFrame> &frames, bool hasMore)
+{
+    // Replace the "load more" row that asked for this page
+    for (int i = m_frames->topLevelItemCount() - 1; i >= 0; --i) {
+        if (m_frames->topLevelItem(i)->data(0, MoreFromRole).isValid()) {
+            delete m_frames->takeTopLevelItem(i);
+        }
+    }
+
+    for (const DebugFrame &frame : frames) {
+        QString location = frame.file.isEmpty() ? frame.address
+                                                : QString("%1:%2").arg(QFileInfo(frame.file).fileName()).arg(frame.line);
+        auto *item = new QTreeWidgetItem({frame.function, location});
+        item->setData(0, KeyRole, frame.level);
+        item->setData(0, FileRole, frame.file);
+        item->setData(0, LineRole, frame.line);
+        item->setToolTip(1, frame.file);
+        m_frames->addTopLevelItem(item);
+    }
+
+    if (hasMore) {
+        auto *more = new QTreeWidgetItem({"Load more frames..."});
+        more->setData(0, MoreFromRole, from + frames.size());
+        more->setForeground(0, QColor(150, 150, 150));
+        m_frames->addTopLevelItem(more);
+    }
+}
+
+void DebuggerPanel::onFrameActivated(QTreeWidgetItem *item)
+{
+    QVariant more = item->data(0, MoreFromRole);
+    if (more.isValid()) {
+        m_session->fetchFrames(more.toInt());
+        item->setText(0, "Loading...");
+        return;
+    }
+
+    m_frameLevel = item->data(0, KeyRole).toInt();
+    m_variables->clear();
+    m_variableItems.clear();
+    m_session->selectFrame(m_frameLevel);
+
+    QString file = item->data(0, FileRole).toString();
+    if (!file.isEmpty()) {
+        emit openLocation(file, item->data(0, LineRole).toInt());
+    }
+}
+
+QTreeWidgetItem *DebuggerPanel::createVariableItem(const DebugVariable &variable, const QString &key)
+{
+    auto *item = new QTreeWidgetItem({variable.name, variable.value, variable.type});
+    item->setData(0, KeyRole, key);
+    item->setData(0, VarobjRole, variable.varobj);
+    item->setData(0, ExpressionRole, variable.expression);
+    item->setToolTip(1, variable.value);
+    if (variable.expandable) {
+        // Children are only requested once the item is opened
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+    }
+    m_variableItems.insert(key, item);
+    return item;
+}
+
+void DebuggerPanel::onVariablesReceived(int frameLevel, const QVector<DebugVariable> &variables)
+{
+    if (frameLevel != m_frameLevel) {
+        return;
+    }
+
+    m_variables->clear();
+    m_variableItems.clear();
+    for (const DebugVariable &variable : variables) {
+        m_variables->addTopLevelItem(createVariableItem(variable, variable.name));
+    }
+}
+
+void DebuggerPanel::onVariableExpanded(QTreeWidgetItem *item)
+{
+    if (item->data(0, RequestedRole).toBool()) {
+        return;
+    }
+    item->setData(0, RequestedRole, true);
+
+    DebugVariable variable;
+    variable.name = item->text(0);
+    variable.expression = item->data(0, ExpressionRole).toString();
+    variable.varobj = item->data(0, VarobjRole).toString();
+
+    auto *loading = new QTreeWidgetItem({"Loading..."});
+    loading->setForeground(0, QColor(150, 150, 150));
+    item->addChild(loading);
+
+    m_session->fetchChildren(item->data(0, KeyRole).toString(), variable, 0);
+}
+
+void DebuggerPanel::onVariableActivated(QTreeWidgetItem *item)
+{
+    QVariant more = item->data(0, MoreFromRole);
+    QTreeWidgetItem *parent = item->parent();
+    if (!more.isValid() || !parent) {
+        return;
+    }
+
+    DebugVariable variable;
+    variable.expression = parent->data(0, ExpressionRole).toString();
+    variable.varobj = parent->data(0, VarobjRole).toString();
+    item->setText(0, "Loading...");
+    m_session->fetchChildren(parent->data(0, KeyRole).toString(), variable, more.toInt());
+}
+
+void DebuggerPanel::onChildrenReceived(const QString &parentKey, const QString &parentVarobj,
+                                       const QVector<DebugVariable> &children, int from, bool hasMore)
+{
+    QTreeWidgetItem *parent = m_variableItems.value(parentKey);
+    if (!parent) {
+        return;
+    }
+    parent->setData(0, VarobjRole, parentVarobj);
+
+    // Drop the "Loading..." or "load more" placeholder at the end
+    if (parent->childCount() > 0) {
+        QTreeWidgetItem *last = parent->child(parent->childCount() - 1);
+        if (last->data(0, KeyRole).toString().isEmpty()) {
+            delete parent->takeChild(parent->childCount() - 1);
+        }
+    }
+
+    QList<QTreeWidgetItem *> items;
+    items.reserve(children.size());
+    for (const DebugVariable &child : children) {
+        items << createVariableItem(child, parentKey + '/' + child.varobj);
+    }
+    parent->addChildren(items);
+
+    if (hasMore) {
+        auto *more = new QTreeWidgetItem({"Load more..."});
+        more->setData(0, MoreFromRole, from + children.size());
+        more->setForeground(0, QColor(150, 150, 150));
+        parent->addChild(more);
+    }
+    if (parent->childCount() == 0) {
+        parent->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicator);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef DEBUGGERPANEL_H
+#define DEBUGGERPANEL_H
+
+#include <QWidget>
+#include <QTreeWidget>
+#include <QToolBar>
+#include <QLabel>
+#include <QHash>
+#include "DebuggerSession.h"
+
+class DebuggerPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DebuggerPanel(DebuggerSession *session, QWidget *parent = nullptr);
+
+signals:
+    void openLocation(const QString &file, int line);
+
+private slots:
+    void onRunning();
+    void onStopped(const QString &file, int line, const QString &reason);
+    void onExited(int exitCode);
+    void onFramesReceived(int from, const QVector<DebugFrame> &frames, bool hasMore);
+    void onVariablesReceived(int frameLevel, const QVector<DebugVariable> &variables);
+    void onChildrenReceived(const QString &parentKey, const QString &parentVarobj,
+                            const QVector<DebugVariable> &children, int from, bool hasMore);
+    void onFrameActivated(QTreeWidgetItem *item);
+    void onVariableExpanded(QTreeWidgetItem *item);
+    void onVariableActivated(QTreeWidgetItem *item);
+
+private:
+    QTreeWidgetItem *createVariableItem(const DebugVariable &variable, const QString &key);
+    void setControlsEnabled(bool stopped);
+
+    DebuggerSession *m_session;
+    QLabel *m_statusLabel;
+    QTreeWidget *m_frames;
+    QTreeWidget *m_variables;
+    QList<QAction *> m_stoppedActions;
+    QAction *m_interruptAction;
+    int m_frameLevel;
+
+    // Items waiting for children, keyed by their path from the frame's locals
+    QHash<QString, QTreeWidgetItem *> m_variableItems;
+};
+
+#endif // DEBUGGERPANEL_H
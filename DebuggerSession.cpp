@@ -0,0 +1,520 @@
+#include "DebuggerSession.h"
+#include <QStandardPaths>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+DebuggerSession::DebuggerSession(QObject *parent)
+    : QObject(parent)
+    , m_gdb(new QProcess(this))
+    , m_exitTimer(new QTimer(this))
+    , m_inferiorMaster(-1)
+    , m_inferiorSlave(-1)
+    , m_inferiorNotifier(nullptr)
+    , m_state(NotStarted)
+    , m_nextToken(1)
+    , m_stopGeneration(0)
+    , m_frameLevel(0)
+{
+    // stdout is parsed as MI; gdb's own complaints on stderr are shown as they are
+    m_gdb->setProcessChannelMode(QProcess::SeparateChannels);
+    connect(m_gdb, &QProcess::readyReadStandardOutput, this, &DebuggerSession::onReadyRead);
+    connect(m_gdb, &QProcess::readyReadStandardError, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_gdb->readAllStandardError()));
+    });
+    m_exitTimer->setSingleShot(true);
+    m_exitTimer->setInterval(1000);
+    connect(m_exitTimer, &QTimer::timeout, m_gdb, &QProcess::kill);
+    connect(m_gdb, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &DebuggerSession::onFinished);
+}
+
+DebuggerSession::~DebuggerSession()
+{
+    if (m_gdb->state() != QProcess::NotRunning) {
+        m_gdb->kill();
+        m_gdb->waitForFinished(3000);
+    }
+    closeInferiorTty();
+}
+
+QString DebuggerSession::debuggerPath()
+{
+    return QStandardPaths::findExecutable("gdb");
+}
+
+bool DebuggerSession::start(const QString &executable, const QStringList &arguments,
+                            const QString &workingDirectory, const QProcessEnvironment &environment,
+                            const QHash<QString, QSet<int>> &breakpoints)
+{
+    if (m_gdb->state() != QProcess::NotRunning) {
+        return false;
+    }
+
+    const QString gdb = debuggerPath();
+    if (gdb.isEmpty()) {
+        emit errorOccurred("gdb was not found on PATH");
+        return false;
+    }
+
+    m_parser.reset();
+    m_callbacks.clear();
+    m_breakpointNumbers.clear();
+    m_pendingBreakpoints.clear();
+    m_varobjs.clear();
+    m_threadId.clear();
+    m_frameLevel = 0;
+    m_stopGeneration++;
+
+    QStringList args;
+    args << "--interpreter=mi2" << "--quiet" << "--nx" << "--args" << executable << arguments;
+    m_gdb->setWorkingDirectory(workingDirectory);
+    m_gdb->setProcessEnvironment(environment);
+    m_gdb->start(gdb, args);
+    if (!m_gdb->waitForStarted(5000)) {
+        emit errorOccurred("Failed to start gdb");
+        return false;
+    }
+
+    // Async mode keeps gdb responsive to breakpoint edits and interrupts while the program runs
+    sendCommand("-gdb-set mi-async on");
+#ifdef Q_OS_WIN
+    sendCommand("-gdb-set new-console on");
+#else
+    const QString tty = openInferiorTty();
+    if (!tty.isEmpty()) {
+        sendCommand("-inferior-tty-set " + quoted(tty));
+    }
+#endif
+    sendCommand("-gdb-set print pretty off");
+    sendCommand("-enable-pretty-printing");
+    for (auto it = breakpoints.constBegin(); it != breakpoints.constEnd(); ++it) {
+        for (int line : it.value()) {
+            setBreakpoint(it.key(), line, true);
+        }
+    }
+    sendCommand("-exec-run", [this](const GdbMiRecord &record) {
+        if (record.resultClass == "error") {
+            emit errorOccurred(record.results["msg"].text());
+        }
+    });
+
+    m_state = Running;
+    emit running();
+    return true;
+}
+
+void DebuggerSession::stop()
+{
+    if (m_gdb->state() == QProcess::NotRunning) {
+        return;
+    }
+    if (m_state == Running) {
+        sendCommand("-exec-interrupt");
+    }
+    sendCommand("-gdb-exit");
+    m_exitTimer->start();
+}
+
+void DebuggerSession::continueExecution()
+{
+    resume("-exec-continue");
+}
+
+void DebuggerSession::stepOver()
+{
+    resume("-exec-next");
+}
+
+void DebuggerSession::stepInto()
+{
+    resume("-exec-step");
+}
+
+void DebuggerSession::stepOut()
+{
+    // Finishes the frame selected in the call stack, which need not be the innermost one
+    resume("-exec-finish " + frameOptions(m_frameLevel));
+}
+
+void DebuggerSession::interrupt()
+{
+    if (m_state == Running) {
+        sendCommand("-exec-interrupt");
+    }
+}
+
+void DebuggerSession::resume(const QByteArray &command)
+{
+    if (m_state != Stopped) {
+        return;
+    }
+
+    m_stopGeneration++;
+    m_state = Running;
+    emit running();
+    sendCommand(command, [this](const GdbMiRecord &record) {
+        if (record.resultClass == "error") {
+            emit errorOccurred(record.results["msg"].text());
+        }
+    });
+}
+
+void DebuggerSession::setBreakpoint(const QString &file, int line, bool enabled)
+{
+    if (m_gdb->state() == QProcess::NotRunning) {
+        return;
+    }
+
+    const QString key = breakpointKey(file, line);
+    // A toggle while the insert is still unanswered only changes what the reply does
+    auto pending = m_pendingBreakpoints.find(key);
+    if (pending != m_pendingBreakpoints.end()) {
+        pending.value() = enabled;
+        return;
+    }
+    if (enabled) {
+        if (m_breakpointNumbers.contains(key)) {
+            return;
+        }
+        m_pendingBreakpoints.insert(key, true);
+        // -f keeps the breakpoint pending until a shared library with that file is loaded
+        sendCommand("-break-insert -f " + quoted(key), [this, key](const GdbMiRecord &record) {
+            const bool wanted = m_pendingBreakpoints.take(key);
+            if (record.resultClass != "done") {
+                return;
+            }
+            const int number = record.results["bkpt"]["number"].toInt();
+            if (wanted) {
+                m_breakpointNumbers.insert(key, number);
+            } else {
+                sendCommand("-break-delete " + QByteArray::number(number));
+            }
+        });
+    } else {
+        auto it = m_breakpointNumbers.find(key);
+        if (it != m_breakpointNumbers.end()) {
+            sendCommand("-break-delete " + QByteArray::number(it.value()));
+            m_breakpointNumbers.erase(it);
+        }
+    }
+}
+
+void DebuggerSession::selectFrame(int level)
+{
+    if (m_state != Stopped) {
+        return;
+    }
+    m_frameLevel = level;
+    listVariables(level);
+}
+
+void DebuggerSession::fetchFrames(int from)
+{
+    if (m_state != Stopped) {
+        return;
+    }
+
+    const int generation = m_stopGeneration;
+    const int to = from + kFramePageSize - 1;
+    sendCommand("-stack-list-frames " + threadOption() + QByteArray::number(from) + ' ' + QByteArray::number(to),
+                [this, generation, from](const GdbMiRecord &record) {
+        if (generation != m_stopGeneration || record.resultClass != "done") {
+            return;
+        }
+
+        const GdbMiValue &stack = record.results["stack"];
+        QVector<DebugFrame> frames;
+        frames.reserve(stack.size());
+        for (const GdbMiValue &entry : stack.children()) {
+            DebugFrame frame;
+            frame.level = entry["level"].toInt();
+            frame.function = entry["func"].text();
+            frame.file = entry["fullname"].isValid() ? entry["fullname"].text() : entry["file"].text();
+            frame.line = entry["line"].toInt();
+            frame.address = entry["addr"].text();
+            frames << frame;
+        }
+        // A full page means there may be more; gdb never walks further than asked
+        emit framesReceived(from, frames, frames.size() == kFramePageSize);
+    });
+}
+
+void DebuggerSession::listVariables(int frameLevel)
+{
+    const int generation = m_stopGeneration;
+
+    // --simple-values leaves out aggregates, so a huge container costs nothing until expanded
+    sendCommand("-stack-list-variables " + frameOptions(frameLevel) + " --simple-values",
+                [this, generation, frameLevel](const GdbMiRecord &record) {
+        if (generation != m_stopGeneration || record.resultClass != "done") {
+            return;
+        }
+
+        QVector<DebugVariable> variables;
+        for (const GdbMiValue &entry : record.results["variables"].children()) {
+            DebugVariable variable;
+            variable.name = entry["name"].text();
+            variable.expression = variable.name;
+            variable.type = entry["type"].text();
+            const GdbMiValue &value = entry["value"];
+            variable.expandable = !value.isValid() || variable.type.contains('*');
+            variable.value = value.isValid() ? value.text() : QString("{...}");
+            variables << variable;
+        }
+        emit variablesReceived(frameLevel, variables);
+    });
+}
+
+void DebuggerSession::fetchChildren(const QString &parentKey, const DebugVariable &parent, int from)
+{
+    if (m_state != Stopped) {
+        return;
+    }
+
+    if (!parent.varobj.isEmpty()) {
+        listChildren(parentKey, parent.varobj, from);
+        return;
+    }
+
+    // Locals become variable objects only once someone looks inside them
+    const int generation = m_stopGeneration;
+    sendCommand("-var-create " + frameOptions(m_frameLevel) + " - * " + quoted(parent.expression),
+                [this, generation, parentKey, from](const GdbMiRecord &record) {
+        if (generation != m_stopGeneration || record.resultClass != "done") {
+            return;
+        }
+        const QString varobj = record.results["name"].text();
+        m_varobjs << varobj;
+        listChildren(parentKey, varobj, from);
+    });
+}
+
+void DebuggerSession::listChildren(const QString &parentKey, const QString &varobj, int from)
+{
+    const int generation = m_stopGeneration;
+    sendCommand("-var-list-children --simple-values " + quoted(varobj) + ' ' + QByteArray::number(from) + ' '
+                    + QByteArray::number(from + kChildPageSize),
+                [this, generation, parentKey, varobj, from](const GdbMiRecord &record) {
+        if (generation != m_stopGeneration || record.resultClass != "done") {
+            return;
+        }
+
+        QVector<DebugVariable> children;
+        for (const GdbMiValue &entry : record.results["children"].children()) {
+            DebugVariable child;
+            child.varobj = entry["name"].text();
+            child.name = entry["exp"].text();
+            child.expression = child.name;
+            child.type = entry["type"].text();
+            child.value = entry["value"].isValid() ? entry["value"].text() : QString("{...}");
+            child.expandable = entry["numchild"].toInt() > 0 || entry["dynamic"].toInt() == 1;
+            children << child;
+        }
+
+        // Dynamic (pretty-printed) objects report has_more; plain aggregates report numchild
+        bool hasMore = record.results["has_more"].toInt() == 1;
+        if (!record.results["has_more"].isValid()) {
+            hasMore = record.results["numchild"].toInt() > from + children.size();
+        }
+        emit childrenReceived(parentKey, varobj, children, from, hasMore);
+    });
+}
+
+void DebuggerSession::sendCommand(const QByteArray &command, Callback callback)
+{
+    const int token = m_nextToken++;
+    if (callback) {
+        m_callbacks.insert(token, callback);
+    }
+    m_gdb->write(QByteArray::number(token) + command + '\n');
+}
+
+void DebuggerSession::onReadyRead()
+{
+    const QVector<GdbMiRecord> records = m_parser.feed(m_gdb->readAllStandardOutput());
+    for (const GdbMiRecord &record : records) {
+        handleRecord(record);
+    }
+}
+
+void DebuggerSession::handleRecord(const GdbMiRecord &record)
+{
+    switch (record.type) {
+    case GdbMiRecord::Result: {
+        Callback callback = m_callbacks.take(record.token);
+        if (callback) {
+            callback(record);
+        }
+        break;
+    }
+    case GdbMiRecord::ExecAsync:
+        if (record.resultClass == "stopped") {
+            handleStopped(record);
+        } else if (record.resultClass == "running" && m_state != Running) {
+            m_state = Running;
+            emit running();
+        }
+        break;
+    case GdbMiRecord::ConsoleStream:
+    case GdbMiRecord::TargetStream:
+        emit output(record.results.text());
+        break;
+    case GdbMiRecord::Other:
+        emit output(QString::fromLocal8Bit(record.line) + '\n');
+        break;
+    default:
+        break;
+    }
+}
+
+void DebuggerSession::handleStopped(const GdbMiRecord &record)
+{
+    const QByteArrayView reason = record.results["reason"].rawData();
+    if (reason.startsWith("exited")) {
+        m_state = Exited;
+        emit exited(record.results["exit-code"].isValid()
+                        ? QString::fromLatin1(record.results["exit-code"].rawData()).toInt(nullptr, 8) : 0);
+        sendCommand("-gdb-exit");
+        return;
+    }
+
+    m_stopGeneration++;
+    m_state = Stopped;
+    m_frameLevel = 0;
+    if (record.results["thread-id"].isValid()) {
+        m_threadId = record.results["thread-id"].rawData().toByteArray();
+    }
+
+    // Variable objects from the previous stop are stale
+    for (const QString &varobj : std::as_const(m_varobjs)) {
+        sendCommand("-var-delete " + quoted(varobj));
+    }
+    m_varobjs.clear();
+
+    const GdbMiValue &frame = record.results["frame"];
+    QString file = frame["fullname"].isValid() ? frame["fullname"].text() : frame["file"].text();
+    emit stopped(file, frame["line"].toInt(), QString::fromLatin1(reason));
+
+    fetchFrames(0);
+    listVariables(0);
+}
+
+void DebuggerSession::onInferiorReadable()
+{
+#ifdef Q_OS_UNIX
+    char buffer[16 * 1024];
+    QByteArray text;
+    for (;;) {
+        const ssize_t count = ::read(m_inferiorMaster, buffer, sizeof(buffer));
+        if (count <= 0) {
+            break;
+        }
+        text.append(buffer, count);
+    }
+    if (!text.isEmpty()) {
+        emit output(QString::fromLocal8Bit(text));
+    }
+#endif
+}
+
+QString DebuggerSession::openInferiorTty()
+{
+    closeInferiorTty();
+#ifdef Q_OS_UNIX
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        if (master >= 0) {
+            ::close(master);
+        }
+        emit output("Could not open a terminal for the program; its output goes to gdb's\n");
+        return QString();
+    }
+    const QString path = QString::fromLocal8Bit(ptsname(master));
+    const int slave = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave < 0) {
+        ::close(master);
+        return QString();
+    }
+
+    // Plain '\n' line endings and no echo, as if the output went to a pipe
+    termios attributes;
+    if (tcgetattr(slave, &attributes) == 0) {
+        attributes.c_oflag &= ~OPOST;
+        attributes.c_lflag &= ~(ECHO | ICANON);
+        tcsetattr(slave, TCSANOW, &attributes);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+
+    m_inferiorMaster = master;
+    m_inferiorSlave = slave;
+    m_inferiorNotifier = new QSocketNotifier(master, QSocketNotifier::Read, this);
+    connect(m_inferiorNotifier, &QSocketNotifier::activated, this, &DebuggerSession::onInferiorReadable);
+    return path;
+#else
+    return QString();
+#endif
+}
+
+void DebuggerSession::closeInferiorTty()
+{
+    delete m_inferiorNotifier;
+    m_inferiorNotifier = nullptr;
+#ifdef Q_OS_UNIX
+    if (m_inferiorMaster >= 0) {
+        ::close(m_inferiorMaster);
+    }
+    if (m_inferiorSlave >= 0) {
+        ::close(m_inferiorSlave);
+    }
+#endif
+    m_inferiorMaster = -1;
+    m_inferiorSlave = -1;
+}
+
+void DebuggerSession::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Q_UNUSED(exitStatus)
+
+    m_exitTimer->stop();
+    // Whatever the program wrote last is still in the terminal
+    onInferiorReadable();
+    closeInferiorTty();
+    m_callbacks.clear();
+    if (m_state != Exited) {
+        m_state = Exited;
+        emit exited(exitCode);
+    }
+}
+
+QByteArray DebuggerSession::threadOption() const
+{
+    return m_threadId.isEmpty() ? QByteArray() : "--thread " + m_threadId + ' ';
+}
+
+QByteArray DebuggerSession::frameOptions(int frameLevel) const
+{
+    return threadOption() + "--frame " + QByteArray::number(frameLevel);
+}
+
+QByteArray DebuggerSession::quoted(const QString &text)
+{
+    QByteArray escaped = text.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    return '"' + escaped + '"';
+}
+
+QString DebuggerSession::breakpointKey(const QString &file, int line)
+{
+    return QFileInfo(file).absoluteFilePath() + ':' + QString::number(line);
+}
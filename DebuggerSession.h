@@ -0,0 +1,129 @@
+#ifndef DEBUGGERSESSION_H
+#define DEBUGGERSESSION_H
+
+#include <QObject>
+#include <QProcess>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <functional>
+#include "GdbMiParser.h"
+
+class QSocketNotifier;
+class QTimer;
+
+struct DebugFrame
+{
+    int level = 0;
+    QString function;
+    QString file;
+    int line = 0;
+    QString address;
+};
+
+struct DebugVariable
+{
+    QString name;
+    QString expression;
+    QString varobj;       // GDB variable object, empty until the value is first expanded
+    QString value;
+    QString type;
+    bool expandable = false;
+};
+
+// Drives gdb over the MI protocol. After each stop only the top of the stack and the
+// innermost frame's simple locals are requested; deeper frames and the children of
+// composite values are fetched in pages when the UI asks for them. gdb's stdout carries
+// only MI records; the program writes to a pseudo-terminal of its own.
+class DebuggerSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        NotStarted,
+        Running,
+        Stopped,
+        Exited
+    };
+
+    static const int kFramePageSize = 20;
+    static const int kChildPageSize = 100;
+
+    explicit DebuggerSession(QObject *parent = nullptr);
+    ~DebuggerSession();
+
+    static QString debuggerPath();
+
+    bool start(const QString &executable, const QStringList &arguments,
+               const QString &workingDirectory, const QProcessEnvironment &environment,
+               const QHash<QString, QSet<int>> &breakpoints);
+    void stop();
+    State state() const { return m_state; }
+    bool isActive() const { return m_state == Running || m_state == Stopped; }
+
+    void continueExecution();
+    void stepOver();
+    void stepInto();
+    void stepOut();
+    void interrupt();
+
+    void setBreakpoint(const QString &file, int line, bool enabled);
+
+    void selectFrame(int level);
+    void fetchFrames(int from);
+    void fetchChildren(const QString &parentKey, const DebugVariable &parent, int from);
+
+signals:
+    void output(const QString &text);
+    void running();
+    void stopped(const QString &file, int line, const QString &reason);
+    void exited(int exitCode);
+    void framesReceived(int from, const QVector<DebugFrame> &frames, bool hasMore);
+    void variablesReceived(int frameLevel, const QVector<DebugVariable> &variables);
+    void childrenReceived(const QString &parentKey, const QString &parentVarobj,
+                          const QVector<DebugVariable> &children, int from, bool hasMore);
+    void errorOccurred(const QString &message);
+
+private slots:
+    void onReadyRead();
+    void onInferiorReadable();
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    using Callback = std::function<void(const GdbMiRecord &)>;
+
+    void sendCommand(const QByteArray &command, Callback callback = Callback());
+    void handleRecord(const GdbMiRecord &record);
+    void handleStopped(const GdbMiRecord &record);
+    void resume(const QByteArray &command);
+    void listVariables(int frameLevel);
+    void listChildren(const QString &parentKey, const QString &varobj, int from);
+    QByteArray threadOption() const;
+    QByteArray frameOptions(int frameLevel) const;
+    static QByteArray quoted(const QString &text);
+    static QString breakpointKey(const QString &file, int line);
+    QString openInferiorTty();
+    void closeInferiorTty();
+
+    QProcess *m_gdb;
+    QTimer *m_exitTimer;   // kills gdb when -gdb-exit is not answered in time
+    int m_inferiorMaster;
+    int m_inferiorSlave;   // held open so the master never reports a hang-up between runs
+    QSocketNotifier *m_inferiorNotifier;
+    GdbMiParser m_parser;
+    State m_state;
+    int m_nextToken;
+    QHash<int, Callback> m_callbacks;
+
+    // Bumped on every stop so replies meant for an earlier stop are dropped
+    int m_stopGeneration;
+    QByteArray m_threadId;
+    int m_frameLevel;
+    QStringList m_varobjs;
+
+    QHash<QString, int> m_breakpointNumbers;
+    QHash<QString, bool> m_pendingBreakpoints;   // inserts awaiting a reply -> still wanted
+};
+
+#endif // DEBUGGERSESSION_H
@@ -0,0 +1,151 @@
+#include "DocumentWatcher.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+FileSignature FileSignature::of(const QString &filePath)
+{
+    FileSignature signature;
+    const QFileInfo info(filePath);
+    signature.exists = info.exists();
+    if (!signature.exists) {
+        return signature;
+    }
+    signature.size = info.size();
+    signature.modified = info.lastModified().toMSecsSinceEpoch();
+#ifdef Q_OS_UNIX
+    struct stat buffer;
+    if (::stat(QFile::encodeName(filePath).constData(), &buffer) == 0) {
+        signature.inode = quint64(buffer.st_ino);
+    }
+#endif
+    return signature;
+}
+
+bool FileSignature::operator==(const FileSignature &other) const
+{
+    return exists == other.exists && size == other.size && modified == other.modified && inode == other.inode;
+}
+
+DocumentWatcher::DocumentWatcher(QObject *parent)
+    : QObject(parent)
+    , m_textHash(0)
+    , m_hasTextHash(false)
+    , m_suspended(false)
+    , m_checkPending(false)
+{
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleDelay);
+    connect(&m_settleTimer, &QTimer::timeout, this, &DocumentWatcher::verify);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &DocumentWatcher::fileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this]() { schedule(); });
+}
+
+void DocumentWatcher::watch(const QString &filePath, const QString &diskText)
+{
+    unwatch();
+    m_filePath = filePath;
+    m_signature = FileSignature::of(filePath);
+    m_textHash = qHash(diskText);
+    m_hasTextHash = true;
+    if (m_signature.exists) {
+        m_watcher.addPath(filePath);
+    }
+    m_watcher.addPath(QFileInfo(filePath).absolutePath());
+}
+
+void DocumentWatcher::unwatch()
+{
+    if (!m_watcher.files().isEmpty()) {
+        m_watcher.removePaths(m_watcher.files());
+    }
+    if (!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+    m_settleTimer.stop();
+    m_filePath.clear();
+    m_checkPending = false;
+}
+
+void DocumentWatcher::acknowledgeSave(const QString &filePath)
+{
+    if (filePath != m_filePath) {
+        // Saved under a new name
+        watch(filePath);
+        m_hasTextHash = false;
+        return;
+    }
+    m_signature = FileSignature::of(filePath);
+    m_hasTextHash = false;
+    if (m_signature.exists && !m_watcher.files().contains(filePath)) {
+        m_watcher.addPath(filePath);
+    }
+}
+
+void DocumentWatcher::setSuspended(bool suspended)
+{
+    m_suspended = suspended;
+    if (!suspended && m_checkPending) {
+        schedule();
+    }
+}
+
+void DocumentWatcher::fileChanged(const QString &path)
+{
+    if (path == m_filePath) {
+        schedule();
+    }
+}
+
+void DocumentWatcher::schedule()
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    m_checkPending = true;
+    if (!m_suspended) {
+        m_settleTimer.start();
+    }
+}
+
+void DocumentWatcher::verify()
+{
+    if (m_suspended || m_filePath.isEmpty()) {
+        return;
+    }
+    m_checkPending = false;
+
+    const FileSignature signature = FileSignature::of(m_filePath);
+    if (signature == m_signature) {
+        return;
+    }
+    const bool existed = m_signature.exists;
+    m_signature = signature;
+    if (!signature.exists) {
+        if (existed) {
+            emit removedFromDisk(m_filePath);
+        }
+        return;
+    }
+    if (!m_watcher.files().contains(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+    }
+
+    QString text;
+    TextFormat format;
+    if (!TextFileCodec::load(m_filePath, &text, &format)) {
+        return;
+    }
+    const size_t textHash = qHash(text);
+    if (m_hasTextHash && textHash == m_textHash) {
+        return;
+    }
+    m_textHash = textHash;
+    m_hasTextHash = true;
+    emit changedOnDisk(m_filePath, text, format);
+}
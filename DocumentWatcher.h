@@ -0,0 +1,68 @@
+#ifndef DOCUMENTWATCHER_H
+#define DOCUMENTWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include "TextFileCodec.h"
+
+// Identity and version of a file as far as stat() can tell
+struct FileSignature
+{
+    bool exists = false;
+    qint64 size = 0;
+    qint64 modified = 0;   // ms since epoch
+    quint64 inode = 0;     // 0 where the platform has none
+
+    static FileSignature of(const QString &filePath);
+    bool operator==(const FileSignature &other) const;
+    bool operator!=(const FileSignature &other) const { return !(*this == other); }
+};
+
+// Notices when the open document's file is changed by another program. Notifications are
+// collapsed for a short while; a file whose size, modification time and inode are unchanged is
+// not read, and one that reads back as the text the editor last loaded is not reported.
+// The file and its directory are both watched, since a file replaced by rename (git, QSaveFile,
+// most code generators) drops out of QFileSystemWatcher.
+class DocumentWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentWatcher(QObject *parent = nullptr);
+
+    // diskText is what the file held when it was loaded, if known
+    void watch(const QString &filePath, const QString &diskText = QString());
+    void unwatch();
+    QString filePath() const { return m_filePath; }
+
+    // The file now holds what the editor saved
+    void acknowledgeSave(const QString &filePath);
+
+    // Checks are postponed while the IDE itself is writing the file
+    void setSuspended(bool suspended);
+
+public slots:
+    void fileChanged(const QString &path);
+
+signals:
+    void changedOnDisk(const QString &filePath, const QString &text, const TextFormat &format);
+    void removedFromDisk(const QString &filePath);
+
+private:
+    static constexpr int kSettleDelay = 100;   // ms
+
+    void schedule();
+    void verify();
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_settleTimer;
+    QString m_filePath;
+    FileSignature m_signature;
+    size_t m_textHash;
+    bool m_hasTextHash;
+    bool m_suspended;
+    bool m_checkPending;
+};
+
+#endif // DOCUMENTWATCHER_H
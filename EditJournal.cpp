@@ -0,0 +1,400 @@
+#include "EditJournal.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextCursor>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+constexpr quint32 kJournalMagic = 0x4c4e4a51;   // "QJNL"
+constexpr quint8 kJournalVersion = 1;
+constexpr quint8 kBaseOnDisk = 0;
+constexpr quint8 kBaseSnapshot = 1;
+
+void appendVarint(QByteArray *out, quint64 value)
+{
+    do {
+        uchar byte = value & 0x7f;
+        value >>= 7;
+        if (value) {
+            byte |= 0x80;
+        }
+        out->append(char(byte));
+    } while (value);
+}
+
+bool readVarint(const char *&p, const char *end, quint64 *value)
+{
+    *value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar byte = uchar(*p++);
+        *value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readBytes(const char *&p, const char *end, quint64 size, QByteArrayView *bytes)
+{
+    if (quint64(end - p) < size) {
+        return false;
+    }
+    *bytes = QByteArrayView(p, qsizetype(size));
+    p += size;
+    return true;
+}
+
+// Identifies the text a journal starts from without storing it
+QByteArray textHash(const QString &text)
+{
+    const QByteArrayView bytes(reinterpret_cast<const char *>(text.constData()), text.size() * qsizetype(sizeof(QChar)));
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+}
+}
+
+EditJournal::EditJournal(QObject *parent)
+    : QObject(parent)
+    , m_length(0)
+    , m_revision(0)
+    , m_journalBytes(0)
+    , m_worker(new QObject)
+    , m_baseOnDisk(true)
+    , m_hasSavePoint(false)
+    , m_savePointOffset(-1)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kFlushInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+
+    m_workerThread.setObjectName("EditJournal");
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+EditJournal::~EditJournal()
+{
+    detach();
+    QMetaObject::invokeMethod(m_worker, []() {}, Qt::BlockingQueuedConnection);
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+QString EditJournal::journalFileFor(const QString &filePath)
+{
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/autosave/" + key.toHex() + ".autosave";
+}
+
+void EditJournal::attach(QTextDocument *document, const QString &filePath, const QString &text, bool savedOnDisk)
+{
+    detach();
+    m_document = document;
+    m_length = document->characterCount() - 1;
+    m_revision = document->revision();
+    m_journalBytes = 0;
+    connect(document, &QTextDocument::contentsChange, this, &EditJournal::onContentsChange);
+    QMetaObject::invokeMethod(m_worker, [this, filePath, text, savedOnDisk]() {
+        start(filePath, text, savedOnDisk);
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::detach()
+{
+    // Also runs after the document is gone, so records still pending reach the journal
+    if (m_document) {
+        disconnect(m_document, nullptr, this, nullptr);
+    }
+    flush();
+    m_document = nullptr;
+    QMetaObject::invokeMethod(m_worker, [this]() {
+        m_journal.close();
+        m_filePath.clear();
+        m_baseText.clear();
+        m_savePointText.clear();
+        m_hasSavePoint = false;
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::markSaving(const QString &filePath, const QString &text)
+{
+    if (!m_document) {
+        return;
+    }
+    flush();
+    QMetaObject::invokeMethod(m_worker, [this, filePath, text]() { setSavePoint(filePath, text); }, Qt::QueuedConnection);
+}
+
+void EditJournal::markSaved(const QString &filePath)
+{
+    QMetaObject::invokeMethod(m_worker, [this, filePath]() {
+        if (filePath == m_filePath) {
+            rebaseOnSavePoint();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    QTextDocument *document = m_document;
+    // Rehighlighting reports the formatted range as removed and added again without
+    // starting a new undo revision; real edits always do
+    if (charsRemoved == charsAdded && document->revision() == m_revision) {
+        return;
+    }
+    m_revision = document->revision();
+
+    // The counts can include the document's implicit final paragraph separator, so the
+    // record is derived from the lengths before and after instead
+    const int length = document->characterCount() - 1;
+    const int added = std::max(0, std::min(charsAdded, length - position));
+    const int removed = m_length - (length - added);
+    if (position < 0 || removed < 0 || position + removed > m_length) {
+        // Out of step with the document; start over from a snapshot
+        m_length = length;
+        flush();
+        QMetaObject::invokeMethod(m_worker, [this, text = document->toPlainText()]() { writeSnapshot(text); },
+                                  Qt::QueuedConnection);
+        m_journalBytes = 0;
+        return;
+    }
+
+    QString text;
+    if (added > 0) {
+        QTextCursor cursor(document);
+        cursor.setPosition(position);
+        cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+        text = cursor.selectedText();
+        for (QChar &c : text) {
+            if (c == QChar::ParagraphSeparator || c == QChar::LineSeparator) {
+                c = u'\n';
+            } else if (c == QChar::Nbsp) {
+                c = u' ';
+            }
+        }
+    }
+
+    const QByteArray utf8 = text.toUtf8();
+    appendVarint(&m_pending, quint64(position));
+    appendVarint(&m_pending, quint64(removed));
+    appendVarint(&m_pending, quint64(utf8.size()));
+    m_pending.append(utf8);
+    m_length = length;
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void EditJournal::flush()
+{
+    m_flushTimer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    m_journalBytes += m_pending.size();
+    QMetaObject::invokeMethod(m_worker, [this, records = m_pending]() { append(records); }, Qt::QueuedConnection);
+    m_pending.clear();
+
+    // Replaying should never cost more than reading the document again
+    if (m_document && m_journalBytes > std::max<qint64>(kCompactThreshold, 2 * qint64(m_length))) {
+        QMetaObject::invokeMethod(m_worker, [this, text = m_document->toPlainText()]() { writeSnapshot(text); },
+                                  Qt::QueuedConnection);
+        m_journalBytes = 0;
+    }
+}
+
+void EditJournal::start(const QString &filePath, const QString &text, bool savedOnDisk)
+{
+    m_journal.close();
+    m_filePath = filePath;
+    m_journalPath = journalFileFor(filePath);
+    m_baseText = text;
+    m_baseOnDisk = savedOnDisk;
+    m_hasSavePoint = false;
+    // A recovered buffer exists nowhere else, so it is written right away; a buffer that
+    // matches the file leaves nothing to recover
+    if (savedOnDisk) {
+        QFile::remove(m_journalPath);
+    } else {
+        writeSnapshot(text);
+    }
+}
+
+void EditJournal::append(const QByteArray &records)
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    // The header is only written with the first edit, so unedited files cost nothing
+    if (!m_journal.isOpen()) {
+        QDir().mkpath(QFileInfo(m_journalPath).absolutePath());
+        m_journal.setFileName(m_journalPath);
+        if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || !writeHeader(&m_journal, !m_baseOnDisk, m_baseText)) {
+            m_journal.close();
+            return;
+        }
+        m_baseText.clear();
+        if (m_hasSavePoint && m_savePointOffset < 0) {
+            m_savePointOffset = m_journal.pos();
+        }
+    }
+    m_journal.write(records);
+    m_journal.flush();
+}
+
+void EditJournal::setSavePoint(const QString &filePath, const QString &text)
+{
+    if (filePath != m_filePath) {
+        // Saved under a new name: the old file never receives these edits
+        removeJournal();
+        m_filePath = filePath;
+        m_journalPath = journalFileFor(filePath);
+        m_baseText = text;
+        m_baseOnDisk = true;
+        m_hasSavePoint = false;
+        return;
+    }
+    m_hasSavePoint = true;
+    m_savePointText = text;
+    m_savePointOffset = m_journal.isOpen() ? m_journal.size() : -1;
+}
+
+void EditJournal::rebaseOnSavePoint()
+{
+    if (!m_hasSavePoint) {
+        return;
+    }
+    m_hasSavePoint = false;
+
+    // Edits made while the save was in flight are kept on top of the saved text
+    QByteArray tail;
+    if (m_journal.isOpen() && m_savePointOffset >= 0) {
+        m_journal.close();
+        QFile reader(m_journalPath);
+        if (reader.open(QIODevice::ReadOnly) && reader.seek(m_savePointOffset)) {
+            tail = reader.readAll();
+        }
+    }
+    m_journal.close();
+
+    if (tail.isEmpty()) {
+        QFile::remove(m_journalPath);
+        m_baseText = m_savePointText;
+        m_baseOnDisk = true;
+    } else {
+        QSaveFile file(m_journalPath);
+        if (file.open(QIODevice::WriteOnly) && writeHeader(&file, false, m_savePointText)) {
+            file.write(tail);
+            file.commit();
+        }
+        m_journal.setFileName(m_journalPath);
+        m_journal.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+    m_savePointText.clear();
+}
+
+void EditJournal::writeSnapshot(const QString &text)
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    m_journal.close();
+    QDir().mkpath(QFileInfo(m_journalPath).absolutePath());
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly) || !writeHeader(&file, true, text) || !file.commit()) {
+        return;
+    }
+    m_journal.setFileName(m_journalPath);
+    m_journal.open(QIODevice::WriteOnly | QIODevice::Append);
+    m_baseText.clear();
+    // Records after the snapshot no longer apply to the text being saved
+    m_hasSavePoint = false;
+    m_savePointText.clear();
+}
+
+bool EditJournal::writeHeader(QIODevice *device, bool snapshot, const QString &text)
+{
+    QByteArray header;
+    header.resize(4);
+    qToLittleEndian(kJournalMagic, header.data());
+    header.append(char(kJournalVersion));
+    header.append(char(snapshot ? kBaseSnapshot : kBaseOnDisk));
+    if (snapshot) {
+        const QByteArray utf8 = text.toUtf8();
+        appendVarint(&header, quint64(utf8.size()));
+        header.append(utf8);
+    } else {
+        header.append(textHash(text));
+    }
+    return device->write(header) == header.size();
+}
+
+void EditJournal::removeJournal()
+{
+    m_journal.close();
+    if (!m_journalPath.isEmpty()) {
+        QFile::remove(m_journalPath);
+    }
+}
+
+EditJournal::Recovery EditJournal::recover(const QString &filePath, const QString &diskText, QString *recovered)
+{
+    QFile file(journalFileFor(filePath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return NothingToRecover;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    QString text;
+    bool baseChanged = false;
+    bool valid = data.size() >= 6 && qFromLittleEndian<quint32>(p) == kJournalMagic && p[4] == char(kJournalVersion);
+    if (valid) {
+        const quint8 kind = quint8(p[5]);
+        p += 6;
+        QByteArrayView bytes;
+        quint64 size = 0;
+        if (kind == kBaseOnDisk) {
+            valid = readBytes(p, end, 16, &bytes);
+            baseChanged = valid && bytes.toByteArray() != textHash(diskText);
+            text = diskText;
+        } else {
+            valid = kind == kBaseSnapshot && readVarint(p, end, &size) && readBytes(p, end, size, &bytes);
+            text = QString::fromUtf8(bytes);
+        }
+    }
+
+    // A record cut short by the crash ends the replay
+    while (valid && p < end) {
+        quint64 position = 0;
+        quint64 removed = 0;
+        quint64 size = 0;
+        QByteArrayView bytes;
+        if (!readVarint(p, end, &position) || !readVarint(p, end, &removed) || !readVarint(p, end, &size)
+            || !readBytes(p, end, size, &bytes)
+            || position > quint64(text.size()) || removed > quint64(text.size()) - position) {
+            break;
+        }
+        text.replace(qsizetype(position), qsizetype(removed), QString::fromUtf8(bytes));
+    }
+
+    if (!valid || text == diskText) {
+        QFile::remove(file.fileName());
+        return NothingToRecover;
+    }
+    *recovered = text;
+    return baseChanged ? BaseChanged : Recovered;
+}
+
+void EditJournal::discard(const QString &filePath)
+{
+    QFile::remove(journalFileFor(filePath));
+}
@@ -0,0 +1,89 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QPointer>
+#include <QTextDocument>
+
+// Crash recovery for the open document. Every edit reported by QTextDocument::contentsChange
+// is encoded as a small "replace range with text" record; records are batched on the GUI
+// thread and appended to <AppLocalDataLocation>/autosave/<md5 of path>.autosave by a worker.
+//
+// A journal starts either from the file on disk (identified by a hash of its text) or from a
+// snapshot of the buffer. A completed save rebases it onto the saved text, keeping only the
+// edits made since, and the file is removed once nothing is left unsaved. It is compacted into
+// a fresh snapshot when the records outgrow the document.
+class EditJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EditJournal(QObject *parent = nullptr);
+    ~EditJournal() override;
+
+    // text is the document's current contents; savedOnDisk tells whether the file holds them
+    void attach(QTextDocument *document, const QString &filePath, const QString &text, bool savedOnDisk);
+    void detach();
+    bool isAttached() const { return !m_document.isNull(); }
+
+    // A save of text was requested, and later completed with no other save still pending
+    void markSaving(const QString &filePath, const QString &text);
+    void markSaved(const QString &filePath);
+
+    enum Recovery {
+        NothingToRecover,
+        Recovered,
+        BaseChanged   // the file changed since the journal began; the replay is a best effort
+    };
+
+    // Replays a journal left by an earlier session on top of the file's current text. A journal
+    // that is unreadable or would not change anything is removed; one whose file changed on
+    // disk is kept until the caller discards it or attaches a new journal.
+    static Recovery recover(const QString &filePath, const QString &diskText, QString *recovered);
+    static void discard(const QString &filePath);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void flush();
+
+private:
+    static constexpr int kFlushInterval = 500;             // ms
+    static constexpr qint64 kCompactThreshold = 1 << 20;   // journal bytes
+
+    static QString journalFileFor(const QString &filePath);
+
+    // Worker thread only
+    void start(const QString &filePath, const QString &text, bool savedOnDisk);
+    void append(const QByteArray &records);
+    void setSavePoint(const QString &filePath, const QString &text);
+    void rebaseOnSavePoint();
+    void writeSnapshot(const QString &text);
+    static bool writeHeader(QIODevice *device, bool snapshot, const QString &text);
+    void removeJournal();
+
+    // GUI thread
+    QPointer<QTextDocument> m_document;
+    int m_length;        // plain text length the next record applies to
+    int m_revision;
+    QByteArray m_pending;
+    qint64 m_journalBytes;   // written since the last snapshot
+    QTimer m_flushTimer;
+
+    QThread m_workerThread;
+    QObject *m_worker;
+
+    // Worker thread
+    QString m_filePath;
+    QString m_journalPath;
+    QFile m_journal;       // open for appending once the header is written
+    QString m_baseText;    // what the header describes until it is written
+    bool m_baseOnDisk;
+    bool m_hasSavePoint;
+    qint64 m_savePointOffset;   // journal size when the save was requested, -1 before the header
+    QString m_savePointText;
+};
+
+#endif // EDITJOURNAL_H
@@ -0,0 +1,67 @@
+#include "FileSaver.h"
+#include "Instrumentation.h"
+#include <QMutexLocker>
+
+FileSaver::FileSaver(QObject *parent)
+    : QObject(parent)
+    , m_worker(new QObject)
+    , m_outstanding(0)
+{
+    m_workerThread.setObjectName("FileSaver");
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_workerThread.start();
+}
+
+FileSaver::~FileSaver()
+{
+    // Queued saves still reach the disk when the IDE quits
+    QMetaObject::invokeMethod(m_worker, []() {}, Qt::BlockingQueuedConnection);
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void FileSaver::save(const QString &filePath, const QString &text, const TextFormat &format)
+{
+    bool alreadyQueued;
+    {
+        QMutexLocker locker(&m_mutex);
+        alreadyQueued = m_queued.contains(filePath);
+        m_queued.insert(filePath, Job{text, format});
+    }
+    if (alreadyQueued) {
+        return;
+    }
+    ++m_outstanding;
+    QMetaObject::invokeMethod(m_worker, [this, filePath]() { write(filePath); }, Qt::QueuedConnection);
+}
+
+void FileSaver::write(const QString &filePath)
+{
+    InstrumentationScope scope("FileSaver::write");
+    Job job;
+    {
+        QMutexLocker locker(&m_mutex);
+        job = m_queued.take(filePath);
+    }
+    QString error;
+    if (!TextFileCodec::save(filePath, job.text, &job.format, &error) && error.isEmpty()) {
+        error = "Unknown error";
+    }
+    QMetaObject::invokeMethod(this, [this, filePath, format = job.format, error]() {
+        finishJob(filePath, format, error);
+    }, Qt::QueuedConnection);
+}
+
+void FileSaver::finishJob(const QString &filePath, const TextFormat &format, const QString &error)
+{
+    --m_outstanding;
+    if (error.isEmpty()) {
+        emit saved(filePath, format);
+    } else {
+        emit saveFailed(filePath, error);
+    }
+    if (m_outstanding == 0) {
+        emit idle();
+    }
+}
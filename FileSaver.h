@@ -0,0 +1,50 @@
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include "TextFileCodec.h"
+
+// Writes documents on a worker thread. save() only keeps the text, which QString shares
+// instead of copying; encoding, the write to a temporary file, fsync and the rename over
+// the original (QSaveFile) all happen on the worker. A save requested while an older one
+// for the same file is still queued replaces it, so only the newest text is written.
+class FileSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileSaver(QObject *parent = nullptr);
+    ~FileSaver() override;
+
+    void save(const QString &filePath, const QString &text, const TextFormat &format);
+    bool isBusy() const { return m_outstanding > 0; }
+
+signals:
+    // The format differs from the requested one when a Latin-1 file had to become UTF-8
+    void saved(const QString &filePath, const TextFormat &format);
+    void saveFailed(const QString &filePath, const QString &error);
+    void idle();
+
+private:
+    struct Job
+    {
+        QString text;
+        TextFormat format;
+    };
+
+    void write(const QString &filePath);   // worker thread
+    // An empty error means the file was written
+    void finishJob(const QString &filePath, const TextFormat &format, const QString &error);
+
+    QThread m_workerThread;
+    QObject *m_worker;
+    int m_outstanding;   // queued writes, GUI thread only
+
+    QMutex m_mutex;   // guards m_queued
+    QHash<QString, Job> m_queued;
+};
+
+#endif // FILESAVER_H
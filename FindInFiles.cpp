@@ -0,0 +1,461 @@
+#include "FindInFiles.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+constexpr int kFilesPerClaim = 8;      // files a worker takes from the shared queue at a time
+constexpr int kBatchMatches = 256;
+constexpr qint64 kBatchIntervalMs = 30;
+constexpr qint64 kBinaryProbeBytes = 8192;
+
+bool isAsciiLetter(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c + ('a' - 'A')) : c;
+}
+
+// How common a byte is in source code; the scan anchors on the rarest byte of the literal
+int byteFrequencyRank(char c)
+{
+    static const char common[] = " etaoinsrlcdhumpfgybwvkxjqz_();,.{}=\n\t*/\"<>-+:&[]0123456789#";
+    const char *found = static_cast<const char *>(std::memchr(common, asciiLower(c), sizeof(common) - 1));
+    return found ? int(sizeof(common) - (found - common)) : 0;
+}
+
+// Finds occurrences of a literal with memchr on one anchor byte, then verifies the rest
+class LiteralScanner
+{
+public:
+    LiteralScanner(const QByteArray &needle, bool caseSensitive)
+        : m_needle(needle)
+        , m_caseSensitive(caseSensitive)
+        , m_anchor(0)
+        , m_dualCase(false)
+    {
+        if (m_needle.isEmpty()) {
+            return;
+        }
+        // Case-insensitive scans prefer a byte without case so a single memchr suffices
+        int best = -1;
+        for (int i = 0; i < m_needle.size(); ++i) {
+            const bool caseless = m_caseSensitive || !isAsciiLetter(m_needle.at(i));
+            const int rank = byteFrequencyRank(m_needle.at(i)) - (caseless ? 1000 : 0);
+            if (best < 0 || rank < best) {
+                best = rank;
+                m_anchor = i;
+            }
+        }
+        m_dualCase = !m_caseSensitive && isAsciiLetter(m_needle.at(m_anchor));
+    }
+
+    bool isValid() const { return !m_needle.isEmpty(); }
+
+    const char *find(const char *begin, const char *end) const
+    {
+        const qsizetype length = m_needle.size();
+        if (end - begin < length) {
+            return nullptr;
+        }
+        const char lower = m_needle.at(m_anchor);
+        const char upper = char(lower - ('a' - 'A'));
+        const char *scanEnd = end - (length - 1 - m_anchor);
+        const char *p = begin + m_anchor;
+        const char *nextLower = nullptr;
+        const char *nextUpper = nullptr;
+        while (p < scanEnd) {
+            const char *hit;
+            if (m_dualCase) {
+                // Remember both candidates so neither case is scanned twice
+                if (!nextLower || nextLower < p) {
+                    nextLower = static_cast<const char *>(std::memchr(p, lower, scanEnd - p));
+                    if (!nextLower) {
+                        nextLower = scanEnd;
+                    }
+                }
+                if (!nextUpper || nextUpper < p) {
+                    nextUpper = static_cast<const char *>(std::memchr(p, upper, scanEnd - p));
+                    if (!nextUpper) {
+                        nextUpper = scanEnd;
+                    }
+                }
+                hit = std::min(nextLower, nextUpper);
+                if (hit == scanEnd) {
+                    return nullptr;
+                }
+            } else {
+                hit = static_cast<const char *>(std::memchr(p, m_needle.at(m_anchor), scanEnd - p));
+                if (!hit) {
+                    return nullptr;
+                }
+            }
+            const char *start = hit - m_anchor;
+            if (matchesAt(start)) {
+                return start;
+            }
+            p = hit + 1;
+        }
+        return nullptr;
+    }
+
+private:
+    bool matchesAt(const char *start) const
+    {
+        if (m_caseSensitive) {
+            return std::memcmp(start, m_needle.constData(), m_needle.size()) == 0;
+        }
+        for (qsizetype i = 0; i < m_needle.size(); ++i) {
+            if (asciiLower(start[i]) != m_needle.at(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QByteArray m_needle;
+    bool m_caseSensitive;
+    int m_anchor;
+    bool m_dualCase;
+};
+
+// Compiled state shared by all workers of one search
+class FileSearcher
+{
+public:
+    explicit FileSearcher(const SearchOptions &options)
+        : m_expression(options.expression())
+        , m_scanner(options.requiredLiteral(), options.caseSensitive)
+    {
+        m_expression.optimize();
+    }
+
+    bool isValid() const { return m_expression.isValid(); }
+
+    // Returns false when the file could not be read or looks binary
+    bool search(const QString &filePath, int limit, QVector<SearchMatch> *matches) const
+    {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        const qint64 size = file.size();
+        if (size == 0) {
+            return true;
+        }
+
+        QByteArray buffer;
+        const char *data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            buffer = file.readAll();
+            data = buffer.constData();
+        }
+        const char *end = data + size;
+        if (std::memchr(data, '\0', std::min(size, kBinaryProbeBytes))) {
+            return false;
+        }
+
+        int lineNumber = 1;
+        const char *counted = data;
+        const char *p = data;
+        while (p < end && matches->size() < limit) {
+            // Without a required literal every line is a candidate
+            const char *hit = m_scanner.isValid() ? m_scanner.find(p, end) : p;
+            if (!hit) {
+                break;
+            }
+            const char *lineStart = hit;
+            while (lineStart > p && lineStart[-1] != '\n') {
+                --lineStart;
+            }
+            const char *lineEnd = static_cast<const char *>(std::memchr(hit, '\n', end - hit));
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+            lineNumber += int(std::count(counted, lineStart, '\n'));
+            counted = lineStart;
+
+            const char *textEnd = lineEnd > lineStart && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+            const QString text = QString::fromUtf8(lineStart, textEnd - lineStart);
+            QRegularExpressionMatchIterator it = m_expression.globalMatch(text);
+            while (it.hasNext() && matches->size() < limit) {
+                const QRegularExpressionMatch match = it.next();
+                if (match.capturedLength() == 0) {
+                    continue;
+                }
+                matches->append({filePath, lineNumber, int(match.capturedStart()), int(match.capturedLength()), text});
+            }
+            if (lineEnd == end) {
+                break;
+            }
+            p = lineEnd + 1;
+        }
+        return true;
+    }
+
+private:
+    QRegularExpression m_expression;
+    LiteralScanner m_scanner;
+};
+}
+
+QRegularExpression SearchOptions::expression() const
+{
+    QString source = regex ? pattern : QRegularExpression::escape(pattern);
+    if (wholeWord) {
+        source = "\\b(?:" + source + ")\\b";
+    }
+    QRegularExpression::PatternOptions patternOptions = QRegularExpression::NoPatternOption;
+    if (!caseSensitive) {
+        patternOptions |= QRegularExpression::CaseInsensitiveOption;
+    }
+    return QRegularExpression(source, patternOptions);
+}
+
+QByteArray SearchOptions::requiredLiteral() const
+{
+    QString literal;
+    if (!regex) {
+        literal = pattern;
+    } else {
+        // Longest run of plain characters that every match must contain; alternation at any
+        // level, groups and classes end a run, and optional characters are dropped from it.
+        // Inline options such as (?i) and \Q...\E quoting change what later characters mean,
+        // so those patterns get no literal at all.
+        if (pattern.contains('|') || pattern.contains(QLatin1String("(?")) || pattern.contains(QLatin1String("\\Q"))) {
+            return QByteArray();
+        }
+        QString run;
+        auto endRun = [&]() {
+            if (run.size() > literal.size()) {
+                literal = run;
+            }
+            run.clear();
+        };
+        for (int i = 0; i < pattern.size(); ++i) {
+            const QChar c = pattern.at(i);
+            if (c == '\\' && i + 1 < pattern.size()) {
+                const QChar escaped = pattern.at(++i);
+                if (escaped.isLetterOrNumber()) {
+                    endRun();   // \d, \w, \b, back references...
+                } else {
+                    run += escaped;
+                }
+            } else if (c == '[' || c == '(') {
+                endRun();
+                int depth = 1;
+                const QChar close = c == '[' ? QChar(']') : QChar(')');
+                while (++i < pattern.size() && depth > 0) {
+                    if (pattern.at(i) == '\\') {
+                        ++i;
+                    } else if (pattern.at(i) == c && c == '(') {
+                        ++depth;
+                    } else if (pattern.at(i) == close) {
+                        --depth;
+                    }
+                }
+                --i;
+            } else if (c == '?' || c == '*' || c == '{') {
+                if (!run.isEmpty()) {
+                    run.chop(1);
+                }
+                endRun();
+                if (c == '{') {
+                    while (i + 1 < pattern.size() && pattern.at(i) != '}') {
+                        ++i;
+                    }
+                }
+            } else if (c == '+') {
+                endRun();
+            } else if (c == '.' || c == '^' || c == '$' || c == ')' || c == ']' || c == '}') {
+                endRun();
+            } else {
+                run += c;
+            }
+        }
+        endRun();
+    }
+
+    QByteArray bytes = literal.toUtf8();
+    if (!caseSensitive) {
+        // Case folding outside ASCII is left to the regular expression
+        for (char c : std::as_const(bytes)) {
+            if (uchar(c) >= 0x80) {
+                return QByteArray();
+            }
+        }
+        bytes = bytes.toLower();
+    }
+    return bytes;
+}
+
+bool FileStamp::isCurrent(const QString &filePath) const
+{
+    const QFileInfo info(filePath);
+    return info.size() == size && info.lastModified().toMSecsSinceEpoch() == modified;
+}
+
+struct FindInFiles::Job
+{
+    QStringList files;
+    FileStamps unverified;
+    FileSearcher searcher;
+    std::atomic<int> nextFile{0};
+    std::atomic<int> filesSearched{0};
+    std::atomic<int> matchCount{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<bool> cancelled{false};
+
+    Job(const QStringList &fileList, const FileStamps &stamps, const SearchOptions &options)
+        : files(fileList)
+        , unverified(stamps)
+        , searcher(options)
+    {
+    }
+};
+
+FindInFiles::FindInFiles(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+}
+
+FindInFiles::~FindInFiles()
+{
+    cancel();
+    for (QThread *thread : std::as_const(m_threads)) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+QVector<SearchMatch> FindInFiles::searchFile(const QString &filePath, const SearchOptions &options, int limit)
+{
+    QVector<SearchMatch> matches;
+    FileSearcher searcher(options);
+    if (searcher.isValid()) {
+        searcher.search(filePath, limit, &matches);
+    }
+    return matches;
+}
+
+void FindInFiles::start(const QStringList &files, const SearchOptions &options, const FileStamps &unverified)
+{
+    cancel();
+    const quint64 generation = ++m_generation;
+    auto job = std::make_shared<Job>(files, unverified, options);
+    m_job = job;
+    if (!job->searcher.isValid() || files.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this, generation]() {
+            complete(generation, 0, 0, false);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // Workers claim small runs of files from a shared counter, so a thread that hits a few
+    // huge files does not hold up the rest of the queue
+    const int workerCount = qBound(1, QThread::idealThreadCount(), int((files.size() + kFilesPerClaim - 1) / kFilesPerClaim));
+    job->activeWorkers = workerCount;
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *thread = QThread::create([this, job, generation]() {
+            QVector<SearchMatch> batch;
+            QElapsedTimer sinceFlush;
+            sinceFlush.start();
+            auto flush = [&]() {
+                if (!batch.isEmpty()) {
+                    QMetaObject::invokeMethod(this, [this, generation, batch]() {
+                        deliver(generation, batch);
+                    }, Qt::QueuedConnection);
+                    batch.clear();
+                }
+                sinceFlush.restart();
+            };
+
+            while (!job->cancelled) {
+                const int first = job->nextFile.fetch_add(kFilesPerClaim);
+                if (first >= job->files.size()) {
+                    break;
+                }
+                const int last = std::min<int>(first + kFilesPerClaim, job->files.size());
+                for (int index = first; index < last && !job->cancelled; ++index) {
+                    const int remaining = kMaxMatches - job->matchCount.load();
+                    if (remaining <= 0) {
+                        job->cancelled = true;
+                        break;
+                    }
+                    const QString &filePath = job->files.at(index);
+                    const auto stamp = job->unverified.constFind(filePath);
+                    if (stamp != job->unverified.constEnd()) {
+                        if (stamp->isCurrent(filePath)) {
+                            continue;
+                        }
+                        emit fileOutdated(filePath);
+                    }
+                    const int before = batch.size();
+                    job->searcher.search(filePath, remaining, &batch);
+                    job->matchCount += batch.size() - before;
+                    ++job->filesSearched;
+                    if (batch.size() >= kBatchMatches || sinceFlush.elapsed() >= kBatchIntervalMs) {
+                        flush();
+                    }
+                }
+            }
+            flush();
+
+            if (--job->activeWorkers == 0) {
+                const bool stopped = job->cancelled && job->matchCount < kMaxMatches;
+                const int filesSearched = job->filesSearched;
+                const int matchCount = std::min(job->matchCount.load(), kMaxMatches);
+                QMetaObject::invokeMethod(this, [this, generation, filesSearched, matchCount, stopped]() {
+                    complete(generation, filesSearched, matchCount, stopped);
+                }, Qt::QueuedConnection);
+            }
+        });
+        thread->setObjectName("FindInFiles worker");
+        m_threads.append(thread);
+        connect(thread, &QThread::finished, this, [this, thread]() {
+            m_threads.removeOne(thread);
+            thread->deleteLater();
+        });
+        thread->start(QThread::LowPriority);
+    }
+}
+
+void FindInFiles::cancel()
+{
+    if (m_job) {
+        m_job->cancelled = true;
+        m_job.reset();
+    }
+}
+
+bool FindInFiles::isRunning() const
+{
+    return m_job != nullptr;
+}
+
+void FindInFiles::deliver(quint64 generation, const QVector<SearchMatch> &matches)
+{
+    // Batches from a cancelled or replaced search can still be in the event queue
+    if (generation == m_generation && m_job) {
+        emit matchesFound(matches);
+    }
+}
+
+void FindInFiles::complete(quint64 generation, int filesSearched, int matchCount, bool cancelled)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    m_job.reset();
+    emit finished(filesSearched, matchCount, cancelled);
+}
@@ -0,0 +1,84 @@
+#ifndef FINDINFILES_H
+#define FINDINFILES_H
+
+#include <QObject>
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class QThread;
+
+struct SearchOptions
+{
+    QString pattern;
+    bool regex = false;
+    bool caseSensitive = false;
+    bool wholeWord = false;
+
+    QRegularExpression expression() const;
+    // Bytes every match must contain, lowercased for case-insensitive searches; empty when unknown
+    QByteArray requiredLiteral() const;
+};
+
+// Size and modification time a file was indexed with. The workers check it before reading
+// the file, so the GUI thread never stats the files an index ruled out.
+struct FileStamp
+{
+    qint64 size = 0;
+    qint64 modified = 0;
+
+    bool isCurrent(const QString &filePath) const;
+};
+using FileStamps = QHash<QString, FileStamp>;
+
+struct SearchMatch
+{
+    QString filePath;
+    int line;      // 1-based
+    int column;    // 0-based, in UTF-16 code units like the editor
+    int length;
+    QString lineText;
+};
+
+// Searches file contents on a pool of worker threads and streams matches back in batches.
+// Files are memory mapped and scanned for a required literal with memchr before the
+// regular expression confirms a candidate line, so most of a large tree is never decoded.
+class FindInFiles : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxMatches = 50000;
+
+    explicit FindInFiles(QObject *parent = nullptr);
+    ~FindInFiles() override;
+
+    // Cancels any running search first. Files listed in unverified are only searched when
+    // they no longer match their stamp, and are then reported through fileOutdated().
+    void start(const QStringList &files, const SearchOptions &options,
+               const FileStamps &unverified = FileStamps());
+    void cancel();
+    bool isRunning() const;
+
+    // Synchronous single-file search, also used by the workers
+    static QVector<SearchMatch> searchFile(const QString &filePath, const SearchOptions &options, int limit = kMaxMatches);
+
+signals:
+    void matchesFound(const QVector<SearchMatch> &matches);
+    void finished(int filesSearched, int matchCount, bool cancelled);
+    void fileOutdated(const QString &filePath);
+
+private:
+    struct Job;
+
+    void deliver(quint64 generation, const QVector<SearchMatch> &matches);
+    void complete(quint64 generation, int filesSearched, int matchCount, bool cancelled);
+
+    std::shared_ptr<Job> m_job;
+    quint64 m_generation;
+    QList<QThread *> m_threads;
+};
+
+#endif // FINDINFILES_H
@@ -0,0 +1,169 @@
+#include "FindInFilesPanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QDir>
+#include <QSet>
+
+FindInFilesPanel::FindInFilesPanel(QWidget *parent)
+    : QWidget(parent)
+    , m_running(false)
+    , m_matchCount(0)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    auto *searchRow = new QHBoxLayout;
+    m_patternEdit = new QLineEdit;
+    m_patternEdit->setPlaceholderText("Search in project files");
+    searchRow->addWidget(m_patternEdit, 1);
+    m_regexCheck = new QCheckBox("Regex");
+    m_caseCheck = new QCheckBox("Match case");
+    m_wordCheck = new QCheckBox("Whole word");
+    for (QCheckBox *check : {m_regexCheck, m_caseCheck, m_wordCheck}) {
+        check->setStyleSheet("color: white;");
+        searchRow->addWidget(check);
+    }
+    m_searchButton = new QPushButton("Search");
+    searchRow->addWidget(m_searchButton);
+    layout->addLayout(searchRow);
+
+    auto *replaceRow = new QHBoxLayout;
+    m_replaceEdit = new QLineEdit;
+    m_replaceEdit->setPlaceholderText("Replace with (\\1 inserts a regex group)");
+    replaceRow->addWidget(m_replaceEdit, 1);
+    m_replaceButton = new QPushButton("Replace All...");
+    replaceRow->addWidget(m_replaceButton);
+    layout->addLayout(replaceRow);
+
+    m_summaryLabel = new QLabel;
+    m_summaryLabel->setStyleSheet("color: white;");
+    layout->addWidget(m_summaryLabel);
+
+    m_results = new QTreeWidget;
+    m_results->setHeaderHidden(true);
+    m_results->setUniformRowHeights(true);
+    m_results->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(m_results, 1);
+
+    connect(m_patternEdit, &QLineEdit::returnPressed, this, &FindInFilesPanel::onSearchClicked);
+    connect(m_searchButton, &QPushButton::clicked, this, &FindInFilesPanel::onSearchClicked);
+    connect(m_replaceButton, &QPushButton::clicked, this, &FindInFilesPanel::onReplaceClicked);
+    connect(m_results, &QTreeWidget::itemActivated, this, &FindInFilesPanel::onItemActivated);
+}
+
+void FindInFilesPanel::setRootPath(const QString &rootPath)
+{
+    m_rootPath = rootPath;
+}
+
+void FindInFilesPanel::focusSearch(const QString &initialText)
+{
+    if (!initialText.isEmpty()) {
+        m_patternEdit->setText(initialText);
+    }
+    m_patternEdit->selectAll();
+    m_patternEdit->setFocus();
+}
+
+SearchOptions FindInFilesPanel::options() const
+{
+    SearchOptions options;
+    options.pattern = m_patternEdit->text();
+    options.regex = m_regexCheck->isChecked();
+    options.caseSensitive = m_caseCheck->isChecked();
+    options.wholeWord = m_wordCheck->isChecked();
+    return options;
+}
+
+void FindInFilesPanel::onSearchClicked()
+{
+    if (m_running) {
+        emit stopRequested();
+        return;
+    }
+    const SearchOptions searchOptions = options();
+    if (searchOptions.pattern.isEmpty()) {
+        return;
+    }
+    if (!searchOptions.expression().isValid()) {
+        m_summaryLabel->setText("Invalid regular expression: " + searchOptions.expression().errorString());
+        return;
+    }
+
+    m_results->clear();
+    m_fileItems.clear();
+    m_matchCount = 0;
+    m_running = true;
+    m_searchButton->setText("Stop");
+    m_summaryLabel->setText("Searching...");
+    emit searchRequested(searchOptions);
+}
+
+void FindInFilesPanel::onReplaceClicked()
+{
+    const SearchOptions searchOptions = options();
+    if (searchOptions.pattern.isEmpty()) {
+        return;
+    }
+    if (!searchOptions.expression().isValid()) {
+        m_summaryLabel->setText("Invalid regular expression: " + searchOptions.expression().errorString());
+        return;
+    }
+    m_summaryLabel->setText("Preparing replacements...");
+    emit replaceRequested(searchOptions, m_replaceEdit->text());
+}
+
+QTreeWidgetItem *FindInFilesPanel::fileItem(const QString &filePath)
+{
+    QTreeWidgetItem *&item = m_fileItems[filePath];
+    if (!item) {
+        item = new QTreeWidgetItem(m_results);
+        item->setData(0, Qt::UserRole, filePath);
+        item->setData(0, Qt::UserRole + 1, 1);
+        item->setExpanded(true);
+    }
+    return item;
+}
+
+void FindInFilesPanel::addMatches(const QVector<SearchMatch> &matches)
+{
+    m_results->setUpdatesEnabled(false);
+    QSet<QTreeWidgetItem *> touched;
+    for (const SearchMatch &match : matches) {
+        QTreeWidgetItem *parent = fileItem(match.filePath);
+        auto *item = new QTreeWidgetItem(parent);
+        item->setText(0, QString("%1: %2").arg(match.line).arg(match.lineText.trimmed()));
+        item->setData(0, Qt::UserRole, match.filePath);
+        item->setData(0, Qt::UserRole + 1, match.line);
+        touched.insert(parent);
+    }
+    // File rows show the relative path and how many matches it has so far
+    for (QTreeWidgetItem *parent : std::as_const(touched)) {
+        const QString filePath = parent->data(0, Qt::UserRole).toString();
+        const QString shown = m_rootPath.isEmpty() ? filePath : QDir(m_rootPath).relativeFilePath(filePath);
+        parent->setText(0, QString("%1 (%2)").arg(shown).arg(parent->childCount()));
+    }
+    m_results->setUpdatesEnabled(true);
+
+    m_matchCount += matches.size();
+    m_summaryLabel->setText(QString("Searching... %1 matches in %2 files").arg(m_matchCount).arg(m_fileItems.size()));
+}
+
+void FindInFilesPanel::searchFinished(int filesSearched, int matchCount, bool cancelled)
+{
+    m_running = false;
+    m_searchButton->setText("Search");
+    QString summary = QString("%1 matches in %2 of %3 files").arg(matchCount).arg(m_fileItems.size()).arg(filesSearched);
+    if (cancelled) {
+        summary += " (stopped)";
+    } else if (matchCount >= FindInFiles::kMaxMatches) {
+        summary += QString(" (limited to the first %1)").arg(FindInFiles::kMaxMatches);
+    }
+    m_summaryLabel->setText(summary);
+}
+
+void FindInFilesPanel::onItemActivated(QTreeWidgetItem *item)
+{
+    emit openLocation(item->data(0, Qt::UserRole).toString(), item->data(0, Qt::UserRole + 1).toInt());
+}
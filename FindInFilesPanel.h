@@ -0,0 +1,58 @@
+#ifndef FINDINFILESPANEL_H
+#define FINDINFILESPANEL_H
+
+#include <QWidget>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QLabel>
+#include <QHash>
+#include "FindInFiles.h"
+
+// Search field and results grouped by file; results are appended while the search runs
+class FindInFilesPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FindInFilesPanel(QWidget *parent = nullptr);
+
+    void setRootPath(const QString &rootPath);
+    void focusSearch(const QString &initialText = QString());
+    SearchOptions options() const;
+
+public slots:
+    void addMatches(const QVector<SearchMatch> &matches);
+    void searchFinished(int filesSearched, int matchCount, bool cancelled);
+
+signals:
+    void searchRequested(const SearchOptions &options);
+    void stopRequested();
+    void replaceRequested(const SearchOptions &options, const QString &replacement);
+    void openLocation(const QString &file, int line);
+
+private slots:
+    void onSearchClicked();
+    void onReplaceClicked();
+    void onItemActivated(QTreeWidgetItem *item);
+
+private:
+    QTreeWidgetItem *fileItem(const QString &filePath);
+
+    QString m_rootPath;
+    bool m_running;
+    int m_matchCount;
+    QLineEdit *m_patternEdit;
+    QCheckBox *m_regexCheck;
+    QCheckBox *m_caseCheck;
+    QCheckBox *m_wordCheck;
+    QPushButton *m_searchButton;
+    QLineEdit *m_replaceEdit;
+    QPushButton *m_replaceButton;
+    QLabel *m_summaryLabel;
+    QTreeWidget *m_results;
+    QHash<QString, QTreeWidgetItem *> m_fileItems;
+};
+
+#endif // FINDINFILESPANEL_H
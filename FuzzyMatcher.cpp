@@ -0,0 +1,292 @@
+#include "FuzzyMatcher.h"
+#include <QDir>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace {
+constexpr int kScoreMatch = 16;
+constexpr int kBonusBoundary = 10;      // after a separator or at the start
+constexpr int kBonusCamelCase = 8;
+constexpr int kBonusConsecutive = 6;
+constexpr int kBonusFileName = 24;      // the whole pattern fits in the file name
+constexpr int kPenaltyGapStart = 3;
+constexpr int kPenaltyGapExtension = 1;
+constexpr int kParallelThreshold = 20000;
+
+// Lowercases one code unit at a time so both arenas keep identical offsets
+QString lowerCodeUnits(QStringView text)
+{
+    QString lower(text.size(), Qt::Uninitialized);
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        lower[i] = text[i].toLower();
+    }
+    return lower;
+}
+
+int bonusAt(QStringView text, qsizetype i)
+{
+    if (i == 0) {
+        return kBonusBoundary;
+    }
+    const QChar previous = text[i - 1];
+    if (previous == '/' || previous == '_' || previous == '-' || previous == '.' || previous == ' ') {
+        return kBonusBoundary;
+    }
+    if (previous.isLower() && text[i].isUpper()) {
+        return kBonusCamelCase;
+    }
+    return 0;
+}
+
+// Scores the shortest window that ends where the pattern first completes
+int scoreWindow(QStringView text, QStringView lower, QStringView pattern)
+{
+    qsizetype p = 0;
+    qsizetype end = -1;
+    for (qsizetype i = 0; i < lower.size(); ++i) {
+        if (lower[i] == pattern[p] && ++p == pattern.size()) {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) {
+        return -1;
+    }
+
+    p = pattern.size() - 1;
+    qsizetype start = end;
+    for (qsizetype i = end; i >= 0; --i) {
+        if (lower[i] == pattern[p] && --p < 0) {
+            start = i;
+            break;
+        }
+    }
+
+    int score = 0;
+    bool consecutive = false;
+    bool inGap = false;
+    p = 0;
+    for (qsizetype i = start; i <= end; ++i) {
+        if (p < pattern.size() && lower[i] == pattern[p]) {
+            score += kScoreMatch + bonusAt(text, i) + (consecutive ? kBonusConsecutive : 0);
+            consecutive = true;
+            inGap = false;
+            ++p;
+        } else {
+            score -= inGap ? kPenaltyGapExtension : kPenaltyGapStart;
+            consecutive = false;
+            inGap = true;
+        }
+    }
+    return score;
+}
+
+int scorePath(QStringView text, QStringView lower, qsizetype nameStart, QStringView pattern)
+{
+    // A match inside the file name beats one spread over the directories
+    const int nameScore = scoreWindow(text.mid(nameStart), lower.mid(nameStart), pattern);
+    if (nameScore >= 0) {
+        return nameScore + kBonusFileName;
+    }
+    return scoreWindow(text, lower, pattern);
+}
+
+bool isSubsequence(QStringView pattern, QStringView text)
+{
+    qsizetype p = 0;
+    for (qsizetype i = 0; i < text.size() && p < pattern.size(); ++i) {
+        if (text[i] == pattern[p]) {
+            ++p;
+        }
+    }
+    return p == pattern.size();
+}
+}
+
+void FuzzyMatcher::setPaths(const QStringList &paths, const QString &rootPath)
+{
+    m_rootPath = rootPath;
+    m_arena.clear();
+    m_offsets.clear();
+    m_nameStarts.clear();
+    m_signatures.clear();
+    m_lastPattern.clear();
+    m_lastSurvivors.clear();
+
+    const QString prefix = rootPath.isEmpty() ? QString() : rootPath + '/';
+    qsizetype total = 0;
+    for (const QString &path : paths) {
+        total += path.size();
+    }
+    m_arena.reserve(total);
+    m_offsets.reserve(paths.size() + 1);
+    m_nameStarts.reserve(paths.size());
+    m_signatures.reserve(paths.size());
+
+    m_offsets.append(0);
+    for (const QString &path : paths) {
+        const QStringView relative = !prefix.isEmpty() && path.startsWith(prefix)
+                                         ? QStringView(path).mid(prefix.size()) : QStringView(path);
+        m_nameStarts.append(quint32(relative.lastIndexOf('/') + 1));
+        m_arena.append(relative);
+        m_offsets.append(quint32(m_arena.size()));
+    }
+    m_lowerArena = lowerCodeUnits(m_arena);
+    for (int i = 0; i < size(); ++i) {
+        m_signatures.append(signature(lowerText(i)));
+    }
+}
+
+quint64 FuzzyMatcher::signature(QStringView lowerText)
+{
+    // One bit per letter, digit and common separator; anything else shares a bit
+    quint64 mask = 0;
+    for (QChar c : lowerText) {
+        const char16_t u = c.unicode();
+        int bit;
+        if (u >= 'a' && u <= 'z') {
+            bit = u - 'a';
+        } else if (u >= '0' && u <= '9') {
+            bit = 26 + (u - '0');
+        } else if (u == '_') {
+            bit = 36;
+        } else if (u == '-') {
+            bit = 37;
+        } else if (u == '.') {
+            bit = 38;
+        } else if (u == '/') {
+            bit = 39;
+        } else {
+            bit = u < 128 ? 40 : 41;
+        }
+        mask |= quint64(1) << bit;
+    }
+    return mask;
+}
+
+QString FuzzyMatcher::path(int index) const
+{
+    return QDir(m_rootPath).filePath(relativePath(index));
+}
+
+QString FuzzyMatcher::relativePath(int index) const
+{
+    return m_arena.mid(m_offsets.at(index), m_offsets.at(index + 1) - m_offsets.at(index));
+}
+
+QString FuzzyMatcher::fileName(int index) const
+{
+    const quint32 start = m_offsets.at(index) + m_nameStarts.at(index);
+    return m_arena.mid(start, m_offsets.at(index + 1) - start);
+}
+
+QStringView FuzzyMatcher::lowerText(int index) const
+{
+    return QStringView(m_lowerArena).mid(m_offsets.at(index), m_offsets.at(index + 1) - m_offsets.at(index));
+}
+
+int FuzzyMatcher::score(QStringView text, QStringView lowerText, QStringView lowerPattern)
+{
+    if (lowerPattern.isEmpty()) {
+        return 0;
+    }
+    return scorePath(text, lowerText, text.lastIndexOf('/') + 1, lowerPattern);
+}
+
+int FuzzyMatcher::scoreAt(int index, QStringView lowerPattern) const
+{
+    const QStringView text = QStringView(m_arena).mid(m_offsets.at(index), m_offsets.at(index + 1) - m_offsets.at(index));
+    return scorePath(text, lowerText(index), m_nameStarts.at(index), lowerPattern);
+}
+
+bool FuzzyMatcher::better(const FuzzyMatch &a, const FuzzyMatch &b) const
+{
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    const quint32 lengthA = m_offsets.at(a.index + 1) - m_offsets.at(a.index);
+    const quint32 lengthB = m_offsets.at(b.index + 1) - m_offsets.at(b.index);
+    return lengthA != lengthB ? lengthA < lengthB : a.index < b.index;
+}
+
+void FuzzyMatcher::scoreRange(const QVector<int> *candidates, int begin, int end, QStringView lowerPattern,
+                              quint64 mask, int limit, QVector<FuzzyMatch> *matches, QVector<int> *survivors) const
+{
+    for (int i = begin; i < end; ++i) {
+        const int index = candidates ? candidates->at(i) : i;
+        if ((m_signatures.at(index) & mask) != mask) {
+            continue;
+        }
+        const int score = scoreAt(index, lowerPattern);
+        if (score < 0) {
+            continue;
+        }
+        survivors->append(index);
+        matches->append({index, score});
+    }
+
+    // Each chunk only needs to hand over its own best `limit`
+    auto order = [this](const FuzzyMatch &a, const FuzzyMatch &b) { return better(a, b); };
+    if (matches->size() > limit) {
+        std::nth_element(matches->begin(), matches->begin() + limit, matches->end(), order);
+        matches->resize(limit);
+    }
+}
+
+QVector<FuzzyMatch> FuzzyMatcher::match(const QString &pattern, int limit)
+{
+    QString lowerPattern = lowerCodeUnits(pattern);
+    lowerPattern.remove(' ');
+
+    QVector<FuzzyMatch> results;
+    if (lowerPattern.isEmpty()) {
+        m_lastPattern.clear();
+        m_lastSurvivors.clear();
+        for (int i = 0; i < qMin(limit, size()); ++i) {
+            results.append({i, 0});
+        }
+        return results;
+    }
+
+    // Anything matching the new pattern also matched one it contains as a subsequence
+    const bool narrowing = !m_lastPattern.isEmpty() && isSubsequence(m_lastPattern, lowerPattern);
+    const QVector<int> *candidates = narrowing ? &m_lastSurvivors : nullptr;
+    const int count = narrowing ? m_lastSurvivors.size() : size();
+    const quint64 mask = signature(lowerPattern);
+
+    const int chunks = count >= kParallelThreshold ? qBound(1, QThread::idealThreadCount(), 16) : 1;
+    QVector<QVector<FuzzyMatch>> matches(chunks);
+    QVector<QVector<int>> survivors(chunks);
+    auto runChunk = [&, this](int chunk) {
+        const int begin = int(qint64(count) * chunk / chunks);
+        const int end = int(qint64(count) * (chunk + 1) / chunks);
+        scoreRange(candidates, begin, end, lowerPattern, mask, limit, &matches[chunk], &survivors[chunk]);
+    };
+
+    // The calling thread takes the first chunk while the pool handles the rest
+    QSemaphore done;
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        QThreadPool::globalInstance()->start([&runChunk, &done, chunk]() {
+            runChunk(chunk);
+            done.release();
+        });
+    }
+    runChunk(0);
+    done.acquire(chunks - 1);
+
+    QVector<int> allSurvivors;
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        allSurvivors += survivors.at(chunk);
+        results += matches.at(chunk);
+    }
+    m_lastSurvivors = allSurvivors;
+    m_lastPattern = lowerPattern;
+
+    auto order = [this](const FuzzyMatch &a, const FuzzyMatch &b) { return better(a, b); };
+    const int top = qMin<int>(limit, results.size());
+    std::partial_sort(results.begin(), results.begin() + top, results.end(), order);
+    results.resize(top);
+    return results;
+}
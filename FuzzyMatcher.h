@@ -0,0 +1,53 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct FuzzyMatch
+{
+    int index;   // into the matcher's path list
+    int score;
+};
+
+// Fuzzy file name matching for quick open, sized for projects with hundreds of thousands of files.
+// Relative paths live in one contiguous arena with a lowercase copy and a per-path character
+// signature, so most candidates are rejected with a single mask test. Scoring is split across
+// threads for large lists, and a query that extends the previous one only rescans its survivors.
+class FuzzyMatcher
+{
+public:
+    void setPaths(const QStringList &paths, const QString &rootPath);
+    int size() const { return m_offsets.isEmpty() ? 0 : m_offsets.size() - 1; }
+    QString path(int index) const;           // absolute
+    QString relativePath(int index) const;
+    QString fileName(int index) const;
+
+    // Best matches first; an empty pattern returns the first paths in project order
+    QVector<FuzzyMatch> match(const QString &pattern, int limit);
+
+    // Higher is better, -1 when the pattern is not a subsequence of the text
+    static int score(QStringView text, QStringView lowerText, QStringView lowerPattern);
+
+private:
+    static quint64 signature(QStringView lowerText);
+    QStringView lowerText(int index) const;
+    int scoreAt(int index, QStringView lowerPattern) const;
+    bool better(const FuzzyMatch &a, const FuzzyMatch &b) const;
+    void scoreRange(const QVector<int> *candidates, int begin, int end, QStringView lowerPattern, quint64 mask,
+                    int limit, QVector<FuzzyMatch> *matches, QVector<int> *survivors) const;
+
+    QString m_rootPath;
+    QString m_arena;        // relative paths back to back
+    QString m_lowerArena;   // same layout, lowercased
+    QVector<quint32> m_offsets;     // path i spans [m_offsets[i], m_offsets[i + 1])
+    QVector<quint32> m_nameStarts;  // offset of the file name within path i
+    QVector<quint64> m_signatures;
+
+    // Candidates that matched the previous pattern, reused when the user keeps typing
+    QString m_lastPattern;
+    QVector<int> m_lastSurvivors;
+};
+
+#endif // FUZZYMATCHER_H
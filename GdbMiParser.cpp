@@ -0,0 +1,284 @@
+#include "GdbMiParser.h"
+#include <cstring>
+
+namespace {
+const GdbMiValue &invalidValue()
+{
+    static const GdbMiValue value;
+    return value;
+}
+
+bool isNameChar(char c)
+{
+    return c != '=' && c != ',' && c != '{' && c != '}' && c != '[' && c != ']' && c != '"' && c != '\r';
+}
+}
+
+QString GdbMiValue::text() const
+{
+    return decodeCString(m_data);
+}
+
+int GdbMiValue::toInt(int defaultValue) const
+{
+    bool ok = false;
+    int value = m_data.toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+const GdbMiValue &GdbMiValue::operator[](QByteArrayView name) const
+{
+    for (const GdbMiValue &child : m_children) {
+        if (child.m_name == name) {
+            return child;
+        }
+    }
+    return invalidValue();
+}
+
+QString GdbMiValue::decodeCString(QByteArrayView escaped)
+{
+    // Most constants (numbers, addresses, file names) have no escapes at all
+    if (escaped.isEmpty() || !memchr(escaped.data(), '\\', size_t(escaped.size()))) {
+        return QString::fromUtf8(escaped);
+    }
+
+    QByteArray decoded;
+    decoded.reserve(escaped.size());
+    for (qsizetype i = 0; i < escaped.size(); ++i) {
+        char c = escaped.at(i);
+        if (c != '\\' || i + 1 == escaped.size()) {
+            decoded.append(c);
+            continue;
+        }
+
+        c = escaped.at(++i);
+        switch (c) {
+        case 'n': decoded.append('\n'); break;
+        case 't': decoded.append('\t'); break;
+        case 'r': decoded.append('\r'); break;
+        case 'e': decoded.append('\033'); break;
+        case 'a': decoded.append('\a'); break;
+        case 'b': decoded.append('\b'); break;
+        case 'f': decoded.append('\f'); break;
+        case 'v': decoded.append('\v'); break;
+        default:
+            if (c >= '0' && c <= '7') {
+                // GDB escapes non-printable bytes as up to three octal digits
+                int value = 0;
+                int digits = 0;
+                while (digits < 3 && i < escaped.size() && escaped.at(i) >= '0' && escaped.at(i) <= '7') {
+                    value = value * 8 + (escaped.at(i) - '0');
+                    ++i;
+                    ++digits;
+                }
+                --i;
+                decoded.append(char(value));
+            } else {
+                decoded.append(c);
+            }
+            break;
+        }
+    }
+    return QString::fromUtf8(decoded);
+}
+
+QVector<GdbMiRecord> GdbMiParser::feed(const QByteArray &chunk)
+{
+    QVector<GdbMiRecord> records;
+
+    // Only a line split across reads forces a copy
+    QByteArray data = m_partial.isEmpty() ? chunk : m_partial + chunk;
+    m_partial.clear();
+
+    const char *base = data.constData();
+    qsizetype begin = 0;
+    for (;;) {
+        const void *newline = memchr(base + begin, '\n', size_t(data.size() - begin));
+        if (!newline) {
+            break;
+        }
+        qsizetype end = static_cast<const char *>(newline) - base;
+        qsizetype lineEnd = end > begin && base[end - 1] == '\r' ? end - 1 : end;
+
+        if (lineEnd > begin) {
+            GdbMiRecord record;
+            if (!parseRecord(data, begin, lineEnd, &record)) {
+                record = GdbMiRecord();
+                record.type = GdbMiRecord::Other;
+                record.buffer = data;
+            }
+            record.line = QByteArrayView(base + begin, lineEnd - begin);
+            records.append(record);
+        }
+        begin = end + 1;
+    }
+
+    if (begin < data.size()) {
+        m_partial = data.mid(begin);
+    }
+    return records;
+}
+
+bool GdbMiParser::parseRecord(const QByteArray &buffer, qsizetype begin, qsizetype end, GdbMiRecord *record)
+{
+    Cursor cursor{buffer.constData() + begin, buffer.constData() + end};
+    record->buffer = buffer;
+
+    if (QByteArrayView(cursor.pos, cursor.end - cursor.pos).startsWith("(gdb)")) {
+        record->type = GdbMiRecord::Prompt;
+        return true;
+    }
+
+    // Optional numeric token ties a result record to the command that caused it
+    if (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9') {
+        int token = 0;
+        while (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9') {
+            token = token * 10 + (*cursor.pos - '0');
+            ++cursor.pos;
+        }
+        record->token = token;
+    }
+    if (cursor.pos == cursor.end) {
+        return false;
+    }
+
+    const char marker = *cursor.pos++;
+    switch (marker) {
+    case '~':
+    case '@':
+    case '&': {
+        record->type = marker == '~' ? GdbMiRecord::ConsoleStream
+                     : marker == '@' ? GdbMiRecord::TargetStream
+                                     : GdbMiRecord::LogStream;
+        record->results.m_kind = GdbMiValue::Const;
+        return parseCString(cursor, &record->results.m_data);
+    }
+    case '^':
+        record->type = GdbMiRecord::Result;
+        break;
+    case '*':
+        record->type = GdbMiRecord::ExecAsync;
+        break;
+    case '+':
+        record->type = GdbMiRecord::StatusAsync;
+        break;
+    case '=':
+        record->type = GdbMiRecord::NotifyAsync;
+        break;
+    default:
+        return false;
+    }
+
+    const char *classBegin = cursor.pos;
+    while (cursor.pos < cursor.end && *cursor.pos != ',') {
+        ++cursor.pos;
+    }
+    record->resultClass = QByteArrayView(classBegin, cursor.pos - classBegin);
+
+    record->results.m_kind = GdbMiValue::Tuple;
+    while (cursor.pos < cursor.end && *cursor.pos == ',') {
+        ++cursor.pos;
+        GdbMiValue result;
+        if (!parseResult(cursor, &result)) {
+            return false;
+        }
+        record->results.m_children.append(std::move(result));
+    }
+    return true;
+}
+
+bool GdbMiParser::parseResult(Cursor &cursor, GdbMiValue *value)
+{
+    const char *nameBegin = cursor.pos;
+    while (cursor.pos < cursor.end && isNameChar(*cursor.pos)) {
+        ++cursor.pos;
+    }
+    if (cursor.pos == cursor.end || *cursor.pos != '=') {
+        return false;
+    }
+    QByteArrayView name(nameBegin, cursor.pos - nameBegin);
+    ++cursor.pos;
+
+    if (!parseValue(cursor, value)) {
+        return false;
+    }
+    value->m_name = name;
+    return true;
+}
+
+bool GdbMiParser::parseValue(Cursor &cursor, GdbMiValue *value)
+{
+    if (cursor.pos == cursor.end) {
+        return false;
+    }
+
+    const char c = *cursor.pos;
+    if (c == '"') {
+        value->m_kind = GdbMiValue::Const;
+        return parseCString(cursor, &value->m_data);
+    }
+
+    if (c != '{' && c != '[') {
+        return false;
+    }
+
+    const char close = c == '{' ? '}' : ']';
+    value->m_kind = c == '{' ? GdbMiValue::Tuple : GdbMiValue::List;
+    ++cursor.pos;
+
+    if (cursor.pos < cursor.end && *cursor.pos == close) {
+        ++cursor.pos;
+        return true;
+    }
+
+    for (;;) {
+        GdbMiValue child;
+        // Lists may hold either bare values or name=value results
+        bool ok = (value->m_kind == GdbMiValue::List && cursor.pos < cursor.end
+                   && (*cursor.pos == '"' || *cursor.pos == '{' || *cursor.pos == '['))
+                      ? parseValue(cursor, &child)
+                      : parseResult(cursor, &child);
+        if (!ok) {
+            return false;
+        }
+        value->m_children.append(std::move(child));
+
+        if (cursor.pos == cursor.end) {
+            return false;
+        }
+        if (*cursor.pos == close) {
+            ++cursor.pos;
+            return true;
+        }
+        if (*cursor.pos != ',') {
+            return false;
+        }
+        ++cursor.pos;
+    }
+}
+
+bool GdbMiParser::parseCString(Cursor &cursor, QByteArrayView *raw)
+{
+    if (cursor.pos == cursor.end || *cursor.pos != '"') {
+        return false;
+    }
+    ++cursor.pos;
+
+    // Find the closing quote, skipping escaped characters; the view keeps the escapes
+    const char *begin = cursor.pos;
+    while (cursor.pos < cursor.end) {
+        if (*cursor.pos == '\\') {
+            cursor.pos += 2;
+            continue;
+        }
+        if (*cursor.pos == '"') {
+            *raw = QByteArrayView(begin, cursor.pos - begin);
+            ++cursor.pos;
+            return true;
+        }
+        ++cursor.pos;
+    }
+    cursor.pos = cursor.end;
+    return false;
+}
@@ -0,0 +1,92 @@
+#ifndef GDBMIPARSER_H
+#define GDBMIPARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVector>
+
+// A node of a GDB/MI result. Names and constants are views into the record's line
+// buffer; C-string escapes are only decoded when a value is asked for as text.
+class GdbMiValue
+{
+public:
+    enum Kind {
+        Invalid,
+        Const,
+        Tuple,
+        List
+    };
+
+    Kind kind() const { return m_kind; }
+    bool isValid() const { return m_kind != Invalid; }
+    QByteArrayView name() const { return m_name; }
+    QByteArrayView rawData() const { return m_data; }
+
+    // Decoded constant, e.g. "a\"b" becomes a"b
+    QString text() const;
+    int toInt(int defaultValue = 0) const;
+
+    const QVector<GdbMiValue> &children() const { return m_children; }
+    int size() const { return m_children.size(); }
+    const GdbMiValue &at(int index) const { return m_children.at(index); }
+    const GdbMiValue &operator[](QByteArrayView name) const;
+
+    static QString decodeCString(QByteArrayView escaped);
+
+private:
+    friend class GdbMiParser;
+
+    Kind m_kind = Invalid;
+    QByteArrayView m_name;
+    QByteArrayView m_data;
+    QVector<GdbMiValue> m_children;
+};
+
+struct GdbMiRecord
+{
+    enum Type {
+        Result,       // ^done, ^running, ^error, ^exit
+        ExecAsync,    // *stopped, *running
+        StatusAsync,  // +download
+        NotifyAsync,  // =thread-created, =breakpoint-modified
+        ConsoleStream,
+        TargetStream,
+        LogStream,
+        Prompt,
+        Other         // Not MI at all, e.g. the debugged program writing to the shared stdout
+    };
+
+    Type type = Prompt;
+    int token = -1;
+    QByteArrayView resultClass;
+    GdbMiValue results;   // Tuple of the record's results, or the stream text as a Const
+    QByteArrayView line;  // The whole undecoded line
+    QByteArray buffer;    // Keeps the views above alive; shares the chunk it was read from
+};
+
+// Incremental MI output parser. Complete lines are parsed in place in the chunk they
+// arrived in; only an unterminated trailing line is copied and carried over.
+class GdbMiParser
+{
+public:
+    QVector<GdbMiRecord> feed(const QByteArray &chunk);
+    void reset() { m_partial.clear(); }
+
+    static bool parseRecord(const QByteArray &buffer, qsizetype begin, qsizetype end, GdbMiRecord *record);
+
+private:
+    struct Cursor
+    {
+        const char *pos;
+        const char *end;
+    };
+
+    static bool parseResult(Cursor &cursor, GdbMiValue *value);
+    static bool parseValue(Cursor &cursor, GdbMiValue *value);
+    static bool parseCString(Cursor &cursor, QByteArrayView *raw);
+
+    QByteArray m_partial;
+};
+
+#endif // GDBMIPARSER_H
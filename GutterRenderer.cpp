@@ -0,0 +1,131 @@
+#include "GutterRenderer.h"
+
+namespace {
+
+constexpr int kDigitGap = 2;   // between the numbers and the fold markers
+
+const QColor kBackground(40, 40, 40, 180);
+const QColor kNumberColor(255, 140, 0);
+
+} // namespace
+
+int GutterRenderer::width(const QFontMetrics &metrics, int digits)
+{
+    const int lineHeight = metrics.height();
+    return lineHeight + lineHeight / 2 + metrics.horizontalAdvance(QLatin1Char('9')) * digits
+           + kDigitGap + foldLaneWidth(metrics) + kChangeLaneWidth;
+}
+
+void GutterRenderer::prepareAtlas(const QFont &font, qreal devicePixelRatio)
+{
+    if (!m_atlas.isNull() && m_atlasRatio == devicePixelRatio && m_atlasFont == font) {
+        return;
+    }
+
+    const QFontMetrics metrics(font);
+    m_atlasFont = font;
+    m_atlasRatio = devicePixelRatio;
+    m_cellWidth = metrics.horizontalAdvance(QLatin1Char('9'));
+    m_lineHeight = metrics.height();
+
+    m_atlas = QPixmap(QSizeF(m_cellWidth * 10 * devicePixelRatio, m_lineHeight * devicePixelRatio).toSize());
+    m_atlas.setDevicePixelRatio(devicePixelRatio);
+    m_atlas.fill(Qt::transparent);
+
+    QPainter painter(&m_atlas);
+    painter.setFont(font);
+    painter.setPen(kNumberColor);
+    for (int digit = 0; digit < 10; ++digit) {
+        painter.drawText(QRectF(digit * m_cellWidth, 0, m_cellWidth, m_lineHeight),
+                         Qt::AlignRight | Qt::AlignTop, QString(QChar(u'0' + digit)));
+    }
+}
+
+void GutterRenderer::paint(QPainter *painter, const QRect &exposed, const QVector<Row> &rows,
+                           const QFont &font, qreal devicePixelRatio, int gutterWidth)
+{
+    prepareAtlas(font, devicePixelRatio);
+    painter->fillRect(exposed, kBackground);
+
+    const qreal scale = 1.0 / devicePixelRatio;
+    const qreal cellPixels = m_cellWidth * devicePixelRatio;
+    const qreal heightPixels = m_lineHeight * devicePixelRatio;
+    const int marker = m_lineHeight;
+    const int foldWidth = m_lineHeight * 3 / 4;
+    const int foldLeft = gutterWidth - kChangeLaneWidth - foldWidth;
+    const int numberRight = foldLeft - kDigitGap;
+    const int changeLeft = gutterWidth - kChangeLaneWidth;
+
+    m_fragments.clear();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+
+    for (const Row &row : rows) {
+        if (row.top > exposed.bottom() || row.top + row.height < exposed.top()) {
+            continue;
+        }
+
+        // Digits from the right; the fragment position is the centre of the cell
+        qreal x = numberRight - m_cellWidth / 2;
+        const qreal y = row.top + m_lineHeight / 2.0;
+        for (int n = row.line; n > 0; n /= 10) {
+            const QRectF source((n % 10) * cellPixels, 0, cellPixels, heightPixels);
+            m_fragments.append(QPainter::PixmapFragment::create(QPointF(x, y), source, scale, scale));
+            x -= m_cellWidth;
+        }
+
+        if (!row.marks) {
+            continue;
+        }
+        if (row.marks & Breakpoint) {
+            painter->setBrush(QColor(220, 50, 50));
+            painter->drawEllipse(QRectF(2, row.top + 2, marker - 4, marker - 4));
+        }
+        if (row.marks & ExecutionLine) {
+            painter->setBrush(QColor(255, 220, 0));
+            const QPointF arrow[3] = {QPointF(3, row.top + 3), QPointF(marker - 2, row.top + marker / 2.0),
+                                      QPointF(3, row.top + marker - 3)};
+            painter->drawPolygon(arrow, 3);
+        }
+        if (row.marks & DiagnosticMarks) {
+            const qreal size = marker / 2.0 - 2;
+            painter->setBrush(row.marks & DiagnosticError ? QColor(240, 70, 70) : QColor(230, 190, 40));
+            painter->drawEllipse(QRectF(marker + 1, row.top + (marker - size) / 2, size, size));
+        }
+        if (row.marks & (FoldStart | Folded)) {
+            // Pointing down while open, right while folded
+            painter->setBrush(QColor(160, 160, 160));
+            const qreal size = foldWidth / 2.0;
+            const QPointF centre(foldLeft + foldWidth / 2.0, row.top + m_lineHeight / 2.0);
+            QPointF triangle[3];
+            if (row.marks & Folded) {
+                triangle[0] = centre + QPointF(-size / 2, -size / 2 - 1);
+                triangle[1] = centre + QPointF(size / 2, 0);
+                triangle[2] = centre + QPointF(-size / 2, size / 2 + 1);
+            } else {
+                triangle[0] = centre + QPointF(-size / 2 - 1, -size / 2);
+                triangle[1] = centre + QPointF(size / 2 + 1, -size / 2);
+                triangle[2] = centre + QPointF(0, size / 2);
+            }
+            painter->drawPolygon(triangle, 3);
+            if (row.marks & Folded) {
+                painter->fillRect(QRect(0, row.top + row.height - 1, gutterWidth, 1), QColor(160, 160, 160, 120));
+            }
+        }
+        if (row.marks & (LineAdded | LineModified)) {
+            painter->fillRect(QRect(changeLeft, row.top, kChangeLaneWidth, row.height),
+                              row.marks & LineAdded ? QColor(80, 180, 80) : QColor(80, 140, 220));
+        }
+        if (row.marks & LinesRemoved) {
+            painter->setBrush(QColor(220, 70, 70));
+            const int bottom = row.top + row.height;
+            const QPointF wedge[3] = {QPointF(changeLeft, bottom - 6), QPointF(gutterWidth, bottom - 3),
+                                      QPointF(changeLeft, bottom)};
+            painter->drawPolygon(wedge, 3);
+        }
+    }
+
+    if (!m_fragments.isEmpty()) {
+        painter->drawPixmapFragments(m_fragments.constData(), m_fragments.size(), m_atlas);
+    }
+}
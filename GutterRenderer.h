@@ -0,0 +1,73 @@
+#ifndef GUTTERRENDERER_H
+#define GUTTERRENDERER_H
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+#include <QVector>
+
+// Paints the editor's gutter: a marker lane (breakpoints, the debugger's line), a diagnostics
+// lane, the line numbers, fold markers and a thin lane for version control changes. Digits
+// are blitted from an atlas rendered once per font and device pixel ratio, all numbers in a
+// paint go out as a single drawPixmapFragments call, and no strings are built per line.
+class GutterRenderer
+{
+public:
+    // Per-line state, combined as bits
+    enum Mark : quint16 {
+        Breakpoint = 0x0001,
+        ExecutionLine = 0x0002,
+        DiagnosticWarning = 0x0004,
+        DiagnosticError = 0x0008,
+        LineAdded = 0x0010,
+        LineModified = 0x0020,
+        LinesRemoved = 0x0040,   // below this line
+        SearchHit = 0x0080,      // overview ruler only
+        FoldStart = 0x0100,      // first line of a region that can be folded
+        Folded = 0x0200,
+
+        DiagnosticMarks = DiagnosticWarning | DiagnosticError,
+        ChangeMarks = LineAdded | LineModified | LinesRemoved
+    };
+
+    // A visible line as laid out by the editor, in gutter coordinates
+    struct Row
+    {
+        int line;     // 1-based
+        int top;
+        int height;
+        quint16 marks;
+
+        bool operator==(const Row &other) const
+        {
+            return line == other.line && top == other.top && height == other.height && marks == other.marks;
+        }
+        bool operator!=(const Row &other) const { return !(*this == other); }
+    };
+
+    static int width(const QFontMetrics &metrics, int digits);
+    static int foldLaneWidth(const QFontMetrics &metrics) { return metrics.height() * 3 / 4; }
+    static int foldLaneLeft(const QFontMetrics &metrics, int gutterWidth)
+    {
+        return gutterWidth - kChangeLaneWidth - foldLaneWidth(metrics);
+    }
+
+    void paint(QPainter *painter, const QRect &exposed, const QVector<Row> &rows,
+               const QFont &font, qreal devicePixelRatio, int gutterWidth);
+
+private:
+    static constexpr int kChangeLaneWidth = 4;
+
+    void prepareAtlas(const QFont &font, qreal devicePixelRatio);
+
+    QPixmap m_atlas;   // "0" to "9", one cell each
+    QFont m_atlasFont;
+    qreal m_atlasRatio = 0;
+    qreal m_cellWidth = 0;
+    int m_lineHeight = 0;
+    QVector<QPainter::PixmapFragment> m_fragments;   // reused between paints
+};
+
+#endif // GUTTERRENDERER_H
@@ -0,0 +1,402 @@
+#include "HeapProfiler.h"
+#include "HeapProfilerProtocol.h"
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QThread>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const int kPollIntervalMs = 100;
+
+// Reading /proc/<pid>/maps is comparatively expensive, so refresh it about once a second
+const int kMapsRefreshTicks = 10;
+
+quint64 statusFieldBytes(const QByteArray &status, const QByteArray &field)
+{
+    int index = status.indexOf(field);
+    if (index < 0) {
+        return 0;
+    }
+    // "VmRSS:     1234 kB"
+    QByteArray value = status.mid(index + field.size(), 32);
+    value = value.left(value.indexOf('\n')).simplified();
+    return value.split(' ').first().toULongLong() * 1024;
+}
+}
+
+HeapProfiler::HeapProfiler(QObject *parent)
+    : QObject(parent)
+    , m_target(new QProcess(this))
+    , m_tempDir(nullptr)
+    , m_pipeFd(-1)
+    , m_notifier(nullptr)
+    , m_pollTimer(new QTimer(this))
+    , m_sampleRate(QTCIDE_HEAPPROF_DEFAULT_RATE)
+    , m_totalAllocated(0)
+    , m_totalAllocations(0)
+    , m_droppedRecords(0)
+    , m_peakResident(0)
+    , m_lastTickAllocated(0)
+    , m_lastTickMs(0)
+    , m_tick(0)
+    , m_symbolizeThread(nullptr)
+{
+    m_pollTimer->setInterval(kPollIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &HeapProfiler::pollTarget);
+
+    connect(m_target, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &HeapProfiler::onTargetFinished);
+    connect(m_target, &QProcess::readyReadStandardOutput, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_target->readAllStandardOutput()));
+    });
+    connect(m_target, &QProcess::readyReadStandardError, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_target->readAllStandardError()));
+    });
+}
+
+HeapProfiler::~HeapProfiler()
+{
+    if (m_target->state() != QProcess::NotRunning) {
+        m_target->kill();
+        m_target->waitForFinished(3000);
+    }
+    closePipe();
+    if (m_symbolizeThread) {
+        m_symbolizeThread->wait();
+        delete m_symbolizeThread;
+    }
+    delete m_tempDir;
+}
+
+QString HeapProfiler::preloadLibraryPath()
+{
+    // Next to the executable in a build tree, lib/ next to bin/ when installed
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QStringList candidates = {
+        appDir + "/libqtcide_heapprof.so",
+        appDir + "/../lib/libqtcide_heapprof.so"
+    };
+    for (const QString &candidate : candidates) {
+        if (QFileInfo::exists(candidate)) {
+            return QFileInfo(candidate).canonicalFilePath();
+        }
+    }
+    return QString();
+}
+
+bool HeapProfiler::start(const QString &executable, const QStringList &arguments,
+                         const QString &workingDirectory, const QProcessEnvironment &environment)
+{
+#ifdef Q_OS_LINUX
+    if (isRunning()) {
+        return false;
+    }
+
+    const QString library = preloadLibraryPath();
+    if (library.isEmpty()) {
+        emit errorOccurred("libqtcide_heapprof.so was not found next to the IDE executable");
+        return false;
+    }
+
+    m_pending.clear();
+    m_siteIndex.clear();
+    m_rawSites.clear();
+    m_liveSamples.clear();
+    m_maps.clear();
+    m_timeline.clear();
+    m_sites.clear();
+    m_totalAllocated = 0;
+    m_totalAllocations = 0;
+    m_droppedRecords = 0;
+    m_peakResident = 0;
+    m_lastTickAllocated = 0;
+    m_lastTickMs = 0;
+    m_tick = 0;
+
+    delete m_tempDir;
+    m_tempDir = new QTemporaryDir;
+    const QByteArray fifoPath = QFile::encodeName(m_tempDir->filePath("heap.fifo"));
+    if (mkfifo(fifoPath.constData(), 0600) != 0) {
+        emit errorOccurred(QString("Could not create pipe: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+        return false;
+    }
+
+    // Opening the read end non-blocking first lets the child open its write end without waiting
+    m_pipeFd = ::open(fifoPath.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_pipeFd < 0) {
+        emit errorOccurred(QString("Could not open pipe: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+        return false;
+    }
+    m_notifier = new QSocketNotifier(m_pipeFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &HeapProfiler::onPipeReadable);
+
+    QProcessEnvironment env = environment;
+    QString preload = env.value("LD_PRELOAD");
+    env.insert("LD_PRELOAD", preload.isEmpty() ? library : library + ":" + preload);
+    env.insert(QTCIDE_HEAPPROF_PIPE_ENV, QString::fromLocal8Bit(fifoPath));
+    if (!env.contains(QTCIDE_HEAPPROF_RATE_ENV)) {
+        env.insert(QTCIDE_HEAPPROF_RATE_ENV, QString::number(QTCIDE_HEAPPROF_DEFAULT_RATE));
+    }
+    m_sampleRate = qMax(1.0, env.value(QTCIDE_HEAPPROF_RATE_ENV).toDouble());
+
+    m_target->setWorkingDirectory(workingDirectory);
+    m_target->setProcessEnvironment(env);
+    m_target->start(executable, arguments);
+    if (!m_target->waitForStarted(5000)) {
+        closePipe();
+        emit errorOccurred("Failed to start " + executable);
+        return false;
+    }
+
+    m_clock.start();
+    m_pollTimer->start();
+    return true;
+#else
+    Q_UNUSED(executable)
+    Q_UNUSED(arguments)
+    Q_UNUSED(workingDirectory)
+    Q_UNUSED(environment)
+    emit errorOccurred("Heap profiling requires Linux");
+    return false;
+#endif
+}
+
+void HeapProfiler::stop()
+{
+    if (m_target->state() != QProcess::NotRunning) {
+        m_target->terminate();
+    }
+}
+
+bool HeapProfiler::isRunning() const
+{
+    return m_target->state() != QProcess::NotRunning || m_symbolizeThread;
+}
+
+void HeapProfiler::onPipeReadable()
+{
+#ifdef Q_OS_LINUX
+    char buffer[64 * 1024];
+    for (;;) {
+        ssize_t count = ::read(m_pipeFd, buffer, sizeof(buffer));
+        if (count > 0) {
+            m_pending.append(buffer, count);
+            continue;
+        }
+        if (count == 0 && m_notifier) {
+            // Writer closed; a FIFO keeps reporting readable at EOF
+            m_notifier->setEnabled(false);
+        }
+        break;
+    }
+
+    const int recordSize = int(sizeof(HeapProfRecord));
+    int offset = 0;
+    while (m_pending.size() - offset >= recordSize) {
+        HeapProfRecord record;
+        memcpy(&record, m_pending.constData() + offset, recordSize);
+        processRecord(record);
+        offset += recordSize;
+    }
+    m_pending.remove(0, offset);
+
+    // Libraries are mapped by the time the first allocation is reported
+    if (m_maps.isEmpty() && !m_rawSites.isEmpty()) {
+        refreshMemoryMaps();
+    }
+#endif
+}
+
+void HeapProfiler::processRecord(const HeapProfRecord &record)
+{
+    m_totalAllocated += record.allocatedBytes;
+    m_totalAllocations += record.allocationCount;
+    m_droppedRecords += record.droppedRecords;
+
+    if (record.type == HeapProfAlloc) {
+        QVector<quint64> frames;
+        frames.reserve(record.depth);
+        for (uint32_t i = 0; i < record.depth && i < QTCIDE_HEAPPROF_MAX_FRAMES; ++i) {
+            frames << record.frames[i];
+        }
+
+        QByteArray key(reinterpret_cast<const char *>(frames.constData()), frames.size() * int(sizeof(quint64)));
+        auto it = m_siteIndex.constFind(key);
+        int index;
+        if (it == m_siteIndex.constEnd()) {
+            index = m_rawSites.size();
+            m_siteIndex.insert(key, index);
+            RawSite site;
+            site.frames = frames;
+            m_rawSites << site;
+        } else {
+            index = it.value();
+        }
+
+        // An allocation of s bytes is sampled with probability 1 - exp(-s/R)
+        const double size = double(record.size);
+        const double probability = size > 0 ? -std::expm1(-size / m_sampleRate) : 1.0;
+        const double weight = 1.0 / probability;
+
+        RawSite &site = m_rawSites[index];
+        site.samples++;
+        site.allocations += weight;
+        site.allocatedBytes += size * weight;
+        site.liveBytes += size * weight;
+        m_liveSamples.insert(record.address, {index, size * weight});
+    } else if (record.type == HeapProfFree) {
+        auto it = m_liveSamples.find(record.address);
+        if (it != m_liveSamples.end()) {
+            m_rawSites[it->site].liveBytes -= it->bytes;
+            m_liveSamples.erase(it);
+        }
+    }
+}
+
+void HeapProfiler::pollTarget()
+{
+#ifdef Q_OS_LINUX
+    const qint64 pid = m_target->processId();
+    if (pid <= 0) {
+        return;
+    }
+    const QString procDir = QString("/proc/%1/").arg(pid);
+
+    QFile status(procDir + "status");
+    if (status.open(QIODevice::ReadOnly)) {
+        QByteArray contents = status.readAll();
+        HeapTimelinePoint point;
+        point.elapsedMs = m_clock.elapsed();
+        point.residentBytes = statusFieldBytes(contents, "VmRSS:");
+        const qint64 deltaMs = point.elapsedMs - m_lastTickMs;
+        if (deltaMs > 0) {
+            point.allocationRate = (m_totalAllocated - m_lastTickAllocated) * 1000.0 / deltaMs;
+        }
+        m_lastTickMs = point.elapsedMs;
+        m_lastTickAllocated = m_totalAllocated;
+
+        // VmHWM is the kernel's own high-water mark, so peaks between polls are not missed
+        m_peakResident = qMax(m_peakResident, qMax(point.residentBytes, statusFieldBytes(contents, "VmHWM:")));
+        m_timeline << point;
+        emit timelineUpdated();
+    }
+
+    if (m_maps.isEmpty() || ++m_tick % kMapsRefreshTicks == 0) {
+        refreshMemoryMaps();
+    }
+#endif
+}
+
+void HeapProfiler::refreshMemoryMaps()
+{
+    // Kept from the last successful read, since /proc is gone once the target exits
+    QFile maps(QString("/proc/%1/maps").arg(m_target->processId()));
+    if (m_target->processId() > 0 && maps.open(QIODevice::ReadOnly)) {
+        QByteArray contents = maps.readAll();
+        if (!contents.isEmpty()) {
+            m_maps = contents;
+        }
+    }
+}
+
+void HeapProfiler::onTargetFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_pollTimer->stop();
+
+    // Drain whatever the destructor-time flush left in the pipe
+    onPipeReadable();
+    closePipe();
+
+    emit finished(exitStatus == QProcess::CrashExit ? -1 : exitCode);
+
+    if (m_rawSites.isEmpty()) {
+        emit errorOccurred("No allocations were recorded; the application may be statically linked");
+        return;
+    }
+
+    emit output("Resolving symbols...\n");
+    m_symbolizeThread = QThread::create([this, rawSites = m_rawSites, maps = m_maps]() {
+        const QVector<HeapSite> sites = buildSites(rawSites, maps);
+        QMetaObject::invokeMethod(this, [this, sites]() {
+            m_sites = sites;
+            emit sitesReady();
+        }, Qt::QueuedConnection);
+    });
+    m_symbolizeThread->setObjectName("HeapProfiler symbolizer");
+    connect(m_symbolizeThread, &QThread::finished, this, [this]() {
+        m_symbolizeThread->deleteLater();
+        m_symbolizeThread = nullptr;
+    });
+    m_symbolizeThread->start(QThread::LowPriority);
+}
+
+void HeapProfiler::closePipe()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+#ifdef Q_OS_LINUX
+    if (m_pipeFd >= 0) {
+        ::close(m_pipeFd);
+        m_pipeFd = -1;
+    }
+#endif
+}
+
+QVector<HeapSite> HeapProfiler::buildSites(const QVector<RawSite> &rawSites, const QByteArray &maps)
+{
+    Symbolizer symbolizer;
+    symbolizer.setMemoryMaps(maps);
+
+    // Every recorded frame is a return address
+    QSet<quint64> addresses;
+    for (const RawSite &site : rawSites) {
+        for (quint64 frame : site.frames) {
+            addresses.insert(frame - 1);
+        }
+    }
+    const QHash<quint64, ProfileFrame> symbols = symbolizer.symbolize(addresses);
+
+    QVector<HeapSite> sites;
+    sites.reserve(rawSites.size());
+    for (const RawSite &raw : rawSites) {
+        HeapSite site;
+        site.samples = raw.samples;
+        site.allocatedBytes = raw.allocatedBytes;
+        site.allocations = raw.allocations;
+        site.liveBytes = qMax(0.0, raw.liveBytes);
+        for (quint64 frame : raw.frames) {
+            site.stack << symbols.value(frame - 1);
+        }
+
+        // operator new and container internals rarely have sources; report the caller
+        for (const ProfileFrame &frame : site.stack) {
+            if (!frame.file.isEmpty()) {
+                site.frame = frame;
+                break;
+            }
+        }
+        if (site.frame.function.isEmpty() && !site.stack.isEmpty()) {
+            site.frame = site.stack.first();
+        }
+        sites << site;
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const HeapSite &a, const HeapSite &b) {
+        return a.allocatedBytes > b.allocatedBytes;
+    });
+    return sites;
+}
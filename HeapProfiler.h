@@ -0,0 +1,119 @@
+#ifndef HEAPPROFILER_H
+#define HEAPPROFILER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QHash>
+#include <QVector>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include "Symbolizer.h"
+
+class QSocketNotifier;
+class QThread;
+class QTimer;
+struct HeapProfRecord;
+
+struct HeapSite
+{
+    // Innermost frame with source information, falling back to the innermost frame
+    ProfileFrame frame;
+    QVector<ProfileFrame> stack;
+    quint64 samples = 0;
+    double allocatedBytes = 0;
+    double allocations = 0;
+    double liveBytes = 0;
+};
+
+struct HeapTimelinePoint
+{
+    qint64 elapsedMs = 0;
+    quint64 residentBytes = 0;
+    double allocationRate = 0;
+};
+
+// Runs an application with the malloc interposer preloaded and aggregates the sampled
+// allocation stream into per-site estimates plus a resident memory timeline.
+class HeapProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeapProfiler(QObject *parent = nullptr);
+    ~HeapProfiler();
+
+    static QString preloadLibraryPath();
+
+    bool start(const QString &executable, const QStringList &arguments,
+               const QString &workingDirectory, const QProcessEnvironment &environment);
+    void stop();
+    bool isRunning() const;
+
+    const QVector<HeapSite> &sites() const { return m_sites; }
+    const QVector<HeapTimelinePoint> &timeline() const { return m_timeline; }
+    quint64 peakResidentBytes() const { return m_peakResident; }
+    quint64 totalAllocatedBytes() const { return m_totalAllocated; }
+    quint64 totalAllocations() const { return m_totalAllocations; }
+    quint64 droppedRecords() const { return m_droppedRecords; }
+
+signals:
+    void output(const QString &text);
+    void finished(int exitCode);
+    void timelineUpdated();
+    void sitesReady();
+    void errorOccurred(const QString &message);
+
+private slots:
+    void onPipeReadable();
+    void onTargetFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void pollTarget();
+
+private:
+    struct RawSite
+    {
+        QVector<quint64> frames;
+        quint64 samples = 0;
+        double allocatedBytes = 0;
+        double allocations = 0;
+        double liveBytes = 0;
+    };
+
+    struct LiveSample
+    {
+        int site;
+        double bytes;
+    };
+
+    void processRecord(const HeapProfRecord &record);
+    void refreshMemoryMaps();
+    void closePipe();
+    static QVector<HeapSite> buildSites(const QVector<RawSite> &rawSites, const QByteArray &maps);
+
+    QProcess *m_target;
+    QTemporaryDir *m_tempDir;
+    int m_pipeFd;
+    QSocketNotifier *m_notifier;
+    QTimer *m_pollTimer;
+    QByteArray m_pending;
+    double m_sampleRate;
+
+    QHash<QByteArray, int> m_siteIndex;
+    QVector<RawSite> m_rawSites;
+    QHash<quint64, LiveSample> m_liveSamples;
+    QByteArray m_maps;
+
+    QElapsedTimer m_clock;
+    quint64 m_totalAllocated;
+    quint64 m_totalAllocations;
+    quint64 m_droppedRecords;
+    quint64 m_peakResident;
+    quint64 m_lastTickAllocated;
+    qint64 m_lastTickMs;
+    int m_tick;
+
+    QVector<HeapTimelinePoint> m_timeline;
+    QVector<HeapSite> m_sites;
+    QThread *m_symbolizeThread;   // runs addr2line; sites are delivered back queued
+};
+
+#endif // HEAPPROFILER_H
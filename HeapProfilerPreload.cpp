@@ -0,0 +1,376 @@
+// Malloc interposer preloaded into applications launched with "Run with Heap Profiler".
+//
+// Allocations are sampled as a Poisson process over allocated bytes, so the cost on the
+// hot path is a thread-local subtraction and sites are weighted by how much they allocate
+// rather than how often. Sampled allocations are written to the pipe named by
+// QTCIDE_HEAPPROF_PIPE together with the thread's unsampled totals; frees are only
+// reported for pointers that were sampled. Plain libc only: no Qt, no STL, no exceptions.
+
+#include "HeapProfilerProtocol.h"
+
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void __libc_free(void *ptr);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+}
+
+#define HEAPPROF_TEXT __attribute__((section("qtcide_heapprof_text")))
+#define HEAPPROF_TLS __attribute__((tls_model("initial-exec")))
+
+// Linker-provided bounds of the section above, used to trim our own frames from backtraces
+extern "C" __attribute__((visibility("hidden"))) char __start_qtcide_heapprof_text[];
+extern "C" __attribute__((visibility("hidden"))) char __stop_qtcide_heapprof_text[];
+
+namespace {
+
+struct ThreadState
+{
+    int64_t bytesUntilSample;
+    uint64_t random;
+    uint64_t allocatedBytes;
+    uint64_t allocationCount;
+    bool initialized;
+    bool busy;
+};
+
+// Open addressing set of sampled pointers; 0 is empty, 1 is a deleted slot
+const uint32_t kTableSize = 1u << 16;
+const uint32_t kMaxProbes = 64;
+const uintptr_t kDeleted = 1;
+
+// One bit per pointer hash lets the common free() skip the table entirely
+const uint32_t kFilterBits = 1u << 20;
+
+int g_fd = -1;
+int64_t g_rate = QTCIDE_HEAPPROF_DEFAULT_RATE;
+uint64_t g_tracked = 0;
+uint64_t g_dropped = 0;
+uintptr_t g_table[kTableSize];
+uint64_t g_filter[kFilterBits / 64];
+
+__thread ThreadState t_state HEAPPROF_TLS;
+
+inline uint64_t hashPointer(uintptr_t ptr)
+{
+    uint64_t h = ptr >> 4;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline bool filterMayContain(uint64_t hash)
+{
+    uint32_t bit = (hash >> 20) & (kFilterBits - 1);
+    return __atomic_load_n(&g_filter[bit / 64], __ATOMIC_RELAXED) & (1ULL << (bit % 64));
+}
+
+HEAPPROF_TEXT bool trackPointer(uintptr_t ptr)
+{
+    uint64_t hash = hashPointer(ptr);
+    uint32_t bit = (hash >> 20) & (kFilterBits - 1);
+    __atomic_fetch_or(&g_filter[bit / 64], 1ULL << (bit % 64), __ATOMIC_RELAXED);
+
+    for (uint32_t probe = 0; probe < kMaxProbes; ++probe) {
+        uintptr_t *slot = &g_table[(hash + probe) & (kTableSize - 1)];
+        uintptr_t current = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        if ((current == 0 || current == kDeleted)
+            && __atomic_compare_exchange_n(slot, &current, ptr, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&g_tracked, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+    return false;
+}
+
+HEAPPROF_TEXT bool untrackPointer(uintptr_t ptr)
+{
+    uint64_t hash = hashPointer(ptr);
+    if (!filterMayContain(hash)) {
+        return false;
+    }
+
+    for (uint32_t probe = 0; probe < kMaxProbes; ++probe) {
+        uintptr_t *slot = &g_table[(hash + probe) & (kTableSize - 1)];
+        uintptr_t current = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        if (current == 0) {
+            return false;
+        }
+        if (current == ptr) {
+            if (__atomic_compare_exchange_n(slot, &current, kDeleted, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                __atomic_fetch_sub(&g_tracked, 1, __ATOMIC_RELAXED);
+                return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+inline uint64_t nextRandom(ThreadState &state)
+{
+    // xorshift64*
+    state.random ^= state.random >> 12;
+    state.random ^= state.random << 25;
+    state.random ^= state.random >> 27;
+    return state.random * 2685821657736338717ULL;
+}
+
+HEAPPROF_TEXT int64_t nextSampleInterval(ThreadState &state)
+{
+    // Exponentially distributed gaps make the sampled bytes a Poisson process
+    double uniform = ((nextRandom(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return int64_t(-log(uniform) * double(g_rate)) + 1;
+}
+
+uint64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+}
+
+HEAPPROF_TEXT void writeRecord(ThreadState &state, HeapProfRecord &record)
+{
+    record.timestampNs = monotonicNs();
+    record.allocatedBytes = state.allocatedBytes;
+    record.allocationCount = state.allocationCount;
+    record.droppedRecords = __atomic_exchange_n(&g_dropped, 0, __ATOMIC_RELAXED);
+
+    // Never block the application on a slow reader; the viewer reports drops instead
+    ssize_t written = write(g_fd, &record, sizeof(record));
+    if (written == ssize_t(sizeof(record))) {
+        state.allocatedBytes = 0;
+        state.allocationCount = 0;
+    } else {
+        __atomic_fetch_add(&g_dropped, record.droppedRecords + 1, __ATOMIC_RELAXED);
+    }
+}
+
+HEAPPROF_TEXT __attribute__((noinline)) void sampleAllocation(void *ptr, size_t size)
+{
+    ThreadState &state = t_state;
+    if (state.busy) {
+        return;
+    }
+
+    if (!state.initialized) {
+        state.initialized = true;
+        state.random = (uintptr_t(&state) ^ monotonicNs()) | 1;
+        state.bytesUntilSample += nextSampleInterval(state);
+        if (state.bytesUntilSample > 0) {
+            return;
+        }
+    }
+    state.bytesUntilSample = nextSampleInterval(state);
+
+    state.busy = true;
+
+    void *frames[QTCIDE_HEAPPROF_MAX_FRAMES + 8];
+    int count = backtrace(frames, QTCIDE_HEAPPROF_MAX_FRAMES + 8);
+
+    HeapProfRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = HeapProfAlloc;
+    record.address = uintptr_t(ptr);
+    record.size = size;
+    for (int i = 0; i < count && record.depth < QTCIDE_HEAPPROF_MAX_FRAMES; ++i) {
+        char *frame = static_cast<char *>(frames[i]);
+        if (frame >= __start_qtcide_heapprof_text && frame < __stop_qtcide_heapprof_text) {
+            continue;
+        }
+        record.frames[record.depth++] = uintptr_t(frame);
+    }
+
+    trackPointer(uintptr_t(ptr));
+    writeRecord(state, record);
+
+    state.busy = false;
+}
+
+__attribute__((always_inline)) inline void recordAllocation(void *ptr, size_t size)
+{
+    if (!ptr || g_fd < 0) {
+        return;
+    }
+
+    ThreadState &state = t_state;
+    state.allocatedBytes += size;
+    state.allocationCount++;
+    state.bytesUntilSample -= int64_t(size);
+    if (__builtin_expect(state.bytesUntilSample <= 0, 0)) {
+        sampleAllocation(ptr, size);
+    }
+}
+
+HEAPPROF_TEXT __attribute__((noinline)) void recordSampledFree(void *ptr)
+{
+    ThreadState &state = t_state;
+    if (state.busy || !untrackPointer(uintptr_t(ptr))) {
+        return;
+    }
+
+    state.busy = true;
+    HeapProfRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = HeapProfFree;
+    record.address = uintptr_t(ptr);
+    writeRecord(state, record);
+    state.busy = false;
+}
+
+__attribute__((always_inline)) inline void recordFree(void *ptr)
+{
+    if (ptr && __atomic_load_n(&g_tracked, __ATOMIC_RELAXED) != 0) {
+        recordSampledFree(ptr);
+    }
+}
+
+void disableInChild()
+{
+    // A forked child would interleave its own heap with ours in the same stream
+    if (g_fd >= 0) {
+        close(g_fd);
+        g_fd = -1;
+    }
+}
+
+__attribute__((constructor)) void initialize()
+{
+    const char *path = getenv(QTCIDE_HEAPPROF_PIPE_ENV);
+    if (!path) {
+        return;
+    }
+
+    if (const char *rate = getenv(QTCIDE_HEAPPROF_RATE_ENV)) {
+        long long value = strtoll(rate, nullptr, 10);
+        if (value > 0) {
+            g_rate = value;
+        }
+    }
+
+    // backtrace() loads libgcc_s on first use, which allocates; do it before sampling starts
+    t_state.busy = true;
+    void *frame;
+    backtrace(&frame, 1);
+    t_state.busy = false;
+
+    int fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+
+    // Descendants still inherit LD_PRELOAD but stay passive without the pipe
+    unsetenv(QTCIDE_HEAPPROF_PIPE_ENV);
+
+    if (fd >= 0) {
+        pthread_atfork(nullptr, nullptr, disableInChild);
+        g_fd = fd;
+    }
+}
+
+__attribute__((destructor)) void finish()
+{
+    // Report the main thread's unsampled tail so totals add up
+    if (g_fd >= 0 && t_state.allocationCount > 0 && !t_state.busy) {
+        t_state.busy = true;
+        HeapProfRecord record;
+        memset(&record, 0, sizeof(record));
+        record.type = HeapProfFlush;
+        writeRecord(t_state, record);
+        t_state.busy = false;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+HEAPPROF_TEXT void *malloc(size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+HEAPPROF_TEXT void free(void *ptr)
+{
+    recordFree(ptr);
+    __libc_free(ptr);
+}
+
+HEAPPROF_TEXT void *calloc(size_t count, size_t size)
+{
+    void *ptr = __libc_calloc(count, size);
+    size_t bytes = 0;
+    if (!__builtin_mul_overflow(count, size, &bytes)) {
+        recordAllocation(ptr, bytes);
+    }
+    return ptr;
+}
+
+HEAPPROF_TEXT void *realloc(void *ptr, size_t size)
+{
+    void *result = __libc_realloc(ptr, size);
+    // A failed realloc leaves the old block allocated; realloc(ptr, 0) frees it and may return null
+    if (result || size == 0) {
+        recordFree(ptr);
+    }
+    recordAllocation(result, size);
+    return result;
+}
+
+HEAPPROF_TEXT void *memalign(size_t alignment, size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+HEAPPROF_TEXT void *aligned_alloc(size_t alignment, size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+HEAPPROF_TEXT int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    recordAllocation(ptr, size);
+    *result = ptr;
+    return 0;
+}
+
+HEAPPROF_TEXT void *valloc(size_t size)
+{
+    void *ptr = __libc_valloc(size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+HEAPPROF_TEXT void *pvalloc(size_t size)
+{
+    void *ptr = __libc_pvalloc(size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+} // extern "C"
@@ -0,0 +1,34 @@
+#ifndef HEAPPROFILERPROTOCOL_H
+#define HEAPPROFILERPROTOCOL_H
+
+#include <stdint.h>
+
+// Wire format shared by the LD_PRELOAD interposer and HeapProfiler. Records are fixed
+// size and smaller than PIPE_BUF, so concurrent writers never interleave.
+
+#define QTCIDE_HEAPPROF_PIPE_ENV "QTCIDE_HEAPPROF_PIPE"
+#define QTCIDE_HEAPPROF_RATE_ENV "QTCIDE_HEAPPROF_RATE"
+#define QTCIDE_HEAPPROF_DEFAULT_RATE (512 * 1024)
+#define QTCIDE_HEAPPROF_MAX_FRAMES 16
+
+enum HeapProfRecordType {
+    HeapProfAlloc = 1,
+    HeapProfFree = 2,
+    HeapProfFlush = 3
+};
+
+struct HeapProfRecord
+{
+    uint32_t type;
+    uint32_t depth;
+    uint64_t address;
+    uint64_t size;
+    uint64_t timestampNs;
+    // Unsampled traffic of the writing thread since its previous record
+    uint64_t allocatedBytes;
+    uint64_t allocationCount;
+    uint64_t droppedRecords;
+    uint64_t frames[QTCIDE_HEAPPROF_MAX_FRAMES];
+};
+
+#endif // HEAPPROFILERPROTOCOL_H
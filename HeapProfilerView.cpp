@@ -0,0 +1,199 @@
+#include "HeapProfilerView.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QVBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileInfo>
+
+HeapTimelineWidget::HeapTimelineWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_timeline(nullptr)
+{
+    setMinimumHeight(100);
+}
+
+void HeapTimelineWidget::setTimeline(const QVector<HeapTimelinePoint> *timeline)
+{
+    m_timeline = timeline;
+    update();
+}
+
+void HeapTimelineWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+
+    if (!m_timeline || m_timeline->size() < 2) {
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawText(rect(), Qt::AlignCenter, "No memory samples");
+        return;
+    }
+
+    double maxResident = 1;
+    double maxRate = 1;
+    for (const HeapTimelinePoint &point : *m_timeline) {
+        maxResident = qMax(maxResident, double(point.residentBytes));
+        maxRate = qMax(maxRate, point.allocationRate);
+    }
+
+    const QRectF plot = QRectF(rect()).adjusted(4, 18, -4, -4);
+    const double duration = qMax<qint64>(1, m_timeline->last().elapsedMs);
+
+    // Both series share the time axis but are scaled to their own maximum
+    QPainterPath resident;
+    QPainterPath rate;
+    for (int i = 0; i < m_timeline->size(); ++i) {
+        const HeapTimelinePoint &point = m_timeline->at(i);
+        qreal x = plot.left() + plot.width() * point.elapsedMs / duration;
+        QPointF residentPoint(x, plot.bottom() - plot.height() * point.residentBytes / maxResident);
+        QPointF ratePoint(x, plot.bottom() - plot.height() * point.allocationRate / maxRate);
+        if (i == 0) {
+            resident.moveTo(residentPoint);
+            rate.moveTo(ratePoint);
+        } else {
+            resident.lineTo(residentPoint);
+            rate.lineTo(ratePoint);
+        }
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(100, 180, 255), 1.5));
+    painter.drawPath(resident);
+    painter.setPen(QPen(QColor(255, 160, 60), 1.0));
+    painter.drawPath(rate);
+
+    painter.setFont(QFont("Consolas", 8));
+    painter.setPen(QColor(100, 180, 255));
+    painter.drawText(QPointF(4, 12), "Resident (max " + HeapProfilerView::formatBytes(maxResident) + ")");
+    painter.setPen(QColor(255, 160, 60));
+    painter.drawText(QPointF(width() / 2, 12), "Allocation rate (max " + HeapProfilerView::formatBytes(maxRate) + "/s)");
+}
+
+HeapProfilerView::HeapProfilerView(QWidget *parent)
+    : QWidget(parent)
+    , m_profiler(nullptr)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    m_summaryLabel = new QLabel("No heap profile");
+    m_summaryLabel->setStyleSheet("color: white;");
+    layout->addWidget(m_summaryLabel);
+
+    auto *splitter = new QSplitter(Qt::Vertical);
+
+    m_timeline = new HeapTimelineWidget;
+    splitter->addWidget(m_timeline);
+
+    m_sites = new QTableWidget(0, 5);
+    m_sites->setHorizontalHeaderLabels({"Allocation Site", "Allocated", "Allocations", "Live at Exit", "Location"});
+    m_sites->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_sites->verticalHeader()->hide();
+    m_sites->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_sites->setSelectionBehavior(QAbstractItemView::SelectRows);
+    splitter->addWidget(m_sites);
+
+    layout->addWidget(splitter, 1);
+
+    connect(m_sites, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+        QTableWidgetItem *item = m_sites->item(row, 4);
+        if (item && !item->data(Qt::UserRole).toString().isEmpty()) {
+            emit openLocation(item->data(Qt::UserRole).toString(), item->data(Qt::UserRole + 1).toInt());
+        }
+    });
+}
+
+QString HeapProfilerView::formatBytes(double bytes)
+{
+    const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 4) {
+        bytes /= 1024;
+        ++unit;
+    }
+    return QString("%1 %2").arg(bytes, 0, 'f', unit == 0 ? 0 : 1).arg(units[unit]);
+}
+
+void HeapProfilerView::setProfiler(const HeapProfiler *profiler)
+{
+    m_profiler = profiler;
+    m_timeline->setTimeline(profiler ? &profiler->timeline() : nullptr);
+}
+
+void HeapProfilerView::updateSummary()
+{
+    if (!m_profiler) {
+        return;
+    }
+
+    QString summary = QString("Peak resident: %1    Allocated: %2 in %3 allocations")
+                          .arg(formatBytes(m_profiler->peakResidentBytes()))
+                          .arg(formatBytes(m_profiler->totalAllocatedBytes()))
+                          .arg(m_profiler->totalAllocations());
+    if (m_profiler->droppedRecords() > 0) {
+        summary += QString("    (%1 samples dropped)").arg(m_profiler->droppedRecords());
+    }
+    m_summaryLabel->setText(summary);
+}
+
+void HeapProfilerView::updateTimeline()
+{
+    updateSummary();
+    m_timeline->update();
+}
+
+void HeapProfilerView::showSites()
+{
+    updateSummary();
+    if (!m_profiler) {
+        return;
+    }
+
+    const QVector<HeapSite> &sites = m_profiler->sites();
+
+    // Sites arrive sorted by allocated bytes; the long tail of one-off samples is noise
+    const int rows = qMin<int>(sites.size(), 500);
+
+    m_sites->setRowCount(rows);
+    for (int row = 0; row < rows; ++row) {
+        const HeapSite &site = sites.at(row);
+
+        QStringList stack;
+        for (const ProfileFrame &frame : site.stack) {
+            stack << frame.function;
+        }
+
+        auto *function = new QTableWidgetItem(site.frame.function);
+        function->setToolTip(stack.join('\n'));
+
+        auto *allocated = new QTableWidgetItem(formatBytes(site.allocatedBytes));
+        auto *allocations = new QTableWidgetItem;
+        allocations->setData(Qt::DisplayRole, qRound64(site.allocations));
+        auto *live = new QTableWidgetItem(formatBytes(site.liveBytes));
+
+        QString location;
+        if (!site.frame.file.isEmpty()) {
+            location = QString("%1:%2").arg(QFileInfo(site.frame.file).fileName()).arg(site.frame.line);
+        }
+        auto *locationItem = new QTableWidgetItem(location);
+        locationItem->setData(Qt::UserRole, site.frame.file);
+        locationItem->setData(Qt::UserRole + 1, site.frame.line);
+        locationItem->setToolTip(site.frame.file);
+
+        m_sites->setItem(row, 0, function);
+        m_sites->setItem(row, 1, allocated);
+        m_sites->setItem(row, 2, allocations);
+        m_sites->setItem(row, 3, live);
+        m_sites->setItem(row, 4, locationItem);
+    }
+}
+
+void HeapProfilerView::clear()
+{
+    m_sites->setRowCount(0);
+    m_summaryLabel->setText("Profiling heap...");
+    m_timeline->update();
+}
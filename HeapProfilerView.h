@@ -0,0 +1,51 @@
+#ifndef HEAPPROFILERVIEW_H
+#define HEAPPROFILERVIEW_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QLabel>
+#include "HeapProfiler.h"
+
+class HeapTimelineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HeapTimelineWidget(QWidget *parent = nullptr);
+
+    void setTimeline(const QVector<HeapTimelinePoint> *timeline);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    const QVector<HeapTimelinePoint> *m_timeline;
+};
+
+class HeapProfilerView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HeapProfilerView(QWidget *parent = nullptr);
+
+    void setProfiler(const HeapProfiler *profiler);
+    void updateTimeline();
+    void showSites();
+    void clear();
+
+    static QString formatBytes(double bytes);
+
+signals:
+    void openLocation(const QString &file, int line);
+
+private:
+    void updateSummary();
+
+    const HeapProfiler *m_profiler;
+    QLabel *m_summaryLabel;
+    HeapTimelineWidget *m_timeline;
+    QTableWidget *m_sites;
+};
+
+#endif // HEAPPROFILERVIEW_H
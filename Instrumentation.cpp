@@ -0,0 +1,353 @@
+#include "Instrumentation.h"
+#include "Symbolizer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QSet>
+#include <QtAlgorithms>
+
+#ifdef Q_OS_LINUX
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+Q_LOGGING_CATEGORY(lcStartup, "qtcide.startup", QtInfoMsg)
+
+std::atomic<bool> Instrumentation::s_enabled(false);
+QElapsedTimer Instrumentation::s_clock = []() {
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+}();
+
+namespace {
+const int kHeartbeatIntervalMs = 4;
+const int kMaxStackDepth = 32;
+const int kMaxStalls = 1000;
+
+std::atomic<qint64> s_heartbeat(0);
+qint64 s_lastStartupPhase = 0;
+
+#ifdef Q_OS_LINUX
+// Filled by the GUI thread inside the signal handler, read by the watchdog
+void *s_sampleFrames[kMaxStackDepth + 2];
+std::atomic<int> s_sampleDepth(-1);
+
+void sampleStackHandler(int)
+{
+    s_sampleDepth.store(backtrace(s_sampleFrames, kMaxStackDepth + 2), std::memory_order_release);
+}
+#endif
+}
+
+void TimingHistogram::add(qint64 durationNs)
+{
+    const qint64 micros = durationNs / 1000;
+    int bucket = micros > 0 ? 64 - qCountLeadingZeroBits(quint64(micros)) : 0;
+    ++buckets[qMin(bucket, kBuckets - 1)];
+    ++count;
+    totalNs += durationNs;
+    maxNs = qMax(maxNs, durationNs);
+}
+
+void TimingHistogram::merge(const TimingHistogram &other)
+{
+    for (int i = 0; i < kBuckets; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    totalNs += other.totalNs;
+    maxNs = qMax(maxNs, other.maxNs);
+}
+
+// Notices when the GUI thread's heartbeat timer stops firing and samples the
+// GUI thread's stack while it is still blocked
+class StallWatchdog : public QThread
+{
+public:
+    explicit StallWatchdog(Instrumentation *instrumentation)
+        : m_instrumentation(instrumentation)
+#ifdef Q_OS_LINUX
+        , m_guiThread(pthread_self())
+#endif
+    {}
+
+protected:
+    void run() override
+    {
+        qint64 lastBeat = s_heartbeat.load();
+        QVector<quint64> stack;
+        const qint64 threshold = Instrumentation::kStallThresholdNs + kHeartbeatIntervalMs * 1000000LL;
+
+        while (!isInterruptionRequested()) {
+            msleep(2);
+            const qint64 beat = s_heartbeat.load();
+            if (beat != lastBeat) {
+                // The loop came back; anything beyond the timer interval was time spent blocked
+                if (beat - lastBeat > threshold) {
+                    EventLoopStall stall;
+                    stall.startNs = lastBeat + kHeartbeatIntervalMs * 1000000LL;
+                    stall.durationNs = beat - stall.startNs;
+                    stall.stack = stack;
+                    m_instrumentation->recordStall(stall);
+                }
+                lastBeat = beat;
+                stack.clear();
+            } else if (stack.isEmpty() && Instrumentation::now() - lastBeat > threshold) {
+                stack = sampleGuiStack();
+            }
+        }
+    }
+
+private:
+    QVector<quint64> sampleGuiStack()
+    {
+        QVector<quint64> stack;
+#ifdef Q_OS_LINUX
+        s_sampleDepth.store(-1);
+        pthread_kill(m_guiThread, SIGURG);
+        for (int i = 0; i < 50 && s_sampleDepth.load(std::memory_order_acquire) < 0; ++i) {
+            usleep(100);
+        }
+        // Skip the handler and the signal trampoline
+        const int depth = s_sampleDepth.load(std::memory_order_acquire);
+        for (int i = 2; i < depth; ++i) {
+            stack << quint64(s_sampleFrames[i]);
+        }
+#endif
+        // An empty stack would be sampled again, so mark the attempt
+        if (stack.isEmpty()) {
+            stack << 0;
+        }
+        return stack;
+    }
+
+    Instrumentation *m_instrumentation;
+#ifdef Q_OS_LINUX
+    pthread_t m_guiThread;
+#endif
+};
+
+Instrumentation::Instrumentation(QObject *parent)
+    : QObject(parent)
+    , m_eventHead(0)
+    , m_dropped(0)
+    , m_guiThreadId(0)
+    , m_watchdog(nullptr)
+    , m_heartbeat(new QTimer(this))
+{
+    m_heartbeat->setTimerType(Qt::PreciseTimer);
+    m_heartbeat->setInterval(kHeartbeatIntervalMs);
+    connect(m_heartbeat, &QTimer::timeout, this, []() {
+        s_heartbeat.store(now());
+    });
+
+#ifdef Q_OS_LINUX
+    // Prime backtrace() so its first call does not allocate inside the signal handler
+    void *frames[1];
+    backtrace(frames, 1);
+    struct sigaction action = {};
+    action.sa_handler = sampleStackHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGURG, &action, nullptr);
+#endif
+}
+
+Instrumentation::~Instrumentation()
+{
+    setEnabled(false);
+}
+
+Instrumentation *Instrumentation::instance()
+{
+    static Instrumentation *instrumentation = new Instrumentation(QCoreApplication::instance());
+    return instrumentation;
+}
+
+void Instrumentation::markStartupPhase(const char *phase)
+{
+    const qint64 end = now();
+    qCInfo(lcStartup, "%-24s %7.1f ms  (%.1f ms since start)", phase,
+           (end - s_lastStartupPhase) / 1e6, end / 1e6);
+    if (isEnabled()) {
+        instance()->record(phase, s_lastStartupPhase, end - s_lastStartupPhase);
+    }
+    s_lastStartupPhase = end;
+}
+
+void Instrumentation::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return;
+    }
+    s_enabled.store(enabled);
+
+    if (enabled) {
+        m_guiThreadId = quint64(quintptr(QThread::currentThreadId()));
+        s_heartbeat.store(now());
+        m_heartbeat->start();
+        m_watchdog = new StallWatchdog(this);
+        m_watchdog->start();
+    } else {
+        m_heartbeat->stop();
+        m_watchdog->requestInterruption();
+        m_watchdog->wait();
+        delete m_watchdog;
+        m_watchdog = nullptr;
+    }
+    emit enabledChanged(enabled);
+}
+
+void Instrumentation::record(const char *name, qint64 startNs, qint64 durationNs)
+{
+    const TraceEvent event = {name, startNs, durationNs, quint64(quintptr(QThread::currentThreadId()))};
+
+    QMutexLocker locker(&m_mutex);
+    m_histograms[name].add(durationNs);
+    // Keep the most recent events once the buffer is full
+    if (m_events.size() < kMaxEvents) {
+        m_events.append(event);
+    } else {
+        m_events[m_eventHead] = event;
+        m_eventHead = (m_eventHead + 1) % kMaxEvents;
+        ++m_dropped;
+    }
+}
+
+void Instrumentation::recordStall(const EventLoopStall &stall)
+{
+    QMutexLocker locker(&m_mutex);
+    m_histograms["Event loop stall"].add(stall.durationNs);
+    if (m_stalls.size() >= kMaxStalls) {
+        m_stalls.removeFirst();
+    }
+    m_stalls.append(stall);
+}
+
+void Instrumentation::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_eventHead = 0;
+    m_histograms.clear();
+    m_stalls.clear();
+    m_dropped = 0;
+}
+
+QHash<QString, TimingHistogram> Instrumentation::histograms() const
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, TimingHistogram> result;
+    for (auto it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+        // The same name may come from literals with different addresses
+        result[QString::fromLatin1(it.key())].merge(it.value());
+    }
+    return result;
+}
+
+QVector<EventLoopStall> Instrumentation::stalls() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stalls;
+}
+
+qint64 Instrumentation::droppedEvents() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+bool Instrumentation::writeChromeTrace(const QString &fileName, QString *error) const
+{
+    QVector<TraceEvent> events;
+    QVector<EventLoopStall> stalls;
+    {
+        QMutexLocker locker(&m_mutex);
+        events = m_events.mid(m_eventHead) + m_events.mid(0, m_eventHead);
+        stalls = m_stalls;
+    }
+
+    // Stall stacks point into this process; resolve them against its current mappings
+    QSet<quint64> addresses;
+    for (const EventLoopStall &stall : stalls) {
+        for (int i = 0; i < stall.stack.size(); ++i) {
+            if (stall.stack.at(i)) {
+                addresses.insert(i == 0 ? stall.stack.at(i) : stall.stack.at(i) - 1);
+            }
+        }
+    }
+    QHash<quint64, ProfileFrame> frames;
+    if (!addresses.isEmpty()) {
+        QFile maps("/proc/self/maps");
+        if (maps.open(QIODevice::ReadOnly)) {
+            Symbolizer symbolizer;
+            symbolizer.setMemoryMaps(maps.readAll());
+            frames = symbolizer.symbolize(addresses);
+        }
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    const quint64 guiThread = m_guiThreadId;
+    QJsonArray traceEvents;
+
+    QJsonObject threadName;
+    threadName["ph"] = "M";
+    threadName["name"] = "thread_name";
+    threadName["pid"] = pid;
+    threadName["tid"] = qint64(guiThread);
+    threadName["args"] = QJsonObject{{"name", "GUI thread"}};
+    traceEvents.append(threadName);
+
+    for (const TraceEvent &event : events) {
+        QJsonObject object;
+        object["name"] = QString::fromLatin1(event.name);
+        object["cat"] = "qtcide";
+        object["ph"] = "X";
+        object["ts"] = event.startNs / 1000.0;
+        object["dur"] = event.durationNs / 1000.0;
+        object["pid"] = pid;
+        object["tid"] = qint64(event.threadId);
+        traceEvents.append(object);
+    }
+
+    for (const EventLoopStall &stall : stalls) {
+        QJsonArray stack;
+        for (int i = 0; i < stall.stack.size(); ++i) {
+            if (!stall.stack.at(i)) {
+                continue;
+            }
+            const ProfileFrame frame = frames.value(i == 0 ? stall.stack.at(i) : stall.stack.at(i) - 1);
+            stack.append(frame.file.isEmpty() ? frame.function
+                                              : QString("%1 (%2:%3)").arg(frame.function, frame.file).arg(frame.line));
+        }
+        QJsonObject object;
+        object["name"] = "Event loop stall";
+        object["cat"] = "stall";
+        object["ph"] = "X";
+        object["ts"] = stall.startNs / 1000.0;
+        object["dur"] = stall.durationNs / 1000.0;
+        object["pid"] = pid;
+        object["tid"] = qint64(guiThread);
+        object["args"] = QJsonObject{{"stack", stack}};
+        traceEvents.append(object);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
@@ -0,0 +1,120 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QLoggingCategory>
+#include <atomic>
+
+Q_DECLARE_LOGGING_CATEGORY(lcStartup)
+
+struct TraceEvent
+{
+    const char *name;   // string literal, never copied
+    qint64 startNs;
+    qint64 durationNs;
+    quint64 threadId;
+};
+
+struct EventLoopStall
+{
+    qint64 startNs;
+    qint64 durationNs;
+    QVector<quint64> stack;   // GUI thread return addresses, innermost first
+};
+
+// Log2 buckets of microseconds: bucket i counts durations in [2^(i-1), 2^i) us
+struct TimingHistogram
+{
+    static constexpr int kBuckets = 24;
+
+    qint64 buckets[kBuckets] = {};
+    qint64 count = 0;
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+
+    void add(qint64 durationNs);
+    void merge(const TimingHistogram &other);
+};
+
+class StallWatchdog;
+class QTimer;
+
+// Opt-in tracing of hot paths and GUI thread stalls. Everything is a no-op
+// until setEnabled(true), apart from one relaxed atomic load per scope.
+class Instrumentation : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 kStallThresholdNs = 16 * 1000 * 1000;
+    static constexpr int kMaxEvents = 200000;
+
+    static Instrumentation *instance();
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static qint64 now() { return s_clock.nsecsElapsed(); }
+    // Logs the time since the previous phase (or process start) to the qtcide.startup category
+    static void markStartupPhase(const char *phase);
+
+    void setEnabled(bool enabled);
+    void record(const char *name, qint64 startNs, qint64 durationNs);
+    void recordStall(const EventLoopStall &stall);
+    void clear();
+
+    // Snapshots, safe to call from the GUI thread while recording continues
+    QHash<QString, TimingHistogram> histograms() const;
+    QVector<EventLoopStall> stalls() const;
+    qint64 droppedEvents() const;
+
+    bool writeChromeTrace(const QString &fileName, QString *error = nullptr) const;
+
+signals:
+    void enabledChanged(bool enabled);
+
+private:
+    explicit Instrumentation(QObject *parent = nullptr);
+    ~Instrumentation() override;
+
+    static std::atomic<bool> s_enabled;
+    static QElapsedTimer s_clock;
+
+    mutable QMutex m_mutex;
+    QVector<TraceEvent> m_events;
+    QHash<const char *, TimingHistogram> m_histograms;
+    QVector<EventLoopStall> m_stalls;
+    int m_eventHead;   // oldest event once the buffer has wrapped
+    qint64 m_dropped;
+    quint64 m_guiThreadId;
+    StallWatchdog *m_watchdog;
+    QTimer *m_heartbeat;
+};
+
+// Times the enclosing scope when instrumentation is enabled
+class InstrumentationScope
+{
+public:
+    explicit InstrumentationScope(const char *name)
+        : m_name(name)
+        , m_start(Instrumentation::isEnabled() ? Instrumentation::now() : -1)
+    {}
+
+    ~InstrumentationScope()
+    {
+        if (m_start >= 0) {
+            Instrumentation::instance()->record(m_name, m_start, Instrumentation::now() - m_start);
+        }
+    }
+
+    InstrumentationScope(const InstrumentationScope &) = delete;
+    InstrumentationScope &operator=(const InstrumentationScope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start;
+};
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,208 @@
+#include "InstrumentationView.h"
+#include <QPainter>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <algorithm>
+
+HistogramWidget::HistogramWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(90);
+}
+
+void HistogramWidget::setHistogram(const QString &name, const TimingHistogram &histogram)
+{
+    m_name = name;
+    m_histogram = histogram;
+    update();
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+    painter.setFont(QFont("Consolas", 8));
+
+    if (m_histogram.count == 0) {
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawText(rect(), Qt::AlignCenter, "Select a scope to see its histogram");
+        return;
+    }
+
+    qint64 maxCount = 1;
+    for (qint64 count : m_histogram.buckets) {
+        maxCount = qMax(maxCount, count);
+    }
+
+    const QRectF plot = QRectF(rect()).adjusted(4, 18, -4, -16);
+    const qreal barWidth = plot.width() / TimingHistogram::kBuckets;
+    // Buckets over the 16 ms frame budget are drawn in red
+    const int budgetBucket = 15;
+    for (int i = 0; i < TimingHistogram::kBuckets; ++i) {
+        if (m_histogram.buckets[i] == 0) {
+            continue;
+        }
+        const qreal height = plot.height() * m_histogram.buckets[i] / maxCount;
+        QRectF bar(plot.left() + i * barWidth + 1, plot.bottom() - height, barWidth - 2, height);
+        painter.fillRect(bar, i >= budgetBucket ? QColor(255, 100, 100) : QColor(255, 140, 0));
+    }
+
+    painter.setPen(QColor(150, 150, 150));
+    for (int i = 0; i < TimingHistogram::kBuckets; i += 4) {
+        painter.drawText(QPointF(plot.left() + i * barWidth, height() - 3),
+                         InstrumentationView::formatDuration(i == 0 ? 0 : (1LL << (i - 1)) * 1000));
+    }
+    painter.setPen(Qt::white);
+    painter.drawText(QPointF(4, 12), QString("%1 (%2 samples)").arg(m_name).arg(m_histogram.count));
+}
+
+InstrumentationView::InstrumentationView(QWidget *parent)
+    : QWidget(parent)
+    , m_refreshTimer(new QTimer(this))
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    auto *header = new QHBoxLayout;
+    m_recordButton = new QPushButton("Record");
+    m_recordButton->setCheckable(true);
+    m_recordButton->setChecked(Instrumentation::isEnabled());
+    header->addWidget(m_recordButton);
+    auto *clearButton = new QPushButton("Clear");
+    header->addWidget(clearButton);
+    auto *exportButton = new QPushButton("Export Chrome Trace...");
+    header->addWidget(exportButton);
+    m_summaryLabel = new QLabel("Instrumentation is off");
+    m_summaryLabel->setStyleSheet("color: white;");
+    header->addWidget(m_summaryLabel, 1);
+    layout->addLayout(header);
+
+    auto *splitter = new QSplitter(Qt::Vertical);
+    m_scopes = new QTableWidget(0, 6);
+    m_scopes->setHorizontalHeaderLabels({"Scope", "Count", "Mean", "p95", "Max", "Total"});
+    m_scopes->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_scopes->verticalHeader()->hide();
+    m_scopes->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_scopes->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_scopes->setSelectionMode(QAbstractItemView::SingleSelection);
+    splitter->addWidget(m_scopes);
+    m_histogram = new HistogramWidget;
+    splitter->addWidget(m_histogram);
+    layout->addWidget(splitter, 1);
+
+    Instrumentation *instrumentation = Instrumentation::instance();
+    connect(m_recordButton, &QPushButton::toggled, instrumentation, &Instrumentation::setEnabled);
+    connect(instrumentation, &Instrumentation::enabledChanged, m_recordButton, &QPushButton::setChecked);
+    connect(clearButton, &QPushButton::clicked, this, [this, instrumentation]() {
+        instrumentation->clear();
+        refresh();
+    });
+    connect(exportButton, &QPushButton::clicked, this, &InstrumentationView::exportTrace);
+    connect(m_scopes, &QTableWidget::itemSelectionChanged, this, &InstrumentationView::refresh);
+
+    // Only poll while something can change and someone is looking
+    m_refreshTimer->setInterval(500);
+    connect(m_refreshTimer, &QTimer::timeout, this, [this]() {
+        if (isVisible() && Instrumentation::isEnabled()) {
+            refresh();
+        }
+    });
+    m_refreshTimer->start();
+}
+
+QString InstrumentationView::formatDuration(qint64 nanoseconds)
+{
+    if (nanoseconds >= 1000000000) {
+        return QString("%1 s").arg(nanoseconds / 1e9, 0, 'f', 2);
+    }
+    if (nanoseconds >= 1000000) {
+        return QString("%1 ms").arg(nanoseconds / 1e6, 0, 'f', 1);
+    }
+    return QString("%1 us").arg(nanoseconds / 1e3, 0, 'f', 0);
+}
+
+qint64 InstrumentationView::percentile(const TimingHistogram &histogram, double fraction)
+{
+    const qint64 target = qint64(histogram.count * fraction);
+    qint64 seen = 0;
+    for (int i = 0; i < TimingHistogram::kBuckets; ++i) {
+        seen += histogram.buckets[i];
+        if (seen > target) {
+            return qMin(histogram.maxNs, (1LL << i) * 1000);
+        }
+    }
+    return histogram.maxNs;
+}
+
+void InstrumentationView::refresh()
+{
+    Instrumentation *instrumentation = Instrumentation::instance();
+    const QHash<QString, TimingHistogram> histograms = instrumentation->histograms();
+
+    QString selected;
+    if (QTableWidgetItem *item = m_scopes->item(m_scopes->currentRow(), 0)) {
+        selected = item->text();
+    }
+
+    QStringList names = histograms.keys();
+    std::sort(names.begin(), names.end(), [&histograms](const QString &a, const QString &b) {
+        return histograms.value(a).totalNs > histograms.value(b).totalNs;
+    });
+
+    m_scopes->blockSignals(true);
+    m_scopes->setRowCount(names.size());
+    for (int row = 0; row < names.size(); ++row) {
+        const TimingHistogram &histogram = histograms[names.at(row)];
+        const QStringList cells = {
+            names.at(row),
+            QString::number(histogram.count),
+            formatDuration(histogram.totalNs / histogram.count),
+            formatDuration(percentile(histogram, 0.95)),
+            formatDuration(histogram.maxNs),
+            formatDuration(histogram.totalNs)
+        };
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = m_scopes->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                m_scopes->setItem(row, column, item);
+            }
+            item->setText(cells.at(column));
+            item->setForeground(histogram.maxNs > Instrumentation::kStallThresholdNs && column == 4
+                                    ? QColor(255, 100, 100) : QColor(Qt::white));
+        }
+        if (names.at(row) == selected) {
+            m_scopes->selectRow(row);
+        }
+    }
+    m_scopes->blockSignals(false);
+
+    m_histogram->setHistogram(selected, histograms.value(selected));
+
+    QString summary = Instrumentation::isEnabled() ? QString("Recording") : QString("Instrumentation is off");
+    summary += QString(" - %1 event loop stalls over 16 ms").arg(instrumentation->stalls().size());
+    if (instrumentation->droppedEvents() > 0) {
+        summary += QString(", %1 oldest trace events overwritten").arg(instrumentation->droppedEvents());
+    }
+    m_summaryLabel->setText(summary);
+}
+
+void InstrumentationView::exportTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Export Chrome Trace", "qtcide-trace.json",
+                                                    "Chrome Trace (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    if (!Instrumentation::instance()->writeChromeTrace(fileName, &error)) {
+        QMessageBox::warning(this, "Export Error", "Could not write trace: " + error);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef INSTRUMENTATIONVIEW_H
+#define INSTRUMENTATIONVIEW_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+#include "Instrumentation.h"
+
+class HistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistogramWidget(QWidget *parent = nullptr);
+
+    void setHistogram(const QString &name, const TimingHistogram &histogram);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QString m_name;
+    TimingHistogram m_histogram;
+};
+
+// Live view of Instrumentation: per-scope timing table and the selected scope's histogram
+class InstrumentationView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit InstrumentationView(QWidget *parent = nullptr);
+
+    static QString formatDuration(qint64 nanoseconds);
+    // Upper bound of the bucket holding the given fraction of samples
+    static qint64 percentile(const TimingHistogram &histogram, double fraction);
+
+private slots:
+    void refresh();
+    void exportTrace();
+
+private:
+    QPushButton *m_recordButton;
+    QLabel *m_summaryLabel;
+    QTableWidget *m_scopes;
+    HistogramWidget *m_histogram;
+    QTimer *m_refreshTimer;
+};
+
+#endif // INSTRUMENTATIONVIEW_H
@@ -5,6 +5,28 @@
 #include "ProjectManager.h"
 #include "NewProjectDialog.h"
 #include "SettingsDialog.h"
+#include "RunConfiguration.h"
+#include "RunConfigurationDialog.h"
+#include "Profiler.h"
+#include "ProfilerView.h"
+#include "HeapProfiler.h"
+#include "HeapProfilerView.h"
+#include "DebuggerSession.h"
+#include "DebuggerPanel.h"
+#include "BenchmarkView.h"
+#include "Instrumentation.h"
+#include "InstrumentationView.h"
+#include "ProjectFileModel.h"
+#include "QuickOpenDialog.h"
+#include "FindInFiles.h"
+#include "FindInFilesPanel.h"
+#include "ReplaceInFiles.h"
+#include "ReplacePreviewDialog.h"
+#include "TrigramIndex.h"
+#include "FileSaver.h"
+#include "EditJournal.h"
+#include "DocumentWatcher.h"
+#include "TextDiff.h"
 #include <QApplication>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -14,12 +36,38 @@
 #include <QDir>
 #include <QFile>
 #include <QTimer>
+#include <QSettings>
+#include <QCloseEvent>
+#include <QScrollBar>
+#include <QTextCursor>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_editor(nullptr)
+    , m_fileTree(nullptr)
+    , m_fileModel(nullptr)
+    , m_terminal(nullptr)
+    , m_quickOpen(nullptr)
+    , m_quickOpenStale(true)
+    , m_findInFiles(new FindInFiles(this))
+    , m_replaceInFiles(new ReplaceInFiles(this))
+    , m_trigramIndex(new TrigramIndex(this))
+    , m_fileSaver(new FileSaver(this))
+    , m_buildAfterSave(false)
+    , m_journal(new EditJournal(this))
+    , m_documentWatcher(new DocumentWatcher(this))
     , m_buildProcess(new QProcess(this))
     , m_runProcess(new QProcess(this))
+    , m_restartPending(false)
     , m_projectManager(new ProjectManager(this))
+    , m_runConfigurations(new RunConfigurationManager(m_projectManager, this))
+    , m_profiler(new Profiler(this))
+    , m_heapProfiler(new HeapProfiler(this))
+    , m_benchmarkRunner(new BenchmarkRunner(this))
+    , m_debugger(new DebuggerSession(this))
+    , m_executionLine(0)
+    , m_restoringProject(false)
+    , m_projectViewPending(false)
 {
     setupUI();
     setupMenuBar();
@@ -40,7 +88,134 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Connect project manager
     connect(m_projectManager, &ProjectManager::projectOpened, this, &MainWindow::onProjectOpened);
+    connect(m_projectManager, &ProjectManager::projectAboutToClose, this, &MainWindow::saveSession);
     connect(m_projectManager, &ProjectManager::projectClosed, this, &MainWindow::onProjectClosed);
+    connect(m_projectManager, &ProjectManager::projectFilesChanged, this, [this]() {
+        m_quickOpenStale = true;
+        m_trigramIndex->updateFiles(m_projectManager->projectFiles());
+    });
+    connect(m_projectManager, &ProjectManager::fileChanged, m_trigramIndex, &TrigramIndex::updateFile);
+    connect(m_trigramIndex, &TrigramIndex::ready, this, [this](int fileCount) {
+        statusBar()->showMessage(QString("Content index ready (%1 files)").arg(fileCount), 3000);
+    });
+    
+    // Connect file saving
+    connect(m_fileSaver, &FileSaver::saved, this, [this](const QString &filePath, const TextFormat &format) {
+        if (filePath == m_currentFilePath) {
+            m_currentFileFormat = format;
+            m_documentWatcher->acknowledgeSave(filePath);
+        }
+        // Only once no newer save is queued is the journal's last save point on disk
+        if (!m_fileSaver->isBusy()) {
+            m_journal->markSaved(filePath);
+        }
+        statusBar()->showMessage("File saved: " + filePath);
+    });
+    connect(m_fileSaver, &FileSaver::saveFailed, this, [this](const QString &filePath, const QString &error) {
+        // The build waiting for the saves would compile what is still on disk
+        if (m_buildAfterSave) {
+            m_buildAfterSave = false;
+            statusBar()->showMessage("Build cancelled: a file could not be saved");
+        }
+        if (filePath == m_currentFilePath && m_editor) {
+            m_editor->document()->setModified(true);
+        }
+        QMessageBox::warning(this, "Save Error", "Could not save file: " + filePath + "\n" + error);
+    });
+    connect(m_fileSaver, &FileSaver::idle, this, [this]() {
+        m_documentWatcher->setSuspended(false);
+        if (m_buildAfterSave) {
+            m_buildAfterSave = false;
+            startBuild();
+        }
+    });
+    
+    // Other programs changing the open file
+    connect(m_projectManager, &ProjectManager::fileChanged, m_documentWatcher, &DocumentWatcher::fileChanged);
+    connect(m_documentWatcher, &DocumentWatcher::changedOnDisk, this,
+            [this](const QString &filePath, const QString &text, const TextFormat &format) {
+        if (filePath != m_currentFilePath) {
+            return;
+        }
+        const QString fileName = QFileInfo(filePath).fileName();
+        if (editor()->document()->isModified()
+            && QMessageBox::question(this, "File Changed on Disk",
+                                     fileName + " was changed by another program. Reload it and discard your unsaved changes?")
+                   != QMessageBox::Yes) {
+            return;
+        }
+        reloadDocument(text, format);
+        statusBar()->showMessage("Reloaded " + fileName + " (changed on disk)");
+    });
+    connect(m_documentWatcher, &DocumentWatcher::removedFromDisk, this, [this](const QString &filePath) {
+        if (filePath == m_currentFilePath && m_editor) {
+            // The buffer is now the only copy; saving writes the file again
+            m_editor->document()->setModified(true);
+            statusBar()->showMessage(QFileInfo(filePath).fileName() + " was deleted on disk");
+        }
+    });
+    
+    // Reopen the project of the last session once the window is up
+    QTimer::singleShot(0, this, &MainWindow::restoreLastProject);
+    
+    connect(m_runConfigurations, &RunConfigurationManager::configurationsChanged,
+            this, &MainWindow::updateRunConfigurationCombo);
+    
+    // Connect profiler
+    connect(m_profiler, &Profiler::output, this, [this](const QString &text) {
+        terminal()->appendText(text);
+    });
+    connect(m_profiler, &Profiler::finished, this, [this](int exitCode) {
+        terminal()->appendText(QString("Profiled application finished with exit code: %1\n").arg(exitCode));
+    });
+    connect(m_profiler, &Profiler::errorOccurred, this, [this](const QString &message) {
+        terminal()->appendText("Profiler error: " + message + "\n\n");
+        statusBar()->showMessage("Profiling failed");
+    });
+    connect(m_profiler, &Profiler::profileReady, this, &MainWindow::onProfileReady);
+    
+    // Connect heap profiler
+    connect(m_heapProfiler, &HeapProfiler::output, this, [this](const QString &text) {
+        terminal()->appendText(text);
+    });
+    connect(m_heapProfiler, &HeapProfiler::finished, this, [this](int exitCode) {
+        terminal()->appendText(QString("Heap profiled application finished with exit code: %1\n").arg(exitCode));
+    });
+    connect(m_heapProfiler, &HeapProfiler::errorOccurred, this, [this](const QString &message) {
+        terminal()->appendText("Heap profiler error: " + message + "\n\n");
+        statusBar()->showMessage("Heap profiling failed");
+    });
+    connect(m_heapProfiler, &HeapProfiler::timelineUpdated, m_heapProfilerView, &HeapProfilerView::updateTimeline);
+    connect(m_heapProfiler, &HeapProfiler::sitesReady, this, &MainWindow::onHeapProfileReady);
+    
+    // Connect benchmark runner
+    connect(m_benchmarkRunner, &BenchmarkRunner::output, this, [this](const QString &text) {
+        terminal()->appendText(text);
+    });
+    connect(m_benchmarkRunner, &BenchmarkRunner::errorOccurred, this, [this](const QString &message) {
+        terminal()->appendText("Benchmark error: " + message + "\n\n");
+        statusBar()->showMessage("Benchmark run failed");
+    });
+    connect(m_benchmarkRunner, &BenchmarkRunner::runFinished, this, &MainWindow::onBenchmarkFinished);
+    
+    // Connect debugger
+    connect(m_debugger, &DebuggerSession::output, this, [this](const QString &text) {
+        terminal()->appendText(text);
+    });
+    connect(m_debugger, &DebuggerSession::errorOccurred, this, [this](const QString &message) {
+        terminal()->appendText("Debugger error: " + message + "\n\n");
+        statusBar()->showMessage("Debugging failed");
+    });
+    connect(m_debugger, &DebuggerSession::running, this, [this]() {
+        m_executionFile.clear();
+        m_executionLine = 0;
+        if (m_editor) {
+            m_editor->setExecutionLine(0);
+        }
+        statusBar()->showMessage("Debugging...");
+    });
+    connect(m_debugger, &DebuggerSession::stopped, this, &MainWindow::onDebuggerStopped);
+    connect(m_debugger, &DebuggerSession::exited, this, &MainWindow::onDebuggerExited);
     
     resize(1400, 900);
     setWindowTitle("QTCIDE - Professional Qt IDE");
@@ -67,15 +242,162 @@ void MainWindow::setupUI()
     m_mainSplitter = new QSplitter(Qt::Horizontal);
     m_stackedWidget->addWidget(m_mainSplitter);
     
-    // File explorer
+    // The file tree, editor and terminal are created on first use (see showMainView)
+    m_rightSplitter = new QSplitter(Qt::Vertical);
+    m_mainSplitter->addWidget(m_rightSplitter);
+    
+    // Profiler results, shown when a profiling run completes
+    m_profilerView = new ProfilerView;
+    m_profilerDock = new QDockWidget("Profiler", this);
+    m_profilerDock->setObjectName("ProfilerDock");
+    m_profilerDock->setWidget(m_profilerView);
+    addDockWidget(Qt::BottomDockWidgetArea, m_profilerDock);
+    m_profilerDock->hide();
+    connect(m_profilerView, &ProfilerView::openLocation, this, &MainWindow::openFileAtLine);
+    
+    m_heapProfilerView = new HeapProfilerView;
+    m_heapProfilerDock = new QDockWidget("Heap Profiler", this);
+    m_heapProfilerDock->setObjectName("HeapProfilerDock");
+    m_heapProfilerDock->setWidget(m_heapProfilerView);
+    addDockWidget(Qt::BottomDockWidgetArea, m_heapProfilerDock);
+    tabifyDockWidget(m_profilerDock, m_heapProfilerDock);
+    m_heapProfilerDock->hide();
+    connect(m_heapProfilerView, &HeapProfilerView::openLocation, this, &MainWindow::openFileAtLine);
+    
+    m_benchmarkView = new BenchmarkView;
+    m_benchmarkView->setHistory(&m_benchmarkHistory);
+    m_benchmarkDock = new QDockWidget("Benchmarks", this);
+    m_benchmarkDock->setObjectName("BenchmarksDock");
+    m_benchmarkDock->setWidget(m_benchmarkView);
+    addDockWidget(Qt::BottomDockWidgetArea, m_benchmarkDock);
+    tabifyDockWidget(m_profilerDock, m_benchmarkDock);
+    m_benchmarkDock->hide();
+    
+    m_instrumentationView = new InstrumentationView;
+    m_instrumentationDock = new QDockWidget("Instrumentation", this);
+    m_instrumentationDock->setObjectName("InstrumentationDock");
+    m_instrumentationDock->setWidget(m_instrumentationView);
+    addDockWidget(Qt::BottomDockWidgetArea, m_instrumentationDock);
+    tabifyDockWidget(m_profilerDock, m_instrumentationDock);
+    m_instrumentationDock->hide();
+    
+    m_debuggerPanel = new DebuggerPanel(m_debugger);
+    m_debuggerDock = new QDockWidget("Debugger", this);
+    m_debuggerDock->setObjectName("DebuggerDock");
+    m_debuggerDock->setWidget(m_debuggerPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, m_debuggerDock);
+    tabifyDockWidget(m_profilerDock, m_debuggerDock);
+    m_debuggerDock->hide();
+    connect(m_debuggerPanel, &DebuggerPanel::openLocation, this, &MainWindow::openFileAtLine);
+    
+    m_findPanel = new FindInFilesPanel;
+    m_findDock = new QDockWidget("Find in Files", this);
+    m_findDock->setObjectName("FindInFilesDock");
+    m_findDock->setWidget(m_findPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, m_findDock);
+    tabifyDockWidget(m_profilerDock, m_findDock);
+    m_findDock->hide();
+    connect(m_findPanel, &FindInFilesPanel::openLocation, this, &MainWindow::openFileAtLine);
+    connect(m_findPanel, &FindInFilesPanel::searchRequested, this, [this](const SearchOptions &options) {
+        m_searchHits.clear();
+        if (m_editor) {
+            m_editor->setLineMarks(GutterRenderer::SearchHit, {});
+        }
+        const QStringList files = m_projectManager->projectFiles();
+        m_findInFiles->start(files, options, m_trigramIndex->ruledOut(options, files));
+    });
+    connect(m_findPanel, &FindInFilesPanel::stopRequested, m_findInFiles, &FindInFiles::cancel);
+    connect(m_findInFiles, &FindInFiles::fileOutdated, m_trigramIndex, &TrigramIndex::updateFile);
+    connect(m_findInFiles, &FindInFiles::matchesFound, m_findPanel, &FindInFilesPanel::addMatches);
+    connect(m_findInFiles, &FindInFiles::matchesFound, this, [this](const QVector<SearchMatch> &matches) {
+        bool inOpenFile = false;
+        for (const SearchMatch &match : matches) {
+            m_searchHits[match.filePath].insert(match.line, GutterRenderer::SearchHit);
+            inOpenFile |= match.filePath == m_currentFilePath;
+        }
+        if (inOpenFile && m_editor) {
+            m_editor->setLineMarks(GutterRenderer::SearchHit, m_searchHits.value(m_currentFilePath));
+        }
+    });
+    connect(m_findInFiles, &FindInFiles::finished, m_findPanel, &FindInFilesPanel::searchFinished);
+    connect(m_findPanel, &FindInFilesPanel::replaceRequested, this, &MainWindow::replaceInFiles);
+    connect(m_replaceInFiles, &ReplaceInFiles::prepared, this, &MainWindow::onReplacementsPrepared);
+    connect(m_replaceInFiles, &ReplaceInFiles::applied, this,
+            [this](const QStringList &files, int replacementCount, const QString &error) {
+        m_projectManager->endBatchChanges();
+        m_undoReplaceAction->setEnabled(m_replaceInFiles->canUndo());
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, "Replace in Files", error);
+            return;
+        }
+        reloadIfOpen(files);
+        statusBar()->showMessage(QString("Replaced %1 occurrences in %2 files").arg(replacementCount).arg(files.size()));
+    });
+    connect(m_replaceInFiles, &ReplaceInFiles::undone, this, [this](const QStringList &files, const QString &error) {
+        m_projectManager->endBatchChanges();
+        m_undoReplaceAction->setEnabled(m_replaceInFiles->canUndo());
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, "Undo Replace in Files", error);
+            return;
+        }
+        reloadIfOpen(files);
+        statusBar()->showMessage(QString("Restored %1 files").arg(files.size()));
+    });
+    
+    // Show welcome screen initially
+    m_stackedWidget->setCurrentWidget(m_welcomeScreen);
+}
+
+CodeEditor *MainWindow::editor()
+{
+    if (!m_editor) {
+        m_editor = new CodeEditor;
+        m_rightSplitter->insertWidget(0, m_editor);
+        connect(m_editor, &CodeEditor::breakpointToggled, this, &MainWindow::onBreakpointToggled);
+    }
+    return m_editor;
+}
+
+Terminal *MainWindow::terminal()
+{
+    if (!m_terminal) {
+        m_terminal = new Terminal;
+        m_terminal->setMaximumHeight(200);
+        m_rightSplitter->addWidget(m_terminal);
+        
+        // Connect terminal signals
+        connect(m_terminal, &Terminal::directoryChanged, this, [this](const QString &path) {
+            if (!m_currentProjectPath.isEmpty() && m_fileTree) {
+                m_fileTree->setRootIndex(m_fileModel->index(path));
+            }
+        });
+        
+        connect(m_terminal, &Terminal::fileSystemChanged, this, [this]() {
+            // Terminal commands only touch their current directory
+            if (m_fileModel) {
+                m_fileModel->refresh(m_terminal->currentDirectory());
+            }
+        });
+    }
+    return m_terminal;
+}
+
+void MainWindow::ensureFileTree()
+{
+    if (m_fileTree) {
+        return;
+    }
+    
+    // Rooted at the project; only directories that have been expanded are listed and watched
+    QString rootPath = m_currentProjectPath.isEmpty() ? QDir::homePath() : m_currentProjectPath;
     m_fileTree = new QTreeView;
-    m_fileModel = new QFileSystemModel;
-    m_fileModel->setRootPath(QDir::homePath());
+    m_fileModel = new ProjectFileModel(this);
+    m_fileModel->setRootPath(rootPath);
     m_fileTree->setModel(m_fileModel);
-    m_fileTree->setRootIndex(m_fileModel->index(QDir::homePath()));
+    m_fileTree->setRootIndex(m_fileModel->index(rootPath));
     m_fileTree->setMaximumWidth(250);
     m_fileTree->setContextMenuPolicy(Qt::CustomContextMenu);
-    m_mainSplitter->addWidget(m_fileTree);
+    m_mainSplitter->insertWidget(0, m_fileTree);
     
     // Connect file tree signals
     connect(m_fileTree, &QTreeView::doubleClicked, this, [this](const QModelIndex &index) {
@@ -87,39 +409,31 @@ void MainWindow::setupUI()
     
     // Context menu for file operations
     connect(m_fileTree, &QTreeView::customContextMenuRequested, this, &MainWindow::showFileContextMenu);
+}
+
+void MainWindow::showMainView()
+{
+    if (m_stackedWidget->currentWidget() == m_mainSplitter) {
+        return;
+    }
     
-    // Right side splitter (editor + terminal)
-    m_rightSplitter = new QSplitter(Qt::Vertical);
-    m_mainSplitter->addWidget(m_rightSplitter);
-    
-    // Editor
-    m_editor = new CodeEditor;
-    m_rightSplitter->addWidget(m_editor);
-    
-    // Terminal
-    m_terminal = new Terminal;
-    m_terminal->setMaximumHeight(200);
-    m_rightSplitter->addWidget(m_terminal);
-    
-    // Connect terminal signals
-    connect(m_terminal, &Terminal::directoryChanged, this, [this](const QString &path) {
-        if (!m_currentProjectPath.isEmpty()) {
-            m_fileTree->setRootIndex(m_fileModel->index(path));
-        }
-    });
-    
-    connect(m_terminal, &Terminal::fileSystemChanged, this, [this]() {
-        // Refresh file tree by updating the model
-        QString currentPath = m_fileModel->rootPath();
-        m_fileModel->setRootPath("");
-        m_fileModel->setRootPath(currentPath);
-    });
-    
-    m_mainSplitter->setSizes({250, 1150});
-    m_rightSplitter->setSizes({700, 200});
-    
-    // Show welcome screen initially
-    m_stackedWidget->setCurrentWidget(m_welcomeScreen);
+    bool firstTime = !m_fileTree;
+    ensureFileTree();
+    editor();
+    terminal();
+    if (firstTime) {
+        // A project restored at startup may have left its layout for the widgets made just now
+        const bool sessionSizes = m_session.mainSplitterSizes.size() == m_mainSplitter->count()
+                                  && m_session.rightSplitterSizes.size() == m_rightSplitter->count();
+        m_mainSplitter->setSizes(sessionSizes ? m_session.mainSplitterSizes : QList<int>{250, 1150});
+        m_rightSplitter->setSizes(sessionSizes ? m_session.rightSplitterSizes : QList<int>{700, 200});
+    }
+    if (m_projectViewPending) {
+        m_projectViewPending = false;
+        terminal()->setCurrentDirectory(m_session.terminalDirectory.isEmpty() ? m_currentProjectPath
+                                                                               : m_session.terminalDirectory);
+    }
+    m_stackedWidget->setCurrentWidget(m_mainSplitter);
 }
 
 void MainWindow::setupMenuBar()
@@ -133,6 +447,10 @@ void MainWindow::setupMenuBar()
     fileMenu->addAction("&New Project...", QKeySequence("Ctrl+Shift+N"), this, &MainWindow::newProject);
     fileMenu->addAction("&Open Project...", QKeySequence("Ctrl+Shift+O"), this, &MainWindow::openProject);
     fileMenu->addAction("Open &Folder", this, &MainWindow::openFolder);
+    fileMenu->addAction("&Quick Open...", QKeySequence("Ctrl+P"), this, &MainWindow::quickOpen);
+    fileMenu->addAction("Find in F&iles...", QKeySequence("Ctrl+Shift+F"), this, &MainWindow::findInFiles);
+    m_undoReplaceAction = fileMenu->addAction("&Undo Replace in Files", this, &MainWindow::undoReplaceInFiles);
+    m_undoReplaceAction->setEnabled(false);
     fileMenu->addSeparator();
     fileMenu->addAction("E&xit", QKeySequence::Quit, this, &QWidget::close);
     
@@ -143,19 +461,66 @@ void MainWindow::setupMenuBar()
     buildMenu->addAction("&Clean", this, &MainWindow::clean);
     buildMenu->addSeparator();
     buildMenu->addAction("&Run", QKeySequence("Ctrl+R"), this, &MainWindow::run);
+    buildMenu->addAction("R&estart", QKeySequence("Ctrl+Shift+R"), this, &MainWindow::restartRun);
+    buildMenu->addAction("&Stop", QKeySequence("Shift+F5"), this, &MainWindow::stopRun);
     buildMenu->addAction("Run &Debug", QKeySequence("F5"), this, &MainWindow::runDebug);
+    buildMenu->addAction("Step &Over", QKeySequence("F10"), m_debugger, &DebuggerSession::stepOver);
+    buildMenu->addAction("Step &Into", QKeySequence("F11"), m_debugger, &DebuggerSession::stepInto);
+    buildMenu->addAction("Step O&ut", QKeySequence("Shift+F11"), m_debugger, &DebuggerSession::stepOut);
+    buildMenu->addAction("Stop Debu&gging", QKeySequence("Ctrl+Shift+F5"), m_debugger, &DebuggerSession::stop);
+    buildMenu->addAction("Run with &Profiler", QKeySequence("Alt+F5"), this, &MainWindow::runWithProfiler);
+    buildMenu->addAction("Run with &Heap Profiler", QKeySequence("Alt+Shift+F5"), this, &MainWindow::runWithHeapProfiler);
+    buildMenu->addAction("Run &Benchmarks", QKeySequence("Ctrl+Alt+B"), this, &MainWindow::runBenchmarks);
+    buildMenu->addSeparator();
+    buildMenu->addAction("Run Con&figurations...", this, &MainWindow::editRunConfigurations);
     
     auto *viewMenu = menuBar()->addMenu("&View");
     viewMenu->addAction("&Welcome", this, &MainWindow::showWelcome);
     viewMenu->addAction("&Terminal", QKeySequence("Ctrl+`"), this, &MainWindow::focusTerminal);
+    viewMenu->addAction(m_profilerDock->toggleViewAction());
+    viewMenu->addAction(m_heapProfilerDock->toggleViewAction());
+    viewMenu->addAction(m_benchmarkDock->toggleViewAction());
+    viewMenu->addAction(m_debuggerDock->toggleViewAction());
+    viewMenu->addAction(m_instrumentationDock->toggleViewAction());
+    viewMenu->addAction(m_findDock->toggleViewAction());
+    viewMenu->addSeparator();
+    viewMenu->addAction("&Fold Region", QKeySequence("Ctrl+Shift+["), this, [this]() { editor()->foldAtCursor(true); });
+    viewMenu->addAction("&Unfold Region", QKeySequence("Ctrl+Shift+]"), this, [this]() { editor()->foldAtCursor(false); });
+    viewMenu->addAction("Unfold &All", this, [this]() { editor()->unfoldAll(); });
+    viewMenu->addAction("Go to Matching &Bracket", QKeySequence("Ctrl+Shift+\\"), this, [this]() { editor()->jumpToMatchingBracket(); });
     
     auto *toolsMenu = menuBar()->addMenu("&Tools");
     toolsMenu->addAction("&Settings...", QKeySequence("Ctrl+,"), this, &MainWindow::showSettings);
+    
+    QAction *instrumentAction = toolsMenu->addAction("Record &Instrumentation");
+    instrumentAction->setCheckable(true);
+    instrumentAction->setChecked(Instrumentation::isEnabled());
+    connect(instrumentAction, &QAction::toggled, this, [this](bool enabled) {
+        Instrumentation::instance()->setEnabled(enabled);
+        if (enabled) {
+            m_instrumentationDock->show();
+            m_instrumentationDock->raise();
+        }
+    });
+    connect(Instrumentation::instance(), &Instrumentation::enabledChanged, instrumentAction, &QAction::setChecked);
+    
+    QAction *indexAction = toolsMenu->addAction("Index Project &Contents");
+    indexAction->setCheckable(true);
+    indexAction->setChecked(QSettings("QTCIDE", "Settings").value("trigramIndex", false).toBool());
+    connect(indexAction, &QAction::toggled, this, [this](bool enabled) {
+        QSettings("QTCIDE", "Settings").setValue("trigramIndex", enabled);
+        if (!enabled) {
+            m_trigramIndex->close();
+        } else if (!m_currentProjectPath.isEmpty()) {
+            m_trigramIndex->open(m_currentProjectPath, m_projectManager->projectFiles());
+        }
+    });
 }
 
 void MainWindow::setupToolBar()
 {
     auto *toolbar = addToolBar("Main");
+    toolbar->setObjectName("MainToolBar");
     toolbar->addAction("New", this, &MainWindow::newFile);
     toolbar->addAction("Open", this, &MainWindow::openFile);
     toolbar->addAction("Save", this, &MainWindow::saveFile);
@@ -163,6 +528,17 @@ void MainWindow::setupToolBar()
     toolbar->addSeparator();
     toolbar->addAction("Build", this, &MainWindow::build);
     toolbar->addAction("Run", this, &MainWindow::run);
+    toolbar->addAction("Restart", this, &MainWindow::restartRun);
+    toolbar->addAction("Stop", this, &MainWindow::stopRun);
+    
+    m_runConfigCombo = new QComboBox;
+    m_runConfigCombo->setMinimumWidth(150);
+    m_runConfigCombo->setToolTip("Active run configuration");
+    toolbar->addWidget(m_runConfigCombo);
+    connect(m_runConfigCombo, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+        m_runConfigurations->setActiveConfiguration(m_runConfigCombo->itemText(index));
+    });
+    updateRunConfigurationCombo();
 }
 
 void MainWindow::setupStatusBar()
@@ -234,8 +610,11 @@ void MainWindow::applyGlassmorphicStyle()
 
 void MainWindow::newFile()
 {
-    m_editor->clear();
-    m_stackedWidget->setCurrentWidget(m_mainSplitter);
+    m_journal->detach();
+    m_documentWatcher->unwatch();
+    editor()->clear();
+    editor()->setLineMarks(GutterRenderer::SearchHit, {});
+    showMainView();
     statusBar()->showMessage("New file created");
 }
 
@@ -243,13 +622,7 @@ void MainWindow::openFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "Open File", QDir::homePath());
     if (!fileName.isEmpty()) {
-        QFile file(fileName);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&file);
-            m_editor->setPlainText(in.readAll());
-            m_stackedWidget->setCurrentWidget(m_mainSplitter);
-            statusBar()->showMessage("File opened: " + fileName);
-        }
+        openFileFromPath(fileName);
     }
 }
 
@@ -257,10 +630,8 @@ void MainWindow::openFolder()
 {
     QString folderPath = QFileDialog::getExistingDirectory(this, "Open Folder", QDir::homePath());
     if (!folderPath.isEmpty()) {
-        m_currentProjectPath = folderPath;
-        m_fileTree->setRootIndex(m_fileModel->index(folderPath));
-        m_terminal->setCurrentDirectory(folderPath);
-        m_stackedWidget->setCurrentWidget(m_mainSplitter);
+        // Route through the project manager so per-project settings (run configurations) load
+        m_projectManager->openProject(folderPath);
         statusBar()->showMessage("Folder opened: " + folderPath);
     }
 }
@@ -272,10 +643,10 @@ void MainWindow::configure()
         return;
     }
     
-    m_terminal->clear();
-    m_terminal->appendText("=== Configuring Project ===\n");
-    m_terminal->appendText("Project: " + m_currentProjectPath + "\n");
-    m_terminal->appendText("Terminal: " + m_terminal->getCurrentShellType() + "\n\n");
+    terminal()->clear();
+    terminal()->appendText("=== Configuring Project ===\n");
+    terminal()->appendText("Project: " + m_currentProjectPath + "\n");
+    terminal()->appendText("Terminal: " + terminal()->getCurrentShellType() + "\n\n");
     
     QString buildDir = m_currentProjectPath + "/build";
     QDir().mkpath(buildDir);
@@ -296,8 +667,8 @@ void MainWindow::configure()
     m_buildProcess->start();
     
     if (!m_buildProcess->waitForStarted()) {
-        m_terminal->appendText("Error: Could not start cmake configure process\n");
-        m_terminal->appendText("Make sure CMake is installed and in PATH\n\n");
+        terminal()->appendText("Error: Could not start cmake configure process\n");
+        terminal()->appendText("Make sure CMake is installed and in PATH\n\n");
         statusBar()->showMessage("Configure failed");
     }
 }
@@ -309,15 +680,25 @@ void MainWindow::build()
         return;
     }
     
-    // Save current file before building
-    if (!m_currentFilePath.isEmpty()) {
+    // Save current file before building; the build starts once the save is on disk. An
+    // unmodified file is left alone so its timestamp does not trigger a rebuild
+    if (!m_currentFilePath.isEmpty() && m_editor && m_editor->document()->isModified()) {
         saveFile();
     }
-    
-    m_terminal->clear();
-    m_terminal->appendText("=== Building Project ===\n");
-    m_terminal->appendText("Project: " + m_currentProjectPath + "\n");
-    m_terminal->appendText("Terminal: " + m_terminal->getCurrentShellType() + "\n\n");
+    if (m_fileSaver->isBusy()) {
+        m_buildAfterSave = true;
+        statusBar()->showMessage("Saving before build...");
+        return;
+    }
+    startBuild();
+}
+
+void MainWindow::startBuild()
+{
+    terminal()->clear();
+    terminal()->appendText("=== Building Project ===\n");
+    terminal()->appendText("Project: " + m_currentProjectPath + "\n");
+    terminal()->appendText("Terminal: " + terminal()->getCurrentShellType() + "\n\n");
     
     QString buildDir = m_currentProjectPath + "/build";
     QDir().mkpath(buildDir);
@@ -326,8 +707,8 @@ void MainWindow::build()
     
     // Check if CMakeLists.txt exists
     if (!QFile::exists(m_currentProjectPath + "/CMakeLists.txt")) {
-        m_terminal->appendText("Error: No CMakeLists.txt found in project directory\n");
-        m_terminal->appendText("Build failed.\n\n");
+        terminal()->appendText("Error: No CMakeLists.txt found in project directory\n");
+        terminal()->appendText("Build failed.\n\n");
         return;
     }
     
@@ -353,8 +734,8 @@ void MainWindow::build()
         m_buildProcess->start();
         
         if (!m_buildProcess->waitForStarted()) {
-            m_terminal->appendText("Error: Could not start build process\n");
-            m_terminal->appendText("Make sure CMake and Ninja are installed and in PATH\n\n");
+            terminal()->appendText("Error: Could not start build process\n");
+            terminal()->appendText("Make sure CMake and Ninja are installed and in PATH\n\n");
             statusBar()->showMessage("Build failed - tools not found");
         }
     }
@@ -374,16 +755,17 @@ void MainWindow::clean()
         return;
     }
     
-    m_terminal->clear();
-    m_terminal->appendText("=== Cleaning Project ===\n");
+    terminal()->clear();
+    terminal()->appendText("=== Cleaning Project ===\n");
     
     QString buildDir = m_currentProjectPath + "/build";
     QDir dir(buildDir);
     if (dir.exists()) {
         dir.removeRecursively();
-        m_terminal->appendText("Build directory cleaned.\n\n");
+        m_runConfigurations->invalidateExecutableCache();
+        terminal()->appendText("Build directory cleaned.\n\n");
     } else {
-        m_terminal->appendText("No build directory to clean.\n\n");
+        terminal()->appendText("No build directory to clean.\n\n");
     }
     
     statusBar()->showMessage("Project cleaned");
@@ -396,51 +778,322 @@ void MainWindow::run()
         return;
     }
     
-    // Find executable in build directory
-    QString buildDir = m_currentProjectPath + "/build";
-    QDir dir(buildDir);
-    
-    QStringList nameFilters;
-#ifdef Q_OS_WIN
-    nameFilters << "*.exe";
-#else
-    nameFilters << "*";
-#endif
+    if (m_runProcess->state() != QProcess::NotRunning) {
+        statusBar()->showMessage("Application is already running - use Restart (Ctrl+Shift+R) to relaunch");
+        return;
+    }
     
-    QFileInfoList executables = dir.entryInfoList(nameFilters, QDir::Files | QDir::Executable);
+    startRunProcess();
+}
+
+void MainWindow::restartRun()
+{
+    if (m_runProcess->state() == QProcess::NotRunning) {
+        run();
+        return;
+    }
     
-    QString executable;
-    for (const QFileInfo &info : executables) {
-        if (!info.fileName().contains("CMakeFiles") && !info.fileName().startsWith("cmake")) {
-            executable = info.absoluteFilePath();
-            break;
-        }
+    // Relaunch from onRunFinished once the old instance is gone
+    m_restartPending = true;
+    m_runProcess->kill();
+    statusBar()->showMessage("Restarting application...");
+}
+
+void MainWindow::stopRun()
+{
+    if (m_runProcess->state() != QProcess::NotRunning) {
+        m_restartPending = false;
+        m_runProcess->kill();
     }
+}
+
+void MainWindow::startRunProcess()
+{
+    RunConfiguration config = m_runConfigurations->activeConfiguration();
+    QString executable = m_runConfigurations->resolveExecutable(config);
     
     if (executable.isEmpty()) {
-        m_terminal->appendText("No executable found. Please build the project first.\n\n");
+        terminal()->appendText("No executable found. Please build the project first.\n\n");
         statusBar()->showMessage("Run failed - no executable found");
         return;
     }
     
-    m_terminal->appendText("=== Running Application ===\n");
-    m_terminal->appendText("Executable: " + executable + "\n\n");
+    terminal()->appendText("=== Running Application ===\n");
+    terminal()->appendText("Configuration: " + config.name + "\n");
+    terminal()->appendText("Executable: " + executable + "\n");
+    if (!config.arguments.isEmpty()) {
+        terminal()->appendText("Arguments: " + config.arguments.join(' ') + "\n");
+    }
+    terminal()->appendText("\n");
     
-    m_runProcess->setWorkingDirectory(buildDir);
-    m_runProcess->start(executable, QStringList());
+    m_runProcess->setWorkingDirectory(m_runConfigurations->workingDirectory(config));
+    m_runProcess->setProcessEnvironment(config.processEnvironment());
+    m_runProcess->start(executable, config.arguments);
     
     if (!m_runProcess->waitForStarted()) {
-        m_terminal->appendText("Error: Could not start application\n\n");
+        terminal()->appendText("Error: Could not start application\n\n");
         statusBar()->showMessage("Run failed");
     } else {
         statusBar()->showMessage("Application running...");
     }
 }
 
+void MainWindow::runWithProfiler()
+{
+    if (m_currentProjectPath.isEmpty()) {
+        QMessageBox::warning(this, "Profile", "Please open a project folder first.");
+        return;
+    }
+    
+    if (m_profiler->isRunning()) {
+        statusBar()->showMessage("A profiling session is already running");
+        return;
+    }
+    
+    RunConfiguration config = m_runConfigurations->activeConfiguration();
+    QString executable = m_runConfigurations->resolveExecutable(config);
+    if (executable.isEmpty()) {
+        terminal()->appendText("No executable found. Please build the project first.\n\n");
+        statusBar()->showMessage("Profile failed - no executable found");
+        return;
+    }
+    
+    terminal()->appendText("=== Profiling Application ===\n");
+    terminal()->appendText("Executable: " + executable + "\n");
+    
+    m_profilerView->clear();
+    if (m_profiler->start(executable, config.arguments,
+                          m_runConfigurations->workingDirectory(config), config.processEnvironment())) {
+        terminal()->appendText(QString("Sampler: %1\n\n").arg(m_profiler->backend() == Profiler::Perf
+                                                                  ? "perf record" : "built-in ptrace sampler"));
+        statusBar()->showMessage("Profiling application...");
+    }
+}
+
+void MainWindow::onProfileReady()
+{
+    m_profilerView->setProfile(&m_profiler->data());
+    m_profilerDock->show();
+    m_profilerDock->raise();
+    
+    statusBar()->showMessage(QString("Profile ready: %1 samples").arg(m_profiler->data().totalSamples));
+}
+
+void MainWindow::runWithHeapProfiler()
+{
+    if (m_currentProjectPath.isEmpty()) {
+        QMessageBox::warning(this, "Heap Profile", "Please open a project folder first.");
+        return;
+    }
+    
+    if (m_heapProfiler->isRunning()) {
+        statusBar()->showMessage("A heap profiling session is already running");
+        return;
+    }
+    
+    RunConfiguration config = m_runConfigurations->activeConfiguration();
+    QString executable = m_runConfigurations->resolveExecutable(config);
+    if (executable.isEmpty()) {
+        terminal()->appendText("No executable found. Please build the project first.\n\n");
+        statusBar()->showMessage("Heap profile failed - no executable found");
+        return;
+    }
+    
+    terminal()->appendText("=== Heap Profiling Application ===\n");
+    terminal()->appendText("Executable: " + executable + "\n\n");
+    
+    m_heapProfilerView->setProfiler(m_heapProfiler);
+    m_heapProfilerView->clear();
+    m_heapProfilerDock->show();
+    m_heapProfilerDock->raise();
+    if (m_heapProfiler->start(executable, config.arguments,
+                              m_runConfigurations->workingDirectory(config), config.processEnvironment())) {
+        statusBar()->showMessage("Heap profiling application...");
+    }
+}
+
+void MainWindow::onHeapProfileReady()
+{
+    m_heapProfilerView->showSites();
+    m_heapProfilerDock->show();
+    m_heapProfilerDock->raise();
+    
+    statusBar()->showMessage("Heap profile ready: peak resident "
+                             + HeapProfilerView::formatBytes(m_heapProfiler->peakResidentBytes()));
+}
+
+void MainWindow::runBenchmarks()
+{
+    if (m_currentProjectPath.isEmpty()) {
+        QMessageBox::warning(this, "Benchmarks", "Please open a project folder first.");
+        return;
+    }
+    
+    if (m_benchmarkRunner->isRunning()) {
+        statusBar()->showMessage("A benchmark run is already in progress");
+        return;
+    }
+    
+    RunConfiguration config = m_runConfigurations->activeConfiguration();
+    QString executable = m_runConfigurations->resolveExecutable(config);
+    if (executable.isEmpty()) {
+        terminal()->appendText("No executable found. Please build the project first.\n\n");
+        statusBar()->showMessage("Benchmark run failed - no executable found");
+        return;
+    }
+    
+    QSettings settings("QTCIDE", "Settings");
+    int repetitions = settings.value("benchmarkRepetitions", 10).toInt();
+    
+    terminal()->appendText("=== Running Benchmarks ===\n");
+    terminal()->appendText(QString("Executable: %1 (%2 repetitions)\n\n").arg(executable).arg(repetitions));
+    
+    if (m_benchmarkRunner->start(executable, config.arguments, m_runConfigurations->workingDirectory(config),
+                                 config.processEnvironment(), m_currentProjectPath, repetitions)) {
+        statusBar()->showMessage("Running benchmarks...");
+    }
+}
+
+void MainWindow::onBenchmarkFinished(const BenchmarkRun &run)
+{
+    // Reload first so runs recorded from the command line in the meantime are kept
+    QString error;
+    if (!m_benchmarkHistory.load(&error)) {
+        terminal()->appendText("Could not read benchmark history: " + error + "\n");
+    }
+    m_benchmarkHistory.addRun(run);
+    if (!m_benchmarkHistory.save(&error)) {
+        terminal()->appendText("Could not save benchmark history: " + error + "\n");
+    }
+    
+    m_benchmarkView->refresh();
+    m_benchmarkDock->show();
+    m_benchmarkDock->raise();
+    
+    terminal()->appendText(QString("Recorded %1 benchmarks for %2\n\n").arg(run.results.size()).arg(run.label()));
+    statusBar()->showMessage("Benchmark run finished");
+}
+
+void MainWindow::openFileAtLine(const QString &filePath, int line)
+{
+    QString path = filePath;
+    if (QFileInfo(path).isRelative() && !m_currentProjectPath.isEmpty()) {
+        path = QDir(m_currentProjectPath).absoluteFilePath(path);
+    }
+    
+    if (!QFileInfo::exists(path)) {
+        statusBar()->showMessage("Source file not found: " + filePath);
+        return;
+    }
+    
+    if (path != m_currentFilePath) {
+        openFileFromPath(path);
+    }
+    editor()->goToLine(line);
+}
+
+void MainWindow::editRunConfigurations()
+{
+    if (m_currentProjectPath.isEmpty()) {
+        QMessageBox::warning(this, "Run Configurations", "Please open a project folder first.");
+        return;
+    }
+    
+    RunConfigurationDialog dialog(m_runConfigurations->configurations(),
+                                  m_runConfigurations->buildDirectory(), this);
+    if (dialog.exec() == QDialog::Accepted) {
+        m_runConfigurations->setConfigurations(dialog.configurations());
+        statusBar()->showMessage("Run configurations saved");
+    }
+}
+
+void MainWindow::updateRunConfigurationCombo()
+{
+    m_runConfigCombo->clear();
+    
+    const QVector<RunConfiguration> configurations = m_runConfigurations->configurations();
+    if (configurations.isEmpty()) {
+        m_runConfigCombo->addItem(m_runConfigurations->activeConfiguration().name);
+        return;
+    }
+    
+    for (const RunConfiguration &config : configurations) {
+        m_runConfigCombo->addItem(config.name);
+    }
+    m_runConfigCombo->setCurrentText(m_runConfigurations->activeConfiguration().name);
+}
+
 void MainWindow::runDebug()
 {
-    // For now, just run normally - debug functionality can be added later
-    run();
+    // F5 continues an existing session rather than starting another
+    if (m_debugger->isActive()) {
+        m_debugger->continueExecution();
+        return;
+    }
+    
+    if (m_currentProjectPath.isEmpty()) {
+        QMessageBox::warning(this, "Debug", "Please open a project folder first.");
+        return;
+    }
+    
+    RunConfiguration config = m_runConfigurations->activeConfiguration();
+    QString executable = m_runConfigurations->resolveExecutable(config);
+    if (executable.isEmpty()) {
+        terminal()->appendText("No executable found. Please build the project first.\n\n");
+        statusBar()->showMessage("Debug failed - no executable found");
+        return;
+    }
+    
+    terminal()->appendText("=== Debugging Application ===\n");
+    terminal()->appendText("Executable: " + executable + "\n\n");
+    
+    if (m_debugger->start(executable, config.arguments, m_runConfigurations->workingDirectory(config),
+                          config.processEnvironment(), m_breakpoints)) {
+        m_debuggerDock->show();
+        m_debuggerDock->raise();
+    }
+}
+
+void MainWindow::onDebuggerStopped(const QString &file, int line, const QString &reason)
+{
+    statusBar()->showMessage(QString("Stopped: %1").arg(reason));
+    if (file.isEmpty()) {
+        return;
+    }
+    
+    m_executionFile = QFileInfo(file).canonicalFilePath();
+    m_executionLine = line;
+    openFileAtLine(file, line);
+    editor()->setExecutionLine(QFileInfo(m_currentFilePath).canonicalFilePath() == m_executionFile ? line : 0);
+}
+
+void MainWindow::onDebuggerExited(int exitCode)
+{
+    m_executionFile.clear();
+    m_executionLine = 0;
+    if (m_editor) {
+        m_editor->setExecutionLine(0);
+    }
+    terminal()->appendText(QString("Debugged application finished with exit code: %1\n").arg(exitCode));
+    statusBar()->showMessage("Debugging finished");
+}
+
+void MainWindow::onBreakpointToggled(int line, bool enabled)
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    QString path = QFileInfo(m_currentFilePath).canonicalFilePath();
+    if (enabled) {
+        m_breakpoints[path].insert(line);
+    } else {
+        m_breakpoints[path].remove(line);
+        if (m_breakpoints[path].isEmpty()) {
+            m_breakpoints.remove(path);
+        }
+    }
+    m_debugger->setBreakpoint(path, line, enabled);
 }
 
 void MainWindow::newProject()
@@ -454,9 +1107,10 @@ void MainWindow::newProject()
         if (m_projectManager->createProject(projectPath, projectName, projectType)) {
             // Open the created project properly
             m_currentProjectPath = projectPath;
+            showMainView();
+            m_fileModel->setRootPath(projectPath);
             m_fileTree->setRootIndex(m_fileModel->index(projectPath));
-            m_terminal->setCurrentDirectory(projectPath);
-            m_stackedWidget->setCurrentWidget(m_mainSplitter);
+            terminal()->setCurrentDirectory(projectPath);
             
             // Open the main source file in the editor
             QString mainFile;
@@ -476,15 +1130,15 @@ void MainWindow::newProject()
             setWindowTitle("QTCIDE - " + projectName);
             
             // Show welcome message in terminal
-            m_terminal->clear();
-            m_terminal->appendText("=== Project Created Successfully ===\n");
-            m_terminal->appendText("Project: " + projectName + "\n");
-            m_terminal->appendText("Type: " + projectType + "\n");
-            m_terminal->appendText("Location: " + projectPath + "\n\n");
-            m_terminal->appendText("To build this project:\n");
-            m_terminal->appendText("1. Use Build -> Configure (Ctrl+Shift+C)\n");
-            m_terminal->appendText("2. Use Build -> Build (Ctrl+B)\n");
-            m_terminal->appendText("3. Use Build -> Run (Ctrl+R)\n\n");
+            terminal()->clear();
+            terminal()->appendText("=== Project Created Successfully ===\n");
+            terminal()->appendText("Project: " + projectName + "\n");
+            terminal()->appendText("Type: " + projectType + "\n");
+            terminal()->appendText("Location: " + projectPath + "\n\n");
+            terminal()->appendText("To build this project:\n");
+            terminal()->appendText("1. Use Build -> Configure (Ctrl+Shift+C)\n");
+            terminal()->appendText("2. Use Build -> Build (Ctrl+B)\n");
+            terminal()->appendText("3. Use Build -> Run (Ctrl+R)\n\n");
         } else {
             QMessageBox::critical(this, "Error", "Failed to create project at: " + projectPath);
         }
@@ -495,9 +1149,7 @@ void MainWindow::openProject()
 {
     QString projectPath = QFileDialog::getExistingDirectory(this, "Open Project", QDir::homePath());
     if (!projectPath.isEmpty()) {
-        if (m_projectManager->openProject(projectPath)) {
-            openFolder();
-        } else {
+        if (!m_projectManager->openProject(projectPath)) {
             QMessageBox::warning(this, "Error", "Failed to open project: " + projectPath);
         }
     }
@@ -505,19 +1157,155 @@ void MainWindow::openProject()
 
 void MainWindow::focusTerminal()
 {
-    m_terminal->setFocus();
+    terminal()->setFocus();
+}
+
+void MainWindow::quickOpen()
+{
+    if (m_projectManager->currentProjectPath().isEmpty()) {
+        statusBar()->showMessage("Open a project to search its files", 3000);
+        return;
+    }
+    if (!m_quickOpen) {
+        m_quickOpen = new QuickOpenDialog(this);
+        connect(m_quickOpen, &QuickOpenDialog::fileSelected, this, &MainWindow::openFileFromPath);
+    }
+    if (m_quickOpenStale) {
+        m_quickOpen->setFiles(m_projectManager->projectFiles(), m_projectManager->currentProjectPath());
+        m_quickOpenStale = false;
+    }
+    m_quickOpen->popup();
+}
+
+void MainWindow::findInFiles()
+{
+    if (m_projectManager->currentProjectPath().isEmpty()) {
+        statusBar()->showMessage("Open a project to search its files", 3000);
+        return;
+    }
+    // A single-line selection in the editor is the most likely search term
+    QString selection;
+    if (m_editor) {
+        selection = m_editor->textCursor().selectedText();
+        if (selection.contains(QChar::ParagraphSeparator)) {
+            selection.clear();
+        }
+    }
+    m_findPanel->setRootPath(m_projectManager->currentProjectPath());
+    m_findDock->show();
+    m_findDock->raise();
+    m_findPanel->focusSearch(selection);
+}
+
+void MainWindow::replaceInFiles(const SearchOptions &options, const QString &replacement)
+{
+    if (m_replaceInFiles->isBusy()) {
+        statusBar()->showMessage("A replacement is already in progress");
+        return;
+    }
+    const QStringList files = m_projectManager->projectFiles();
+    m_replaceInFiles->prepare(files, options, replacement, m_trigramIndex->ruledOut(options, files));
+}
+
+void MainWindow::onReplacementsPrepared(const QVector<FileReplacement> &replacements)
+{
+    if (replacements.isEmpty()) {
+        statusBar()->showMessage("Nothing to replace");
+        return;
+    }
+
+    ReplacePreviewDialog dialog(replacements, m_projectManager->currentProjectPath(), this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    const QVector<FileReplacement> selected = dialog.selectedReplacements();
+    if (selected.isEmpty()) {
+        return;
+    }
+
+    // Unsaved edits in the open file would be overwritten by the reload afterwards
+    if (m_editor && m_editor->document()->isModified()) {
+        for (const FileReplacement &replacement : selected) {
+            if (replacement.filePath == m_currentFilePath) {
+                QMessageBox::warning(this, "Replace in Files",
+                                     "Save or revert your changes to " + QFileInfo(m_currentFilePath).fileName() + " first.");
+                return;
+            }
+        }
+    }
+
+    // Another replace or undo may have started while the preview was open; apply() would
+    // then do nothing and the batch would never be closed
+    if (m_replaceInFiles->isBusy()) {
+        statusBar()->showMessage("A replacement is already in progress");
+        return;
+    }
+    m_projectManager->beginBatchChanges();
+    m_replaceInFiles->apply(selected);
+    statusBar()->showMessage(QString("Replacing in %1 files...").arg(selected.size()));
+}
+
+void MainWindow::undoReplaceInFiles()
+{
+    if (!m_replaceInFiles->canUndo() || m_replaceInFiles->isBusy()) {
+        return;
+    }
+    if (m_editor && m_editor->document()->isModified()) {
+        QMessageBox::warning(this, "Undo Replace in Files", "Save or revert your changes to the open file first.");
+        return;
+    }
+    m_projectManager->beginBatchChanges();
+    m_replaceInFiles->undo();
+}
+
+void MainWindow::reloadIfOpen(const QStringList &files)
+{
+    if (m_currentFilePath.isEmpty() || !files.contains(m_currentFilePath)) {
+        return;
+    }
+    QString text;
+    TextFormat format;
+    if (TextFileCodec::load(m_currentFilePath, &text, &format)) {
+        reloadDocument(text, format);
+    }
+}
+
+void MainWindow::reloadDocument(const QString &text, const TextFormat &format)
+{
+    // Only the lines that differ are edited, in one undo step; the cursor, the scroll position
+    // and the highlighting of every other block stay as they are
+    InstrumentationScope scope("MainWindow::reloadDocument");
+    QTextDocument *document = editor()->document();
+    const QVector<TextReplacement> edits = TextDiff::lineEdits(editor()->toPlainText(), text);
+    if (!edits.isEmpty()) {
+        QTextCursor cursor(document);
+        cursor.beginEditBlock();
+        for (auto it = edits.crbegin(); it != edits.crend(); ++it) {
+            cursor.setPosition(it->position);
+            cursor.setPosition(it->position + it->length, QTextCursor::KeepAnchor);
+            cursor.insertText(it->text);
+        }
+        cursor.endEditBlock();
+    }
+    document->setModified(false);
+    m_currentFileFormat = format;
+    m_journal->attach(document, m_currentFilePath, text, true);
+    m_documentWatcher->watch(m_currentFilePath, text);
 }
 
 void MainWindow::onBuildFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    // Any build may have produced or replaced executables
+    m_runConfigurations->invalidateExecutableCache();
+    
     if (exitStatus == QProcess::CrashExit) {
-        m_terminal->appendText("Build process crashed\n");
+        terminal()->appendText("Build process crashed\n");
         statusBar()->showMessage("Build failed - process crashed");
     } else if (exitCode == 0) {
-        m_terminal->appendText("Build completed successfully\n\n");
+        terminal()->appendText("Build completed successfully\n\n");
         statusBar()->showMessage("Build successful");
     } else {
-        m_terminal->appendText(QString("Build failed with exit code: %1\n\n").arg(exitCode));
+        terminal()->appendText(QString("Build failed with exit code: %1\n\n").arg(exitCode));
         statusBar()->showMessage("Build failed");
     }
 }
@@ -525,22 +1313,29 @@ void MainWindow::onBuildFinished(int exitCode, QProcess::ExitStatus exitStatus)
 void MainWindow::onBuildOutput()
 {
     QByteArray data = m_buildProcess->readAllStandardOutput();
-    m_terminal->appendText(QString::fromLocal8Bit(data));
+    terminal()->appendText(QString::fromLocal8Bit(data));
 }
 
 void MainWindow::onBuildError()
 {
     QByteArray data = m_buildProcess->readAllStandardError();
-    m_terminal->appendText(QString::fromLocal8Bit(data));
+    terminal()->appendText(QString::fromLocal8Bit(data));
 }
 
 void MainWindow::onRunFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    if (m_restartPending) {
+        m_restartPending = false;
+        terminal()->appendText("Application stopped for restart\n\n");
+        startRunProcess();
+        return;
+    }
+    
     if (exitStatus == QProcess::CrashExit) {
-        m_terminal->appendText("Application crashed\n\n");
+        terminal()->appendText("Application crashed\n\n");
         statusBar()->showMessage("Application crashed");
     } else {
-        m_terminal->appendText(QString("Application finished with exit code: %1\n\n").arg(exitCode));
+        terminal()->appendText(QString("Application finished with exit code: %1\n\n").arg(exitCode));
         statusBar()->showMessage("Application finished");
     }
 }
@@ -548,21 +1343,39 @@ void MainWindow::onRunFinished(int exitCode, QProcess::ExitStatus exitStatus)
 void MainWindow::onRunOutput()
 {
     QByteArray data = m_runProcess->readAllStandardOutput();
-    m_terminal->appendText(QString::fromLocal8Bit(data));
+    terminal()->appendText(QString::fromLocal8Bit(data));
 }
 
 void MainWindow::onRunError()
 {
     QByteArray data = m_runProcess->readAllStandardError();
-    m_terminal->appendText(QString::fromLocal8Bit(data));
+    terminal()->appendText(QString::fromLocal8Bit(data));
 }
 
 void MainWindow::onProjectOpened(const QString &projectPath)
 {
     m_currentProjectPath = projectPath;
-    m_fileTree->setRootIndex(m_fileModel->index(projectPath));
-    m_terminal->setCurrentDirectory(projectPath);
-    m_stackedWidget->setCurrentWidget(m_mainSplitter);
+    m_session = ProjectSession::fromJson(m_projectManager->projectSetting("session").toObject());
+    if (m_restoringProject && !m_fileTree) {
+        // The file tree is rooted at the project when it is created
+        m_projectViewPending = true;
+    } else {
+        m_projectViewPending = false;
+        showMainView();
+        m_fileModel->setRootPath(projectPath);
+        m_fileTree->setRootIndex(m_fileModel->index(projectPath));
+        terminal()->setCurrentDirectory(projectPath);
+    }
+    
+    m_benchmarkHistory = BenchmarkHistory(projectPath);
+    m_benchmarkHistory.load();
+    m_benchmarkView->refresh();
+    
+    if (QSettings("QTCIDE", "Settings").value("trigramIndex", false).toBool()) {
+        m_trigramIndex->open(projectPath, m_projectManager->projectFiles());
+    }
+    
+    applySession();
     
     QString projectName = QFileInfo(projectPath).baseName();
     setWindowTitle("QTCIDE - " + projectName);
@@ -572,10 +1385,121 @@ void MainWindow::onProjectOpened(const QString &projectPath)
 void MainWindow::onProjectClosed()
 {
     m_currentProjectPath.clear();
+    m_projectViewPending = false;
+    m_session = ProjectSession();
+    m_trigramIndex->close();
+    m_benchmarkHistory = BenchmarkHistory();
+    m_benchmarkView->refresh();
     setWindowTitle("QTCIDE - Professional Qt IDE");
     statusBar()->showMessage("Project closed");
 }
 
+void MainWindow::restoreLastProject()
+{
+    QSettings settings("QTCIDE", "Settings");
+    const QString projectPath = settings.value("lastProject").toString();
+    if (settings.value("Editor/RestoreSession", true).toBool() && !projectPath.isEmpty() && QDir(projectPath).exists()) {
+        // The model and recent projects come back now; the widgets wait for a document
+        m_restoringProject = true;
+        m_projectManager->openProject(projectPath);
+        m_restoringProject = false;
+    }
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    saveSession();
+    QSettings("QTCIDE", "Settings").setValue("lastProject", m_currentProjectPath);
+    QMainWindow::closeEvent(event);
+}
+
+void MainWindow::saveSession()
+{
+    if (m_currentProjectPath.isEmpty()) {
+        return;
+    }
+    
+    rememberDocumentState();
+    if (m_stackedWidget->currentWidget() == m_mainSplitter) {
+        m_session.mainSplitterSizes = m_mainSplitter->sizes();
+        m_session.rightSplitterSizes = m_rightSplitter->sizes();
+    }
+    if (m_terminal) {
+        m_session.terminalDirectory = m_terminal->currentDirectory();
+    }
+    m_session.windowState = saveState();
+    m_projectManager->setProjectSetting("session", m_session.toJson());
+}
+
+void MainWindow::applySession()
+{
+    // The layout comes back at once; the active document is only read after the window has
+    // painted it, and the others when they are opened again
+    if (m_session.mainSplitterSizes.size() == m_mainSplitter->count()) {
+        m_mainSplitter->setSizes(m_session.mainSplitterSizes);
+    }
+    if (m_session.rightSplitterSizes.size() == m_rightSplitter->count()) {
+        m_rightSplitter->setSizes(m_session.rightSplitterSizes);
+    }
+    if (!m_session.windowState.isEmpty()) {
+        restoreState(m_session.windowState);
+    }
+    if (!m_session.terminalDirectory.isEmpty() && m_terminal) {
+        m_terminal->setCurrentDirectory(m_session.terminalDirectory);
+    }
+    
+    const QString activeFile = m_session.activeFile();
+    if (activeFile.isEmpty()) {
+        return;
+    }
+    const QString projectPath = m_currentProjectPath;
+    const QString filePath = QDir(projectPath).absoluteFilePath(activeFile);
+    QTimer::singleShot(0, this, [this, projectPath, filePath]() {
+        if (m_currentProjectPath == projectPath && m_currentFilePath != filePath && QFileInfo::exists(filePath)) {
+            openFileFromPath(filePath);
+        }
+    });
+}
+
+QString MainWindow::sessionPath(const QString &filePath) const
+{
+    // Only files inside the project are remembered, relative to it
+    if (m_currentProjectPath.isEmpty() || filePath.isEmpty()) {
+        return QString();
+    }
+    const QString relative = QDir(m_currentProjectPath).relativeFilePath(filePath);
+    return relative.startsWith("..") ? QString() : relative;
+}
+
+void MainWindow::rememberDocumentState()
+{
+    const QString path = sessionPath(m_currentFilePath);
+    if (path.isEmpty() || !m_editor) {
+        return;
+    }
+    DocumentViewState state;
+    state.filePath = path;
+    const QTextCursor cursor = m_editor->textCursor();
+    state.cursorPosition = cursor.position();
+    state.anchorPosition = cursor.anchor();
+    state.firstVisibleLine = m_editor->verticalScrollBar()->value();
+    m_session.remember(state);
+}
+
+void MainWindow::restoreDocumentState()
+{
+    const DocumentViewState *state = m_session.find(sessionPath(m_currentFilePath));
+    if (!state) {
+        return;
+    }
+    const int end = editor()->document()->characterCount() - 1;
+    QTextCursor cursor(editor()->document());
+    cursor.setPosition(qBound(0, state->anchorPosition, end));
+    cursor.setPosition(qBound(0, state->cursorPosition, end), QTextCursor::KeepAnchor);
+    editor()->setTextCursor(cursor);
+    editor()->verticalScrollBar()->setValue(state->firstVisibleLine);
+}
+
 void MainWindow::saveFile()
 {
     if (m_currentFilePath.isEmpty()) {
@@ -601,28 +1525,67 @@ void MainWindow::showWelcome()
 
 void MainWindow::openFileFromPath(const QString &filePath)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&file);
-        m_editor->setPlainText(in.readAll());
-        m_stackedWidget->setCurrentWidget(m_mainSplitter);
-        m_currentFilePath = filePath;
-        statusBar()->showMessage("File opened: " + filePath);
-        setWindowTitle("QTCIDE - " + QFileInfo(filePath).fileName());
+    InstrumentationScope scope("MainWindow::openFileFromPath");
+    QString text;
+    TextFormat format;
+    QString error;
+    if (!TextFileCodec::load(filePath, &text, &format, &error)) {
+        statusBar()->showMessage("Could not open " + filePath + ": " + error);
+        return;
     }
+    m_documentWatcher->watch(filePath, text);
+    
+    // Edits that a crash or an unsaved quit left in the journal are offered back
+    rememberDocumentState();
+    m_journal->detach();
+    bool savedOnDisk = true;
+    QString recovered;
+    const EditJournal::Recovery recovery = EditJournal::recover(filePath, text, &recovered);
+    if (recovery != EditJournal::NothingToRecover) {
+        QString question = QFileInfo(filePath).fileName() + " has unsaved changes from an earlier session. Recover them?";
+        if (recovery == EditJournal::BaseChanged) {
+            question = QFileInfo(filePath).fileName() + " has unsaved changes from an earlier session, but the file "
+                       "was changed on disk since they were made and applying them may garble it.\n\n"
+                       "Apply them anyway? Choosing No discards them.";
+        }
+        if (QMessageBox::question(this, "Recover Unsaved Changes", question) == QMessageBox::Yes) {
+            text = recovered;
+            savedOnDisk = false;
+        } else {
+            EditJournal::discard(filePath);
+        }
+    }
+    editor()->setPlainText(text);
+    editor()->document()->setModified(!savedOnDisk);
+    m_journal->attach(editor()->document(), filePath, text, savedOnDisk);
+    showMainView();
+    m_currentFilePath = filePath;
+    m_currentFileFormat = format;
+    restoreDocumentState();
+    
+    QString canonicalPath = QFileInfo(filePath).canonicalFilePath();
+    editor()->setBreakpoints(m_breakpoints.value(canonicalPath));
+    editor()->setExecutionLine(canonicalPath == m_executionFile ? m_executionLine : 0);
+    editor()->setLineMarks(GutterRenderer::SearchHit, m_searchHits.value(filePath));
+    statusBar()->showMessage("File opened: " + filePath + " (" + format.description() + ")");
+    setWindowTitle("QTCIDE - " + QFileInfo(filePath).fileName());
 }
 
 void MainWindow::saveFileToPath(const QString &filePath)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << m_editor->toPlainText();
-        statusBar()->showMessage("File saved: " + filePath);
-        setWindowTitle("QTCIDE - " + QFileInfo(filePath).fileName());
+    // Written back in the encoding and line ending style the file was loaded with; only the
+    // snapshot is taken here, FileSaver encodes and writes it
+    const QString text = editor()->toPlainText();
+    m_documentWatcher->setSuspended(true);
+    m_fileSaver->save(filePath, text, m_currentFileFormat);
+    if (m_journal->isAttached()) {
+        m_journal->markSaving(filePath, text);
     } else {
-        QMessageBox::warning(this, "Save Error", "Could not save file: " + filePath);
+        m_journal->attach(editor()->document(), filePath, text, true);
     }
+    editor()->document()->setModified(false);
+    statusBar()->showMessage("Saving " + filePath + "...");
+    setWindowTitle("QTCIDE - " + QFileInfo(filePath).fileName());
 }
 
 void MainWindow::showFileContextMenu(const QPoint &point)
@@ -686,7 +1649,7 @@ void MainWindow::showFileContextMenu(const QPoint &point)
     
     connect(openTerminalAction, &QAction::triggered, [this, selectedPath, isDirectory]() {
         QString targetPath = isDirectory ? selectedPath : QFileInfo(selectedPath).dir().absolutePath();
-        m_terminal->setCurrentDirectory(targetPath);
+        terminal()->setCurrentDirectory(targetPath);
         focusTerminal();
     });
     
@@ -835,13 +1798,13 @@ void MainWindow::showSettings()
     
     // Connect to settings changes for immediate application
     connect(&dialog, &SettingsDialog::settingsChanged, this, [this]() {
-        m_terminal->applyTerminalSettings();
-        statusBar()->showMessage("Terminal settings applied: " + m_terminal->getCurrentShellType());
+        terminal()->applyTerminalSettings();
+        statusBar()->showMessage("Terminal settings applied: " + terminal()->getCurrentShellType());
     });
     
     if (dialog.exec() == QDialog::Accepted) {
         // Apply settings one more time to ensure everything is updated
-        m_terminal->applyTerminalSettings();
-        statusBar()->showMessage("Settings updated and applied - using " + m_terminal->getCurrentShellType());
+        terminal()->applyTerminalSettings();
+        statusBar()->showMessage("Settings updated and applied - using " + terminal()->getCurrentShellType());
     }
 }
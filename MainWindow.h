@@ -11,18 +11,44 @@
 #include <QStatusBar>
 #include <QTextEdit>
 #include <QTreeView>
-#include <QFileSystemModel>
 #include <QProcess>
 #include <QLabel>
 #include <QPushButton>
 #include <QGraphicsDropShadowEffect>
 #include <QInputDialog>
 #include <QClipboard>
+#include <QComboBox>
+#include <QDockWidget>
+#include <QHash>
+#include <QSet>
+#include "BenchmarkHistory.h"
+#include "TextFileCodec.h"
+#include "ProjectSession.h"
 
 class WelcomeScreen;
 class Terminal;
 class CodeEditor;
 class ProjectManager;
+class RunConfigurationManager;
+class Profiler;
+class ProfilerView;
+class HeapProfiler;
+class HeapProfilerView;
+class DebuggerSession;
+class DebuggerPanel;
+class BenchmarkView;
+class InstrumentationView;
+class ProjectFileModel;
+class QuickOpenDialog;
+class FindInFiles;
+class FindInFilesPanel;
+class ReplaceInFiles;
+class TrigramIndex;
+class FileSaver;
+class EditJournal;
+class DocumentWatcher;
+struct SearchOptions;
+struct FileReplacement;
 
 class MainWindow : public QMainWindow
 {
@@ -35,6 +61,9 @@ public:
     void openFolder(); // Make this public so WelcomeScreen can access it
     void newProject(); // Make this public so WelcomeScreen can access it
 
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private slots:
     void newFile();
     void openFile();
@@ -45,13 +74,31 @@ private slots:
     void rebuild();
     void clean();
     void run();
+    void restartRun();
+    void stopRun();
     void runDebug();
+    void onDebuggerStopped(const QString &file, int line, const QString &reason);
+    void onDebuggerExited(int exitCode);
+    void onBreakpointToggled(int line, bool enabled);
+    void editRunConfigurations();
+    void runWithProfiler();
+    void onProfileReady();
+    void runWithHeapProfiler();
+    void onHeapProfileReady();
+    void runBenchmarks();
+    void onBenchmarkFinished(const BenchmarkRun &run);
+    void openFileAtLine(const QString &filePath, int line);
     void showWelcome();
     void openFileFromPath(const QString &filePath);
     void openProject();
     void focusTerminal();
+    void quickOpen();
+    void findInFiles();
+    void undoReplaceInFiles();
     void onProjectOpened(const QString &projectPath);
     void onProjectClosed();
+    void restoreLastProject();
+    void saveSession();
     void onBuildFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onBuildOutput();
     void onBuildError();
@@ -67,6 +114,23 @@ private:
     void setupToolBar();
     void setupStatusBar();
     void applyGlassmorphicStyle();
+    // Heavy widgets are built on first use to keep startup short
+    CodeEditor *editor();
+    Terminal *terminal();
+    void ensureFileTree();
+    void showMainView();
+    void reloadIfOpen(const QStringList &files);
+    void reloadDocument(const QString &text, const TextFormat &format);
+    void applySession();
+    QString sessionPath(const QString &filePath) const;
+    void rememberDocumentState();
+    void restoreDocumentState();
+    // Plain members rather than slots, so this header can forward declare the search types
+    void replaceInFiles(const SearchOptions &options, const QString &replacement);
+    void onReplacementsPrepared(const QVector<FileReplacement> &replacements);
+    void startBuild();
+    void startRunProcess();
+    void updateRunConfigurationCombo();
     
     QWidget *m_centralWidget;
     QStackedWidget *m_stackedWidget;
@@ -79,20 +143,74 @@ private:
     
     // File explorer
     QTreeView *m_fileTree;
-    QFileSystemModel *m_fileModel;
+    ProjectFileModel *m_fileModel;
     
     // Terminal
     Terminal *m_terminal;
     
+    // Quick open; the file list is handed over again only after the project changed
+    QuickOpenDialog *m_quickOpen;
+    bool m_quickOpenStale;
+    
+    // Project-wide content search
+    FindInFiles *m_findInFiles;
+    FindInFilesPanel *m_findPanel;
+    QDockWidget *m_findDock;
+    ReplaceInFiles *m_replaceInFiles;
+    QAction *m_undoReplaceAction;
+    TrigramIndex *m_trigramIndex;   // optional, see Tools > Index Project Contents
+    QHash<QString, QHash<int, quint16>> m_searchHits;   // matched lines per file, for the overview ruler
+    
+    // Saves run on a worker thread; a build waits for them without blocking the GUI
+    FileSaver *m_fileSaver;
+    bool m_buildAfterSave;
+    EditJournal *m_journal;   // unsaved edits of the open document, for crash recovery
+    DocumentWatcher *m_documentWatcher;
+    
     // Build and run processes
     QProcess *m_buildProcess;
     QProcess *m_runProcess;
+    bool m_restartPending;
     
     // Project management
     ProjectManager *m_projectManager;
+    RunConfigurationManager *m_runConfigurations;
+    QComboBox *m_runConfigCombo;
+    
+    // Profiling
+    Profiler *m_profiler;
+    ProfilerView *m_profilerView;
+    QDockWidget *m_profilerDock;
+    HeapProfiler *m_heapProfiler;
+    HeapProfilerView *m_heapProfilerView;
+    QDockWidget *m_heapProfilerDock;
+    
+    // Benchmarks; the history is reloaded per project
+    BenchmarkRunner *m_benchmarkRunner;
+    BenchmarkHistory m_benchmarkHistory;
+    BenchmarkView *m_benchmarkView;
+    QDockWidget *m_benchmarkDock;
+    
+    // Hot path timings and event loop stalls of the IDE itself
+    InstrumentationView *m_instrumentationView;
+    QDockWidget *m_instrumentationDock;
+    
+    // Debugging; breakpoints are kept per canonical file path
+    DebuggerSession *m_debugger;
+    DebuggerPanel *m_debuggerPanel;
+    QDockWidget *m_debuggerDock;
+    QHash<QString, QSet<int>> m_breakpoints;
+    QString m_executionFile;
+    int m_executionLine;
     
     QString m_currentProjectPath;
     QString m_currentFilePath;
+    ProjectSession m_session;   // view state per document, written to .qtcide_project
+    TextFormat m_currentFileFormat;   // encoding and line endings to save the file with
+    // The project reopened at startup gets its tree, editor and terminal only once a document
+    // is shown; showMainView applies what onProjectOpened left for it
+    bool m_restoringProject;
+    bool m_projectViewPending;
 
     void saveFileToPath(const QString &filePath);
     void createNewFile(const QString &basePath);
@@ -0,0 +1,321 @@
+#include "Minimap.h"
+#include "GutterRenderer.h"
+#include "Instrumentation.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const QColor kBackground(30, 30, 30, 200);
+const QColor kRulerBackground(40, 40, 40, 180);
+const QColor kTextColor(200, 200, 200);   // text the highlighter left unformatted
+const QColor kSliderColor(255, 255, 255, 30);
+constexpr int kTextAlpha = 170;
+
+QRgb minimapPixel(const QColor &color)
+{
+    return qPremultiply(qRgba(color.red(), color.green(), color.blue(), kTextAlpha));
+}
+
+QColor rulerColor(quint16 marks)
+{
+    if (marks & GutterRenderer::DiagnosticError) {
+        return QColor(240, 70, 70);
+    }
+    if (marks & GutterRenderer::DiagnosticWarning) {
+        return QColor(230, 190, 40);
+    }
+    if (marks & GutterRenderer::SearchHit) {
+        return QColor(255, 140, 0);
+    }
+    if (marks & GutterRenderer::LineAdded) {
+        return QColor(80, 180, 80);
+    }
+    if (marks & GutterRenderer::LineModified) {
+        return QColor(80, 140, 220);
+    }
+    return QColor(220, 70, 70);   // lines removed
+}
+
+} // namespace
+
+Minimap::Minimap(QPlainTextEdit *editor)
+    : QWidget(editor)
+    , m_editor(editor)
+    , m_blockCount(editor->document()->blockCount())
+    , m_imageValid(false)
+    , m_imageStart(0)
+    , m_rows(0)
+    , m_linePixels(kLineHeight)
+    , m_charPixels(1)
+    , m_dirtyFirst(INT_MAX)
+    , m_dirtyLast(-1)
+    , m_rulerValid(false)
+{
+    setCursor(Qt::PointingHandCursor);
+    connect(editor->document(), &QTextDocument::contentsChange, this, &Minimap::onContentsChange);
+    connect(editor->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() { update(); });
+    connect(editor->verticalScrollBar(), &QScrollBar::rangeChanged, this, [this]() { update(); });
+}
+
+void Minimap::setMarks(const QHash<int, quint16> &marks)
+{
+    m_marks = marks;
+    m_rulerValid = false;
+    update(kMapWidth, 0, kRulerWidth, height());
+}
+
+void Minimap::blockChanged(int blockNumber)
+{
+    m_dirtyFirst = qMin(m_dirtyFirst, blockNumber);
+    m_dirtyLast = qMax(m_dirtyLast, blockNumber);
+    update();
+}
+
+void Minimap::onContentsChange(int position, int /* charsRemoved */, int charsAdded)
+{
+    // Only the edited blocks are rendered again, unless lines were added or removed and
+    // everything below moved; blocks the highlighter reformats later come through blockChanged
+    QTextDocument *document = m_editor->document();
+    const int first = qMax(0, document->findBlock(position).blockNumber());
+    const QTextBlock lastBlock = document->findBlock(position + charsAdded);
+    int last = lastBlock.isValid() ? lastBlock.blockNumber() : document->blockCount() - 1;
+    if (document->blockCount() != m_blockCount) {
+        m_blockCount = document->blockCount();
+        last = INT_MAX;
+        m_rulerValid = false;
+    }
+    m_dirtyFirst = qMin(m_dirtyFirst, first);
+    m_dirtyLast = qMax(m_dirtyLast, last);
+    update();
+}
+
+int Minimap::firstVisibleLine() const
+{
+    // QPlainTextEdit scrolls by layout lines, which are not blocks once lines wrap
+    const QTextBlock block = m_editor->document()->findBlockByLineNumber(m_editor->verticalScrollBar()->value());
+    return block.isValid() ? block.blockNumber() : 0;
+}
+
+int Minimap::visibleLineCount() const
+{
+    return qMax(1, m_editor->viewport()->height() / m_editor->fontMetrics().lineSpacing());
+}
+
+int Minimap::windowStart(int rows) const
+{
+    // The whole document when it fits; otherwise the window moves in proportion to the
+    // editor's scroll position, so both reach the end of the document together
+    const int total = m_editor->document()->blockCount();
+    if (total <= rows) {
+        return 0;
+    }
+    const int scrollable = qMax(1, total - visibleLineCount());
+    return int(qint64(qMin(firstVisibleLine(), scrollable)) * (total - rows) / scrollable);
+}
+
+void Minimap::prepareImage()
+{
+    const qreal ratio = devicePixelRatioF();
+    const QSize size = (QSizeF(kMapWidth, height()) * ratio).toSize();
+    if (m_image.size() == size && m_image.devicePixelRatio() == ratio) {
+        return;
+    }
+    m_image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    m_image.setDevicePixelRatio(ratio);
+    m_linePixels = qMax(1, qRound(kLineHeight * ratio));
+    m_charPixels = qMax(1, qRound(ratio));
+    m_rows = m_image.isNull() ? 0 : size.height() / m_linePixels;
+    m_imageValid = false;
+}
+
+void Minimap::scrollImage(int start)
+{
+    const int delta = start - m_imageStart;
+    m_imageStart = start;
+    if (!m_imageValid || qAbs(delta) >= m_rows) {
+        m_image.fill(Qt::transparent);
+        m_imageValid = true;
+        renderLines(start, start + m_rows - 1);
+        return;
+    }
+    if (delta == 0) {
+        return;
+    }
+
+    // Rows still on screen move; only the lines that scrolled in are rendered
+    const qsizetype lineBytes = qsizetype(m_image.bytesPerLine()) * m_linePixels;
+    const qsizetype keptBytes = lineBytes * (m_rows - qAbs(delta));
+    uchar *bits = m_image.bits();
+    if (delta > 0) {
+        std::memmove(bits, bits + lineBytes * delta, keptBytes);
+        renderLines(start + m_rows - delta, start + m_rows - 1);
+    } else {
+        std::memmove(bits + lineBytes * -delta, bits, keptBytes);
+        renderLines(start, start - delta - 1);
+    }
+}
+
+void Minimap::renderLines(int first, int last)
+{
+    first = qMax(first, m_imageStart);
+    last = qMin(last, m_imageStart + m_rows - 1);
+    if (first > last) {
+        return;
+    }
+
+    QTextBlock block = m_editor->document()->findBlockByNumber(first);
+    for (int line = first; line <= last; ++line) {
+        const int row = line - m_imageStart;
+        for (int y = 0; y < m_linePixels; ++y) {
+            std::memset(m_image.scanLine(row * m_linePixels + y), 0, m_image.bytesPerLine());
+        }
+        if (block.isValid()) {
+            renderBlock(block, row);
+            block = block.next();
+        }
+    }
+}
+
+void Minimap::renderBlock(const QTextBlock &block, int row)
+{
+    const QString text = block.text();
+    const QList<QTextLayout::FormatRange> formats = block.layout()->formats();
+    const int columns = m_image.width() / m_charPixels;
+    const int textPixels = qMax(1, m_linePixels - m_linePixels / 2);   // the rest separates lines
+    const QRgb plain = minimapPixel(kTextColor);
+
+    // The highlighter's ranges are ordered and do not overlap
+    int range = 0;
+    int colorRange = -1;
+    QRgb rangeColor = plain;
+    int column = 0;
+    for (int i = 0; i < text.size() && column < columns; ++i) {
+        const QChar c = text.at(i);
+        if (c == u'\t') {
+            column = (column / kTabWidth + 1) * kTabWidth;
+            continue;
+        }
+        if (c.isSpace()) {
+            ++column;
+            continue;
+        }
+
+        while (range < formats.size() && formats.at(range).start + formats.at(range).length <= i) {
+            ++range;
+        }
+        QRgb pixel = plain;
+        if (range < formats.size() && formats.at(range).start <= i) {
+            if (colorRange != range) {
+                const QTextCharFormat &format = formats.at(range).format;
+                rangeColor = format.hasProperty(QTextFormat::ForegroundBrush)
+                                 ? minimapPixel(format.foreground().color()) : plain;
+                colorRange = range;
+            }
+            pixel = rangeColor;
+        }
+
+        for (int y = 0; y < textPixels; ++y) {
+            QRgb *out = reinterpret_cast<QRgb *>(m_image.scanLine(row * m_linePixels + y)) + column * m_charPixels;
+            for (int x = 0; x < m_charPixels; ++x) {
+                out[x] = pixel;
+            }
+        }
+        ++column;
+    }
+}
+
+void Minimap::paintEvent(QPaintEvent *event)
+{
+    InstrumentationScope scope("Minimap::paintEvent");
+    QPainter painter(this);
+    painter.fillRect(event->rect(), kBackground);
+
+    prepareImage();
+    if (m_rows > 0) {
+        const bool wasValid = m_imageValid;
+        scrollImage(windowStart(m_rows));
+        if (wasValid && m_dirtyFirst <= m_dirtyLast) {
+            renderLines(m_dirtyFirst, m_dirtyLast);
+        }
+        painter.drawImage(0, 0, m_image);
+
+        const qreal rowHeight = m_linePixels / devicePixelRatioF();
+        painter.fillRect(QRectF(0, (firstVisibleLine() - m_imageStart) * rowHeight,
+                                kMapWidth, visibleLineCount() * rowHeight), kSliderColor);
+    }
+    m_dirtyFirst = INT_MAX;
+    m_dirtyLast = -1;
+
+    paintRuler(&painter);
+}
+
+void Minimap::paintRuler(QPainter *painter)
+{
+    // Marks are merged per pixel row when they change, so painting does not depend on how many
+    // there are
+    const int rulerHeight = height();
+    const int total = qMax(1, m_editor->document()->blockCount());
+    if (!m_rulerValid || m_rulerRows.size() != rulerHeight) {
+        m_rulerRows.fill(0, rulerHeight);
+        for (auto it = m_marks.cbegin(); it != m_marks.cend(); ++it) {
+            const int y = int(qint64(it.key() - 1) * rulerHeight / total);
+            if (y >= 0 && y < rulerHeight) {
+                m_rulerRows[y] |= it.value();
+            }
+        }
+        m_rulerValid = true;
+    }
+
+    painter->fillRect(QRect(kMapWidth, 0, kRulerWidth, rulerHeight), kRulerBackground);
+    const int visibleTop = int(qint64(firstVisibleLine()) * rulerHeight / total);
+    const int visibleHeight = qMax(2, int(qint64(visibleLineCount()) * rulerHeight / total));
+    painter->fillRect(QRect(kMapWidth, visibleTop, kRulerWidth, visibleHeight), kSliderColor);
+
+    for (int y = 0; y < rulerHeight; ++y) {
+        const quint16 marks = m_rulerRows.at(y);
+        if (marks) {
+            painter->fillRect(QRect(kMapWidth + 2, y, kRulerWidth - 4, 2), rulerColor(marks));
+        }
+    }
+}
+
+void Minimap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        scrollEditorTo(event->position().toPoint(), false);
+    }
+}
+
+void Minimap::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        scrollEditorTo(event->position().toPoint(), true);
+    }
+}
+
+void Minimap::scrollEditorTo(const QPoint &pos, bool dragging)
+{
+    // A click on the map centres the line under the mouse. Dragging, and the ruler, move
+    // through the whole document in proportion, so the window does not shift under the mouse
+    QTextDocument *document = m_editor->document();
+    const int total = document->blockCount();
+    const int visible = visibleLineCount();
+    int first;
+    if (!dragging && pos.x() < kMapWidth) {
+        const qreal rowHeight = m_linePixels / devicePixelRatioF();
+        first = m_imageStart + int(pos.y() / rowHeight) - visible / 2;
+    } else {
+        const int y = qBound(0, pos.y(), height());
+        first = int(qint64(y) * total / qMax(1, height())) - visible / 2;
+    }
+    first = qBound(0, first, qMax(0, total - 1));
+    m_editor->verticalScrollBar()->setValue(document->findBlockByNumber(first).firstLineNumber());
+}
@@ -0,0 +1,72 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QWidget>
+#include <QImage>
+#include <QHash>
+#include <QVector>
+
+class QPainter;
+class QPlainTextEdit;
+class QTextBlock;
+
+// Strip to the right of the editor: a downsampled rendering of the lines around the viewport,
+// one pixel per character in the highlighter's colors, and an overview ruler with the marks of
+// the whole document. The rendering is cached in an image covering exactly the lines on screen;
+// scrolling moves its rows and renders only the lines that came into view, and an edit or a
+// rehighlight renders only the blocks it touched. The owner forwards the highlighter's
+// per-block notifications to blockChanged().
+class Minimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kMapWidth = 96;
+    static constexpr int kRulerWidth = 10;
+    static constexpr int kWidth = kMapWidth + kRulerWidth;
+
+    explicit Minimap(QPlainTextEdit *editor);
+
+    // GutterRenderer::Mark bits per 1-based line, shown on the overview ruler
+    void setMarks(const QHash<int, quint16> &marks);
+    // The highlighter formatted the block again; contentsChange misses the blocks it cascades to
+    void blockChanged(int blockNumber);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    static constexpr int kLineHeight = 2;   // logical pixels per line
+    static constexpr int kTabWidth = 4;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    int firstVisibleLine() const;
+    int visibleLineCount() const;
+    int windowStart(int rows) const;
+    void prepareImage();
+    void scrollImage(int start);
+    void renderLines(int first, int last);   // block numbers, clipped to the image
+    void renderBlock(const QTextBlock &block, int row);
+    void scrollEditorTo(const QPoint &pos, bool dragging);
+    void paintRuler(QPainter *painter);
+
+    QPlainTextEdit *m_editor;
+    int m_blockCount;
+
+    QImage m_image;
+    bool m_imageValid;
+    int m_imageStart;    // block shown in the image's first row
+    int m_rows;          // lines the image holds
+    int m_linePixels;    // device pixels per line and per character
+    int m_charPixels;
+    int m_dirtyFirst;    // blocks to render again, m_dirtyFirst > m_dirtyLast when none
+    int m_dirtyLast;
+
+    QHash<int, quint16> m_marks;
+    QVector<quint16> m_rulerRows;   // marks merged per ruler pixel row
+    bool m_rulerValid;
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,517 @@
+#include "Profiler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QStandardPaths>
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <sys/user.h>
+#include <sys/uio.h>
+#include <elf.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+void ProfileData::addStack(const QVector<ProfileFrame> &leafFirst, quint64 count)
+{
+    if (leafFirst.isEmpty()) {
+        return;
+    }
+
+    totalSamples += count;
+    root.totalSamples += count;
+
+    // Walk root to leaf, merging into the call tree used by the flame graph
+    ProfileNode *node = &root;
+    QSet<QString> counted;
+    for (int i = leafFirst.size() - 1; i >= 0; --i) {
+        const ProfileFrame &frame = leafFirst.at(i);
+
+        ProfileNode *child = nullptr;
+        for (ProfileNode &candidate : node->children) {
+            if (candidate.frame.function == frame.function) {
+                child = &candidate;
+                break;
+            }
+        }
+        if (!child) {
+            node->children.push_back(ProfileNode());
+            child = &node->children.back();
+            child->frame = frame;
+        }
+        child->totalSamples += count;
+        node = child;
+
+        // Recursive functions only count once towards their inclusive total
+        HotFunction &hot = functions[frame.function];
+        if (hot.frame.function.isEmpty() || (hot.frame.file.isEmpty() && !frame.file.isEmpty())) {
+            hot.frame = frame;
+        }
+        if (!counted.contains(frame.function)) {
+            counted.insert(frame.function);
+            hot.totalSamples += count;
+        }
+    }
+
+    node->selfSamples += count;
+    functions[leafFirst.first().function].selfSamples += count;
+}
+
+void ProfileData::clear()
+{
+    root = ProfileNode();
+    root.frame.function = "all";
+    functions.clear();
+    totalSamples = 0;
+}
+
+#ifdef Q_OS_LINUX
+namespace {
+
+bool readRegisters(pid_t pid, quint64 *pc, quint64 *fp, quint64 *lr)
+{
+#if defined(__x86_64__)
+    struct user_regs_struct regs;
+    if (ptrace(PTRACE_GETREGS, pid, nullptr, &regs) != 0) {
+        return false;
+    }
+    *pc = regs.rip;
+    *fp = regs.rbp;
+    *lr = 0;
+    return true;
+#elif defined(__aarch64__)
+    struct user_pt_regs regs;
+    struct iovec iov = { &regs, sizeof(regs) };
+    if (ptrace(PTRACE_GETREGSET, pid, reinterpret_cast<void *>(NT_PRSTATUS), &iov) != 0) {
+        return false;
+    }
+    *pc = regs.pc;
+    *fp = regs.regs[29];
+    *lr = regs.regs[30];
+    return true;
+#else
+    Q_UNUSED(pid)
+    Q_UNUSED(pc)
+    Q_UNUSED(fp)
+    Q_UNUSED(lr)
+    return false;
+#endif
+}
+
+bool peekWord(pid_t pid, quint64 address, quint64 *value)
+{
+    errno = 0;
+    long word = ptrace(PTRACE_PEEKDATA, pid, reinterpret_cast<void *>(address), nullptr);
+    if (errno != 0) {
+        return false;
+    }
+    *value = static_cast<quint64>(word);
+    return true;
+}
+
+// Frame-pointer unwinding; targets built without frame pointers yield shallow stacks
+QVector<quint64> walkStack(pid_t pid)
+{
+    QVector<quint64> stack;
+    quint64 pc = 0, fp = 0, lr = 0;
+    if (!readRegisters(pid, &pc, &fp, &lr)) {
+        return stack;
+    }
+
+    stack << pc;
+    if (lr) {
+        stack << lr;
+    }
+
+    for (int depth = 0; depth < 128 && fp != 0; ++depth) {
+        quint64 next = 0, ret = 0;
+        if (!peekWord(pid, fp, &next) || !peekWord(pid, fp + 8, &ret) || ret == 0) {
+            break;
+        }
+        if (ret != lr) {
+            stack << ret;
+        }
+        lr = 0;
+        if (next <= fp) {
+            break;
+        }
+        fp = next;
+    }
+    return stack;
+}
+
+} // namespace
+
+PtraceSampler::PtraceSampler(qint64 pid, int intervalUs, QObject *parent)
+    : QThread(parent)
+    , m_pid(pid)
+    , m_intervalUs(intervalUs)
+    , m_stopRequested(false)
+{
+}
+
+QVector<QVector<quint64>> PtraceSampler::takeStacks()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<QVector<quint64>> stacks;
+    stacks.swap(m_stacks);
+    return stacks;
+}
+
+QByteArray PtraceSampler::memoryMaps()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maps;
+}
+
+void PtraceSampler::run()
+{
+    // ptrace requests must come from the thread that attached, so all tracing stays here
+    const pid_t pid = static_cast<pid_t>(m_pid);
+    if (ptrace(PTRACE_SEIZE, pid, nullptr, nullptr) != 0) {
+        return;
+    }
+
+    int sampleCount = 0;
+    bool alive = true;
+    while (!m_stopRequested && alive) {
+        usleep(static_cast<useconds_t>(m_intervalUs));
+
+        if (ptrace(PTRACE_INTERRUPT, pid, nullptr, nullptr) != 0) {
+            break;
+        }
+
+        // Peek without reaping so QProcess still observes the exit status
+        siginfo_t info = {};
+        if (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WSTOPPED | WNOWAIT | __WALL) != 0) {
+            break;
+        }
+        if (info.si_code == CLD_EXITED || info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED) {
+            alive = false;
+            break;
+        }
+
+        int status = 0;
+        if (waitpid(pid, &status, __WALL) != pid || !WIFSTOPPED(status)) {
+            break;
+        }
+
+        QVector<quint64> stack = walkStack(pid);
+
+        // Re-read the mappings while the loader is still pulling in shared libraries
+        QByteArray maps;
+        if (sampleCount == 0 || sampleCount == 16 || sampleCount % 1024 == 0) {
+            QFile mapsFile(QString("/proc/%1/maps").arg(m_pid));
+            if (mapsFile.open(QIODevice::ReadOnly)) {
+                maps = mapsFile.readAll();
+            }
+        }
+        ++sampleCount;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!stack.isEmpty()) {
+                m_stacks << stack;
+            }
+            if (!maps.isEmpty()) {
+                m_maps = maps;
+            }
+        }
+
+        // Re-inject real signals; interrupt stops resume without one
+        int signal = (status >> 16) == PTRACE_EVENT_STOP ? 0 : WSTOPSIG(status);
+        if (ptrace(PTRACE_CONT, pid, nullptr, reinterpret_cast<void *>(static_cast<quintptr>(signal))) != 0) {
+            break;
+        }
+    }
+
+    if (alive) {
+        ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+    }
+}
+#endif
+
+Profiler::Profiler(QObject *parent)
+    : QObject(parent)
+    , m_target(new QProcess(this))
+    , m_script(new QProcess(this))
+    , m_backend(Perf)
+    , m_tempDir(nullptr)
+    , m_exitCode(0)
+    , m_symbolizeThread(nullptr)
+#ifdef Q_OS_LINUX
+    , m_sampler(nullptr)
+#endif
+{
+    m_data.clear();
+
+    connect(m_target, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &Profiler::onTargetFinished);
+    connect(m_target, &QProcess::readyReadStandardOutput, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_target->readAllStandardOutput()));
+    });
+    connect(m_target, &QProcess::readyReadStandardError, this, [this]() {
+        emit output(QString::fromLocal8Bit(m_target->readAllStandardError()));
+    });
+    connect(m_script, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &Profiler::onScriptFinished);
+}
+
+Profiler::~Profiler()
+{
+    stop();
+#ifdef Q_OS_LINUX
+    if (m_sampler) {
+        m_sampler->stop();
+        m_sampler->wait();
+    }
+#endif
+    if (m_symbolizeThread) {
+        m_symbolizeThread->wait();
+        delete m_symbolizeThread;
+    }
+    delete m_tempDir;
+}
+
+bool Profiler::isPerfAvailable()
+{
+    static const bool available = []() {
+        if (QStandardPaths::findExecutable("perf").isEmpty()) {
+            return false;
+        }
+#ifdef Q_OS_LINUX
+        // Level 3 (Debian/Ubuntu kernels) forbids unprivileged perf_event_open entirely
+        QFile paranoid("/proc/sys/kernel/perf_event_paranoid");
+        if (paranoid.open(QIODevice::ReadOnly) && paranoid.readAll().trimmed().toInt() > 2) {
+            return false;
+        }
+#endif
+        return true;
+    }();
+    return available;
+}
+
+bool Profiler::start(const QString &executable, const QStringList &arguments,
+                     const QString &workingDirectory, const QProcessEnvironment &environment)
+{
+    if (isRunning()) {
+        return false;
+    }
+
+    m_data.clear();
+    m_exitCode = 0;
+    delete m_tempDir;
+    m_tempDir = new QTemporaryDir;
+
+    m_target->setWorkingDirectory(workingDirectory);
+    m_target->setProcessEnvironment(environment);
+
+    if (isPerfAvailable()) {
+        m_backend = Perf;
+        QStringList args;
+        args << "record" << "-F" << "999" << "-g"
+             << "-o" << m_tempDir->filePath("perf.data")
+             << "--" << executable;
+        args << arguments;
+        m_target->start("perf", args);
+    } else {
+#ifdef Q_OS_LINUX
+        m_backend = BuiltinSampler;
+        m_target->start(executable, arguments);
+#else
+        emit errorOccurred("perf is not available and the built-in sampler requires Linux");
+        return false;
+#endif
+    }
+
+    if (!m_target->waitForStarted()) {
+        emit errorOccurred("Could not start " + (m_backend == Perf ? QString("perf") : executable));
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    if (m_backend == BuiltinSampler) {
+        m_sampler = new PtraceSampler(m_target->processId(), 1000, this);
+        m_sampler->start();
+    }
+#endif
+    return true;
+}
+
+void Profiler::stop()
+{
+    if (m_target->state() != QProcess::NotRunning) {
+        // SIGINT lets perf record flush perf.data before exiting
+        if (m_backend == Perf) {
+#ifdef Q_OS_LINUX
+            ::kill(pid_t(m_target->processId()), SIGINT);
+#else
+            m_target->terminate();
+#endif
+        } else {
+            m_target->kill();
+        }
+    }
+}
+
+bool Profiler::isRunning() const
+{
+    return m_target->state() != QProcess::NotRunning || m_script->state() != QProcess::NotRunning
+        || m_symbolizeThread;
+}
+
+void Profiler::onTargetFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_exitCode = exitStatus == QProcess::CrashExit ? -1 : exitCode;
+
+#ifdef Q_OS_LINUX
+    if (m_sampler) {
+        m_sampler->stop();
+        m_sampler->wait();
+        const QByteArray maps = m_sampler->memoryMaps();
+        const QVector<QVector<quint64>> stacks = m_sampler->takeStacks();
+        delete m_sampler;
+        m_sampler = nullptr;
+
+        emit finished(m_exitCode);
+        emit output("Resolving symbols...\n");
+        symbolizeSamples(maps, stacks);
+        return;
+    }
+#endif
+
+    emit finished(m_exitCode);
+
+    QString perfData = m_tempDir->filePath("perf.data");
+    if (!QFileInfo::exists(perfData)) {
+        emit errorOccurred("perf did not record any samples");
+        return;
+    }
+
+    emit output("Processing profile samples...\n");
+    m_script->start("perf", QStringList() << "script" << "-i" << perfData
+                                          << "-F" << "comm,ip,sym,dso,srcline");
+}
+
+void Profiler::onScriptFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (exitStatus == QProcess::CrashExit || exitCode != 0) {
+        emit errorOccurred(QString::fromLocal8Bit(m_script->readAllStandardError()));
+        return;
+    }
+
+    parsePerfScript(m_script->readAllStandardOutput());
+    emit profileReady();
+}
+
+void Profiler::parsePerfScript(const QByteArray &script)
+{
+    // Each sample is a header line followed by indented "ip symbol+off (dso)" frames,
+    // each optionally followed by an indented "file:line" source line
+    QVector<ProfileFrame> stack;
+    const QList<QByteArray> lines = script.split('\n');
+
+    for (const QByteArray &rawLine : lines) {
+        QByteArray line = rawLine.trimmed();
+        bool isHeader = !rawLine.isEmpty() && rawLine.at(0) != ' ' && rawLine.at(0) != '\t';
+
+        if (line.isEmpty() || isHeader) {
+            m_data.addStack(stack);
+            stack.clear();
+            continue;
+        }
+
+        int space = line.indexOf(' ');
+        bool isFrame = false;
+        if (space > 0) {
+            line.left(space).toULongLong(&isFrame, 16);
+        }
+
+        if (isFrame) {
+            QByteArray symbol = line.mid(space + 1).trimmed();
+            QByteArray module;
+
+            int dsoStart = symbol.lastIndexOf(" (");
+            if (dsoStart >= 0 && symbol.endsWith(')')) {
+                module = symbol.mid(dsoStart + 2, symbol.size() - dsoStart - 3);
+                symbol.truncate(dsoStart);
+            }
+            int offset = symbol.lastIndexOf("+0x");
+            if (offset > 0) {
+                symbol.truncate(offset);
+            }
+            if (symbol.isEmpty() || symbol == "[unknown]") {
+                symbol = "[" + QFileInfo(QString::fromUtf8(module)).fileName().toUtf8() + "]";
+            }
+
+            ProfileFrame frame;
+            frame.function = QString::fromUtf8(symbol);
+            stack << frame;
+        } else if (!stack.isEmpty()) {
+            int colon = line.lastIndexOf(':');
+            bool ok = false;
+            int lineNumber = colon > 0 ? line.mid(colon + 1).toInt(&ok) : 0;
+            if (ok && lineNumber > 0) {
+                stack.last().file = QString::fromUtf8(line.left(colon));
+                stack.last().line = lineNumber;
+            }
+        }
+    }
+
+    m_data.addStack(stack);
+}
+
+void Profiler::symbolizeSamples(const QByteArray &maps, const QVector<QVector<quint64>> &stacks)
+{
+    m_symbolizeThread = QThread::create([this, maps, stacks]() {
+        const QVector<QVector<ProfileFrame>> frames = symbolizeStacks(maps, stacks);
+        QMetaObject::invokeMethod(this, [this, frames]() {
+            for (const QVector<ProfileFrame> &stack : frames) {
+                m_data.addStack(stack);
+            }
+            emit profileReady();
+        }, Qt::QueuedConnection);
+    });
+    m_symbolizeThread->setObjectName("Profiler symbolizer");
+    connect(m_symbolizeThread, &QThread::finished, this, [this]() {
+        m_symbolizeThread->deleteLater();
+        m_symbolizeThread = nullptr;
+    });
+    m_symbolizeThread->start(QThread::LowPriority);
+}
+
+QVector<QVector<ProfileFrame>> Profiler::symbolizeStacks(const QByteArray &maps,
+                                                         const QVector<QVector<quint64>> &stacks)
+{
+    Symbolizer symbolizer;
+    symbolizer.setMemoryMaps(maps);
+
+    // Return addresses point past the call instruction
+    auto frameAddress = [](const QVector<quint64> &stack, int i) {
+        return i == 0 ? stack.at(i) : stack.at(i) - 1;
+    };
+
+    QSet<quint64> addresses;
+    for (const QVector<quint64> &stack : stacks) {
+        for (int i = 0; i < stack.size(); ++i) {
+            addresses.insert(frameAddress(stack, i));
+        }
+    }
+
+    const QHash<quint64, ProfileFrame> symbols = symbolizer.symbolize(addresses);
+    QVector<QVector<ProfileFrame>> result;
+    result.reserve(stacks.size());
+    for (const QVector<quint64> &stack : stacks) {
+        QVector<ProfileFrame> frames;
+        frames.reserve(stack.size());
+        for (int i = 0; i < stack.size(); ++i) {
+            frames << symbols.value(frameAddress(stack, i));
+        }
+        result << frames;
+    }
+    return result;
+}
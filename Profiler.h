@@ -0,0 +1,116 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QThread>
+#include <QHash>
+#include <QVector>
+#include <QTemporaryDir>
+#include <QMutex>
+#include <atomic>
+#include <vector>
+#include "Symbolizer.h"
+
+struct ProfileNode
+{
+    ProfileFrame frame;
+    quint64 selfSamples = 0;
+    quint64 totalSamples = 0;
+    std::vector<ProfileNode> children;
+};
+
+struct HotFunction
+{
+    ProfileFrame frame;
+    quint64 selfSamples = 0;
+    quint64 totalSamples = 0;
+};
+
+struct ProfileData
+{
+    ProfileNode root;
+    QHash<QString, HotFunction> functions;
+    quint64 totalSamples = 0;
+
+    // Frames are ordered leaf first, as both perf and the stack walker report them
+    void addStack(const QVector<ProfileFrame> &leafFirst, quint64 count = 1);
+    void clear();
+};
+
+#ifdef Q_OS_LINUX
+// Fallback sampler used when perf is not installed or not permitted: periodically
+// interrupts the target with ptrace and walks its frame-pointer chain.
+class PtraceSampler : public QThread
+{
+public:
+    PtraceSampler(qint64 pid, int intervalUs, QObject *parent = nullptr);
+
+    void stop() { m_stopRequested = true; }
+    QVector<QVector<quint64>> takeStacks();
+    QByteArray memoryMaps();
+
+protected:
+    void run() override;
+
+private:
+    qint64 m_pid;
+    int m_intervalUs;
+    std::atomic<bool> m_stopRequested;
+    QMutex m_mutex;
+    QVector<QVector<quint64>> m_stacks;
+    QByteArray m_maps;
+};
+#endif
+
+class Profiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Backend {
+        Perf,
+        BuiltinSampler
+    };
+
+    explicit Profiler(QObject *parent = nullptr);
+    ~Profiler();
+
+    static bool isPerfAvailable();
+
+    bool start(const QString &executable, const QStringList &arguments,
+               const QString &workingDirectory, const QProcessEnvironment &environment);
+    void stop();
+    bool isRunning() const;
+    Backend backend() const { return m_backend; }
+    const ProfileData &data() const { return m_data; }
+
+signals:
+    void output(const QString &text);
+    void finished(int exitCode);
+    void profileReady();
+    void errorOccurred(const QString &message);
+
+private slots:
+    void onTargetFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onScriptFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    void parsePerfScript(const QByteArray &script);
+    void symbolizeSamples(const QByteArray &maps, const QVector<QVector<quint64>> &stacks);
+    static QVector<QVector<ProfileFrame>> symbolizeStacks(const QByteArray &maps,
+                                                          const QVector<QVector<quint64>> &stacks);
+
+    QProcess *m_target;
+    QProcess *m_script;
+    Backend m_backend;
+    QTemporaryDir *m_tempDir;
+    ProfileData m_data;
+    int m_exitCode;
+    QThread *m_symbolizeThread;   // runs addr2line; the profile is delivered back queued
+#ifdef Q_OS_LINUX
+    PtraceSampler *m_sampler;
+#endif
+};
+
+#endif // PROFILER_H
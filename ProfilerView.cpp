@@ -0,0 +1,225 @@
+#include "ProfilerView.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QToolTip>
+#include <QVBoxLayout>
+#include <QSplitter>
+#include <QHeaderView>
+#include <QFileInfo>
+#include <algorithm>
+
+namespace {
+const int kRowHeight = 18;
+}
+
+FlameGraphWidget::FlameGraphWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_data(nullptr)
+    , m_zoomRoot(nullptr)
+{
+    setMouseTracking(true);
+    setMinimumHeight(120);
+}
+
+void FlameGraphWidget::setProfile(const ProfileData *data)
+{
+    m_data = data;
+    m_zoomRoot = data ? &data->root : nullptr;
+    update();
+}
+
+void FlameGraphWidget::layoutNode(const ProfileNode *node, qreal x, qreal width, int depth)
+{
+    // Frames narrower than a pixel are invisible; skip their whole subtree
+    if (width < 1.0) {
+        return;
+    }
+
+    m_frames.append({QRectF(x, depth * kRowHeight, width, kRowHeight - 1), node});
+
+    qreal childX = x;
+    for (const ProfileNode &child : node->children) {
+        qreal childWidth = width * child.totalSamples / qMax<quint64>(1, node->totalSamples);
+        layoutNode(&child, childX, childWidth, depth + 1);
+        childX += childWidth;
+    }
+}
+
+void FlameGraphWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+
+    m_frames.clear();
+    if (!m_data || !m_zoomRoot || m_data->totalSamples == 0) {
+        painter.setPen(QColor(150, 150, 150));
+        painter.drawText(rect(), Qt::AlignCenter, "No profile samples");
+        return;
+    }
+
+    layoutNode(m_zoomRoot, 0, width(), 0);
+
+    painter.setFont(QFont("Consolas", 8));
+    for (const FrameRect &frame : m_frames) {
+        // Stable warm colour per function so the same frame is recognisable across runs
+        uint hash = qHash(frame.node->frame.function);
+        QColor color(200 + hash % 55, 80 + (hash >> 8) % 120, (hash >> 16) % 60);
+        painter.fillRect(frame.rect, color);
+
+        if (frame.rect.width() > 30) {
+            painter.setPen(Qt::black);
+            QString label = painter.fontMetrics().elidedText(frame.node->frame.function, Qt::ElideRight,
+                                                              int(frame.rect.width()) - 4);
+            painter.drawText(frame.rect.adjusted(2, 0, -2, 0), Qt::AlignVCenter | Qt::AlignLeft, label);
+        }
+    }
+}
+
+const ProfileNode *FlameGraphWidget::nodeAt(const QPoint &pos) const
+{
+    for (const FrameRect &frame : m_frames) {
+        if (frame.rect.contains(pos)) {
+            return frame.node;
+        }
+    }
+    return nullptr;
+}
+
+void FlameGraphWidget::mousePressEvent(QMouseEvent *event)
+{
+    // Click zooms into a frame; clicking the top row zooms back out
+    const ProfileNode *node = nodeAt(event->pos());
+    if (!node || !m_data) {
+        return;
+    }
+    m_zoomRoot = node == m_zoomRoot ? &m_data->root : node;
+    update();
+}
+
+void FlameGraphWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const ProfileNode *node = nodeAt(event->pos());
+    if (node && !node->frame.file.isEmpty()) {
+        emit frameActivated(node->frame.file, node->frame.line);
+    }
+}
+
+void FlameGraphWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    const ProfileNode *node = nodeAt(event->pos());
+    if (!node || !m_data) {
+        QToolTip::hideText();
+        return;
+    }
+
+    double percent = 100.0 * node->totalSamples / qMax<quint64>(1, m_data->totalSamples);
+    QString text = QString("%1\n%2 samples (%3%)")
+                       .arg(node->frame.function)
+                       .arg(node->totalSamples)
+                       .arg(percent, 0, 'f', 2);
+    if (!node->frame.file.isEmpty()) {
+        text += QString("\n%1:%2").arg(node->frame.file).arg(node->frame.line);
+    }
+    QToolTip::showText(event->globalPosition().toPoint(), text, this);
+}
+
+ProfilerView::ProfilerView(QWidget *parent)
+    : QWidget(parent)
+    , m_data(nullptr)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    m_summaryLabel = new QLabel("No profile");
+    m_summaryLabel->setStyleSheet("color: white;");
+    layout->addWidget(m_summaryLabel);
+
+    auto *splitter = new QSplitter(Qt::Vertical);
+
+    m_flameGraph = new FlameGraphWidget;
+    splitter->addWidget(m_flameGraph);
+
+    m_hotFunctions = new QTableWidget(0, 5);
+    m_hotFunctions->setHorizontalHeaderLabels({"Function", "Self %", "Self", "Total %", "Location"});
+    m_hotFunctions->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_hotFunctions->verticalHeader()->hide();
+    m_hotFunctions->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_hotFunctions->setSelectionBehavior(QAbstractItemView::SelectRows);
+    splitter->addWidget(m_hotFunctions);
+
+    layout->addWidget(splitter, 1);
+
+    connect(m_flameGraph, &FlameGraphWidget::frameActivated, this, &ProfilerView::openLocation);
+    connect(m_hotFunctions, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+        QTableWidgetItem *item = m_hotFunctions->item(row, 4);
+        if (item && !item->data(Qt::UserRole).toString().isEmpty()) {
+            emit openLocation(item->data(Qt::UserRole).toString(), item->data(Qt::UserRole + 1).toInt());
+        }
+    });
+}
+
+void ProfilerView::setProfile(const ProfileData *data)
+{
+    m_data = data;
+    m_flameGraph->setProfile(data);
+    m_summaryLabel->setText(QString("%1 samples, %2 functions")
+                                .arg(data->totalSamples)
+                                .arg(data->functions.size()));
+    populateHotFunctions();
+}
+
+void ProfilerView::clear()
+{
+    m_data = nullptr;
+    m_flameGraph->setProfile(nullptr);
+    m_hotFunctions->setRowCount(0);
+    m_summaryLabel->setText("Profiling...");
+}
+
+void ProfilerView::populateHotFunctions()
+{
+    QVector<HotFunction> functions;
+    functions.reserve(m_data->functions.size());
+    for (const HotFunction &function : m_data->functions) {
+        functions << function;
+    }
+    std::sort(functions.begin(), functions.end(), [](const HotFunction &a, const HotFunction &b) {
+        return a.selfSamples != b.selfSamples ? a.selfSamples > b.selfSamples
+                                              : a.totalSamples > b.totalSamples;
+    });
+
+    // The table is for spotting hot spots; the long tail stays in the flame graph
+    const int rows = qMin<int>(functions.size(), 500);
+    const double total = qMax<quint64>(1, m_data->totalSamples);
+
+    m_hotFunctions->setSortingEnabled(false);
+    m_hotFunctions->setRowCount(rows);
+    for (int row = 0; row < rows; ++row) {
+        const HotFunction &function = functions.at(row);
+
+        auto *selfPercent = new QTableWidgetItem;
+        selfPercent->setData(Qt::DisplayRole, qRound(10000.0 * function.selfSamples / total) / 100.0);
+        auto *self = new QTableWidgetItem;
+        self->setData(Qt::DisplayRole, function.selfSamples);
+        auto *totalPercent = new QTableWidgetItem;
+        totalPercent->setData(Qt::DisplayRole, qRound(10000.0 * function.totalSamples / total) / 100.0);
+
+        QString location;
+        if (!function.frame.file.isEmpty()) {
+            location = QString("%1:%2").arg(QFileInfo(function.frame.file).fileName()).arg(function.frame.line);
+        }
+        auto *locationItem = new QTableWidgetItem(location);
+        locationItem->setData(Qt::UserRole, function.frame.file);
+        locationItem->setData(Qt::UserRole + 1, function.frame.line);
+        locationItem->setToolTip(function.frame.file);
+
+        m_hotFunctions->setItem(row, 0, new QTableWidgetItem(function.frame.function));
+        m_hotFunctions->setItem(row, 1, selfPercent);
+        m_hotFunctions->setItem(row, 2, self);
+        m_hotFunctions->setItem(row, 3, totalPercent);
+        m_hotFunctions->setItem(row, 4, locationItem);
+    }
+    m_hotFunctions->setSortingEnabled(true);
+}
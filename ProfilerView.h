@@ -0,0 +1,66 @@
+#ifndef PROFILERVIEW_H
+#define PROFILERVIEW_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QLabel>
+#include <QVector>
+#include <QRectF>
+#include "Profiler.h"
+
+class FlameGraphWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FlameGraphWidget(QWidget *parent = nullptr);
+
+    void setProfile(const ProfileData *data);
+
+signals:
+    void frameActivated(const QString &file, int line);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    struct FrameRect
+    {
+        QRectF rect;
+        const ProfileNode *node;
+    };
+
+    void layoutNode(const ProfileNode *node, qreal x, qreal width, int depth);
+    const ProfileNode *nodeAt(const QPoint &pos) const;
+
+    const ProfileData *m_data;
+    const ProfileNode *m_zoomRoot;
+    QVector<FrameRect> m_frames;
+};
+
+class ProfilerView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ProfilerView(QWidget *parent = nullptr);
+
+    void setProfile(const ProfileData *data);
+    void clear();
+
+signals:
+    void openLocation(const QString &file, int line);
+
+private:
+    void populateHotFunctions();
+
+    const ProfileData *m_data;
+    QLabel *m_summaryLabel;
+    FlameGraphWidget *m_flameGraph;
+    QTableWidget *m_hotFunctions;
+};
+
+#endif // PROFILERVIEW_H
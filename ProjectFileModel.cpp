@@ -0,0 +1,567 @@
+#include "ProjectFileModel.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+bool matchesIgnoreRules(const QString &name, const QString &relativePath, bool isDir,
+                        const QVector<IgnorePattern> &namePatterns,
+                        const QVector<IgnorePattern> &pathPatterns)
+{
+    for (const IgnorePattern &pattern : namePatterns) {
+        if ((isDir || !pattern.directoryOnly) && pattern.expression.match(name).hasMatch()) {
+            return true;
+        }
+    }
+    for (const IgnorePattern &pattern : pathPatterns) {
+        if ((isDir || !pattern.directoryOnly) && pattern.expression.match(relativePath).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool entryLessThan(const DirectoryEntry &a, const DirectoryEntry &b)
+{
+    // Directories first, then case-insensitive by name
+    if (a.isDir != b.isDir) {
+        return a.isDir;
+    }
+    int order = a.name.compare(b.name, Qt::CaseInsensitive);
+    return order != 0 ? order < 0 : a.name < b.name;
+}
+
+// Runs on the lister thread, so it only touches its arguments
+QVector<DirectoryEntry> readDirectory(const QString &path, const QString &relativeBase,
+                                      const QVector<IgnorePattern> &namePatterns,
+                                      const QVector<IgnorePattern> &pathPatterns)
+{
+    QVector<DirectoryEntry> entries;
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QString name = it.fileName();
+        const QString relative = relativeBase.isEmpty() ? name : relativeBase + '/' + name;
+        const bool isDir = it.fileInfo().isDir();
+        if (!matchesIgnoreRules(name, relative, isDir, namePatterns, pathPatterns)) {
+            entries.append({name, isDir});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), entryLessThan);
+    return entries;
+}
+}
+
+ProjectFileModel::ProjectFileModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , m_nextToken(0)
+    , m_lister(new QObject)
+{
+    // An empty, already listed root until a project is opened
+    m_nodes.append({kNone, internName(QString()), 0, kNone, quint8(IsDir | Listed)});
+
+    m_pendingTimer.setInterval(0);
+    connect(&m_pendingTimer, &QTimer::timeout, this, &ProjectFileModel::processPending);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ProjectFileModel::refresh);
+
+    m_listerThread.setObjectName("ProjectFileModel lister");
+    m_lister->moveToThread(&m_listerThread);
+    connect(&m_listerThread, &QThread::finished, m_lister, &QObject::deleteLater);
+    m_listerThread.start(QThread::LowPriority);
+}
+
+ProjectFileModel::~ProjectFileModel()
+{
+    // Listings still queued for this model are discarded along with its posted events
+    m_listerThread.quit();
+    m_listerThread.wait();
+}
+
+void ProjectFileModel::setRootPath(const QString &path)
+{
+    beginResetModel();
+    if (!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_childLists.clear();
+    m_freeChildLists.clear();
+    m_names.clear();
+    m_nameIds.clear();
+    m_requests.clear();
+    m_pending.clear();
+    m_pendingTimer.stop();
+
+    m_rootPath = QDir::cleanPath(QDir(path).absolutePath());
+    m_nodes.append({kNone, internName(QString()), 0, kNone, IsDir});
+    loadIgnoreRules();
+    endResetModel();
+}
+
+void ProjectFileModel::loadIgnoreRules()
+{
+    m_namePatterns.clear();
+    m_pathPatterns.clear();
+
+    // Same exclusions as ProjectManager::scanProjectFiles, plus the project's .gitignore
+    QStringList patterns = {".git", "build"};
+    QFile gitignore(m_rootPath + "/.gitignore");
+    if (gitignore.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&gitignore);
+        while (!in.atEnd()) {
+            QString line = in.readLine().trimmed();
+            // Negations are rare enough in practice to leave those entries visible
+            if (!line.isEmpty() && !line.startsWith('#') && !line.startsWith('!')) {
+                patterns << line;
+            }
+        }
+    }
+
+    for (QString pattern : std::as_const(patterns)) {
+        const bool directoryOnly = pattern.endsWith('/');
+        if (directoryOnly) {
+            pattern.chop(1);
+        }
+        const bool anchored = pattern.contains('/');
+        if (pattern.startsWith('/')) {
+            pattern.remove(0, 1);
+        }
+        QRegularExpression expression(QRegularExpression::wildcardToRegularExpression(pattern));
+        if (!expression.isValid()) {
+            continue;
+        }
+        if (anchored) {
+            m_pathPatterns.append({expression, directoryOnly});
+        } else {
+            m_namePatterns.append({expression, directoryOnly});
+        }
+    }
+}
+
+bool ProjectFileModel::isIgnored(const QString &relativePath, bool isDir) const
+{
+    return matchesIgnoreRules(relativePath.section('/', -1), relativePath, isDir, m_namePatterns, m_pathPatterns);
+}
+
+quint32 ProjectFileModel::internName(const QString &name)
+{
+    // Names like CMakeLists.txt or src repeat across a tree; each is stored once
+    auto it = m_nameIds.constFind(name);
+    if (it != m_nameIds.constEnd()) {
+        return it.value();
+    }
+    const quint32 id = quint32(m_names.size());
+    m_names.append(name);
+    m_nameIds.insert(name, id);
+    return id;
+}
+
+quint32 ProjectFileModel::allocateNode(quint32 parent, quint32 name, bool isDir, quint32 row)
+{
+    const Node node = {parent, name, row, kNone, quint8(isDir ? IsDir : 0)};
+    if (!m_freeNodes.isEmpty()) {
+        const quint32 id = m_freeNodes.takeLast();
+        m_nodes[id] = node;
+        return id;
+    }
+    m_nodes.append(node);
+    return quint32(m_nodes.size() - 1);
+}
+
+void ProjectFileModel::freeSubtree(quint32 node)
+{
+    const quint32 list = m_nodes.at(node).children;
+    if (list != kNone) {
+        for (quint32 child : std::as_const(m_childLists[list])) {
+            freeSubtree(child);
+        }
+        m_childLists[list] = QVector<quint32>();
+        m_freeChildLists.append(list);
+    }
+    if (m_nodes.at(node).flags & Listed) {
+        m_watcher.removePath(pathOf(node));
+    }
+    m_requests.remove(node);
+    m_pending.removeIf([node](const PendingListing &pending) { return pending.node == node; });
+    m_nodes[node].flags = 0;
+    m_freeNodes.append(node);
+}
+
+QVector<quint32> &ProjectFileModel::childList(quint32 node)
+{
+    quint32 &list = m_nodes[node].children;
+    if (list == kNone) {
+        if (!m_freeChildLists.isEmpty()) {
+            list = m_freeChildLists.takeLast();
+        } else {
+            list = quint32(m_childLists.size());
+            m_childLists.append(QVector<quint32>());
+        }
+    }
+    return m_childLists[list];
+}
+
+const QVector<quint32> &ProjectFileModel::children(quint32 node) const
+{
+    static const QVector<quint32> empty;
+    const quint32 list = m_nodes.at(node).children;
+    return list == kNone ? empty : m_childLists.at(list);
+}
+
+quint32 ProjectFileModel::childNamed(quint32 node, const QString &name) const
+{
+    // Comparing interned ids keeps this a linear scan over integers
+    const quint32 nameId = m_nameIds.value(name, kNone);
+    if (nameId == kNone) {
+        return kNone;
+    }
+    for (quint32 child : children(node)) {
+        if (m_nodes.at(child).name == nameId) {
+            return child;
+        }
+    }
+    return kNone;
+}
+
+quint32 ProjectFileModel::findListedNode(const QString &path) const
+{
+    const QString relative = QDir(m_rootPath).relativeFilePath(path);
+    if (relative.startsWith("..")) {
+        return kNone;
+    }
+    quint32 node = 0;
+    if (relative != ".") {
+        for (const QString &part : relative.split('/', Qt::SkipEmptyParts)) {
+            node = childNamed(node, part);
+            if (node == kNone) {
+                return kNone;
+            }
+        }
+    }
+    return node;
+}
+
+QString ProjectFileModel::pathOf(quint32 node) const
+{
+    QStringList parts;
+    for (; node != 0 && node != kNone; node = m_nodes.at(node).parent) {
+        parts.prepend(m_names.at(m_nodes.at(node).name));
+    }
+    return parts.isEmpty() ? m_rootPath : m_rootPath + '/' + parts.join('/');
+}
+
+bool ProjectFileModel::lessThan(quint32 node, const DirectoryEntry &entry) const
+{
+    const Node &n = m_nodes.at(node);
+    return entryLessThan({m_names.at(n.name), bool(n.flags & IsDir)}, entry);
+}
+
+void ProjectFileModel::requestListing(quint32 node, bool refresh)
+{
+    const quint32 token = m_nextToken++;
+    m_requests.insert(node, token);
+
+    const QString path = pathOf(node);
+    const QString relativeBase = node == 0 ? QString() : path.mid(m_rootPath.size() + 1);
+    const QVector<IgnorePattern> namePatterns = m_namePatterns;
+    const QVector<IgnorePattern> pathPatterns = m_pathPatterns;
+    QMetaObject::invokeMethod(m_lister, [this, node, token, refresh, path, relativeBase, namePatterns, pathPatterns]() {
+        const QVector<DirectoryEntry> entries = readDirectory(path, relativeBase, namePatterns, pathPatterns);
+        QMetaObject::invokeMethod(this, [this, node, token, refresh, entries]() {
+            onListingReady(node, token, refresh, entries);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void ProjectFileModel::onListingReady(quint32 node, quint32 token, bool refresh, const QVector<DirectoryEntry> &entries)
+{
+    // Superseded, listed synchronously in the meantime, or the node is gone
+    if (m_requests.value(node, kNone) != token) {
+        return;
+    }
+    m_requests.remove(node);
+    m_pending.append({node, token, refresh, entries, 0});
+    if (!m_pendingTimer.isActive()) {
+        m_pendingTimer.start();
+    }
+}
+
+void ProjectFileModel::processPending()
+{
+    // Insert a bounded number of rows per event loop pass so huge directories never freeze the view
+    int budget = kInsertChunk;
+    while (budget > 0 && !m_pending.isEmpty()) {
+        PendingListing pending = m_pending.takeFirst();
+        if (pending.refresh) {
+            applyDifference(pending.node, pending.entries);
+            budget -= qMax<int>(1, pending.entries.size());
+            continue;
+        }
+
+        const int count = qMin<int>(budget, pending.entries.size() - pending.next);
+        appendChildren(pending.node, pending.entries, pending.next, count);
+        pending.next += count;
+        budget -= qMax(1, count);
+        if (pending.next < pending.entries.size()) {
+            m_pending.prepend(pending);
+        } else {
+            finishListing(pending.node);
+        }
+    }
+    if (m_pending.isEmpty()) {
+        m_pendingTimer.stop();
+    }
+}
+
+void ProjectFileModel::finishListing(quint32 node)
+{
+    m_nodes[node].flags &= ~Loading;
+    if (m_nodes.at(node).flags & Stale) {
+        m_nodes[node].flags &= ~Stale;
+        requestListing(node, true);
+    }
+    if (children(node).isEmpty()) {
+        // The view only asks hasChildren() again on layout, so drop the expander explicitly
+        const QPersistentModelIndex index(indexFromNode(node));
+        emit layoutAboutToBeChanged({index});
+        emit layoutChanged({index});
+    }
+}
+
+void ProjectFileModel::appendChildren(quint32 node, const QVector<DirectoryEntry> &entries, int from, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+    QVector<quint32> &list = childList(node);
+    const int first = list.size();
+    beginInsertRows(indexFromNode(node), first, first + count - 1);
+    list.reserve(first + count);
+    for (int i = from; i < from + count; ++i) {
+        const DirectoryEntry &entry = entries.at(i);
+        list.append(allocateNode(node, internName(entry.name), entry.isDir, quint32(list.size())));
+    }
+    endInsertRows();
+}
+
+void ProjectFileModel::applyDifference(quint32 node, const QVector<DirectoryEntry> &entries)
+{
+    const QModelIndex parentIndex = indexFromNode(node);
+    QVector<quint32> &list = childList(node);
+    auto renumberFrom = [this, &list](int row) {
+        for (int i = row; i < list.size(); ++i) {
+            m_nodes[list.at(i)].row = quint32(i);
+        }
+    };
+
+    // Remove children that disappeared or changed type
+    for (int row = list.size() - 1; row >= 0; --row) {
+        const quint32 child = list.at(row);
+        const DirectoryEntry key = {m_names.at(m_nodes.at(child).name), bool(m_nodes.at(child).flags & IsDir)};
+        if (!std::binary_search(entries.cbegin(), entries.cend(), key, entryLessThan)) {
+            beginRemoveRows(parentIndex, row, row);
+            list.removeAt(row);
+            freeSubtree(child);
+            renumberFrom(row);
+            endRemoveRows();
+        }
+    }
+
+    // Insert new entries at their sorted position
+    for (const DirectoryEntry &entry : entries) {
+        auto position = std::lower_bound(list.begin(), list.end(), entry,
+                                         [this](quint32 child, const DirectoryEntry &value) {
+                                             return lessThan(child, value);
+                                         });
+        if (position != list.end() && !entryLessThan(entry, {m_names.at(m_nodes.at(*position).name),
+                                                             bool(m_nodes.at(*position).flags & IsDir)})) {
+            continue;
+        }
+        const int row = int(position - list.begin());
+        beginInsertRows(parentIndex, row, row);
+        list.insert(row, allocateNode(node, internName(entry.name), entry.isDir, quint32(row)));
+        renumberFrom(row + 1);
+        endInsertRows();
+    }
+}
+
+void ProjectFileModel::listNow(quint32 node)
+{
+    const quint8 flags = m_nodes.at(node).flags;
+    if ((flags & Listed) && !(flags & Loading)) {
+        return;
+    }
+
+    // Finish a listing that has already arrived, otherwise read the directory right here
+    for (int i = 0; i < m_pending.size(); ++i) {
+        if (m_pending.at(i).node == node && !m_pending.at(i).refresh) {
+            const PendingListing pending = m_pending.takeAt(i);
+            appendChildren(node, pending.entries, pending.next, pending.entries.size() - pending.next);
+            finishListing(node);
+            return;
+        }
+    }
+
+    m_requests.remove(node);
+    const QString path = pathOf(node);
+    if (!(flags & Listed)) {
+        m_nodes[node].flags |= Listed;
+        m_watcher.addPath(path);
+    }
+    m_nodes[node].flags |= Loading;
+    const QVector<DirectoryEntry> entries =
+        readDirectory(path, node == 0 ? QString() : path.mid(m_rootPath.size() + 1), m_namePatterns, m_pathPatterns);
+    appendChildren(node, entries, 0, entries.size());
+    finishListing(node);
+}
+
+void ProjectFileModel::refresh(const QString &directory)
+{
+    if (m_rootPath.isEmpty()) {
+        return;
+    }
+
+    // Only directories the user has already seen need updating
+    const quint32 node = findListedNode(directory);
+    if (node == kNone || !(m_nodes.at(node).flags & Listed)) {
+        return;
+    }
+    if (m_nodes.at(node).flags & Loading) {
+        m_nodes[node].flags |= Stale;   // re-read once the current listing is in
+        return;
+    }
+    if (!QFileInfo(pathOf(node)).isDir()) {
+        return;   // the parent directory's own change removes it
+    }
+    requestListing(node, true);
+}
+
+quint32 ProjectFileModel::nodeFromIndex(const QModelIndex &index) const
+{
+    return index.isValid() ? quint32(index.internalId()) : 0;
+}
+
+QModelIndex ProjectFileModel::indexFromNode(quint32 node) const
+{
+    if (node == 0 || node == kNone) {
+        return QModelIndex();
+    }
+    return createIndex(int(m_nodes.at(node).row), 0, quintptr(node));
+}
+
+QModelIndex ProjectFileModel::index(const QString &path)
+{
+    if (m_rootPath.isEmpty()) {
+        return QModelIndex();
+    }
+    const QString relative = QDir(m_rootPath).relativeFilePath(path);
+    if (relative == "." || relative.startsWith("..")) {
+        return QModelIndex();
+    }
+
+    quint32 node = 0;
+    for (const QString &part : relative.split('/', Qt::SkipEmptyParts)) {
+        listNow(node);
+        node = childNamed(node, part);
+        if (node == kNone) {
+            return QModelIndex();
+        }
+    }
+    return indexFromNode(node);
+}
+
+QString ProjectFileModel::filePath(const QModelIndex &index) const
+{
+    return pathOf(nodeFromIndex(index));
+}
+
+QString ProjectFileModel::fileName(const QModelIndex &index) const
+{
+    const quint32 node = nodeFromIndex(index);
+    return node != 0 ? m_names.at(m_nodes.at(node).name) : QFileInfo(m_rootPath).fileName();
+}
+
+bool ProjectFileModel::isDir(const QModelIndex &index) const
+{
+    return m_nodes.at(nodeFromIndex(index)).flags & IsDir;
+}
+
+QModelIndex ProjectFileModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const QVector<quint32> &list = children(nodeFromIndex(parent));
+    if (column != 0 || row < 0 || row >= list.size()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(list.at(row)));
+}
+
+QModelIndex ProjectFileModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+    return indexFromNode(m_nodes.at(nodeFromIndex(child)).parent);
+}
+
+int ProjectFileModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    return children(nodeFromIndex(parent)).size();
+}
+
+int ProjectFileModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 1;
+}
+
+QVariant ProjectFileModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const quint32 node = nodeFromIndex(index);
+    switch (role) {
+    case Qt::DisplayRole:
+        return m_names.at(m_nodes.at(node).name);
+    case Qt::DecorationRole:
+        return m_iconProvider.icon(m_nodes.at(node).flags & IsDir ? QFileIconProvider::Folder : QFileIconProvider::File);
+    case Qt::ToolTipRole:
+        return pathOf(node);
+    default:
+        return QVariant();
+    }
+}
+
+bool ProjectFileModel::hasChildren(const QModelIndex &parent) const
+{
+    const quint32 node = nodeFromIndex(parent);
+    const quint8 flags = m_nodes.at(node).flags;
+    if (!(flags & IsDir)) {
+        return false;
+    }
+    // Unlisted and loading directories show an expander until they turn out to be empty
+    return !(flags & Listed) || (flags & Loading) || !children(node).isEmpty();
+}
+
+bool ProjectFileModel::canFetchMore(const QModelIndex &parent) const
+{
+    const quint8 flags = m_nodes.at(nodeFromIndex(parent)).flags;
+    return (flags & IsDir) && !(flags & Listed);
+}
+
+void ProjectFileModel::fetchMore(const QModelIndex &parent)
+{
+    const quint32 node = nodeFromIndex(parent);
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    m_nodes[node].flags |= Listed | Loading;
+    m_watcher.addPath(pathOf(node));
+    requestListing(node, false);
+}
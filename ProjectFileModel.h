@@ -0,0 +1,134 @@
+#ifndef PROJECTFILEMODEL_H
+#define PROJECTFILEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QFileSystemWatcher>
+#include <QFileIconProvider>
+#include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+
+struct DirectoryEntry
+{
+    QString name;
+    bool isDir;
+};
+
+struct IgnorePattern
+{
+    QRegularExpression expression;
+    bool directoryOnly;   // written with a trailing '/', as in "build/"
+};
+
+// File tree for the open project, built for very large repositories:
+// - nodes are 20 byte records in one arena, addressed by index, with interned names;
+// - only directories the view expands are listed, on a background thread;
+// - listings are inserted in chunks so the GUI stays responsive;
+// - entries matched by the ignore rules are hidden;
+// - watcher changes are applied as row insertions and removals, never a reset.
+class ProjectFileModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectFileModel(QObject *parent = nullptr);
+    ~ProjectFileModel() override;
+
+    void setRootPath(const QString &path);
+    QString rootPath() const { return m_rootPath; }
+
+    // Lists the directories on the way synchronously, so any existing path can be addressed
+    QModelIndex index(const QString &path);
+    QString filePath(const QModelIndex &index) const;
+    QString fileName(const QModelIndex &index) const;
+    bool isDir(const QModelIndex &index) const;
+    bool isIgnored(const QString &relativePath, bool isDir) const;
+    int nodeCount() const { return m_nodes.size() - m_freeNodes.size(); }
+
+    // Re-reads a directory that has already been listed and applies the difference
+    void refresh(const QString &directory);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    static constexpr quint32 kNone = 0xffffffffu;
+    static constexpr int kInsertChunk = 2000;
+
+    enum NodeFlag : quint8 {
+        IsDir = 0x1,
+        Listed = 0x2,    // a listing has been requested; children are materialized or arriving
+        Loading = 0x4,   // the first listing has not been fully inserted yet
+        Stale = 0x8      // changed on disk while loading, re-read when done
+    };
+
+    struct Node
+    {
+        quint32 parent;
+        quint32 name;       // index into m_names
+        quint32 row;        // position among the parent's children
+        quint32 children;   // index into m_childLists, kNone until listed
+        quint8 flags;
+    };
+
+    // A finished background listing waiting to be inserted or diffed
+    struct PendingListing
+    {
+        quint32 node;
+        quint32 token;
+        bool refresh;
+        QVector<DirectoryEntry> entries;
+        int next;
+    };
+
+    quint32 internName(const QString &name);
+    quint32 allocateNode(quint32 parent, quint32 name, bool isDir, quint32 row);
+    void freeSubtree(quint32 node);
+    QVector<quint32> &childList(quint32 node);
+    const QVector<quint32> &children(quint32 node) const;
+    quint32 childNamed(quint32 node, const QString &name) const;
+    quint32 findListedNode(const QString &path) const;
+    QModelIndex indexFromNode(quint32 node) const;
+    quint32 nodeFromIndex(const QModelIndex &index) const;
+    QString pathOf(quint32 node) const;
+    bool lessThan(quint32 node, const DirectoryEntry &entry) const;
+
+    void requestListing(quint32 node, bool refresh);
+    void onListingReady(quint32 node, quint32 token, bool refresh, const QVector<DirectoryEntry> &entries);
+    void processPending();
+    void finishListing(quint32 node);
+    void appendChildren(quint32 node, const QVector<DirectoryEntry> &entries, int from, int count);
+    void applyDifference(quint32 node, const QVector<DirectoryEntry> &entries);
+    void listNow(quint32 node);
+    void loadIgnoreRules();
+
+    QString m_rootPath;
+    QVector<Node> m_nodes;
+    QVector<quint32> m_freeNodes;
+    QVector<QVector<quint32>> m_childLists;
+    QVector<quint32> m_freeChildLists;
+    QVector<QString> m_names;
+    QHash<QString, quint32> m_nameIds;
+
+    QHash<quint32, quint32> m_requests;   // node -> token of its outstanding listing
+    quint32 m_nextToken;
+    QList<PendingListing> m_pending;
+    QTimer m_pendingTimer;
+
+    QThread m_listerThread;
+    QObject *m_lister;
+    QFileSystemWatcher m_watcher;
+    QFileIconProvider m_iconProvider;
+    QVector<IgnorePattern> m_namePatterns;   // match a single path component
+    QVector<IgnorePattern> m_pathPatterns;   // match the path relative to the root
+};
+
+#endif // PROJECTFILEMODEL_H
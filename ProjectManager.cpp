@@ -1,4 +1,5 @@
 #include "ProjectManager.h"
+#include "Instrumentation.h"
 #include <QFileInfo>
 #include <QDirIterator>
 #include <QJsonDocument>
@@ -7,11 +8,19 @@
 #include <QDebug>
 #include <QTextStream>
 #include <QFile>
+#include <QTimer>
 
 ProjectManager::ProjectManager(QObject *parent)
     : QObject(parent)
     , m_fileWatcher(new QFileSystemWatcher(this))
+    , m_batchDepth(0)
+    , m_settlingBatches(0)
+    , m_batchSettleTimer(new QTimer(this))
+    , m_batchRescan(false)
 {
+    m_batchSettleTimer->setSingleShot(true);
+    m_batchSettleTimer->setInterval(kBatchSettleMs);
+    connect(m_batchSettleTimer, &QTimer::timeout, this, &ProjectManager::finishBatchChanges);
     connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged,
             this, &ProjectManager::onDirectoryChanged);
     connect(m_fileWatcher, &QFileSystemWatcher::fileChanged,
@@ -144,6 +153,7 @@ bool ProjectManager::createProject(const QString &projectPath, const QString &pr
         out << "Thumbs.db\n";
         out << "*.autosave\n";
         out << ".qtcide_project\n";
+        out << ".qtcide_benchmarks.json\n";
     }
     
     return openProject(projectPath);
@@ -288,6 +298,7 @@ void ProjectManager::createLibraryProjectFiles(const QString &projectPath, const
 void ProjectManager::closeProject()
 {
     if (!m_currentProjectPath.isEmpty()) {
+        emit projectAboutToClose(m_currentProjectPath);
         saveProjectSettings();
         m_fileWatcher->removePaths(m_fileWatcher->directories());
         m_fileWatcher->removePaths(m_fileWatcher->files());
@@ -303,6 +314,7 @@ void ProjectManager::closeProject()
 
 void ProjectManager::scanProjectFiles()
 {
+    InstrumentationScope scope("ProjectManager::scanProjectFiles");
     m_projectFiles.clear();
     
     if (m_currentProjectPath.isEmpty()) {
@@ -322,6 +334,7 @@ void ProjectManager::scanProjectFiles()
             m_fileWatcher->addPath(filePath);
         }
     }
+    emit projectFilesChanged();
 }
 
 void ProjectManager::addRecentProject(const QString &projectPath)
@@ -343,14 +356,68 @@ void ProjectManager::removeRecentProject(const QString &projectPath)
     saveRecentProjects();
 }
 
+void ProjectManager::beginBatchChanges()
+{
+    ++m_batchDepth;
+}
+
+void ProjectManager::endBatchChanges()
+{
+    if (m_batchDepth == m_settlingBatches) {
+        return;
+    }
+    ++m_settlingBatches;
+    m_batchSettleTimer->start();
+}
+
+void ProjectManager::finishBatchChanges()
+{
+    m_batchDepth -= m_settlingBatches;
+    m_settlingBatches = 0;
+    if (m_batchDepth > 0) {
+        return;
+    }
+    if (m_batchRescan) {
+        m_batchRescan = false;
+        scanProjectFiles();
+    }
+    const QSet<QString> changed = m_batchChangedFiles;
+    m_batchChangedFiles.clear();
+    for (const QString &path : changed) {
+        emit fileChanged(path);
+    }
+}
+
 void ProjectManager::onDirectoryChanged(const QString &path)
 {
     Q_UNUSED(path)
+    if (m_batchDepth > 0) {
+        m_batchRescan = true;
+        if (m_settlingBatches > 0) {
+            m_batchSettleTimer->start();
+        }
+        return;
+    }
     scanProjectFiles();
 }
 
 void ProjectManager::onFileChanged(const QString &path)
 {
+    if (m_batchDepth > 0) {
+        m_batchChangedFiles.insert(path);
+        // Files replaced by rename drop out of the watcher; the closing rescan adds them back
+        m_batchRescan = true;
+        if (m_settlingBatches > 0) {
+            m_batchSettleTimer->start();
+        }
+        return;
+    }
+    // QSaveFile, most editors and git replace a file by renaming over it, which drops it from
+    // the watcher; only the project root is watched as a directory, so nothing else adds it back.
+    // addPath does nothing for a path that is still watched.
+    if (QFileInfo::exists(path)) {
+        m_fileWatcher->addPath(path);
+    }
     emit fileChanged(path);
 }
 
@@ -403,6 +470,16 @@ void ProjectManager::loadProjectSettings()
     }
 }
 
+void ProjectManager::setProjectSetting(const QString &key, const QJsonValue &value)
+{
+    if (m_currentProjectPath.isEmpty()) {
+        return;
+    }
+    
+    m_projectSettings.insert(key, value);
+    saveProjectSettings();
+}
+
 void ProjectManager::saveProjectSettings()
 {
     if (m_currentProjectPath.isEmpty()) {
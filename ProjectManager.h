@@ -3,10 +3,13 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QSet>
 #include <QFileSystemWatcher>
 #include <QDir>
 #include <QJsonObject>
 
+class QTimer;
+
 class ProjectManager : public QObject
 {
     Q_OBJECT
@@ -23,19 +26,33 @@ public:
     QStringList projectFiles() const { return m_projectFiles; }
     QStringList recentProjects() const { return m_recentProjects; }
     
+    QJsonValue projectSetting(const QString &key) const { return m_projectSettings.value(key); }
+    void setProjectSetting(const QString &key, const QJsonValue &value);
+    
     void addRecentProject(const QString &projectPath);
     void removeRecentProject(const QString &projectPath);
+    
+    // Watcher notifications between these calls are collapsed into one rescan at the end,
+    // so tools that rewrite many files do not trigger a rescan per file. Calls nest. The
+    // batch closes once the watcher has been quiet for kBatchSettleMs, since it reports
+    // the renames of the last writes after they return.
+    static constexpr int kBatchSettleMs = 200;
+    void beginBatchChanges();
+    void endBatchChanges();
 
 signals:
     void projectOpened(const QString &projectPath);
+    void projectAboutToClose(const QString &projectPath);   // settings can still be written
     void projectClosed();
     void fileAdded(const QString &filePath);
     void fileRemoved(const QString &filePath);
     void fileChanged(const QString &filePath);
+    void projectFilesChanged();
 
 private slots:
     void onDirectoryChanged(const QString &path);
     void onFileChanged(const QString &path);
+    void finishBatchChanges();
 
 private:
     void scanProjectFiles();
@@ -53,6 +70,11 @@ private:
     QStringList m_recentProjects;
     QFileSystemWatcher *m_fileWatcher;
     QJsonObject m_projectSettings;
+    int m_batchDepth;
+    int m_settlingBatches;   // ended, closed by m_batchSettleTimer
+    QTimer *m_batchSettleTimer;
+    bool m_batchRescan;
+    QSet<QString> m_batchChangedFiles;
 };
 
 #endif // PROJECTMANAGER_H
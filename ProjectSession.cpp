@@ -0,0 +1,95 @@
+#include "ProjectSession.h"
+#include <QJsonArray>
+#include <algorithm>
+
+namespace {
+QJsonArray sizesToJson(const QList<int> &sizes)
+{
+    QJsonArray array;
+    for (int size : sizes) {
+        array.append(size);
+    }
+    return array;
+}
+
+QList<int> sizesFromJson(const QJsonValue &value)
+{
+    QList<int> sizes;
+    for (const auto &size : value.toArray()) {
+        sizes << size.toInt();
+    }
+    return sizes;
+}
+}
+
+QJsonObject DocumentViewState::toJson() const
+{
+    QJsonObject object;
+    object["file"] = filePath;
+    object["cursor"] = cursorPosition;
+    object["anchor"] = anchorPosition;
+    object["firstVisibleLine"] = firstVisibleLine;
+    return object;
+}
+
+DocumentViewState DocumentViewState::fromJson(const QJsonObject &object)
+{
+    DocumentViewState state;
+    state.filePath = object.value("file").toString();
+    state.cursorPosition = object.value("cursor").toInt();
+    state.anchorPosition = object.value("anchor").toInt(state.cursorPosition);
+    state.firstVisibleLine = object.value("firstVisibleLine").toInt();
+    return state;
+}
+
+const DocumentViewState *ProjectSession::find(const QString &filePath) const
+{
+    for (const DocumentViewState &state : documents) {
+        if (state.filePath == filePath) {
+            return &state;
+        }
+    }
+    return nullptr;
+}
+
+void ProjectSession::remember(const DocumentViewState &state)
+{
+    documents.erase(std::remove_if(documents.begin(), documents.end(),
+                                   [&state](const DocumentViewState &other) { return other.filePath == state.filePath; }),
+                    documents.end());
+    documents.append(state);
+    if (documents.size() > kMaxDocuments) {
+        documents.remove(0, documents.size() - kMaxDocuments);
+    }
+}
+
+QJsonObject ProjectSession::toJson() const
+{
+    QJsonArray array;
+    for (const DocumentViewState &state : documents) {
+        array.append(state.toJson());
+    }
+    QJsonObject object;
+    object["documents"] = array;
+    object["mainSplitter"] = sizesToJson(mainSplitterSizes);
+    object["rightSplitter"] = sizesToJson(rightSplitterSizes);
+    object["terminalDirectory"] = terminalDirectory;
+    object["windowState"] = QString::fromLatin1(windowState.toBase64());
+    return object;
+}
+
+ProjectSession ProjectSession::fromJson(const QJsonObject &object)
+{
+    ProjectSession session;
+    for (const auto &value : object.value("documents").toArray()) {
+        DocumentViewState state = DocumentViewState::fromJson(value.toObject());
+        if (!state.filePath.isEmpty()) {
+            session.documents << state;
+        }
+    }
+    session.mainSplitterSizes = sizesFromJson(object.value("mainSplitter"));
+    session.rightSplitterSizes = sizesFromJson(object.value("rightSplitter"));
+    session.terminalDirectory = object.value("terminalDirectory").toString();
+    session.windowState = QByteArray::fromBase64(object.value("windowState").toString().toLatin1());
+    return session;
+}
@@ -0,0 +1,42 @@
+#ifndef PROJECTSESSION_H
+#define PROJECTSESSION_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QByteArray>
+#include <QJsonObject>
+
+// Where the editor was in a document, restored when the document is shown again
+struct DocumentViewState
+{
+    QString filePath;          // relative to the project when inside it
+    int cursorPosition = 0;
+    int anchorPosition = 0;
+    int firstVisibleLine = 0;
+
+    QJsonObject toJson() const;
+    static DocumentViewState fromJson(const QJsonObject &object);
+};
+
+// The window as it was when the project was last closed, kept in .qtcide_project. Only view
+// state is stored; documents are read again when they are shown.
+struct ProjectSession
+{
+    static constexpr int kMaxDocuments = 50;
+
+    QVector<DocumentViewState> documents;   // least recently shown first, the last one is active
+    QList<int> mainSplitterSizes;
+    QList<int> rightSplitterSizes;
+    QString terminalDirectory;
+    QByteArray windowState;                 // docks and toolbars, QMainWindow::saveState
+
+    const DocumentViewState *find(const QString &filePath) const;
+    void remember(const DocumentViewState &state);   // becomes the active document
+    QString activeFile() const { return documents.isEmpty() ? QString() : documents.last().filePath; }
+
+    QJsonObject toJson() const;
+    static ProjectSession fromJson(const QJsonObject &object);
+};
+
+#endif // PROJECTSESSION_H
@@ -0,0 +1,148 @@
+#include "QuickOpenDialog.h"
+#include "Instrumentation.h"
+#include <QVBoxLayout>
+#include <QKeyEvent>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+QuickOpenDialog::QuickOpenDialog(QWidget *parent)
+    : QDialog(parent, Qt::Popup)
+{
+    setupUI();
+    applyGlassmorphicStyle();
+    resize(600, 400);
+
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &QuickOpenDialog::updateResults);
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &QuickOpenDialog::activateCurrent);
+    connect(m_resultList, &QListWidget::itemActivated, this, &QuickOpenDialog::activateCurrent);
+    m_searchEdit->installEventFilter(this);
+}
+
+void QuickOpenDialog::setupUI()
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(10, 10, 10, 10);
+    layout->setSpacing(6);
+
+    m_searchEdit = new QLineEdit;
+    m_searchEdit->setPlaceholderText("Type to search files by name...");
+    layout->addWidget(m_searchEdit);
+
+    m_resultList = new QListWidget;
+    m_resultList->setUniformItemSizes(true);
+    m_resultList->setFocusPolicy(Qt::NoFocus);
+    layout->addWidget(m_resultList);
+
+    m_statusLabel = new QLabel;
+    layout->addWidget(m_statusLabel);
+}
+
+void QuickOpenDialog::setFiles(const QStringList &files, const QString &rootPath)
+{
+    m_matcher.setPaths(files, rootPath);
+    if (isVisible()) {
+        updateResults();
+    }
+}
+
+void QuickOpenDialog::popup()
+{
+    // Centered near the top of the main window, like the command palettes users know
+    if (QWidget *window = parentWidget() ? parentWidget()->window() : nullptr) {
+        const QPoint topCenter = window->mapToGlobal(QPoint(window->width() / 2, 60));
+        move(topCenter.x() - width() / 2, topCenter.y());
+    }
+    m_searchEdit->selectAll();
+    updateResults();
+    show();
+    m_searchEdit->setFocus();
+}
+
+void QuickOpenDialog::updateResults()
+{
+    InstrumentationScope scope("QuickOpenDialog::updateResults");
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<FuzzyMatch> matches = m_matcher.match(m_searchEdit->text(), kMaxResults);
+    const qint64 matchMicroseconds = timer.nsecsElapsed() / 1000;
+
+    m_resultList->setUpdatesEnabled(false);
+    m_resultList->clear();
+    for (const FuzzyMatch &match : matches) {
+        const QString relative = m_matcher.relativePath(match.index);
+        const QString directory = QFileInfo(relative).path();
+        auto *item = new QListWidgetItem(directory == "." ? m_matcher.fileName(match.index)
+                                                          : m_matcher.fileName(match.index) + "   " + directory);
+        item->setData(Qt::UserRole, m_matcher.path(match.index));
+        item->setToolTip(relative);
+        m_resultList->addItem(item);
+    }
+    m_resultList->setCurrentRow(matches.isEmpty() ? -1 : 0);
+    m_resultList->setUpdatesEnabled(true);
+
+    m_statusLabel->setText(QString("%1 of %2 files (%3 ms)")
+                               .arg(matches.size()).arg(m_matcher.size())
+                               .arg(matchMicroseconds / 1000.0, 0, 'f', 1));
+}
+
+void QuickOpenDialog::activateCurrent()
+{
+    QListWidgetItem *item = m_resultList->currentItem();
+    if (!item) {
+        return;
+    }
+    const QString path = item->data(Qt::UserRole).toString();
+    hide();
+    emit fileSelected(path);
+}
+
+bool QuickOpenDialog::eventFilter(QObject *watched, QEvent *event)
+{
+    // Navigation keys move through the results while the search field keeps focus
+    if (watched == m_searchEdit && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent *>(event);
+        switch (keyEvent->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QCoreApplication::sendEvent(m_resultList, event);
+            return true;
+        case Qt::Key_Escape:
+            hide();
+            return true;
+        default:
+            break;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+void QuickOpenDialog::applyGlassmorphicStyle()
+{
+    setStyleSheet(R"(
+        QuickOpenDialog {
+            background: qlineargradient(x1: 0, y1: 0, x2: 1, y2: 1,
+                                      stop: 0 rgba(20, 20, 20, 240),
+                                      stop: 1 rgba(40, 40, 40, 240));
+            border: 1px solid rgba(255, 140, 0, 150);
+            border-radius: 8px;
+        }
+
+        QListWidget, QLineEdit {
+            background: rgba(50, 50, 50, 180);
+            border: 1px solid rgba(255, 140, 0, 100);
+            border-radius: 6px;
+            color: white;
+            padding: 4px;
+        }
+
+        QListWidget::item:selected {
+            background: rgba(255, 140, 0, 100);
+        }
+
+        QLabel {
+            color: rgba(255, 255, 255, 150);
+        }
+    )");
+}
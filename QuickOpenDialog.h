@@ -0,0 +1,43 @@
+#ifndef QUICKOPENDIALOG_H
+#define QUICKOPENDIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QLabel>
+#include "FuzzyMatcher.h"
+
+// Ctrl+P popup: type part of a file name, pick a result with the arrow keys and Enter
+class QuickOpenDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit QuickOpenDialog(QWidget *parent = nullptr);
+
+    void setFiles(const QStringList &files, const QString &rootPath);
+    void popup();
+
+signals:
+    void fileSelected(const QString &filePath);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void updateResults();
+    void activateCurrent();
+
+private:
+    void setupUI();
+    void applyGlassmorphicStyle();
+
+    static constexpr int kMaxResults = 200;
+
+    FuzzyMatcher m_matcher;
+    QLineEdit *m_searchEdit;
+    QListWidget *m_resultList;
+    QLabel *m_statusLabel;
+};
+
+#endif // QUICKOPENDIALOG_H
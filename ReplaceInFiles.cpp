@@ -0,0 +1,363 @@
+#include "ReplaceInFiles.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+#include <memory>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QMutex>
+#include <QStringDecoder>
+#include <QStringEncoder>
+#include <QCryptographicHash>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr qint64 kBinaryProbeBytes = 8192;
+
+// Runs body(0..count-1) on the global thread pool plus the calling thread and waits
+void parallelFor(int count, const std::function<void(int)> &body)
+{
+    if (count <= 0) {
+        return;
+    }
+    std::atomic<int> next{0};
+    QSemaphore done;
+    auto run = [&]() {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            body(i);
+        }
+        done.release();
+    };
+    const int workers = qBound(1, QThread::idealThreadCount(), count);
+    for (int i = 1; i < workers; ++i) {
+        QThreadPool::globalInstance()->start(run);
+    }
+    run();
+    done.acquire(workers);
+}
+
+bool readFile(const QString &filePath, QByteArray *data)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    *data = file.readAll();
+    return true;
+}
+
+QString expandReplacement(const QString &replacement, const QRegularExpressionMatch &match, bool expandCaptures)
+{
+    if (!expandCaptures || !replacement.contains('\\')) {
+        return replacement;
+    }
+    QString result;
+    for (int i = 0; i < replacement.size(); ++i) {
+        const QChar c = replacement.at(i);
+        if (c == '\\' && i + 1 < replacement.size()) {
+            const QChar next = replacement.at(++i);
+            if (next.isDigit()) {
+                result += match.captured(next.digitValue());
+            } else if (next == 'n') {
+                result += '\n';
+            } else if (next == 't') {
+                result += '\t';
+            } else {
+                result += next;
+            }
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Applies ascending, non-overlapping edits and records the edits that restore the original
+QString applyEdits(const QString &text, const QVector<TextEdit> &edits, QVector<TextEdit> *reverse)
+{
+    QString result;
+    result.reserve(text.size());
+    int last = 0;
+    int delta = 0;
+    for (const TextEdit &edit : edits) {
+        result.append(QStringView(text).mid(last, edit.position - last));
+        if (reverse) {
+            reverse->append({edit.position + delta, int(edit.text.size()), text.mid(edit.position, edit.length),
+                             edit.line, QString()});
+        }
+        result += edit.text;
+        delta += int(edit.text.size()) - edit.length;
+        last = edit.position + edit.length;
+    }
+    result.append(QStringView(text).mid(last));
+    return result;
+}
+
+// Rewrites one file through a temporary file and rename; fills in the undo record on success
+bool writeReplacement(const FileReplacement &replacement, FileReplacement *reverse, QString *error)
+{
+    QByteArray original;
+    if (!readFile(replacement.filePath, &original)) {
+        *error = "Cannot read " + replacement.filePath;
+        return false;
+    }
+    if (ReplaceInFiles::checksum(original) != replacement.checksum) {
+        *error = replacement.filePath + " changed since the preview";
+        return false;
+    }
+
+    // A byte order mark is decoded as U+FEFF and written back the same way, like every other
+    // byte the edits do not touch
+    QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::ConvertInitialBom);
+    const QString text = decoder(original);
+    QVector<TextEdit> reverseEdits;
+    const QByteArray updated = QStringEncoder(QStringEncoder::Utf8)(applyEdits(text, replacement.edits, &reverseEdits));
+
+    QSaveFile file(replacement.filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(updated) != updated.size() || !file.commit()) {
+        *error = QString("Cannot write %1: %2").arg(replacement.filePath, file.errorString());
+        return false;
+    }
+    if (reverse) {
+        *reverse = {replacement.filePath, ReplaceInFiles::checksum(updated), reverseEdits};
+    }
+    return true;
+}
+}
+
+ReplaceInFiles::ReplaceInFiles(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+{
+}
+
+ReplaceInFiles::~ReplaceInFiles()
+{
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+QByteArray ReplaceInFiles::checksum(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5);
+}
+
+FileReplacement ReplaceInFiles::computeFile(const QString &filePath, const QRegularExpression &expression,
+                                            const QByteArray &requiredLiteral, bool caseSensitive,
+                                            const QString &replacement, bool expandCaptures)
+{
+    FileReplacement result;
+    result.filePath = filePath;
+
+    QByteArray data;
+    if (!readFile(filePath, &data) || data.isEmpty()) {
+        return result;
+    }
+    if (std::memchr(data.constData(), '\0', std::min<qint64>(data.size(), kBinaryProbeBytes))) {
+        return result;
+    }
+    if (!requiredLiteral.isEmpty() && !(caseSensitive ? data : data.toLower()).contains(requiredLiteral)) {
+        return result;
+    }
+
+    // Files that are not valid UTF-8 are left alone rather than re-encoded lossily. The byte
+    // order mark stays in the text, so offsets line up with what writeReplacement decodes.
+    QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::ConvertInitialBom);
+    const QString text = decoder(data);
+    if (decoder.hasError()) {
+        return result;
+    }
+
+    // Matched line by line without the line break, as Find in Files does, so the edits are
+    // exactly the matches its preview showed
+    int line = 1;
+    qsizetype lineStart = text.startsWith(QChar(0xFEFF)) ? 1 : 0;
+    while (lineStart <= text.size()) {
+        qsizetype next = text.indexOf(u'\n', lineStart);
+        if (next < 0) {
+            next = text.size();
+        }
+        const qsizetype lineEnd = next > lineStart && text.at(next - 1) == u'\r' ? next - 1 : next;
+        const QString lineText = text.mid(lineStart, lineEnd - lineStart);
+        QRegularExpressionMatchIterator it = expression.globalMatch(lineText);
+        while (it.hasNext()) {
+            const QRegularExpressionMatch match = it.next();
+            if (match.capturedLength() == 0) {
+                continue;
+            }
+            const QString replaced = expandReplacement(replacement, match, expandCaptures);
+            // Concatenated rather than arg()ed, since source lines often contain %1 and friends
+            const QString preview = QString::number(line) + ": "
+                                    + QStringView(lineText).left(match.capturedStart()).trimmed().toString() + "["
+                                    + match.captured() + " → " + replaced + "]"
+                                    + QStringView(lineText).mid(match.capturedEnd()).trimmed().toString();
+            result.edits.append({int(lineStart + match.capturedStart()), int(match.capturedLength()), replaced,
+                                 line, preview});
+        }
+        lineStart = next + 1;
+        ++line;
+    }
+    if (!result.edits.isEmpty()) {
+        result.checksum = checksum(data);
+    }
+    return result;
+}
+
+void ReplaceInFiles::runInBackground(const std::function<Completion()> &work)
+{
+    auto completion = std::make_shared<Completion>();
+    m_thread = QThread::create([work, completion]() {
+        *completion = work();
+    });
+    m_thread->setObjectName("ReplaceInFiles");
+    // Completing after the thread is gone means the handlers can start the next step right away
+    connect(m_thread, &QThread::finished, this, [this, completion]() {
+        m_thread->deleteLater();
+        m_thread = nullptr;
+        if (*completion) {
+            (*completion)();
+        }
+    });
+    m_thread->start();
+}
+
+void ReplaceInFiles::prepare(const QStringList &files, const SearchOptions &options, const QString &replacement,
+                             const FileStamps &unverified)
+{
+    if (isBusy()) {
+        return;
+    }
+    const QRegularExpression expression = options.expression();
+    const QByteArray literal = options.requiredLiteral();
+    const bool caseSensitive = options.caseSensitive;
+    const bool expandCaptures = options.regex;
+
+    runInBackground([this, files, unverified, expression, literal, caseSensitive, replacement, expandCaptures]() {
+        std::vector<FileReplacement> results(files.size());
+        parallelFor(files.size(), [&](int i) {
+            const auto stamp = unverified.constFind(files.at(i));
+            if (stamp != unverified.constEnd() && stamp->isCurrent(files.at(i))) {
+                return;
+            }
+            results[i] = computeFile(files.at(i), expression, literal, caseSensitive, replacement, expandCaptures);
+        });
+
+        QVector<FileReplacement> replacements;
+        for (FileReplacement &result : results) {
+            if (!result.edits.isEmpty()) {
+                replacements.append(std::move(result));
+            }
+        }
+        std::sort(replacements.begin(), replacements.end(), [](const FileReplacement &a, const FileReplacement &b) {
+            return a.filePath < b.filePath;
+        });
+        return Completion([this, replacements]() {
+            emit prepared(replacements);
+        });
+    });
+}
+
+QString ReplaceInFiles::runTransaction(const QVector<FileReplacement> &replacements,
+                                       QVector<FileReplacement> *undo, QStringList *written)
+{
+    const int count = replacements.size();
+
+    // Nothing is written unless every file still has the contents the edits were computed for
+    std::atomic<int> changed{-1};
+    parallelFor(count, [&](int i) {
+        QByteArray data;
+        if (changed.load() < 0 && (!readFile(replacements.at(i).filePath, &data)
+                                   || checksum(data) != replacements.at(i).checksum)) {
+            changed = i;
+        }
+    });
+    if (changed.load() >= 0) {
+        return replacements.at(changed.load()).filePath + " changed since the preview; nothing was replaced";
+    }
+
+    std::vector<FileReplacement> reverse(count);
+    std::vector<char> done(count, 0);
+    std::atomic<bool> failed{false};
+    QMutex errorMutex;
+    QString error;
+    parallelFor(count, [&](int i) {
+        if (failed) {
+            return;
+        }
+        QString message;
+        if (writeReplacement(replacements.at(i), &reverse[i], &message)) {
+            done[i] = 1;
+        } else {
+            failed = true;
+            QMutexLocker locker(&errorMutex);
+            if (error.isEmpty()) {
+                error = message;
+            }
+        }
+    });
+
+    if (failed) {
+        // Put back what was already written so the project is never left half replaced
+        for (int i = 0; i < count; ++i) {
+            QString ignored;
+            if (done[i]) {
+                writeReplacement(reverse[i], nullptr, &ignored);
+            }
+        }
+        return error + "; all files were restored";
+    }
+
+    undo->clear();
+    written->clear();
+    for (int i = 0; i < count; ++i) {
+        undo->append(std::move(reverse[i]));
+        written->append(replacements.at(i).filePath);
+    }
+    return QString();
+}
+
+void ReplaceInFiles::apply(const QVector<FileReplacement> &replacements)
+{
+    if (isBusy()) {
+        return;
+    }
+    runInBackground([this, replacements]() {
+        QVector<FileReplacement> undo;
+        QStringList written;
+        const QString error = runTransaction(replacements, &undo, &written);
+        int replacementCount = 0;
+        for (const FileReplacement &replacement : replacements) {
+            replacementCount += replacement.edits.size();
+        }
+        return Completion([this, undo, written, replacementCount, error]() {
+            if (error.isEmpty()) {
+                m_undo = undo;
+            }
+            emit applied(written, error.isEmpty() ? replacementCount : 0, error);
+        });
+    });
+}
+
+void ReplaceInFiles::undo()
+{
+    if (isBusy() || m_undo.isEmpty()) {
+        return;
+    }
+    const QVector<FileReplacement> replacements = m_undo;
+    runInBackground([this, replacements]() {
+        QVector<FileReplacement> redo;
+        QStringList written;
+        const QString error = runTransaction(replacements, &redo, &written);
+        return Completion([this, written, error]() {
+            if (error.isEmpty()) {
+                m_undo.clear();
+            }
+            emit undone(written, error);
+        });
+    });
+}
@@ -0,0 +1,71 @@
+#ifndef REPLACEINFILES_H
+#define REPLACEINFILES_H
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <functional>
+#include "FindInFiles.h"
+
+class QThread;
+
+// One replacement in a file's decoded text
+struct TextEdit
+{
+    int position;   // UTF-16 offset into the whole file
+    int length;
+    QString text;
+    int line;       // 1-based, for the preview
+    QString preview;
+};
+
+struct FileReplacement
+{
+    QString filePath;
+    QByteArray checksum;   // of the file contents the edits were computed against
+    QVector<TextEdit> edits;
+};
+
+// Project-wide replace in three steps: edits are computed in parallel for review, then applied
+// as one transaction (every file is checked before any is written, each write is an atomic
+// temp file rename, and written files are rolled back if a later one fails), and the whole
+// operation can be undone at once.
+class ReplaceInFiles : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplaceInFiles(QObject *parent = nullptr);
+    ~ReplaceInFiles() override;
+
+    // Files in unverified are skipped while they still match their stamp, as in FindInFiles
+    void prepare(const QStringList &files, const SearchOptions &options, const QString &replacement,
+                 const FileStamps &unverified = FileStamps());
+    void apply(const QVector<FileReplacement> &replacements);
+    void undo();
+    bool canUndo() const { return !m_undo.isEmpty(); }
+    bool isBusy() const { return m_thread != nullptr; }
+
+    // \0 to \9 in the replacement insert captured groups when searching with a regex
+    static FileReplacement computeFile(const QString &filePath, const QRegularExpression &expression,
+                                       const QByteArray &requiredLiteral, bool caseSensitive,
+                                       const QString &replacement, bool expandCaptures);
+    static QByteArray checksum(const QByteArray &data);
+
+signals:
+    void prepared(const QVector<FileReplacement> &replacements);
+    void applied(const QStringList &files, int replacementCount, const QString &error);
+    void undone(const QStringList &files, const QString &error);
+
+private:
+    // The work runs on a background thread and returns what to do on the GUI thread afterwards
+    using Completion = std::function<void()>;
+    void runInBackground(const std::function<Completion()> &work);
+    static QString runTransaction(const QVector<FileReplacement> &replacements,
+                                  QVector<FileReplacement> *undo, QStringList *written);
+
+    QThread *m_thread;
+    QVector<FileReplacement> m_undo;
+};
+
+#endif // REPLACEINFILES_H
@@ -0,0 +1,121 @@
+#include "ReplacePreviewDialog.h"
+#include <QVBoxLayout>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QDir>
+
+ReplacePreviewDialog::ReplacePreviewDialog(const QVector<FileReplacement> &replacements, const QString &rootPath,
+                                           QWidget *parent)
+    : QDialog(parent)
+    , m_replacements(replacements)
+{
+    setWindowTitle("Replace in Files");
+    setModal(true);
+    resize(800, 500);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(20, 20, 20, 20);
+    layout->setSpacing(10);
+
+    m_summaryLabel = new QLabel;
+    layout->addWidget(m_summaryLabel);
+
+    m_tree = new QTreeWidget;
+    m_tree->setHeaderHidden(true);
+    m_tree->setUniformRowHeights(true);
+    layout->addWidget(m_tree, 1);
+
+    // Children are built for the first lines only; huge renames would otherwise take seconds to list
+    const QDir root(rootPath);
+    for (int i = 0; i < m_replacements.size(); ++i) {
+        const FileReplacement &replacement = m_replacements.at(i);
+        auto *fileItem = new QTreeWidgetItem(m_tree);
+        fileItem->setText(0, QString("%1 (%2)").arg(root.relativeFilePath(replacement.filePath))
+                                                .arg(replacement.edits.size()));
+        fileItem->setFlags(fileItem->flags() | Qt::ItemIsUserCheckable);
+        fileItem->setCheckState(0, Qt::Checked);
+        fileItem->setData(0, Qt::UserRole, i);
+        const int shown = qMin<int>(replacement.edits.size(), kPreviewLinesPerFile);
+        for (int e = 0; e < shown; ++e) {
+            auto *editItem = new QTreeWidgetItem(fileItem);
+            editItem->setText(0, replacement.edits.at(e).preview);
+        }
+        if (replacement.edits.size() > shown) {
+            auto *moreItem = new QTreeWidgetItem(fileItem);
+            moreItem->setText(0, QString("... %1 more").arg(replacement.edits.size() - shown));
+        }
+    }
+    if (m_tree->topLevelItemCount() <= 20) {
+        m_tree->expandAll();
+    }
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    buttons->button(QDialogButtonBox::Ok)->setText("Replace");
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_tree, &QTreeWidget::itemChanged, this, &ReplacePreviewDialog::updateSummary);
+
+    applyGlassmorphicStyle();
+    updateSummary();
+}
+
+QVector<FileReplacement> ReplacePreviewDialog::selectedReplacements() const
+{
+    QVector<FileReplacement> selected;
+    for (int i = 0; i < m_tree->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = m_tree->topLevelItem(i);
+        if (item->checkState(0) == Qt::Checked) {
+            selected.append(m_replacements.at(item->data(0, Qt::UserRole).toInt()));
+        }
+    }
+    return selected;
+}
+
+void ReplacePreviewDialog::updateSummary()
+{
+    int files = 0;
+    int edits = 0;
+    for (int i = 0; i < m_tree->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = m_tree->topLevelItem(i);
+        if (item->checkState(0) == Qt::Checked) {
+            ++files;
+            edits += m_replacements.at(item->data(0, Qt::UserRole).toInt()).edits.size();
+        }
+    }
+    m_summaryLabel->setText(QString("%1 replacements in %2 files").arg(edits).arg(files));
+}
+
+void ReplacePreviewDialog::applyGlassmorphicStyle()
+{
+    setStyleSheet(R"(
+        ReplacePreviewDialog {
+            background: qlineargradient(x1: 0, y1: 0, x2: 1, y2: 1,
+                                      stop: 0 rgba(20, 20, 20, 240),
+                                      stop: 1 rgba(40, 40, 40, 240));
+        }
+
+        QTreeWidget {
+            background: rgba(50, 50, 50, 180);
+            border: 1px solid rgba(255, 140, 0, 100);
+            border-radius: 6px;
+            color: white;
+            padding: 4px;
+        }
+
+        QPushButton {
+            background: qlineargradient(x1: 0, y1: 0, x2: 1, y2: 1,
+                                      stop: 0 rgba(255, 140, 0, 180),
+                                      stop: 1 rgba(255, 100, 0, 180));
+            border: none;
+            border-radius: 6px;
+            color: white;
+            font-weight: bold;
+            padding: 6px 12px;
+        }
+
+        QLabel {
+            color: white;
+        }
+    )");
+}
@@ -0,0 +1,31 @@
+#ifndef REPLACEPREVIEWDIALOG_H
+#define REPLACEPREVIEWDIALOG_H
+
+#include <QDialog>
+#include <QTreeWidget>
+#include <QLabel>
+#include "ReplaceInFiles.h"
+
+// Lists every pending replacement grouped by file; unchecked files are left alone
+class ReplacePreviewDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ReplacePreviewDialog(const QVector<FileReplacement> &replacements, const QString &rootPath,
+                         QWidget *parent = nullptr);
+
+    QVector<FileReplacement> selectedReplacements() const;
+
+private:
+    void applyGlassmorphicStyle();
+    void updateSummary();
+
+    static constexpr int kPreviewLinesPerFile = 50;
+
+    QVector<FileReplacement> m_replacements;
+    QTreeWidget *m_tree;
+    QLabel *m_summaryLabel;
+};
+
+#endif // REPLACEPREVIEWDIALOG_H
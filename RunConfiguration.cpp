@@ -0,0 +1,232 @@
+#include "RunConfiguration.h"
+#include "ProjectManager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+
+QJsonObject RunConfiguration::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["target"] = target;
+    object["arguments"] = QJsonArray::fromStringList(arguments);
+    object["environment"] = QJsonArray::fromStringList(environment);
+    object["workingDirectory"] = workingDirectory;
+    return object;
+}
+
+RunConfiguration RunConfiguration::fromJson(const QJsonObject &object)
+{
+    RunConfiguration config;
+    config.name = object.value("name").toString();
+    config.target = object.value("target").toString();
+    config.workingDirectory = object.value("workingDirectory").toString();
+
+    for (const auto &value : object.value("arguments").toArray()) {
+        config.arguments << value.toString();
+    }
+    for (const auto &value : object.value("environment").toArray()) {
+        config.environment << value.toString();
+    }
+    return config;
+}
+
+QProcessEnvironment RunConfiguration::processEnvironment() const
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (const QString &entry : environment) {
+        int separator = entry.indexOf('=');
+        if (separator > 0) {
+            env.insert(entry.left(separator).trimmed(), entry.mid(separator + 1));
+        }
+    }
+    return env;
+}
+
+RunConfigurationManager::RunConfigurationManager(ProjectManager *projectManager, QObject *parent)
+    : QObject(parent)
+    , m_projectManager(projectManager)
+{
+    connect(m_projectManager, &ProjectManager::projectOpened, this, &RunConfigurationManager::onProjectOpened);
+    connect(m_projectManager, &ProjectManager::projectClosed, this, &RunConfigurationManager::onProjectClosed);
+}
+
+RunConfiguration RunConfigurationManager::activeConfiguration() const
+{
+    for (const RunConfiguration &config : m_configurations) {
+        if (config.name == m_activeName) {
+            return config;
+        }
+    }
+
+    if (!m_configurations.isEmpty()) {
+        return m_configurations.first();
+    }
+
+    // No saved configurations: auto-detect the executable with no arguments
+    RunConfiguration config;
+    config.name = "Default";
+    return config;
+}
+
+void RunConfigurationManager::setActiveConfiguration(const QString &name)
+{
+    if (m_activeName == name) {
+        return;
+    }
+
+    m_activeName = name;
+    save();
+    emit activeConfigurationChanged(name);
+}
+
+void RunConfigurationManager::setConfigurations(const QVector<RunConfiguration> &configurations)
+{
+    m_configurations = configurations;
+
+    bool activeExists = false;
+    for (const RunConfiguration &config : m_configurations) {
+        if (config.name == m_activeName) {
+            activeExists = true;
+            break;
+        }
+    }
+    if (!activeExists) {
+        m_activeName = m_configurations.isEmpty() ? QString() : m_configurations.first().name;
+    }
+
+    m_executableCache.clear();
+    save();
+    emit configurationsChanged();
+}
+
+QString RunConfigurationManager::buildDirectory() const
+{
+    if (m_projectManager->currentProjectPath().isEmpty()) {
+        return QString();
+    }
+    return m_projectManager->currentProjectPath() + "/build";
+}
+
+QString RunConfigurationManager::resolveExecutable(const RunConfiguration &config)
+{
+    // Cached paths only need a single stat to stay valid between builds
+    auto cached = m_executableCache.constFind(config.target);
+    if (cached != m_executableCache.constEnd() && QFileInfo::exists(cached.value())) {
+        return cached.value();
+    }
+
+    QString buildDir = buildDirectory();
+    if (buildDir.isEmpty()) {
+        return QString();
+    }
+
+    QString executable;
+    if (config.target.isEmpty()) {
+        executable = detectExecutable(buildDir);
+    } else {
+        QFileInfo info(QDir(buildDir).absoluteFilePath(config.target));
+#ifdef Q_OS_WIN
+        if (!info.exists() && info.suffix().isEmpty()) {
+            info.setFile(info.absoluteFilePath() + ".exe");
+        }
+#endif
+        if (info.isFile() && info.isExecutable()) {
+            executable = info.absoluteFilePath();
+        }
+    }
+
+    if (!executable.isEmpty()) {
+        m_executableCache.insert(config.target, executable);
+    }
+    return executable;
+}
+
+QString RunConfigurationManager::workingDirectory(const RunConfiguration &config) const
+{
+    if (config.workingDirectory.isEmpty()) {
+        return buildDirectory();
+    }
+    return QDir(m_projectManager->currentProjectPath()).absoluteFilePath(config.workingDirectory);
+}
+
+void RunConfigurationManager::invalidateExecutableCache()
+{
+    m_executableCache.clear();
+}
+
+QString RunConfigurationManager::detectExecutable(const QString &buildDir) const
+{
+    QDir dir(buildDir);
+
+    QStringList nameFilters;
+#ifdef Q_OS_WIN
+    nameFilters << "*.exe";
+#else
+    nameFilters << "*";
+#endif
+
+    QFileInfoList executables = dir.entryInfoList(nameFilters, QDir::Files | QDir::Executable);
+
+    // Prefer the target named after the project, which is what the project templates generate
+    QString projectName = m_projectManager->currentProjectName();
+    QString fallback;
+    for (const QFileInfo &info : executables) {
+        if (info.fileName().contains("CMakeFiles") || info.fileName().startsWith("cmake")) {
+            continue;
+        }
+        if (info.completeBaseName() == projectName) {
+            return info.absoluteFilePath();
+        }
+        if (fallback.isEmpty()) {
+            fallback = info.absoluteFilePath();
+        }
+    }
+    return fallback;
+}
+
+void RunConfigurationManager::onProjectOpened(const QString &projectPath)
+{
+    Q_UNUSED(projectPath)
+    load();
+}
+
+void RunConfigurationManager::onProjectClosed()
+{
+    m_configurations.clear();
+    m_activeName.clear();
+    m_executableCache.clear();
+    emit configurationsChanged();
+}
+
+void RunConfigurationManager::load()
+{
+    m_configurations.clear();
+    m_executableCache.clear();
+
+    const QJsonArray array = m_projectManager->projectSetting("runConfigurations").toArray();
+    for (const auto &value : array) {
+        RunConfiguration config = RunConfiguration::fromJson(value.toObject());
+        if (!config.name.isEmpty()) {
+            m_configurations << config;
+        }
+    }
+
+    m_activeName = m_projectManager->projectSetting("activeRunConfiguration").toString();
+    emit configurationsChanged();
+}
+
+void RunConfigurationManager::save()
+{
+    if (m_projectManager->currentProjectPath().isEmpty()) {
+        return;
+    }
+
+    QJsonArray array;
+    for (const RunConfiguration &config : m_configurations) {
+        array.append(config.toJson());
+    }
+
+    m_projectManager->setProjectSetting("runConfigurations", array);
+    m_projectManager->setProjectSetting("activeRunConfiguration", m_activeName);
+}
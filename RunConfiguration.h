@@ -0,0 +1,66 @@
+#ifndef RUNCONFIGURATION_H
+#define RUNCONFIGURATION_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+
+class ProjectManager;
+
+struct RunConfiguration
+{
+    QString name;
+    QString target;            // Executable path (absolute or relative to the build dir), empty = auto-detect
+    QStringList arguments;
+    QStringList environment;   // KEY=VALUE entries applied on top of the system environment
+    QString workingDirectory;  // Empty = build directory
+
+    QJsonObject toJson() const;
+    static RunConfiguration fromJson(const QJsonObject &object);
+    QProcessEnvironment processEnvironment() const;
+};
+
+class RunConfigurationManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RunConfigurationManager(ProjectManager *projectManager, QObject *parent = nullptr);
+
+    QVector<RunConfiguration> configurations() const { return m_configurations; }
+    RunConfiguration activeConfiguration() const;
+    QString activeConfigurationName() const { return m_activeName; }
+    void setActiveConfiguration(const QString &name);
+    void setConfigurations(const QVector<RunConfiguration> &configurations);
+
+    QString buildDirectory() const;
+    QString resolveExecutable(const RunConfiguration &config);
+    QString workingDirectory(const RunConfiguration &config) const;
+    void invalidateExecutableCache();
+
+signals:
+    void configurationsChanged();
+    void activeConfigurationChanged(const QString &name);
+
+private slots:
+    void onProjectOpened(const QString &projectPath);
+    void onProjectClosed();
+
+private:
+    void load();
+    void save();
+    QString detectExecutable(const QString &buildDir) const;
+
+    ProjectManager *m_projectManager;
+    QVector<RunConfiguration> m_configurations;
+    QString m_activeName;
+
+    // Resolved executables keyed by run configuration target; cleared whenever the build changes
+    QHash<QString, QString> m_executableCache;
+};
+
+#endif // RUNCONFIGURATION_H
@@ -0,0 +1,239 @@
+#include "RunConfigurationDialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QLabel>
+#include <QFileDialog>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QProcess>
+
+RunConfigurationDialog::RunConfigurationDialog(const QVector<RunConfiguration> &configurations,
+                                               const QString &buildDirectory, QWidget *parent)
+    : QDialog(parent)
+    , m_configurations(configurations)
+    , m_buildDirectory(buildDirectory)
+    , m_currentRow(-1)
+{
+    setupUI();
+    applyGlassmorphicStyle();
+    setModal(true);
+    setWindowTitle("Run Configurations");
+    resize(700, 420);
+
+    for (const RunConfiguration &config : m_configurations) {
+        m_list->addItem(config.name);
+    }
+    setEditorsEnabled(!m_configurations.isEmpty());
+    if (!m_configurations.isEmpty()) {
+        m_list->setCurrentRow(0);
+    }
+}
+
+void RunConfigurationDialog::setupUI()
+{
+    auto *mainLayout = new QVBoxLayout(this);
+    mainLayout->setContentsMargins(20, 20, 20, 20);
+    mainLayout->setSpacing(15);
+
+    auto *contentLayout = new QHBoxLayout;
+
+    // Configuration list
+    auto *listLayout = new QVBoxLayout;
+    m_list = new QListWidget;
+    m_list->setMaximumWidth(200);
+    listLayout->addWidget(m_list);
+
+    auto *listButtons = new QHBoxLayout;
+    m_addButton = new QPushButton("Add");
+    m_removeButton = new QPushButton("Remove");
+    listButtons->addWidget(m_addButton);
+    listButtons->addWidget(m_removeButton);
+    listLayout->addLayout(listButtons);
+    contentLayout->addLayout(listLayout);
+
+    // Configuration details
+    auto *formLayout = new QFormLayout;
+    m_nameEdit = new QLineEdit;
+    formLayout->addRow("Name:", m_nameEdit);
+
+    auto *targetLayout = new QHBoxLayout;
+    m_targetEdit = new QLineEdit;
+    m_targetEdit->setPlaceholderText("Auto-detect from build directory");
+    m_browseTargetButton = new QPushButton("Browse...");
+    m_browseTargetButton->setMaximumWidth(80);
+    targetLayout->addWidget(m_targetEdit);
+    targetLayout->addWidget(m_browseTargetButton);
+    formLayout->addRow("Executable:", targetLayout);
+
+    m_argumentsEdit = new QLineEdit;
+    m_argumentsEdit->setPlaceholderText("--flag \"value with spaces\"");
+    formLayout->addRow("Arguments:", m_argumentsEdit);
+
+    m_environmentEdit = new QPlainTextEdit;
+    m_environmentEdit->setPlaceholderText("KEY=VALUE (one per line)");
+    m_environmentEdit->setMaximumHeight(100);
+    formLayout->addRow("Environment:", m_environmentEdit);
+
+    auto *workingDirLayout = new QHBoxLayout;
+    m_workingDirectoryEdit = new QLineEdit;
+    m_workingDirectoryEdit->setPlaceholderText("Build directory");
+    m_browseWorkingDirButton = new QPushButton("Browse...");
+    m_browseWorkingDirButton->setMaximumWidth(80);
+    workingDirLayout->addWidget(m_workingDirectoryEdit);
+    workingDirLayout->addWidget(m_browseWorkingDirButton);
+    formLayout->addRow("Working Dir:", workingDirLayout);
+
+    contentLayout->addLayout(formLayout, 1);
+    mainLayout->addLayout(contentLayout, 1);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    mainLayout->addWidget(buttonBox);
+
+    connect(m_list, &QListWidget::currentRowChanged, this, &RunConfigurationDialog::onCurrentRowChanged);
+    connect(m_addButton, &QPushButton::clicked, this, &RunConfigurationDialog::addConfiguration);
+    connect(m_removeButton, &QPushButton::clicked, this, &RunConfigurationDialog::removeConfiguration);
+    connect(m_browseTargetButton, &QPushButton::clicked, this, &RunConfigurationDialog::browseTarget);
+    connect(m_browseWorkingDirButton, &QPushButton::clicked, this, &RunConfigurationDialog::browseWorkingDirectory);
+    connect(m_nameEdit, &QLineEdit::textEdited, this, [this](const QString &text) {
+        if (QListWidgetItem *item = m_list->currentItem()) {
+            item->setText(text);
+        }
+    });
+    connect(buttonBox, &QDialogButtonBox::accepted, this, [this]() {
+        storeCurrent();
+        accept();
+    });
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+}
+
+void RunConfigurationDialog::storeCurrent()
+{
+    if (m_currentRow < 0 || m_currentRow >= m_configurations.size()) {
+        return;
+    }
+
+    RunConfiguration &config = m_configurations[m_currentRow];
+    config.name = m_nameEdit->text().trimmed();
+    if (config.name.isEmpty()) {
+        config.name = QString("Configuration %1").arg(m_currentRow + 1);
+    }
+    config.target = m_targetEdit->text().trimmed();
+    config.arguments = QProcess::splitCommand(m_argumentsEdit->text());
+    config.environment = m_environmentEdit->toPlainText().split('\n', Qt::SkipEmptyParts);
+    config.workingDirectory = m_workingDirectoryEdit->text().trimmed();
+}
+
+void RunConfigurationDialog::onCurrentRowChanged(int row)
+{
+    storeCurrent();
+    m_currentRow = row;
+
+    if (row < 0 || row >= m_configurations.size()) {
+        setEditorsEnabled(false);
+        return;
+    }
+
+    const RunConfiguration &config = m_configurations.at(row);
+    m_nameEdit->setText(config.name);
+    m_targetEdit->setText(config.target);
+
+    QStringList quotedArguments;
+    for (const QString &argument : config.arguments) {
+        quotedArguments << (argument.contains(' ') ? '"' + argument + '"' : argument);
+    }
+    m_argumentsEdit->setText(quotedArguments.join(' '));
+    m_environmentEdit->setPlainText(config.environment.join('\n'));
+    m_workingDirectoryEdit->setText(config.workingDirectory);
+    setEditorsEnabled(true);
+}
+
+void RunConfigurationDialog::addConfiguration()
+{
+    storeCurrent();
+
+    RunConfiguration config;
+    config.name = QString("Configuration %1").arg(m_configurations.size() + 1);
+    m_configurations << config;
+    m_list->addItem(config.name);
+    m_list->setCurrentRow(m_configurations.size() - 1);
+}
+
+void RunConfigurationDialog::removeConfiguration()
+{
+    int row = m_list->currentRow();
+    if (row < 0) {
+        return;
+    }
+
+    // Drop the row before the list selection moves so storeCurrent() does not write it back
+    m_currentRow = -1;
+    m_configurations.removeAt(row);
+    delete m_list->takeItem(row);
+}
+
+void RunConfigurationDialog::browseTarget()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Select Executable", m_buildDirectory);
+    if (!path.isEmpty()) {
+        m_targetEdit->setText(QDir(m_buildDirectory).relativeFilePath(path));
+    }
+}
+
+void RunConfigurationDialog::browseWorkingDirectory()
+{
+    QString path = QFileDialog::getExistingDirectory(this, "Select Working Directory", m_buildDirectory);
+    if (!path.isEmpty()) {
+        m_workingDirectoryEdit->setText(path);
+    }
+}
+
+void RunConfigurationDialog::setEditorsEnabled(bool enabled)
+{
+    m_nameEdit->setEnabled(enabled);
+    m_targetEdit->setEnabled(enabled);
+    m_argumentsEdit->setEnabled(enabled);
+    m_environmentEdit->setEnabled(enabled);
+    m_workingDirectoryEdit->setEnabled(enabled);
+    m_browseTargetButton->setEnabled(enabled);
+    m_browseWorkingDirButton->setEnabled(enabled);
+    m_removeButton->setEnabled(enabled);
+}
+
+void RunConfigurationDialog::applyGlassmorphicStyle()
+{
+    setStyleSheet(R"(
+        RunConfigurationDialog {
+            background: qlineargradient(x1: 0, y1: 0, x2: 1, y2: 1,
+                                      stop: 0 rgba(20, 20, 20, 240),
+                                      stop: 1 rgba(40, 40, 40, 240));
+        }
+
+        QListWidget, QLineEdit, QPlainTextEdit {
+            background: rgba(50, 50, 50, 180);
+            border: 1px solid rgba(255, 140, 0, 100);
+            border-radius: 6px;
+            color: white;
+            padding: 4px;
+        }
+
+        QListWidget::item:selected {
+            background: rgba(255, 140, 0, 100);
+        }
+
+        QPushButton {
+            background: qlineargradient(x1: 0, y1: 0, x2: 1, y2: 1,
+                                      stop: 0 rgba(255, 140, 0, 180),
+                                      stop: 1 rgba(255, 100, 0, 180));
+            border: none;
+            border-radius: 6px;
+            color: white;
+            font-weight: bold;
+            padding: 6px 12px;
+        }
+
+        QLabel {
+            color: white;
+        }
+    )");
+}
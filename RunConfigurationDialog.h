@@ -0,0 +1,50 @@
+#ifndef RUNCONFIGURATIONDIALOG_H
+#define RUNCONFIGURATIONDIALOG_H
+
+#include <QDialog>
+#include <QListWidget>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include "RunConfiguration.h"
+
+class RunConfigurationDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    RunConfigurationDialog(const QVector<RunConfiguration> &configurations,
+                           const QString &buildDirectory, QWidget *parent = nullptr);
+
+    QVector<RunConfiguration> configurations() const { return m_configurations; }
+
+private slots:
+    void onCurrentRowChanged(int row);
+    void addConfiguration();
+    void removeConfiguration();
+    void browseTarget();
+    void browseWorkingDirectory();
+
+private:
+    void setupUI();
+    void applyGlassmorphicStyle();
+    void storeCurrent();
+    void setEditorsEnabled(bool enabled);
+
+    QVector<RunConfiguration> m_configurations;
+    QString m_buildDirectory;
+    int m_currentRow;
+
+    QListWidget *m_list;
+    QLineEdit *m_nameEdit;
+    QLineEdit *m_targetEdit;
+    QLineEdit *m_argumentsEdit;
+    QPlainTextEdit *m_environmentEdit;
+    QLineEdit *m_workingDirectoryEdit;
+    QPushButton *m_addButton;
+    QPushButton *m_removeButton;
+    QPushButton *m_browseTargetButton;
+    QPushButton *m_browseWorkingDirButton;
+};
+
+#endif // RUNCONFIGURATIONDIALOG_H
@@ -1,11 +1,12 @@
 #include "SettingsDialog.h"
-#include "Terminal.h"
+#include "ToolchainDiscovery.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QFontDatabase>
 #include <QStandardItemModel>
 #include <QStandardItem>
+#include <QSignalBlocker>
 
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent)
@@ -17,6 +18,11 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     setModal(true);
     setWindowTitle("QTCIDE Settings");
     setFixedSize(600, 500);
+
+    // Filled from the cache right away; a probe still running updates the lists when it is done
+    ToolchainDiscovery *discovery = ToolchainDiscovery::instance();
+    connect(discovery, &ToolchainDiscovery::ready, this, &SettingsDialog::onToolchainsReady);
+    discovery->start();
 }
 
 void SettingsDialog::setupUI()
@@ -155,6 +161,9 @@ void SettingsDialog::setupEditorTab()
     m_syntaxHighlightingCheck = new QCheckBox("Enable syntax highlighting");
     editorLayout->addRow("", m_syntaxHighlightingCheck);
     
+    m_restoreSessionCheck = new QCheckBox("Reopen the last project and its files on startup");
+    editorLayout->addRow("", m_restoreSessionCheck);
+    
     layout->addWidget(editorGroup);
     layout->addStretch();
     
@@ -199,6 +208,8 @@ void SettingsDialog::setupBuildTab()
     gitLayout->addWidget(m_browseGitButton);
     buildLayout->addRow("Git Path:", gitLayout);
     
+    showDetectedTools();
+    
     layout->addWidget(buildGroup);
     layout->addStretch();
     
@@ -221,11 +232,41 @@ void SettingsDialog::setupBuildTab()
     });
 }
 
+void SettingsDialog::showDetectedTools()
+{
+    // Show what was found on PATH when no explicit path is set
+    ToolchainDiscovery *discovery = ToolchainDiscovery::instance();
+    const QList<QPair<QLineEdit *, QString>> detectedTools = {
+        {m_cmakePathEdit, "cmake"}, {m_ninjaPathEdit, "ninja"}, {m_gitPathEdit, "git"}
+    };
+    for (const auto &entry : detectedTools) {
+        ToolInfo tool = discovery->tool(entry.second);
+        if (tool.isAvailable()) {
+            entry.first->setPlaceholderText(tool.path);
+            entry.first->setToolTip(tool.version);
+        }
+    }
+}
+
+void SettingsDialog::onToolchainsReady()
+{
+    const QString terminalType = m_terminalTypeCombo->currentData().toString();
+    {
+        const QSignalBlocker blocker(m_terminalTypeCombo);
+        populateTerminalTypes();
+        const int index = m_terminalTypeCombo->findData(terminalType);
+        if (index >= 0) {
+            m_terminalTypeCombo->setCurrentIndex(index);
+        }
+    }
+    onTerminalTypeChanged();
+    showDetectedTools();
+}
+
 void SettingsDialog::populateTerminalTypes()
 {
-    // Create a temporary terminal instance to detect available terminals
-    Terminal tempTerminal;
-    QStringList availableTerminals = tempTerminal.detectAvailableTerminals();
+    // From the discovery cache; onToolchainsReady fills the list again once a probe finishes
+    QStringList availableTerminals = ToolchainDiscovery::instance()->availableShells();
     
     m_terminalTypeCombo->clear();
     
@@ -239,15 +280,7 @@ void SettingsDialog::populateTerminalTypes()
     m_terminalTypeCombo->addItem("Custom Shell", "custom");
     
     // Add unavailable terminals as disabled items (for reference)
-    QStringList allPossibleTerminals;
-    
-#ifdef Q_OS_WIN
-    allPossibleTerminals << "cmd" << "powershell" << "pwsh" << "msys2" << "mingw64" << "gitbash";
-#elif defined(Q_OS_MACOS)
-    allPossibleTerminals << "zsh" << "bash" << "fish";
-#else
-    allPossibleTerminals << "bash" << "zsh" << "fish" << "dash";
-#endif
+    QStringList allPossibleTerminals = ToolchainDiscovery::shellCandidates();
     
     for (const QString &terminal : allPossibleTerminals) {
         if (!availableTerminals.contains(terminal)) {
@@ -320,6 +353,7 @@ void SettingsDialog::resetToDefaults()
     m_autoIndentCheck->setChecked(true);
     m_lineNumbersCheck->setChecked(true);
     m_syntaxHighlightingCheck->setChecked(true);
+    m_restoreSessionCheck->setChecked(true);
     
     // Build tools defaults
     m_cmakePathEdit->setText("cmake");
@@ -347,8 +381,7 @@ void SettingsDialog::loadSettings()
     
     // If no terminal type is saved, detect and use the first available
     if (terminalType.isEmpty()) {
-        Terminal tempTerminal;
-        QStringList available = tempTerminal.detectAvailableTerminals();
+        QStringList available = ToolchainDiscovery::instance()->availableShells();
         if (!available.isEmpty()) {
             terminalType = available.first();
             m_settings->setValue("Terminal/Type", terminalType);
@@ -375,6 +408,7 @@ void SettingsDialog::loadSettings()
     m_autoIndentCheck->setChecked(m_settings->value("Editor/AutoIndent", true).toBool());
     m_lineNumbersCheck->setChecked(m_settings->value("Editor/LineNumbers", true).toBool());
     m_syntaxHighlightingCheck->setChecked(m_settings->value("Editor/SyntaxHighlighting", true).toBool());
+    m_restoreSessionCheck->setChecked(m_settings->value("Editor/RestoreSession", true).toBool());
     
     // Build tools settings
     m_cmakePathEdit->setText(m_settings->value("BuildTools/CMakePath", "cmake").toString());
@@ -400,6 +434,7 @@ void SettingsDialog::saveSettings()
     m_settings->setValue("Editor/AutoIndent", m_autoIndentCheck->isChecked());
     m_settings->setValue("Editor/LineNumbers", m_lineNumbersCheck->isChecked());
     m_settings->setValue("Editor/SyntaxHighlighting", m_syntaxHighlightingCheck->isChecked());
+    m_settings->setValue("Editor/RestoreSession", m_restoreSessionCheck->isChecked());
     
     // Build tools settings
     m_settings->setValue("BuildTools/CMakePath", m_cmakePathEdit->text());
@@ -45,6 +45,7 @@ private slots:
     void browseShellPath();
     void resetToDefaults();
     void applySettings();
+    void onToolchainsReady();
 
 private:
     void setupUI();
@@ -55,6 +56,7 @@ private:
     void loadSettings();
     void saveSettings();
     void populateTerminalTypes();
+    void showDetectedTools();
     
     QString getTerminalDisplayName(const QString &terminalType);
     
@@ -75,6 +77,7 @@ private:
     QCheckBox *m_autoIndentCheck;
     QCheckBox *m_lineNumbersCheck;
     QCheckBox *m_syntaxHighlightingCheck;
+    QCheckBox *m_restoreSessionCheck;
     
     // Build settings
     QLineEdit *m_cmakePathEdit;
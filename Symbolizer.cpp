@@ -0,0 +1,185 @@
+#include "Symbolizer.h"
+#include <QProcess>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QStringList>
+#include <QtEndian>
+
+namespace {
+
+// ELF header and program header fields used by readModuleLayout
+const quint16 kElfExecutable = 2;   // ET_EXEC
+const quint32 kLoadSegment = 1;     // PT_LOAD
+
+template <typename T>
+T elfField(const QByteArray &data, qsizetype at)
+{
+    return qFromLittleEndian<T>(data.constData() + at);
+}
+
+} // namespace
+
+void Symbolizer::setMemoryMaps(const QByteArray &maps)
+{
+    // "start-end perms offset dev inode path"; only executable file mappings matter
+    m_mappings.clear();
+    for (const QByteArray &line : maps.split('\n')) {
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() < 6 || !fields.at(1).contains('x') || !fields.at(5).startsWith('/')) {
+            continue;
+        }
+
+        QList<QByteArray> range = fields.at(0).split('-');
+        if (range.size() != 2) {
+            continue;
+        }
+
+        MemoryMapping mapping;
+        mapping.start = range.at(0).toULongLong(nullptr, 16);
+        mapping.end = range.at(1).toULongLong(nullptr, 16);
+        mapping.offset = fields.at(2).toULongLong(nullptr, 16);
+        mapping.path = QString::fromUtf8(fields.at(5));
+        m_mappings << mapping;
+    }
+}
+
+bool Symbolizer::locate(quint64 address, QString *module, quint64 *offset) const
+{
+    for (const MemoryMapping &mapping : m_mappings) {
+        if (address >= mapping.start && address < mapping.end) {
+            *module = mapping.path;
+            *offset = address - mapping.start + mapping.offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+Symbolizer::ModuleLayout Symbolizer::readModuleLayout(const QString &path)
+{
+    ModuleLayout layout;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return layout;
+    }
+
+    // Little-endian ELF only, which covers every target the profilers run on
+    const QByteArray header = file.read(64);
+    if (header.size() < 52 || !header.startsWith("\x7f" "ELF") || header.at(5) != 1) {
+        return layout;
+    }
+    const bool is64 = header.at(4) == 2;
+    if (is64 && header.size() < 64) {
+        return layout;
+    }
+    layout.fixedAddress = elfField<quint16>(header, 16) == kElfExecutable;
+
+    const quint64 headerOffset = is64 ? elfField<quint64>(header, 32) : elfField<quint32>(header, 28);
+    const int entrySize = elfField<quint16>(header, is64 ? 54 : 42);
+    const int entryCount = elfField<quint16>(header, is64 ? 56 : 44);
+    if (entrySize < (is64 ? 56 : 32) || !file.seek(qint64(headerOffset))) {
+        return layout;
+    }
+    const QByteArray table = file.read(qint64(entrySize) * entryCount);
+    const int available = int(table.size() / entrySize);
+    for (int i = 0; i < available; ++i) {
+        const qsizetype entry = qsizetype(i) * entrySize;
+        if (elfField<quint32>(table, entry) != kLoadSegment) {
+            continue;
+        }
+        LoadSegment segment;
+        if (is64) {
+            segment.offset = elfField<quint64>(table, entry + 8);
+            segment.address = elfField<quint64>(table, entry + 16);
+            segment.size = elfField<quint64>(table, entry + 32);
+        } else {
+            segment.offset = elfField<quint32>(table, entry + 4);
+            segment.address = elfField<quint32>(table, entry + 8);
+            segment.size = elfField<quint32>(table, entry + 16);
+        }
+        layout.segments << segment;
+    }
+    return layout;
+}
+
+quint64 Symbolizer::linkAddress(const ModuleLayout &layout, quint64 address, quint64 fileOffset)
+{
+    // addr2line wants the address the module was linked for. A fixed-address executable
+    // runs there; a shared object or PIE is found through the segment holding the offset.
+    if (layout.fixedAddress) {
+        return address;
+    }
+    for (const LoadSegment &segment : layout.segments) {
+        if (fileOffset >= segment.offset && fileOffset - segment.offset < segment.size) {
+            return fileOffset - segment.offset + segment.address;
+        }
+    }
+    return fileOffset;
+}
+
+QHash<quint64, ProfileFrame> Symbolizer::symbolize(const QSet<quint64> &addresses) const
+{
+    // Group by module so each module needs a single addr2line run
+    QMap<QString, QVector<QPair<quint64, quint64>>> offsetsByModule;
+    QHash<quint64, ProfileFrame> frames;
+
+    for (quint64 address : addresses) {
+        QString module;
+        quint64 offset = 0;
+        if (locate(address, &module, &offset)) {
+            offsetsByModule[module].append(qMakePair(address, offset));
+        } else {
+            ProfileFrame frame;
+            frame.function = "0x" + QString::number(address, 16);
+            frames.insert(address, frame);
+        }
+    }
+
+    for (auto it = offsetsByModule.begin(); it != offsetsByModule.end(); ++it) {
+        QVector<QPair<quint64, quint64>> &entries = it.value();
+        const ModuleLayout layout = readModuleLayout(it.key());
+
+        // Addresses go through stdin, since a large profile would not fit on the command line
+        QByteArray input;
+        for (auto &entry : entries) {
+            entry.second = linkAddress(layout, entry.first, entry.second);
+            input += "0x" + QByteArray::number(entry.second, 16) + '\n';
+        }
+
+        QProcess addr2line;
+        addr2line.start("addr2line", QStringList() << "-C" << "-f" << "-e" << it.key());
+        QList<QByteArray> lines;
+        if (addr2line.waitForStarted()) {
+            addr2line.write(input);
+            addr2line.closeWriteChannel();
+            if (addr2line.waitForFinished(30000)) {
+                lines = addr2line.readAllStandardOutput().split('\n');
+            } else {
+                addr2line.kill();
+                addr2line.waitForFinished();
+            }
+        }
+
+        // Output is a function line followed by a file:line line per address
+        for (int i = 0; i < entries.size(); ++i) {
+            ProfileFrame frame;
+            if (2 * i + 1 < lines.size()) {
+                frame.function = QString::fromUtf8(lines.at(2 * i));
+                QByteArray location = lines.at(2 * i + 1);
+                int colon = location.lastIndexOf(':');
+                if (colon > 0 && !location.startsWith("??")) {
+                    frame.file = QString::fromUtf8(location.left(colon));
+                    frame.line = location.mid(colon + 1).split(' ').first().toInt();
+                }
+            }
+            if (frame.function.isEmpty() || frame.function == "??") {
+                frame.function = QString("[%1+0x%2]").arg(QFileInfo(it.key()).fileName())
+                                                     .arg(entries.at(i).second, 0, 16);
+            }
+            frames.insert(entries.at(i).first, frame);
+        }
+    }
+
+    return frames;
+}
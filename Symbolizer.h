@@ -0,0 +1,60 @@
+#ifndef SYMBOLIZER_H
+#define SYMBOLIZER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+struct ProfileFrame
+{
+    QString function;
+    QString file;
+    int line = 0;
+};
+
+// Maps runtime addresses of a (possibly exited) process to functions and source lines,
+// using a snapshot of its /proc/<pid>/maps and one addr2line run per module. Blocks on
+// addr2line, so callers run it on a worker thread.
+class Symbolizer
+{
+public:
+    void setMemoryMaps(const QByteArray &maps);
+    bool isEmpty() const { return m_mappings.isEmpty(); }
+
+    // Addresses must point inside the instruction (subtract 1 from return addresses)
+    QHash<quint64, ProfileFrame> symbolize(const QSet<quint64> &addresses) const;
+
+private:
+    struct MemoryMapping
+    {
+        quint64 start;
+        quint64 end;
+        quint64 offset;
+        QString path;
+    };
+
+    // PT_LOAD segments of an ELF module, to turn file offsets into link-time addresses
+    struct LoadSegment
+    {
+        quint64 offset;
+        quint64 size;
+        quint64 address;
+    };
+
+    struct ModuleLayout
+    {
+        bool fixedAddress = false;   // ET_EXEC: mapped at the addresses it was linked for
+        QVector<LoadSegment> segments;
+    };
+
+    static ModuleLayout readModuleLayout(const QString &path);
+    static quint64 linkAddress(const ModuleLayout &layout, quint64 address, quint64 fileOffset);
+
+    bool locate(quint64 address, QString *module, quint64 *offset) const;
+
+    QVector<MemoryMapping> m_mappings;
+};
+
+#endif // SYMBOLIZER_H
@@ -1,4 +1,6 @@
 #include "Terminal.h"
+#include "Instrumentation.h"
+#include "ToolchainDiscovery.h"
 #include <QDir>
 #include <QKeyEvent>
 #include <QScrollBar>
@@ -14,12 +16,14 @@ Terminal::Terminal(QWidget *parent)
     : QWidget(parent)
     , m_process(new QProcess(this))
     , m_currentDirectory(QDir::homePath())
+    , m_shellsDetected(false)
 {
     setupUI();
     applyTerminalStyle();
-    autoDetectTerminal();
-    loadTerminalSettings();
+    // Usable right away with the platform default; the detected shell and settings follow
+    m_shellType = fallbackShellType();
     initializeTerminal();
+    autoDetectTerminal();
     
     connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &Terminal::onProcessFinished);
@@ -113,6 +117,7 @@ void Terminal::clear()
 
 void Terminal::appendText(const QString &text)
 {
+    InstrumentationScope scope("Terminal::appendText");
     m_output->moveCursor(QTextCursor::End);
     m_output->insertPlainText(text);
     m_output->moveCursor(QTextCursor::End);
@@ -415,113 +420,63 @@ void Terminal::executeBuildCommand(const QString &command)
 
 void Terminal::autoDetectTerminal()
 {
-    m_availableTerminals = detectAvailableTerminals();
-    
-    if (m_availableTerminals.isEmpty()) {
-        // Fallback to system default
+    // Served from the shared discovery cache, or applied once the background probe finishes
+    ToolchainDiscovery *discovery = ToolchainDiscovery::instance();
+    connect(discovery, &ToolchainDiscovery::ready, this, [this, discovery]() {
+        onTerminalsDetected(discovery->availableShells());
+    });
+    discovery->start();
+    if (discovery->isReady()) {
+        onTerminalsDetected(discovery->availableShells());
+    }
+}
+
+QString Terminal::fallbackShellType()
+{
 #ifdef Q_OS_WIN
-        m_shellType = "cmd";
+    return "cmd";
 #elif defined(Q_OS_MACOS)
-        m_shellType = "zsh";
+    return "zsh";
 #else
-        m_shellType = "bash";
+    return "bash";
 #endif
-    } else {
-        // Use the first available terminal as default
-        m_shellType = m_availableTerminals.first();
+}
+
+void Terminal::onTerminalsDetected(const QStringList &terminals)
+{
+    // The ready signal may still arrive after the cache already answered
+    if (m_shellsDetected) {
+        return;
     }
+    m_shellsDetected = true;
+    m_availableTerminals = terminals;
+    
+    // Use the first available terminal as default
+    m_shellType = m_availableTerminals.isEmpty() ? fallbackShellType() : m_availableTerminals.first();
     
     appendText(QString("Auto-detected terminal: %1\n").arg(m_shellType));
     appendText(QString("Available terminals: %1\n\n").arg(m_availableTerminals.join(", ")));
+    
+    loadTerminalSettings();
+    updatePrompt();
 }
 
 QStringList Terminal::detectAvailableTerminals()
 {
-    QStringList available;
-    
-#ifdef Q_OS_WIN
-    QStringList candidates = {"cmd", "powershell", "pwsh", "msys2", "mingw64", "gitbash"};
-    
-    for (const QString &terminal : candidates) {
-        if (isTerminalAvailable(terminal)) {
-            available << terminal;
-        }
-    }
-#elif defined(Q_OS_MACOS)
-    QStringList candidates = {"zsh", "bash", "fish"};
-    
-    for (const QString &terminal : candidates) {
-        if (isTerminalAvailable(terminal)) {
-            available << terminal;
-        }
-    }
-#else // Linux
-    QStringList candidates = {"bash", "zsh", "fish", "dash"};
-    
-    for (const QString &terminal : candidates) {
-        if (isTerminalAvailable(terminal)) {
-            available << terminal;
-        }
-    }
-#endif
-    
-    return available;
+    // Whatever is known now; autoDetectTerminal follows the ready signal instead
+    ToolchainDiscovery *discovery = ToolchainDiscovery::instance();
+    discovery->start();
+    return discovery->availableShells();
 }
 
 bool Terminal::isTerminalAvailable(const QString &terminalType)
 {
-    QString executablePath = getTerminalExecutablePath(terminalType);
-    
-    if (executablePath.isEmpty()) {
-        return false;
-    }
-    
-    QFileInfo fileInfo(executablePath);
-    return fileInfo.exists() && fileInfo.isExecutable();
+    return !getTerminalExecutablePath(terminalType).isEmpty();
 }
 
-QString Terminal::getTerminalExecutablePath(const QString &terminalType) const
+QString Terminal::getTerminalExecutablePath(const QString &terminalType)
 {
-#ifdef Q_OS_WIN
-    if (terminalType == "cmd") {
-        return QStandardPaths::findExecutable("cmd");
-    } else if (terminalType == "powershell") {
-        return QStandardPaths::findExecutable("powershell");
-    } else if (terminalType == "pwsh") {
-        return QStandardPaths::findExecutable("pwsh");
-    } else if (terminalType == "msys2") {
-        QStringList paths = {"C:/msys64/usr/bin/bash.exe", "C:/msys64/usr/bin/bash"};
-        for (const QString &path : paths) {
-            if (QFileInfo::exists(path)) return path;
-        }
-    } else if (terminalType == "mingw64") {
-        QStringList paths = {"C:/msys64/mingw64/bin/bash.exe", "C:/msys64/mingw64/bin/bash"};
-        for (const QString &path : paths) {
-            if (QFileInfo::exists(path)) return path;
-        }
-    } else if (terminalType == "gitbash") {
-        QStringList paths = {
-            "C:/Program Files/Git/bin/bash.exe",
-            "C:/Program Files (x86)/Git/bin/bash.exe",
-            "C:/Git/bin/bash.exe"
-        };
-        for (const QString &path : paths) {
-            if (QFileInfo::exists(path)) return path;
-        }
-    }
-#else
-    if (terminalType == "bash") {
-        return QStandardPaths::findExecutable("bash");
-    } else if (terminalType == "zsh") {
-        return QStandardPaths::findExecutable("zsh");
-    } else if (terminalType == "fish") {
-        return QStandardPaths::findExecutable("fish");
-    } else if (terminalType == "dash") {
-        return QStandardPaths::findExecutable("dash");
-    }
-#endif
-    
-    return QString();
+    return ToolchainDiscovery::instance()->shellPath(terminalType);
 }
 
 QString Terminal::getTerminalDisplayName() const
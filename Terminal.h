@@ -26,8 +26,8 @@ public:
     QString currentDirectory() const { return m_currentDirectory; }
     void loadTerminalSettings();
     void applyTerminalSettings();
-    QStringList detectAvailableTerminals();
-    bool isTerminalAvailable(const QString &terminalType);
+    static QStringList detectAvailableTerminals();
+    static bool isTerminalAvailable(const QString &terminalType);
     QString getCurrentShellType() const { return m_shellType; }
     QString getShellExecutable() const;
 
@@ -46,7 +46,9 @@ private:
     void applyTerminalStyle();
     void updatePrompt();
     void autoDetectTerminal();
-    QString getTerminalExecutablePath(const QString &terminalType) const;
+    void onTerminalsDetected(const QStringList &terminals);
+    static QString fallbackShellType();
+    static QString getTerminalExecutablePath(const QString &terminalType);
     void initializeTerminal();
     void switchToTerminal(const QString &terminalType);
     QString getTerminalDisplayName() const;
@@ -74,6 +76,7 @@ private:
     QString m_shellType;
     QString m_customShellPath;
     QStringList m_availableTerminals;
+    bool m_shellsDetected;
 };
 
 #endif // TERMINAL_H
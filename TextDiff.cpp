@@ -0,0 +1,175 @@
+#include "TextDiff.h"
+#include <QHash>
+#include <algorithm>
+
+namespace {
+
+struct Line
+{
+    qsizetype offset;
+    qsizetype length;   // including the '\n'
+};
+
+QVector<Line> splitLines(const QString &text)
+{
+    QVector<Line> lines;
+    qsizetype start = 0;
+    while (start < text.size()) {
+        const qsizetype newline = text.indexOf(u'\n', start);
+        const qsizetype end = newline < 0 ? text.size() : newline + 1;
+        lines.append({start, end - start});
+        start = end;
+    }
+    return lines;
+}
+
+enum Operation : char { Equal, Delete, Insert };
+
+// Myers' greedy algorithm; fills ops front to back, or returns false past maxDistance
+template<typename Equals>
+bool shortestEditScript(int n, int m, Equals equals, int maxDistance, QVector<char> *ops)
+{
+    const int max = std::min(n + m, maxDistance);
+    QVector<int> v(2 * max + 3, 0);
+    auto V = [&v, max](int k) -> int & { return v[k + max + 1]; };
+
+    // trace[d] holds V for diagonals -d..d as it was before round d
+    QVector<QVector<int>> trace;
+    int distance = -1;
+    for (int d = 0; d <= max && distance < 0; ++d) {
+        trace.append(QVector<int>(v.cbegin() + (max + 1 - d), v.cbegin() + (max + 2 + d)));
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && V(k - 1) < V(k + 1))) ? V(k + 1) : V(k - 1) + 1;
+            int y = x - k;
+            while (x < n && y < m && equals(x, y)) {
+                ++x;
+                ++y;
+            }
+            V(k) = x;
+            if (x >= n && y >= m) {
+                distance = d;
+                break;
+            }
+        }
+    }
+    if (distance < 0) {
+        return false;
+    }
+
+    QVector<char> reversed;
+    int x = n;
+    int y = m;
+    for (int d = distance; d > 0; --d) {
+        const QVector<int> &previous = trace.at(d);
+        auto P = [&previous, d](int k) { return previous.at(k + d); };
+        const int k = x - y;
+        const int previousK = (k == -d || (k != d && P(k - 1) < P(k + 1))) ? k + 1 : k - 1;
+        const int previousX = P(previousK);
+        const int previousY = previousX - previousK;
+        while (x > previousX && y > previousY) {
+            reversed.append(Equal);
+            --x;
+            --y;
+        }
+        reversed.append(previousK == k + 1 ? Insert : Delete);
+        x = previousX;
+        y = previousY;
+    }
+    while (x > 0 && y > 0) {
+        reversed.append(Equal);
+        --x;
+        --y;
+    }
+    std::reverse(reversed.begin(), reversed.end());
+    *ops = reversed;
+    return true;
+}
+
+// Keeps only the characters between the common head and tail of the old and new text
+void appendEdit(QVector<TextReplacement> *edits, const QString &before, qsizetype position,
+                qsizetype length, const QString &text)
+{
+    const qsizetype limit = std::min(length, text.size());
+    qsizetype head = 0;
+    while (head < limit && before.at(position + head) == text.at(head)) {
+        ++head;
+    }
+    qsizetype tail = 0;
+    while (tail < limit - head && before.at(position + length - 1 - tail) == text.at(text.size() - 1 - tail)) {
+        ++tail;
+    }
+    if (length - head - tail == 0 && text.size() - head - tail == 0) {
+        return;
+    }
+    edits->append({position + head, length - head - tail, text.mid(head, text.size() - head - tail)});
+}
+
+} // namespace
+
+QVector<TextReplacement> TextDiff::lineEdits(const QString &before, const QString &after, int maxDistance)
+{
+    QVector<TextReplacement> edits;
+    if (before == after) {
+        return edits;
+    }
+
+    const QVector<Line> a = splitLines(before);
+    const QVector<Line> b = splitLines(after);
+    auto lineA = [&](int i) { return QStringView(before).mid(a[i].offset, a[i].length); };
+    auto lineB = [&](int j) { return QStringView(after).mid(b[j].offset, b[j].length); };
+
+    int prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && lineA(prefix) == lineB(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix
+           && lineA(a.size() - 1 - suffix) == lineB(b.size() - 1 - suffix)) {
+        ++suffix;
+    }
+    const int n = a.size() - prefix - suffix;
+    const int m = b.size() - prefix - suffix;
+
+    // Hashes make the inner loop cheap; equal hashes are confirmed on the text
+    QVector<size_t> hashA(n);
+    QVector<size_t> hashB(m);
+    for (int i = 0; i < n; ++i) {
+        hashA[i] = qHash(lineA(prefix + i));
+    }
+    for (int j = 0; j < m; ++j) {
+        hashB[j] = qHash(lineB(prefix + j));
+    }
+    auto equals = [&](int i, int j) {
+        return hashA[i] == hashB[j] && lineA(prefix + i) == lineB(prefix + j);
+    };
+
+    QVector<char> ops;
+    if (!shortestEditScript(n, m, equals, maxDistance, &ops)) {
+        ops = QVector<char>(n, Delete) + QVector<char>(m, Insert);
+    }
+
+    int i = prefix;
+    int j = prefix;
+    qsizetype position = prefix < a.size() ? a[prefix].offset : before.size();
+    for (int op = 0; op < ops.size();) {
+        if (ops[op] == Equal) {
+            position += a[i].length;
+            ++i;
+            ++j;
+            ++op;
+            continue;
+        }
+        qsizetype removed = 0;
+        QString inserted;
+        for (; op < ops.size() && ops[op] != Equal; ++op) {
+            if (ops[op] == Delete) {
+                removed += a[i++].length;
+            } else {
+                inserted += lineB(j++);
+            }
+        }
+        appendEdit(&edits, before, position, removed, inserted);
+        position += removed;
+    }
+    return edits;
+}
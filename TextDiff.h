@@ -0,0 +1,30 @@
+#ifndef TEXTDIFF_H
+#define TEXTDIFF_H
+
+#include <QString>
+#include <QVector>
+
+// Replace length characters at position with text; positions refer to the original text
+struct TextReplacement
+{
+    qsizetype position;
+    qsizetype length;
+    QString text;
+};
+
+// Turns one version of a document into another with as few and as small edits as practical,
+// so applying them to a QTextDocument keeps the undo history, cursors and the highlighting of
+// every untouched block. Lines are compared with Myers' O(ND) algorithm after stripping the
+// common head and tail; when more than maxDistance lines differ the rest of the middle is
+// replaced as one edit. Each edit is trimmed to the characters that really changed.
+class TextDiff
+{
+public:
+    static constexpr int kDefaultMaxDistance = 1000;
+
+    // Sorted by position and non-overlapping; apply from the last to the first
+    static QVector<TextReplacement> lineEdits(const QString &before, const QString &after,
+                                              int maxDistance = kDefaultMaxDistance);
+};
+
+#endif // TEXTDIFF_H
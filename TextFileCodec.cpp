@@ -0,0 +1,254 @@
+#include "TextFileCodec.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QStringDecoder>
+#include <QStringEncoder>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 kHighBits = 0x8080808080808080ULL;
+
+// Word at a time, four words per step so the compiler can keep it in vector registers;
+// stops at the first block that has a byte above 0x7f
+bool isAscii(const char *data, qsizetype size)
+{
+    qsizetype i = 0;
+    for (; i + 32 <= size; i += 32) {
+        quint64 words[4];
+        std::memcpy(words, data + i, sizeof(words));
+        if ((words[0] | words[1] | words[2] | words[3]) & kHighBits) {
+            return false;
+        }
+    }
+    for (; i < size; ++i) {
+        if (static_cast<uchar>(data[i]) & 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Files without a byte order mark: text in UTF-16 has a zero in almost every other byte,
+// which UTF-8 and Latin-1 text never has
+TextFormat::Encoding sniffEncoding(const char *data, qsizetype size)
+{
+    const qsizetype sample = std::min<qsizetype>(size, 4096) & ~qsizetype(1);
+    if (sample < 4) {
+        return TextFormat::Utf8;
+    }
+    qsizetype evenZeros = 0;
+    qsizetype oddZeros = 0;
+    for (qsizetype i = 0; i < sample; i += 2) {
+        evenZeros += data[i] == 0;
+        oddZeros += data[i + 1] == 0;
+    }
+    const qsizetype pairs = sample / 2;
+    if (oddZeros > pairs / 4 && evenZeros <= pairs / 64) {
+        return TextFormat::Utf16LE;
+    }
+    if (evenZeros > pairs / 4 && oddZeros <= pairs / 64) {
+        return TextFormat::Utf16BE;
+    }
+    return TextFormat::Utf8;
+}
+
+// Compacts in place from the first '\r': "\r\n" and a lone '\r' both become '\n'.
+// Returns the style most lines used, so a mixed file is saved in its dominant style.
+TextFormat::LineEnding normalizeLineEndings(QString &text, qsizetype firstCarriageReturn)
+{
+    QChar *data = text.data();
+    const qsizetype size = text.size();
+    qsizetype lf = std::count(data, data + firstCarriageReturn, u'\n');
+    qsizetype crlf = 0;
+    qsizetype cr = 0;
+    qsizetype out = firstCarriageReturn;
+    for (qsizetype i = firstCarriageReturn; i < size; ++i) {
+        QChar c = data[i];
+        if (c == u'\r') {
+            if (i + 1 < size && data[i + 1] == u'\n') {
+                ++i;
+                ++crlf;
+            } else {
+                ++cr;
+            }
+            c = u'\n';
+        } else if (c == u'\n') {
+            ++lf;
+        }
+        data[out++] = c;
+    }
+    text.truncate(out);
+
+    if (crlf >= lf && crlf >= cr) {
+        return TextFormat::CRLF;
+    }
+    return cr > lf ? TextFormat::CR : TextFormat::LF;
+}
+
+} // namespace
+
+QString TextFormat::description() const
+{
+    QString text;
+    switch (encoding) {
+    case Utf8: text = "UTF-8"; break;
+    case Utf16LE: text = "UTF-16 LE"; break;
+    case Utf16BE: text = "UTF-16 BE"; break;
+    case Latin1: text = "Latin-1"; break;
+    }
+    if (byteOrderMark) {
+        text += " BOM";
+    }
+    if (lineEnding == CRLF) {
+        text += ", CRLF";
+    } else if (lineEnding == CR) {
+        text += ", CR";
+    }
+    return text;
+}
+
+bool TextFileCodec::load(const QString &filePath, QString *text, TextFormat *format, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    // Decode straight from the page cache; pipes, empty and special files are read instead
+    QByteArray buffer;
+    QByteArrayView data;
+    uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+    if (mapped) {
+        data = QByteArrayView(mapped, file.size());
+    } else {
+        buffer = file.readAll();
+        if (file.error() != QFileDevice::NoError) {
+            if (error) {
+                *error = file.errorString();
+            }
+            return false;
+        }
+        data = buffer;
+    }
+
+    *text = decode(data, format);
+    if (mapped) {
+        file.unmap(mapped);
+    }
+    return true;
+}
+
+QString TextFileCodec::decode(QByteArrayView data, TextFormat *format)
+{
+    TextFormat detected;
+    const char *bytes = data.data();
+    qsizetype size = data.size();
+
+    if (size >= 3 && std::memcmp(bytes, "\xEF\xBB\xBF", 3) == 0) {
+        detected.byteOrderMark = true;
+        bytes += 3;
+        size -= 3;
+    } else if (size >= 2 && std::memcmp(bytes, "\xFF\xFE", 2) == 0) {
+        detected.encoding = TextFormat::Utf16LE;
+        detected.byteOrderMark = true;
+        bytes += 2;
+        size -= 2;
+    } else if (size >= 2 && std::memcmp(bytes, "\xFE\xFF", 2) == 0) {
+        detected.encoding = TextFormat::Utf16BE;
+        detected.byteOrderMark = true;
+        bytes += 2;
+        size -= 2;
+    } else {
+        detected.encoding = sniffEncoding(bytes, size);
+    }
+
+    QString text;
+    if (detected.encoding == TextFormat::Utf8) {
+        if (isAscii(bytes, size)) {
+            text = QString::fromLatin1(bytes, size);
+        } else {
+            QStringDecoder decoder(QStringDecoder::Utf8);
+            text = decoder.decode(QByteArrayView(bytes, size));
+            if (decoder.hasError()) {
+                // Not UTF-8 after all; Latin-1 maps every byte, so saving writes the same bytes back
+                detected.encoding = TextFormat::Latin1;
+                detected.byteOrderMark = false;
+                text = QString::fromLatin1(data.data(), data.size());
+            }
+        }
+    } else {
+        const auto encoding = detected.encoding == TextFormat::Utf16LE ? QStringDecoder::Utf16LE
+                                                                        : QStringDecoder::Utf16BE;
+        QStringDecoder decoder(encoding);
+        text = decoder.decode(QByteArrayView(bytes, size));
+    }
+
+    // Most files have no '\r' at all, which memchr over the raw bytes settles without a copy
+    const bool byteEncoded = detected.encoding == TextFormat::Utf8 || detected.encoding == TextFormat::Latin1;
+    if (!byteEncoded || std::memchr(bytes, '\r', size)) {
+        const qsizetype cr = text.indexOf(u'\r');
+        if (cr >= 0) {
+            detected.lineEnding = normalizeLineEndings(text, cr);
+        }
+    }
+
+    if (format) {
+        *format = detected;
+    }
+    return text;
+}
+
+QByteArray TextFileCodec::encode(const QString &text, TextFormat *format)
+{
+    QString converted;
+    const QString *source = &text;
+    if (format->lineEnding == TextFormat::CRLF) {
+        converted = text;
+        converted.replace(QChar(u'\n'), QStringLiteral("\r\n"));
+        source = &converted;
+    } else if (format->lineEnding == TextFormat::CR) {
+        converted = text;
+        converted.replace(u'\n', u'\r');
+        source = &converted;
+    }
+
+    if (format->encoding == TextFormat::Latin1) {
+        const bool fits = std::all_of(source->cbegin(), source->cend(),
+                                      [](QChar c) { return c.unicode() <= 0xff; });
+        if (fits) {
+            return source->toLatin1();
+        }
+        format->encoding = TextFormat::Utf8;
+    }
+
+    QStringConverter::Encoding encoding = QStringConverter::Utf8;
+    if (format->encoding == TextFormat::Utf16LE) {
+        encoding = QStringConverter::Utf16LE;
+    } else if (format->encoding == TextFormat::Utf16BE) {
+        encoding = QStringConverter::Utf16BE;
+    }
+    QStringEncoder encoder(encoding, format->byteOrderMark ? QStringConverter::Flag::WriteBom
+                                                           : QStringConverter::Flag::Default);
+    return encoder.encode(*source);
+}
+
+bool TextFileCodec::save(const QString &filePath, const QString &text, TextFormat *format, QString *error)
+{
+    // QSaveFile writes a temporary file, syncs it and renames it over the original on commit,
+    // so a crash or a full disk leaves the old contents in place
+    const QByteArray bytes = encode(text, format);
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        file.cancelWriting();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef TEXTFILECODEC_H
+#define TEXTFILECODEC_H
+
+#include <QString>
+#include <QByteArray>
+#include <QByteArrayView>
+
+// How a file was stored on disk; the editor always works with '\n' line ends
+struct TextFormat
+{
+    enum Encoding { Utf8, Utf16LE, Utf16BE, Latin1 };
+    enum LineEnding { LF, CRLF, CR };
+
+    Encoding encoding = Utf8;
+    bool byteOrderMark = false;
+    LineEnding lineEnding = LF;
+
+    QString description() const;   // e.g. "UTF-8 BOM, CRLF"
+};
+
+// Loads and saves editor documents without going through QTextStream. Input is memory
+// mapped, pure ASCII is widened directly and everything else is decoded in a single pass;
+// UTF-8 that does not validate is kept byte for byte as Latin-1. Line endings are
+// normalized to '\n' only when the file contains a '\r' at all, and both encoding and
+// line ending style are written back unchanged on save; a file that mixes styles is
+// written back in the one most of its lines used.
+class TextFileCodec
+{
+public:
+    static bool load(const QString &filePath, QString *text, TextFormat *format, QString *error = nullptr);
+    static QString decode(QByteArrayView data, TextFormat *format);
+
+    // A Latin-1 document that gained characters outside Latin-1 is switched to UTF-8
+    static QByteArray encode(const QString &text, TextFormat *format);
+    static bool save(const QString &filePath, const QString &text, TextFormat *format, QString *error = nullptr);
+};
+
+#endif // TEXTFILECODEC_H
@@ -0,0 +1,370 @@
+#include "ToolchainDiscovery.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+namespace {
+const int kCacheVersion = 1;
+
+qint64 modificationTime(const QString &path)
+{
+    QFileInfo info(path);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+}
+
+QString toolVersion(const QString &path)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(path, {"--version"});
+    if (!process.waitForFinished(3000)) {
+        process.kill();
+        process.waitForFinished(1000);
+        return QString();
+    }
+    const QStringList lines = QString::fromLocal8Bit(process.readAll()).split('\n', Qt::SkipEmptyParts);
+    return lines.isEmpty() ? QString() : lines.first().trimmed();
+}
+
+QJsonArray toJson(const QList<ToolInfo> &tools)
+{
+    QJsonArray array;
+    for (const ToolInfo &tool : tools) {
+        QJsonObject object;
+        object["name"] = tool.name;
+        object["path"] = tool.path;
+        object["version"] = tool.version;
+        object["modified"] = tool.modified;
+        array.append(object);
+    }
+    return array;
+}
+
+QList<ToolInfo> fromJson(const QJsonArray &array)
+{
+    QList<ToolInfo> tools;
+    for (const QJsonValue &value : array) {
+        QJsonObject object = value.toObject();
+        ToolInfo tool;
+        tool.name = object["name"].toString();
+        tool.path = object["path"].toString();
+        tool.version = object["version"].toString();
+        tool.modified = qint64(object["modified"].toDouble());
+        tools << tool;
+    }
+    return tools;
+}
+}
+
+ToolchainDiscovery::ToolchainDiscovery(QObject *parent)
+    : QObject(parent)
+    , m_probeThread(nullptr)
+    , m_started(false)
+    , m_ready(false)
+{
+}
+
+ToolchainDiscovery::~ToolchainDiscovery()
+{
+    // Quitting mid-probe: the probe stops after the tool it is running and never touches this
+    if (m_probeThread) {
+        m_probeThread->requestInterruption();
+        m_probeThread->wait();
+        delete m_probeThread;
+    }
+}
+
+ToolchainDiscovery *ToolchainDiscovery::instance()
+{
+    static ToolchainDiscovery *discovery = new ToolchainDiscovery(QCoreApplication::instance());
+    return discovery;
+}
+
+QStringList ToolchainDiscovery::shellCandidates()
+{
+#ifdef Q_OS_WIN
+    return {"cmd", "powershell", "pwsh", "msys2", "mingw64", "gitbash"};
+#elif defined(Q_OS_MACOS)
+    return {"zsh", "bash", "fish"};
+#else
+    return {"bash", "zsh", "fish", "dash"};
+#endif
+}
+
+QStringList ToolchainDiscovery::toolCandidates()
+{
+    QStringList tools = {"cmake", "ninja", "make", "git", "gcc", "g++", "clang", "clang++", "gdb"};
+#ifdef Q_OS_WIN
+    tools << "cl";
+#endif
+    return tools;
+}
+
+QString ToolchainDiscovery::locateShell(const QString &shellType)
+{
+#ifdef Q_OS_WIN
+    QStringList paths;
+    if (shellType == "msys2") {
+        paths = {"C:/msys64/usr/bin/bash.exe", "C:/msys64/usr/bin/bash"};
+    } else if (shellType == "mingw64") {
+        paths = {"C:/msys64/mingw64/bin/bash.exe", "C:/msys64/mingw64/bin/bash"};
+    } else if (shellType == "gitbash") {
+        paths = {
+            "C:/Program Files/Git/bin/bash.exe",
+            "C:/Program Files (x86)/Git/bin/bash.exe",
+            "C:/Git/bin/bash.exe"
+        };
+    } else if (shellType == "cmd" || shellType == "powershell" || shellType == "pwsh") {
+        return QStandardPaths::findExecutable(shellType);
+    }
+    for (const QString &path : paths) {
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    return QString();
+#else
+    if (!shellCandidates().contains(shellType)) {
+        return QString();
+    }
+    return QStandardPaths::findExecutable(shellType);
+#endif
+}
+
+QString ToolchainDiscovery::cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppCacheLocation) + "/toolchains.json";
+}
+
+ToolchainDiscovery::Snapshot ToolchainDiscovery::probe()
+{
+    Snapshot snapshot;
+    snapshot.pathVariable = qEnvironmentVariable("PATH");
+    for (const QString &directory : snapshot.pathVariable.split(QDir::listSeparator(), Qt::SkipEmptyParts)) {
+        snapshot.pathDirectories.insert(directory, modificationTime(directory));
+    }
+
+    for (const QString &shellType : shellCandidates()) {
+        ToolInfo shell;
+        shell.name = shellType;
+        QString path = locateShell(shellType);
+        if (!path.isEmpty() && QFileInfo(path).isExecutable()) {
+            shell.path = path;
+            shell.modified = modificationTime(path);
+        }
+        snapshot.shells << shell;
+    }
+
+    for (const QString &name : toolCandidates()) {
+        if (QThread::currentThread()->isInterruptionRequested()) {
+            break;
+        }
+        ToolInfo tool;
+        tool.name = name;
+        tool.path = QStandardPaths::findExecutable(name);
+        if (tool.isAvailable()) {
+            tool.modified = modificationTime(tool.path);
+            // cl prints its banner on stderr and rejects --version
+            if (name != "cl") {
+                tool.version = toolVersion(tool.path);
+            }
+        }
+        snapshot.tools << tool;
+    }
+    return snapshot;
+}
+
+bool ToolchainDiscovery::loadCache(Snapshot *snapshot)
+{
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["version"].toInt() != kCacheVersion) {
+        return false;
+    }
+
+    snapshot->pathVariable = root["path"].toString();
+    QJsonObject directories = root["pathDirectories"].toObject();
+    for (auto it = directories.constBegin(); it != directories.constEnd(); ++it) {
+        snapshot->pathDirectories.insert(it.key(), qint64(it.value().toDouble()));
+    }
+    snapshot->shells = fromJson(root["shells"].toArray());
+    snapshot->tools = fromJson(root["tools"].toArray());
+    return true;
+}
+
+void ToolchainDiscovery::saveCache(const Snapshot &snapshot)
+{
+    QJsonObject directories;
+    for (auto it = snapshot.pathDirectories.constBegin(); it != snapshot.pathDirectories.constEnd(); ++it) {
+        directories[it.key()] = double(it.value());
+    }
+    QJsonObject root;
+    root["version"] = kCacheVersion;
+    root["path"] = snapshot.pathVariable;
+    root["pathDirectories"] = directories;
+    root["shells"] = toJson(snapshot.shells);
+    root["tools"] = toJson(snapshot.tools);
+
+    QDir().mkpath(QFileInfo(cacheFile()).absolutePath());
+    QFile file(cacheFile());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    }
+}
+
+bool ToolchainDiscovery::isCurrent(const Snapshot &snapshot)
+{
+    // A changed PATH, a tool installed into a PATH directory or an upgraded tool all invalidate
+    if (snapshot.pathVariable != qEnvironmentVariable("PATH")) {
+        return false;
+    }
+    for (auto it = snapshot.pathDirectories.constBegin(); it != snapshot.pathDirectories.constEnd(); ++it) {
+        if (modificationTime(it.key()) != it.value()) {
+            return false;
+        }
+    }
+    for (const QList<ToolInfo> *list : {&snapshot.shells, &snapshot.tools}) {
+        for (const ToolInfo &tool : *list) {
+            if (tool.isAvailable() && modificationTime(tool.path) != tool.modified) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ToolchainDiscovery::start()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_started) {
+            return;
+        }
+        m_started = true;
+    }
+
+    Snapshot cached;
+    if (loadCache(&cached)) {
+        if (isCurrent(cached)) {
+            setSnapshot(cached);
+            return;
+        }
+        // Most of an outdated cache is usually still right; it answers until the probe is done
+        QMutexLocker locker(&m_mutex);
+        m_snapshot = cached;
+    }
+    startProbe();
+}
+
+void ToolchainDiscovery::startProbe()
+{
+    // A refresh can come right after the previous probe published its results but before its
+    // thread ended
+    if (m_probeThread) {
+        m_probeThread->wait();
+    }
+    QThread *thread = QThread::create([this]() {
+        Snapshot snapshot = probe();
+        if (QThread::currentThread()->isInterruptionRequested()) {
+            return;
+        }
+        saveCache(snapshot);
+        setSnapshot(snapshot);
+    });
+    m_probeThread = thread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_probeThread == thread) {
+            m_probeThread = nullptr;
+        }
+        thread->deleteLater();
+    });
+    thread->start();
+}
+
+void ToolchainDiscovery::refresh()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_started && !m_ready) {
+            return;   // a probe is already running
+        }
+        m_started = true;
+        m_ready = false;
+    }
+    QFile::remove(cacheFile());
+    startProbe();
+}
+
+void ToolchainDiscovery::setSnapshot(const Snapshot &snapshot)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_snapshot = snapshot;
+        m_ready = true;
+    }
+    // Delivered on the GUI thread to receivers living there
+    emit ready();
+}
+
+bool ToolchainDiscovery::isReady() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ready;
+}
+
+QStringList ToolchainDiscovery::availableShells() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList shells;
+    for (const ToolInfo &shell : m_snapshot.shells) {
+        if (shell.isAvailable()) {
+            shells << shell.name;
+        }
+    }
+    return shells;
+}
+
+QString ToolchainDiscovery::shellPath(const QString &shellType) const
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const ToolInfo &shell : m_snapshot.shells) {
+            if (shell.name == shellType && shell.isAvailable()) {
+                return shell.path;
+            }
+        }
+        if (m_ready) {
+            return QString();
+        }
+    }
+    // Not probed yet; answer directly rather than block
+    return locateShell(shellType);
+}
+
+ToolInfo ToolchainDiscovery::tool(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (const ToolInfo &tool : m_snapshot.tools) {
+        if (tool.name == name) {
+            return tool;
+        }
+    }
+    return ToolInfo();
+}
+
+QList<ToolInfo> ToolchainDiscovery::tools() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot.tools;
+}
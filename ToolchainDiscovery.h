@@ -0,0 +1,78 @@
+#ifndef TOOLCHAINDISCOVERY_H
+#define TOOLCHAINDISCOVERY_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QStringList>
+
+class QThread;
+
+struct ToolInfo
+{
+    QString name;      // "cmake", "bash", ...
+    QString path;      // absolute path, empty when not found
+    QString version;   // first line of --version, shells and cl excepted
+    qint64 modified = 0;
+
+    bool isAvailable() const { return !path.isEmpty(); }
+};
+
+// Process-wide cache of the shells, build tools and compilers installed on this machine.
+// Probing happens once on a worker thread; results are persisted in AppCacheLocation and
+// reused on later starts while PATH and the tools' modification times are unchanged. An
+// outdated cache still answers queries until the new probe emits ready(), so callers never wait.
+class ToolchainDiscovery : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ToolchainDiscovery *instance();
+    ~ToolchainDiscovery() override;
+
+    // Loads the cache or starts probing in the background; called once at startup
+    void start();
+    bool isReady() const;
+    // Throws away the cache and probes again, e.g. after installing a compiler
+    void refresh();
+
+    QStringList availableShells() const;
+    QString shellPath(const QString &shellType) const;
+    ToolInfo tool(const QString &name) const;
+    QList<ToolInfo> tools() const;
+
+    static QStringList shellCandidates();
+    static QStringList toolCandidates();
+    static QString locateShell(const QString &shellType);
+
+signals:
+    void ready();
+
+private:
+    explicit ToolchainDiscovery(QObject *parent = nullptr);
+
+    struct Snapshot
+    {
+        QString pathVariable;
+        QHash<QString, qint64> pathDirectories;   // PATH entry -> mtime
+        QList<ToolInfo> shells;
+        QList<ToolInfo> tools;
+    };
+
+    static Snapshot probe();
+    static QString cacheFile();
+    static bool loadCache(Snapshot *snapshot);
+    static void saveCache(const Snapshot &snapshot);
+    static bool isCurrent(const Snapshot &snapshot);
+    void startProbe();
+    void setSnapshot(const Snapshot &snapshot);
+
+    QThread *m_probeThread;   // GUI thread only
+
+    mutable QMutex m_mutex;
+    bool m_started;
+    bool m_ready;
+    Snapshot m_snapshot;
+};
+
+#endif // TOOLCHAINDISCOVERY_H
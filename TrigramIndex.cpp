@@ -0,0 +1,430 @@
+#include "TrigramIndex.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr quint32 kCacheMagic = 0x51545249;   // "QTRI"
+constexpr quint32 kCacheVersion = 1;
+constexpr quint32 kNoFile = 0xffffffffu;
+
+quint32 foldByte(uchar c)
+{
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+qint64 modificationTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+}
+
+TrigramIndex::TrigramIndex(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+    , m_ready(false)
+    , m_worker(new QObject)
+    , m_deadCount(0)
+{
+    m_workerThread.setObjectName("TrigramIndex");
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    close();
+    // Let the queued save finish before the worker's event loop stops
+    QMetaObject::invokeMethod(m_worker, []() {}, Qt::BlockingQueuedConnection);
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+QVector<quint32> TrigramIndex::trigrams(const QByteArray &data)
+{
+    QVector<quint32> result;
+    if (data.size() < 3) {
+        return result;
+    }
+    result.reserve(data.size() - 2);
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    quint32 key = (foldByte(bytes[0]) << 8) | foldByte(bytes[1]);
+    for (qsizetype i = 2; i < data.size(); ++i) {
+        key = ((key << 8) | foldByte(bytes[i])) & 0xffffff;
+        result.append(key);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+QVector<quint32> TrigramIndex::decode(const PostingList &list)
+{
+    QVector<quint32> ids;
+    ids.reserve(list.count);
+    const uchar *p = reinterpret_cast<const uchar *>(list.deltas.constData());
+    const uchar *end = p + list.deltas.size();
+    quint32 previous = 0;
+    while (p < end) {
+        quint32 delta = 0;
+        int shift = 0;
+        while (p < end) {
+            const uchar byte = *p++;
+            delta |= quint32(byte & 0x7f) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        previous += delta;
+        ids.append(previous);
+    }
+    return ids;
+}
+
+void TrigramIndex::append(PostingList *list, quint32 id)
+{
+    quint32 delta = list->count == 0 ? id : id - list->last;
+    do {
+        uchar byte = delta & 0x7f;
+        delta >>= 7;
+        if (delta) {
+            byte |= 0x80;
+        }
+        list->deltas.append(char(byte));
+    } while (delta);
+    list->last = id;
+    ++list->count;
+}
+
+QString TrigramIndex::cacheFileFor(const QString &projectPath)
+{
+    const QByteArray key = QCryptographicHash::hash(QDir::cleanPath(projectPath).toUtf8(), QCryptographicHash::Md5);
+    return QStandardPaths::writableLocation(QStandardPaths::AppCacheLocation) + "/trigrams/" + key.toHex() + ".idx";
+}
+
+void TrigramIndex::open(const QString &projectPath, const QStringList &files)
+{
+    const quint64 generation = ++m_generation;
+    m_projectPath = projectPath;
+    m_ready = false;
+    const QString cacheFile = cacheFileFor(projectPath);
+    QMetaObject::invokeMethod(m_worker, [this, generation, cacheFile, files]() {
+        if (cacheFile != m_cacheFile) {
+            clear();
+            m_cacheFile = cacheFile;
+            load();
+        }
+        synchronize(generation, files);
+    }, Qt::QueuedConnection);
+}
+
+void TrigramIndex::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    ++m_generation;
+    m_projectPath.clear();
+    m_ready = false;
+    // Whatever was indexed so far is kept; the next open only re-reads files that changed
+    QMetaObject::invokeMethod(m_worker, [this]() {
+        save();
+        clear();
+        m_cacheFile.clear();
+    }, Qt::QueuedConnection);
+}
+
+void TrigramIndex::updateFiles(const QStringList &files)
+{
+    if (!isOpen()) {
+        return;
+    }
+    const quint64 generation = m_generation;
+    QMetaObject::invokeMethod(m_worker, [this, generation, files]() {
+        synchronize(generation, files);
+    }, Qt::QueuedConnection);
+}
+
+void TrigramIndex::updateFile(const QString &filePath)
+{
+    if (!isOpen()) {
+        return;
+    }
+    const quint64 generation = m_generation;
+    QMetaObject::invokeMethod(m_worker, [this, generation, filePath]() {
+        if (generation != m_generation || !m_fileIds.contains(filePath)) {
+            return;
+        }
+        if (QFileInfo::exists(filePath)) {
+            indexFile(filePath);
+        } else {
+            removeFile(filePath);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TrigramIndex::synchronize(quint64 generation, const QStringList &files)
+{
+    // Drop files that left the project, then (re)index new and modified ones
+    const QSet<QString> wanted(files.cbegin(), files.cend());
+    QStringList gone;
+    for (auto it = m_fileIds.cbegin(); it != m_fileIds.cend(); ++it) {
+        if (!wanted.contains(it.key())) {
+            gone << it.key();
+        }
+    }
+    for (const QString &filePath : std::as_const(gone)) {
+        removeFile(filePath);
+    }
+
+    for (const QString &filePath : files) {
+        if (generation != m_generation) {
+            return;   // the project was closed or replaced meanwhile
+        }
+        const quint32 id = m_fileIds.value(filePath, kNoFile);
+        if (id != kNoFile) {
+            const QFileInfo info(filePath);
+            const FileEntry &entry = m_files.at(id);
+            if (entry.size == info.size() && entry.modified == modificationTime(info)) {
+                continue;
+            }
+        }
+        indexFile(filePath);
+    }
+
+    if (m_deadCount * 4 > m_files.size()) {
+        compact();
+    }
+    save();
+
+    const int fileCount = m_fileIds.size();
+    QMetaObject::invokeMethod(this, [this, generation, fileCount]() {
+        if (generation == m_generation) {
+            m_ready = true;
+            emit ready(fileCount);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TrigramIndex::indexFile(const QString &filePath)
+{
+    // Reading and splitting happen outside the lock; searches only wait for the insertion
+    const QFileInfo info(filePath);
+    FileEntry entry = {filePath, modificationTime(info), info.size(), true, false};
+    QVector<quint32> keys;
+    if (info.size() <= kMaxIndexedFileSize) {
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QByteArray data = file.readAll();
+            if (!std::memchr(data.constData(), '\0', std::min<qsizetype>(data.size(), 8192))) {
+                keys = trigrams(data);
+                entry.indexed = true;
+            }
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    const quint32 previous = m_fileIds.value(filePath, kNoFile);
+    if (previous != kNoFile) {
+        m_files[previous].alive = false;
+        ++m_deadCount;
+    }
+    const quint32 id = quint32(m_files.size());
+    m_files.append(entry);
+    m_fileIds.insert(filePath, id);
+    for (quint32 key : std::as_const(keys)) {
+        append(&m_postings[key], id);
+    }
+}
+
+void TrigramIndex::removeFile(const QString &filePath)
+{
+    QWriteLocker locker(&m_lock);
+    auto it = m_fileIds.find(filePath);
+    if (it != m_fileIds.end()) {
+        m_files[it.value()].alive = false;
+        ++m_deadCount;
+        m_fileIds.erase(it);
+    }
+}
+
+void TrigramIndex::compact()
+{
+    // Renumbers live files densely; posting lists are rewritten without re-reading any file
+    QWriteLocker locker(&m_lock);
+    QVector<quint32> remap(m_files.size(), kNoFile);
+    QVector<FileEntry> files;
+    for (int id = 0; id < m_files.size(); ++id) {
+        if (m_files.at(id).alive) {
+            remap[id] = quint32(files.size());
+            files.append(m_files.at(id));
+        }
+    }
+
+    QHash<quint32, PostingList> postings;
+    for (auto it = m_postings.cbegin(); it != m_postings.cend(); ++it) {
+        PostingList list = {QByteArray(), 0, 0};
+        for (quint32 id : decode(it.value())) {
+            if (remap.at(id) != kNoFile) {
+                append(&list, remap.at(id));
+            }
+        }
+        if (list.count > 0) {
+            postings.insert(it.key(), list);
+        }
+    }
+
+    m_files = files;
+    m_postings = postings;
+    m_fileIds.clear();
+    for (int id = 0; id < m_files.size(); ++id) {
+        m_fileIds.insert(m_files.at(id).path, quint32(id));
+    }
+    m_deadCount = 0;
+}
+
+void TrigramIndex::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_files.clear();
+    m_fileIds.clear();
+    m_postings.clear();
+    m_deadCount = 0;
+}
+
+bool TrigramIndex::load()
+{
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion) {
+        return false;
+    }
+
+    QWriteLocker locker(&m_lock);
+    quint32 fileCount = 0;
+    in >> fileCount;
+    m_files.reserve(fileCount);
+    for (quint32 i = 0; i < fileCount && in.status() == QDataStream::Ok; ++i) {
+        FileEntry entry;
+        in >> entry.path >> entry.modified >> entry.size >> entry.alive >> entry.indexed;
+        if (entry.alive) {
+            m_fileIds.insert(entry.path, i);
+        } else {
+            ++m_deadCount;
+        }
+        m_files.append(entry);
+    }
+    quint32 postingCount = 0;
+    in >> postingCount;
+    for (quint32 i = 0; i < postingCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 key;
+        PostingList list;
+        in >> key >> list.last >> list.count >> list.deltas;
+        m_postings.insert(key, list);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        // A truncated cache is rebuilt rather than trusted
+        m_files.clear();
+        m_fileIds.clear();
+        m_postings.clear();
+        m_deadCount = 0;
+        return false;
+    }
+    return true;
+}
+
+void TrigramIndex::save() const
+{
+    if (m_cacheFile.isEmpty()) {
+        return;
+    }
+    QDir().mkpath(QFileInfo(m_cacheFile).path());
+    QSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream out(&file);
+    out << kCacheMagic << kCacheVersion;
+
+    QReadLocker locker(&m_lock);
+    out << quint32(m_files.size());
+    for (const FileEntry &entry : m_files) {
+        out << entry.path << entry.modified << entry.size << entry.alive << entry.indexed;
+    }
+    out << quint32(m_postings.size());
+    for (auto it = m_postings.cbegin(); it != m_postings.cend(); ++it) {
+        out << it.key() << it.value().last << it.value().count << it.value().deltas;
+    }
+    locker.unlock();
+    file.commit();
+}
+
+FileStamps TrigramIndex::ruledOut(const SearchOptions &options, const QStringList &files) const
+{
+    FileStamps excluded;
+    if (!m_ready) {
+        return excluded;
+    }
+    const QVector<quint32> keys = trigrams(options.requiredLiteral());
+    if (keys.isEmpty()) {
+        return excluded;
+    }
+
+    QReadLocker locker(&m_lock);
+    // Intersect from the shortest posting list so the working set only shrinks
+    QVector<const PostingList *> lists;
+    for (quint32 key : keys) {
+        auto it = m_postings.constFind(key);
+        if (it == m_postings.constEnd()) {
+            lists.clear();
+            break;
+        }
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const PostingList *a, const PostingList *b) {
+        return a->count < b->count;
+    });
+
+    QVector<quint32> matching = lists.isEmpty() ? QVector<quint32>() : decode(*lists.first());
+    for (int i = 1; i < lists.size() && !matching.isEmpty(); ++i) {
+        const QVector<quint32> other = decode(*lists.at(i));
+        QVector<quint32> intersection;
+        std::set_intersection(matching.cbegin(), matching.cend(), other.cbegin(), other.cend(),
+                              std::back_inserter(intersection));
+        matching = intersection;
+    }
+
+    QSet<QString> possible;
+    for (quint32 id : std::as_const(matching)) {
+        if (m_files.at(id).alive) {
+            possible.insert(m_files.at(id).path);
+        }
+    }
+
+    // Files the index has not seen yet, or could not index, must still be searched
+    for (const QString &filePath : files) {
+        const quint32 id = m_fileIds.value(filePath, kNoFile);
+        if (id != kNoFile && m_files.at(id).indexed && !possible.contains(filePath)) {
+            excluded.insert(filePath, {m_files.at(id).size, m_files.at(id).modified});
+        }
+    }
+    return excluded;
+}
@@ -0,0 +1,94 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QObject>
+#include <QThread>
+#include <QReadWriteLock>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <atomic>
+#include "FindInFiles.h"
+
+// Content index for repeated searches, in the style of codesearch: every indexed file is
+// listed under each (ASCII case-folded) three byte sequence it contains, so a query only has
+// to verify the files whose posting lists contain all trigrams of its required literal.
+//
+// File ids only grow: a changed file is tombstoned and indexed again under a new id, which
+// keeps every posting list sorted and lets it be stored as varint deltas. Tombstones are
+// compacted away once they make up a quarter of the ids. The index is built and updated on
+// its own thread and cached per project in the user cache directory.
+class TrigramIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TrigramIndex(QObject *parent = nullptr);
+    ~TrigramIndex() override;
+
+    void open(const QString &projectPath, const QStringList &files);
+    void close();
+    bool isOpen() const { return !m_projectPath.isEmpty(); }
+    bool isReady() const { return m_ready; }
+
+    // Keeps the index in line with ProjectManager's file list and change notifications
+    void updateFiles(const QStringList &files);
+    void updateFile(const QString &filePath);
+
+    // The files that cannot contain a match, with the stamp each was indexed under; none when
+    // the query cannot be narrowed. Change notifications miss files replaced by a rename, so
+    // the search workers skip these only while their stamp still holds.
+    FileStamps ruledOut(const SearchOptions &options, const QStringList &files) const;
+
+    static QVector<quint32> trigrams(const QByteArray &data);
+
+signals:
+    void ready(int fileCount);
+
+private:
+    static constexpr qint64 kMaxIndexedFileSize = 16 * 1024 * 1024;
+
+    struct FileEntry
+    {
+        QString path;
+        qint64 modified;
+        qint64 size;
+        bool alive;
+        bool indexed;   // false for files that were too large, binary or unreadable
+    };
+
+    struct PostingList
+    {
+        QByteArray deltas;   // varint encoded gaps between ascending file ids
+        quint32 last;
+        quint32 count;
+    };
+
+    // Worker thread only
+    void synchronize(quint64 generation, const QStringList &files);
+    void indexFile(const QString &filePath);
+    void removeFile(const QString &filePath);
+    void compact();
+    void clear();
+    bool load();
+    void save() const;
+    static QString cacheFileFor(const QString &projectPath);
+
+    static QVector<quint32> decode(const PostingList &list);
+    static void append(PostingList *list, quint32 id);
+
+    QString m_projectPath;
+    QString m_cacheFile;   // of the project the worker currently holds
+    std::atomic<quint64> m_generation;
+    std::atomic<bool> m_ready;
+    QThread m_workerThread;
+    QObject *m_worker;
+
+    mutable QReadWriteLock m_lock;   // guards everything below; only the worker writes
+    QVector<FileEntry> m_files;
+    QHash<QString, quint32> m_fileIds;   // live id per path
+    QHash<quint32, PostingList> m_postings;
+    int m_deadCount;
+};
+
+#endif // TRIGRAMINDEX_H
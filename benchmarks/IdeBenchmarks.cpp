@@ -0,0 +1,665 @@
+// Benchmarks for the IDE's own hot paths.
+//
+// Speaks a subset of the Google Benchmark command line and JSON format so the
+// results can be recorded with "QTCIDE --benchmark" and compared across commits:
+//
+//   qtcide_benchmarks --benchmark_format=json --benchmark_repetitions=10
+//   qtcide_benchmarks --benchmark_filter=Highlighter --benchmark_large
+
+#include <QApplication>
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QKeyEvent>
+#include <QRegularExpression>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include "CodeEditor.h"
+#include "Terminal.h"
+#include "ProjectManager.h"
+#include "FuzzyMatcher.h"
+#include "FindInFiles.h"
+#include "TrigramIndex.h"
+#include "TextFileCodec.h"
+#include "TextDiff.h"
+#include <QEventLoop>
+
+namespace {
+
+// One timed repetition; throughput counters are optional
+struct Measurement
+{
+    double nanoseconds = 0;
+    qint64 iterations = 1;
+    double bytes = 0;
+    double items = 0;
+};
+
+struct Benchmark
+{
+    QString name;
+    bool large;   // only run with --benchmark_large
+    std::function<Measurement()> run;
+};
+
+struct Options
+{
+    QRegularExpression filter{"."};
+    int repetitions = 1;
+    bool json = false;
+    bool large = false;
+    bool list = false;
+    QString outFile;
+};
+
+QTemporaryDir *scratchDir()
+{
+    static QTemporaryDir dir;
+    return &dir;
+}
+
+// Synthetic C++ that exercises every highlighting rule: keywords, Qt types,
+// strings, numbers, preprocessor lines and both comment styles
+QString syntheticSource(qint64 minimumBytes)
+{
+    static const QString chunk = QStringLiteral(
+        "#include <QString>\n"
+        "// Computes a checksum over the widget names\n"
+        "namespace detail {\n"
+        "class Accumulator : public QObject\n"
+        "{\n"
+        "public:\n"
+        "    explicit Accumulator(QWidget *parent = nullptr) : m_total(0) {}\n"
+        "    /* Sums the characters; values above 0x7f are folded */\n"
+        "    int add(const QString &text) const\n"
+        "    {\n"
+        "        for (int i = 0; i < text.size(); ++i) {\n"
+        "            if (text.at(i).unicode() > 127) continue;\n"
+        "            m_total += text.at(i).unicode() * 31 + 7;\n"
+        "        }\n"
+        "        return m_total > 1000000 ? -1 : m_total; // \"overflow\"\n"
+        "    }\n"
+        "private:\n"
+        "    mutable int m_total;\n"
+        "};\n"
+        "}\n\n");
+
+    QString source;
+    source.reserve(minimumBytes + chunk.size());
+    while (source.size() < minimumBytes) {
+        source += chunk;
+    }
+    return source;
+}
+
+QString sourceFile(qint64 megabytes)
+{
+    const QString path = scratchDir()->filePath(QString("source_%1mb.cpp").arg(megabytes));
+    if (!QFile::exists(path)) {
+        QFile file(path);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(syntheticSource(megabytes * 1024 * 1024).toUtf8());
+        }
+    }
+    return path;
+}
+
+// A project with fileCount files spread over 100-file directories; a quarter of
+// them do not match the project file filters
+QString projectTree(int fileCount)
+{
+    const QString root = scratchDir()->filePath(QString("project_%1").arg(fileCount));
+    if (QDir(root).exists()) {
+        return root;
+    }
+
+    const char *extensions[] = {".cpp", ".h", ".txt", ".cc"};
+    for (int i = 0; i < fileCount; ++i) {
+        const QString dir = QString("%1/src/module%2/part%3").arg(root).arg(i / 10000).arg(i / 100 % 100);
+        if (i % 100 == 0) {
+            QDir().mkpath(dir);
+        }
+        QFile file(QString("%1/file%2%3").arg(dir).arg(i).arg(extensions[i % 4]));
+        file.open(QIODevice::WriteOnly);
+    }
+    return root;
+}
+
+// An editor at a typical window size, shown so layout and painting happen as in the IDE
+std::unique_ptr<CodeEditor> makeShownEditor()
+{
+    auto editor = std::make_unique<CodeEditor>();
+    editor->resize(1000, 800);
+    editor->show();
+    return editor;
+}
+
+Measurement highlightBlock()
+{
+    QTextDocument document;
+    document.setPlainText(syntheticSource(1024 * 1024));
+    CppHighlighter highlighter(&document);
+
+    QElapsedTimer timer;
+    timer.start();
+    highlighter.rehighlight();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.bytes = document.characterCount();
+    m.items = document.blockCount();
+    return m;
+}
+
+Measurement editorLoad(qint64 megabytes)
+{
+    const QString path = sourceFile(megabytes);
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+
+    // Same steps as MainWindow::openFileFromPath, plus the first paint
+    QElapsedTimer timer;
+    timer.start();
+    QString text;
+    TextFileCodec::load(path, &text, nullptr);
+    editor->setPlainText(text);
+    QCoreApplication::processEvents();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.bytes = QFileInfo(path).size();
+    return m;
+}
+
+// Frames of scrolling through a million lines, each repainting the text and the gutter
+Measurement gutterScroll(int lineCount)
+{
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+    editor->setPlainText(QString("    value = compute(value, %1);\n").repeated(lineCount));
+    QCoreApplication::processEvents();
+    QScrollBar *scrollBar = editor->verticalScrollBar();
+    scrollBar->setValue(scrollBar->maximum() / 2);
+    QCoreApplication::processEvents();
+    const int start = scrollBar->value();
+
+    const int frames = 300;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 1; i <= frames; ++i) {
+        scrollBar->setValue(start + i * 3);
+        QCoreApplication::processEvents();
+    }
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = frames;
+    return m;
+}
+
+// Folding and unfolding one function body of the given number of lines
+Measurement foldRegion(int lineCount)
+{
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+    editor->setPlainText("void generated()\n{\n" + QString("    call();\n").repeated(lineCount) + "}\n");
+    QCoreApplication::processEvents();
+
+    QElapsedTimer timer;
+    timer.start();
+    editor->setFolded(1, true);
+    QCoreApplication::processEvents();
+    editor->setFolded(1, false);
+    QCoreApplication::processEvents();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = 2;
+    m.items = 2.0 * lineCount;
+    return m;
+}
+
+// Jumping between the braces of a function body of the given number of lines, each jump
+// matching the brace and highlighting the pair
+Measurement bracketMatch(int lineCount)
+{
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+    editor->setPlainText("void generated()\n{\n" + QString("    call(value[0]);\n").repeated(lineCount) + "}\n");
+    QTextCursor cursor(editor->document()->findBlockByNumber(1));
+    cursor.movePosition(QTextCursor::Right);
+    editor->setTextCursor(cursor);
+    QCoreApplication::processEvents();
+
+    const int jumps = 1000;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < jumps; ++i) {
+        editor->jumpToMatchingBracket();
+    }
+    QCoreApplication::processEvents();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = jumps;
+    return m;
+}
+
+// Typing into a column cursor on every row of a generated table, each keystroke applied to all
+// cursors in one edit block and laid out before the next
+Measurement multiCursorTyping(int rowCount)
+{
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+    QString table;
+    for (int i = 0; i < rowCount; ++i) {
+        table += QString("    {\"entry_%1\", %2, 0x%3},\n").arg(i).arg(i * 7 % 1000).arg(i, 4, 16, QChar('0'));
+    }
+    editor->setPlainText(table);
+    const qreal column = editor->fontMetrics().horizontalAdvance("    {");
+    editor->selectColumns(0, rowCount - 1, column, column);
+    QCoreApplication::processEvents();
+
+    const int keystrokes = 20;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < keystrokes; ++i) {
+        QKeyEvent event(QEvent::KeyPress, Qt::Key_Space, Qt::NoModifier, " ");
+        QCoreApplication::sendEvent(editor.get(), &event);
+        QCoreApplication::processEvents();
+    }
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = keystrokes;
+    m.items = double(keystrokes) * editor->cursorCount();
+    return m;
+}
+
+Measurement terminalAppend(int lineCount, int linesPerCall)
+{
+    Terminal terminal;
+    terminal.resize(800, 200);
+    terminal.show();
+    const QString line = QString("[ 42%] Building CXX object CMakeFiles/app.dir/src/module.cpp.o\n");
+    const QString chunk = line.repeated(linesPerCall);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < lineCount; i += linesPerCall) {
+        terminal.appendText(chunk);
+    }
+    QCoreApplication::processEvents();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = lineCount / linesPerCall;
+    m.bytes = double(lineCount) * line.size();
+    m.items = lineCount;
+    return m;
+}
+
+Measurement scanProjectFiles(int fileCount)
+{
+    const QString root = projectTree(fileCount);
+    ProjectManager manager;
+
+    // Opening a project is dominated by the recursive scan and watcher registration
+    QElapsedTimer timer;
+    timer.start();
+    manager.openProject(root);
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.items = fileCount;
+    manager.closeProject();
+    return m;
+}
+
+Measurement completionLatency()
+{
+    const std::unique_ptr<CodeEditor> editor = makeShownEditor();
+    editor->setPlainText(syntheticSource(64 * 1024));
+    editor->moveCursor(QTextCursor::End);
+    QCompleter *completer = editor->findChild<QCompleter *>();
+
+    auto press = [&editor](Qt::Key key, const QString &text) {
+        QKeyEvent event(QEvent::KeyPress, key, Qt::NoModifier, text);
+        QCoreApplication::sendEvent(editor.get(), &event);
+    };
+
+    // The second letter of a word is the first keystroke that filters and shows the popup
+    const int rounds = 200;
+    qint64 elapsed = 0;
+    QElapsedTimer timer;
+    for (int i = 0; i < rounds; ++i) {
+        press(Qt::Key_Q, "Q");
+        timer.start();
+        press(Qt::Key_W, "W");
+        elapsed += timer.nsecsElapsed();
+        press(Qt::Key_Space, " ");
+        if (completer) {
+            completer->popup()->hide();
+        }
+    }
+
+    Measurement m;
+    m.nanoseconds = elapsed;
+    m.iterations = rounds;
+    return m;
+}
+
+// Typing a query one letter at a time against a synthetic project file list
+Measurement quickOpenTyping(int fileCount)
+{
+    static const char *directories[] = {"src", "include", "tests", "tools", "third_party/lib"};
+    static const char *names[] = {"MainWindow", "code_editor", "ProjectManager", "terminal-view", "fuzzy"};
+    QStringList paths;
+    paths.reserve(fileCount);
+    for (int i = 0; i < fileCount; ++i) {
+        paths << QString("/project/%1/module%2/%3%4.cpp").arg(directories[i % 5]).arg(i / 1000)
+                     .arg(names[i / 5 % 5]).arg(i);
+    }
+    FuzzyMatcher matcher;
+    matcher.setPaths(paths, "/project");
+
+    const QString query = "prjmgr42";
+    QElapsedTimer timer;
+    timer.start();
+    for (int length = 1; length <= query.size(); ++length) {
+        matcher.match(query.left(length), 200);
+    }
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = query.size();
+    m.items = double(fileCount) * query.size();
+    return m;
+}
+
+// fileCount synthetic 64 KB sources; every tenth one also mentions a rare identifier
+QStringList searchTree(int fileCount)
+{
+    const QString root = scratchDir()->filePath(QString("search_%1").arg(fileCount));
+    QStringList files;
+    QDir().mkpath(root);
+    const QByteArray source = syntheticSource(64 * 1024).toUtf8();
+    for (int i = 0; i < fileCount; ++i) {
+        const QString path = QString("%1/source%2.cpp").arg(root).arg(i);
+        if (!QFile::exists(path)) {
+            QFile file(path);
+            file.open(QIODevice::WriteOnly);
+            file.write(source);
+            if (i % 10 == 0) {
+                file.write("int rareIdentifierForIndex = 42;\n");
+            }
+        }
+        files << path;
+    }
+    return files;
+}
+
+// Searches the synthetic sources and waits for the last streamed batch
+Measurement findInFiles(int fileCount, bool regex)
+{
+    const QStringList files = searchTree(fileCount);
+    const qint64 sourceBytes = QFileInfo(files.first()).size();
+
+    SearchOptions options;
+    options.pattern = regex ? "Accumulator\\(\\w+" : "checksum";
+    options.regex = regex;
+    FindInFiles search;
+    QEventLoop loop;
+    QObject::connect(&search, &FindInFiles::finished, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    search.start(files, options);
+    loop.exec();
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.bytes = double(sourceBytes) * fileCount;
+    m.items = fileCount;
+    return m;
+}
+
+// Narrowing a query with a built index; the build itself is not timed
+Measurement trigramQuery(int fileCount)
+{
+    const QStringList files = searchTree(fileCount);
+    TrigramIndex index;
+    QEventLoop loop;
+    QObject::connect(&index, &TrigramIndex::ready, &loop, &QEventLoop::quit);
+    index.open(scratchDir()->filePath("search_index"), files);
+    loop.exec();
+
+    SearchOptions options;
+    options.pattern = "rareIdentifierForIndex";
+    const int rounds = 100;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rounds; ++i) {
+        index.ruledOut(options, files);
+    }
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.iterations = rounds;
+    m.items = double(fileCount) * rounds;
+    return m;
+}
+
+// Reloading a 10 MB file after another program changed a line every 10000 lines
+Measurement reloadDiff()
+{
+    const QString before = syntheticSource(10 * 1024 * 1024);
+    QStringList lines = before.split('\n');
+    for (int i = 0; i < lines.size(); i += 10000) {
+        lines[i] += " // changed";
+    }
+    const QString after = lines.join('\n');
+
+    QElapsedTimer timer;
+    timer.start();
+    TextDiff::lineEdits(before, after);
+
+    Measurement m;
+    m.nanoseconds = timer.nsecsElapsed();
+    m.bytes = before.size() * qint64(sizeof(QChar));
+    return m;
+}
+
+QVector<Benchmark> benchmarks()
+{
+    QVector<Benchmark> list;
+    list.append({"CppHighlighter/highlightBlock/1MB", false, highlightBlock});
+    for (int megabytes : {1, 10, 100}) {
+        list.append({QString("CodeEditor/load/%1MB").arg(megabytes), megabytes > 10,
+                     [megabytes]() { return editorLoad(megabytes); }});
+    }
+    list.append({"Terminal/appendText/lines", false, []() { return terminalAppend(20000, 1); }});
+    list.append({"Terminal/appendText/chunks", false, []() { return terminalAppend(200000, 64); }});
+    for (int files : {10000, 100000, 1000000}) {
+        list.append({QString("ProjectManager/scanProjectFiles/%1").arg(files), files > 100000,
+                     [files]() { return scanProjectFiles(files); }});
+    }
+    list.append({"CodeEditor/completion", false, completionLatency});
+    list.append({"CodeEditor/scroll/1000000", false, []() { return gutterScroll(1000000); }});
+    list.append({"CodeEditor/fold/100000", false, []() { return foldRegion(100000); }});
+    list.append({"CodeEditor/bracketMatch/1000000", false, []() { return bracketMatch(1000000); }});
+    list.append({"CodeEditor/multiCursor/10000", false, []() { return multiCursorTyping(10000); }});
+    list.append({"FuzzyMatcher/typing/500000", false, []() { return quickOpenTyping(500000); }});
+    list.append({"FindInFiles/literal/2000", false, []() { return findInFiles(2000, false); }});
+    list.append({"FindInFiles/regex/2000", false, []() { return findInFiles(2000, true); }});
+    list.append({"TrigramIndex/query/2000", false, []() { return trigramQuery(2000); }});
+    list.append({"TextDiff/reload/10MB", false, reloadDiff});
+    return list;
+}
+
+QJsonObject entry(const QString &name, const Measurement &m, int repetitions, int index)
+{
+    const double perIteration = m.nanoseconds / m.iterations;
+    QJsonObject object;
+    object["name"] = name;
+    object["run_name"] = name;
+    object["run_type"] = "iteration";
+    object["repetitions"] = repetitions;
+    object["repetition_index"] = index;
+    object["threads"] = 1;
+    object["iterations"] = m.iterations;
+    object["real_time"] = perIteration;
+    object["cpu_time"] = perIteration;
+    object["time_unit"] = "ns";
+    if (m.bytes > 0) {
+        object["bytes_per_second"] = m.bytes / (m.nanoseconds / 1e9);
+    }
+    if (m.items > 0) {
+        object["items_per_second"] = m.items / (m.nanoseconds / 1e9);
+    }
+    return object;
+}
+
+QJsonObject aggregate(const QString &name, const QString &kind, double value, int repetitions)
+{
+    QJsonObject object;
+    object["name"] = name + "_" + kind;
+    object["run_name"] = name;
+    object["run_type"] = "aggregate";
+    object["aggregate_name"] = kind;
+    object["repetitions"] = repetitions;
+    object["threads"] = 1;
+    object["iterations"] = repetitions;
+    object["real_time"] = value;
+    object["cpu_time"] = value;
+    object["time_unit"] = "ns";
+    return object;
+}
+
+bool parseOptions(const QStringList &arguments, Options *options)
+{
+    for (const QString &argument : arguments.mid(1)) {
+        const QString value = argument.section('=', 1);
+        if (argument.startsWith("--benchmark_filter=")) {
+            options->filter = QRegularExpression(value);
+        } else if (argument.startsWith("--benchmark_repetitions=")) {
+            options->repetitions = qMax(1, value.toInt());
+        } else if (argument.startsWith("--benchmark_format=")) {
+            options->json = value == "json";
+        } else if (argument.startsWith("--benchmark_out=")) {
+            options->outFile = value;
+        } else if (argument == "--benchmark_large") {
+            options->large = true;
+        } else if (argument == "--benchmark_list_tests") {
+            options->list = true;
+        } else {
+            QTextStream(stderr) << "Unknown argument: " << argument << "\n"
+                                << "Options: --benchmark_filter=<regex> --benchmark_repetitions=<n> "
+                                   "--benchmark_format=console|json --benchmark_out=<file> "
+                                   "--benchmark_large --benchmark_list_tests\n";
+            return false;
+        }
+    }
+    return options->filter.isValid();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // Widgets are created but never need a screen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    app.setApplicationName("qtcide_benchmarks");
+    // Keep ProjectManager's recent project list out of the user's configuration
+    QStandardPaths::setTestModeEnabled(true);
+
+    Options options;
+    if (!parseOptions(app.arguments(), &options)) {
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    QJsonArray results;
+    for (const Benchmark &benchmark : benchmarks()) {
+        if (!options.filter.match(benchmark.name).hasMatch() || (benchmark.large && !options.large)) {
+            continue;
+        }
+        if (options.list) {
+            out << benchmark.name << Qt::endl;
+            continue;
+        }
+
+        QVector<double> times;
+        for (int i = 0; i < options.repetitions; ++i) {
+            const Measurement m = benchmark.run();
+            results.append(entry(benchmark.name, m, options.repetitions, i));
+            times << m.nanoseconds / m.iterations;
+            if (!options.json) {
+                out << benchmark.name.leftJustified(44)
+                    << QString::number(m.nanoseconds / m.iterations, 'f', 0).rightJustified(16) << " ns"
+                    << QString::number(m.iterations).rightJustified(10) << Qt::endl;
+            }
+        }
+
+        if (options.repetitions > 1) {
+            double sum = 0;
+            for (double time : times) {
+                sum += time;
+            }
+            const double mean = sum / times.size();
+            double squares = 0;
+            for (double time : times) {
+                squares += (time - mean) * (time - mean);
+            }
+            std::sort(times.begin(), times.end());
+            const int middle = times.size() / 2;
+            const double median = times.size() % 2 ? times.at(middle) : (times.at(middle - 1) + times.at(middle)) / 2;
+            results.append(aggregate(benchmark.name, "mean", mean, options.repetitions));
+            results.append(aggregate(benchmark.name, "median", median, options.repetitions));
+            results.append(aggregate(benchmark.name, "stddev", std::sqrt(squares / (times.size() - 1)), options.repetitions));
+        }
+    }
+    if (options.list) {
+        return 0;
+    }
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["host_name"] = QSysInfo::machineHostName();
+    context["executable"] = app.applicationFilePath();
+    context["num_cpus"] = QThread::idealThreadCount();
+#ifdef NDEBUG
+    context["library_build_type"] = "release";
+#else
+    context["library_build_type"] = "debug";
+#endif
+    QJsonObject root;
+    root["context"] = context;
+    root["benchmarks"] = results;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (options.json) {
+        out << json;
+    }
+    if (!options.outFile.isEmpty()) {
+        QFile file(options.outFile);
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            QTextStream(stderr) << "Could not write " << options.outFile << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
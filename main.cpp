@@ -1,18 +1,117 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QStyleFactory>
 #include <QPalette>
 #include <QDir>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QTextStream>
+#include <QTimer>
 #include "MainWindow.h"
+#include "BenchmarkRunner.h"
+#include "BenchmarkHistory.h"
+#include "Instrumentation.h"
+#include "ToolchainDiscovery.h"
+
+// Runs a benchmark executable without the GUI, records it in the project's
+// history and prints the comparison. Exits with 1 when something regressed.
+static int runHeadlessBenchmark(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run a benchmark executable and compare it against the project's history");
+    parser.addHelpOption();
+    parser.addOption({"benchmark", "Google Benchmark or Catch2 executable to run.", "executable"});
+    parser.addOption({"project", "Project directory holding the benchmark history.", "directory", QDir::currentPath()});
+    parser.addOption({"repetitions", "Number of repetitions per benchmark.", "count", "10"});
+    parser.addOption({"baseline", "Commit to compare against (default: previous run).", "commit"});
+    parser.addPositionalArgument("args", "Extra arguments passed to the benchmark executable.", "[-- args...]");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const QString executable = QFileInfo(parser.value("benchmark")).absoluteFilePath();
+    const QString projectPath = QFileInfo(parser.value("project")).absoluteFilePath();
+
+    BenchmarkHistory history(projectPath);
+    QString error;
+    if (!history.load(&error)) {
+        err << "Could not read benchmark history: " << error << Qt::endl;
+        return 2;
+    }
+
+    BenchmarkRunner runner;
+    QObject::connect(&runner, &BenchmarkRunner::output, [&err](const QString &text) {
+        err << text;
+        err.flush();
+    });
+    QObject::connect(&runner, &BenchmarkRunner::errorOccurred, [&](const QString &message) {
+        err << "Benchmark error: " << message << Qt::endl;
+        app.exit(2);
+    });
+    QObject::connect(&runner, &BenchmarkRunner::runFinished, [&](const BenchmarkRun &run) {
+        int baselineIndex = parser.isSet("baseline") ? history.findCommit(parser.value("baseline"))
+                                                     : history.runs().size() - 1;
+        if (parser.isSet("baseline") && baselineIndex < 0) {
+            err << "No recorded run for baseline " << parser.value("baseline") << Qt::endl;
+        }
+        const BenchmarkRun baseline = baselineIndex >= 0 ? history.runs().at(baselineIndex) : BenchmarkRun();
+
+        history.addRun(run);
+        QString saveError;
+        if (!history.save(&saveError)) {
+            err << "Could not save benchmark history: " << saveError << Qt::endl;
+        }
+
+        out << "Current:  " << run.label() << Qt::endl;
+        out << "Baseline: " << (baselineIndex >= 0 ? baseline.label() : QString("none")) << Qt::endl << Qt::endl;
+
+        int regressions = 0;
+        for (const BenchmarkComparison &comparison : BenchmarkHistory::compare(baseline, run)) {
+            out << comparison.name.leftJustified(48)
+                << BenchmarkHistory::formatDuration(comparison.current.median).rightJustified(12)
+                << (" +/- " + BenchmarkHistory::formatDuration(comparison.current.stddev)).leftJustified(16);
+            if (comparison.verdict != BenchmarkComparison::Added) {
+                out << QString("%1%2%").arg(comparison.changePercent > 0 ? "+" : "")
+                           .arg(comparison.changePercent, 0, 'f', 1).rightJustified(9)
+                    << QString("  p=%1  ").arg(comparison.pValue, 0, 'g', 3);
+            }
+            out << BenchmarkHistory::verdictText(comparison.verdict) << Qt::endl;
+            if (comparison.verdict == BenchmarkComparison::Regressed) {
+                ++regressions;
+            }
+        }
+        app.exit(regressions > 0 ? 1 : 0);
+    });
+
+    if (!runner.start(executable, parser.positionalArguments(), QFileInfo(executable).absolutePath(),
+                      QProcessEnvironment::systemEnvironment(), projectPath, parser.value("repetitions").toInt())) {
+        return 2;
+    }
+    return app.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    // Headless mode has to be decided before a QApplication needs a display
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--benchmark") == 0 || qstrncmp(argv[i], "--benchmark=", 12) == 0) {
+            QCoreApplication app(argc, argv);
+            app.setApplicationName("QTCIDE");
+            return runHeadlessBenchmark(app);
+        }
+    }
+
     QApplication app(argc, argv);
+    Instrumentation::markStartupPhase("QApplication");
     
     // Set application properties
     app.setApplicationName("QTCIDE");
     app.setApplicationVersion("1.0");
     app.setOrganizationName("QTCIDE");
     
+    // Shells and build tools are probed once in the background and cached across runs
+    ToolchainDiscovery::instance()->start();
+    
     // Apply dark theme
     app.setStyle(QStyleFactory::create("Fusion"));
     QPalette darkPalette;
@@ -30,9 +129,21 @@ int main(int argc, char *argv[])
     darkPalette.setColor(QPalette::Highlight, QColor(255, 140, 0));
     darkPalette.setColor(QPalette::HighlightedText, Qt::black);
     app.setPalette(darkPalette);
+    Instrumentation::markStartupPhase("Theme");
+    
+    // Opt-in tracing from the first frame; can also be toggled in Tools
+    if (qEnvironmentVariableIntValue("QTCIDE_INSTRUMENTATION") > 0) {
+        Instrumentation::instance()->setEnabled(true);
+    }
     
+    // Everything not needed for the first frame is built on demand by MainWindow
     MainWindow window;
+    Instrumentation::markStartupPhase("MainWindow");
     window.show();
+    Instrumentation::markStartupPhase("Window shown");
+    QTimer::singleShot(0, &window, []() {
+        Instrumentation::markStartupPhase("First event loop pass");
+    });
     
     return app.exec();
 }